@@ -3,8 +3,15 @@ CONFIG += ordered
 
 SUBDIRS += \
     src \
+    schemagen \
     tests \
+    benchmarks \
     examples/csv_demo \
 
+# Генератор заголовков схем (tools/schemagen) нужен при сборке тестов
+schemagen.subdir = tools/schemagen
+schemagen.depends = src
+
 # tests зависит от src
-tests.depends = src
+tests.depends = src schemagen
+benchmarks.depends = src
@@ -0,0 +1,587 @@
+#include "ModelBenchmarks.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+#include "ColumnStore.h"
+#include "CsvReader.h"
+#include "ModelCore.h"
+#include "ModelFactory.h"
+#include "ModelSchema.h"
+#include "PredicateKernels.h"
+#include "SchemaCache.h"
+#include "SchemaRegistry.h"
+#include "SqlQueryHandlerFactory.h"
+
+using QForge::nsModel::ColumnStore;
+using QForge::nsModel::CsvReader;
+using QForge::nsModel::ModelCore;
+using QForge::nsModel::ModelFactory;
+using QForge::nsModel::QueryHandler;
+using QForge::nsModel::PredicateKernels;
+using QForge::nsModel::SchemaCache;
+using QForge::nsModel::SchemaRegistry;
+using QForge::nsModel::SqlQueryHandlerFactory;
+
+namespace {
+
+// Устройство без записи на диск: замеряется только кодирование
+class NullDevice : public QIODevice
+{
+protected:
+    qint64 readData(char*, qint64) override { return -1; }
+    qint64 writeData(const char*, qint64 size) override { return size; }
+};
+
+}
+
+void ModelBenchmarks::initTestCase()
+{
+    model = new TableModel(getProjectRoot() + "/benchmarks/BenchmarkModel.yml", emptyQueryHandler);
+    QVERIFY2(model->isValid(), qPrintable(model->getLastError()));
+
+    // Заполняем пачками, чтобы не держать в памяти миллион QVariantMap сразу
+    const int batch = 100000;
+    for (int first = 0; first < kRowCount; first += batch) {
+        model->appendRows(generateRows(first, batch));
+    }
+    QCOMPARE(model->rowCount(), kRowCount);
+}
+
+void ModelBenchmarks::cleanupTestCase()
+{
+    delete model;
+    model = nullptr;
+}
+
+void ModelBenchmarks::sortDoubleColumn()
+{
+    QForge::SortRule byPrice;
+    byPrice.columnName = "price";
+
+    QBENCHMARK {
+        model->setSortRules({});
+        model->setSortRules({byPrice});
+    }
+}
+
+void ModelBenchmarks::sortStringColumn()
+{
+    QForge::SortRule byName;
+    byName.columnName = "name";
+
+    QBENCHMARK {
+        model->setSortRules({});
+        model->setSortRules({byName});
+    }
+}
+
+void ModelBenchmarks::toggleSortDirection()
+{
+    model->sort(2, Qt::AscendingOrder);
+
+    Qt::SortOrder order = Qt::AscendingOrder;
+    QBENCHMARK {
+        order = (order == Qt::AscendingOrder) ? Qt::DescendingOrder : Qt::AscendingOrder;
+        model->sort(2, order);
+    }
+}
+
+void ModelBenchmarks::singleEditSorted()
+{
+    model->sort(2, Qt::AscendingOrder);
+
+    QRandomGenerator rng(42);
+    QBENCHMARK {
+        const int row = int(rng.bounded(quint32(model->rowCount())));
+        model->setData(model->index(row, 2), rng.bounded(100000.0));
+    }
+}
+
+void ModelBenchmarks::singleInsertSorted()
+{
+    model->sort(2, Qt::AscendingOrder);
+
+    QBENCHMARK {
+        model->appendRows(generateRows(nextId++, 1));
+    }
+}
+
+void ModelBenchmarks::int64Kernel_data()
+{
+    addIsaRows();
+}
+
+void ModelBenchmarks::int64Kernel()
+{
+    QFETCH(int, isa);
+    PredicateKernels::setActiveIsa(PredicateKernels::Isa(isa));
+
+    QRandomGenerator rng(7);
+    QVector<qint64> values(kRowCount);
+    for (qint64& value : values) {
+        value = rng.bounded(10000);
+    }
+    QVector<quint64> words((kRowCount + 63) / 64);
+
+    auto body = [&]() {
+        PredicateKernels::compareInt64(values.constData(), kRowCount, QForge::FilterOperator::Between,
+                                       100, 5000, words.data());
+    };
+    QBENCHMARK {
+        body();
+    }
+    reportThroughput(QString("int64 between (%1)").arg(PredicateKernels::isaName(PredicateKernels::activeIsa())),
+                     kRowCount, body);
+
+    PredicateKernels::setActiveIsa(PredicateKernels::supportedIsa());
+}
+
+void ModelBenchmarks::doubleKernel_data()
+{
+    addIsaRows();
+}
+
+void ModelBenchmarks::doubleKernel()
+{
+    QFETCH(int, isa);
+    PredicateKernels::setActiveIsa(PredicateKernels::Isa(isa));
+
+    QRandomGenerator rng(7);
+    QVector<double> values(kRowCount);
+    for (double& value : values) {
+        value = rng.bounded(100000.0);
+    }
+    QVector<quint64> words((kRowCount + 63) / 64);
+
+    auto body = [&]() {
+        PredicateKernels::compareDouble(values.constData(), kRowCount, QForge::FilterOperator::Less,
+                                        50000.0, 0.0, words.data());
+    };
+    QBENCHMARK {
+        body();
+    }
+    reportThroughput(QString("double less (%1)").arg(PredicateKernels::isaName(PredicateKernels::activeIsa())),
+                     kRowCount, body);
+
+    PredicateKernels::setActiveIsa(PredicateKernels::supportedIsa());
+}
+
+void ModelBenchmarks::filterNumericColumn()
+{
+    QForge::Filter cheap;
+    cheap.rules.append({"price", QForge::FilterOperator::Between, 100.0, 50000.0});
+
+    QBENCHMARK {
+        model->setFilter(cheap);
+        model->clearFilter();
+    }
+}
+
+void ModelBenchmarks::csvRowBoundaries_data()
+{
+    addIsaRows();
+}
+
+void ModelBenchmarks::csvRowBoundaries()
+{
+    QFETCH(int, isa);
+    PredicateKernels::setActiveIsa(PredicateKernels::Isa(isa));
+
+    const QByteArray text = generateCsv(kRowCount);
+    auto body = [&]() {
+        const QVector<qint64> ends = CsvReader::rowEnds(text.constData(), text.size(), '"');
+        QCOMPARE(ends.size(), kRowCount + 1);
+    };
+    QBENCHMARK {
+        body();
+    }
+    reportBandwidth(QString("csv row boundaries (%1)").arg(PredicateKernels::isaName(PredicateKernels::activeIsa())),
+                    text.size(), 10, body);
+
+    PredicateKernels::setActiveIsa(PredicateKernels::supportedIsa());
+}
+
+void ModelBenchmarks::csvIngest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("bench.csv");
+    const QByteArray text = generateCsv(kRowCount);
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(text), qint64(text.size()));
+    }
+
+    const QVector<QForge::Column> columns = model->getSchema().columns;
+    auto body = [&]() {
+        CsvReader reader;
+        QVERIFY(reader.open(path));
+        ColumnStore store;
+        store.reset(columns);
+        QCOMPARE(reader.read(store), kRowCount);
+    };
+    QBENCHMARK {
+        body();
+    }
+    reportBandwidth("csv ingest (mmap, all cores)", text.size(), 3, body);
+}
+
+void ModelBenchmarks::schemaStartup_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::newRow("cold") << false;
+    QTest::newRow("warm") << true;
+}
+
+void ModelBenchmarks::schemaStartup()
+{
+    QFETCH(bool, cached);
+
+    // Приложение при старте создаёт около 80 моделей, каждая из своего файла схемы
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QStringList paths;
+    for (int i = 0; i < kStartupModels; ++i) {
+        paths.append(dir.filePath(QString("Model%1.yml").arg(i)));
+        QVERIFY(QFile::copy(getProjectRoot() + "/benchmarks/BenchmarkModel.yml", paths.last()));
+    }
+
+    const QString previousDirectory = SchemaCache::directory();
+    SchemaCache::setDirectory(cached ? dir.filePath("cache") : QString());
+
+    auto body = [&]() {
+        // Без реестра: иначе схемы разбирались бы только в первый раз
+        SchemaRegistry::instance().clear();
+        for (const QString& path : paths) {
+            ModelCore core(path);
+            QVERIFY(core.isValid());
+        }
+    };
+    // Тёплый запуск: кэш уже построен предыдущим запуском
+    body();
+    QBENCHMARK {
+        body();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    body();
+    qInfo().noquote() << QString("schema startup (%1, %2 models): %3 ms")
+                             .arg(cached ? "warm" : "cold")
+                             .arg(kStartupModels)
+                             .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 2);
+
+    SchemaCache::setDirectory(previousDirectory);
+}
+
+void ModelBenchmarks::bulkModelStartup_data()
+{
+    QTest::addColumn<bool>("bulk");
+    QTest::newRow("serial") << false;
+    QTest::newRow("factory") << true;
+}
+
+void ModelBenchmarks::bulkModelStartup()
+{
+    QFETCH(bool, bulk);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QStringList paths;
+    for (int i = 0; i < kStartupModels; ++i) {
+        paths.append(dir.filePath(QString("Model%1.yml").arg(i)));
+        QVERIFY(QFile::copy(getProjectRoot() + "/benchmarks/BenchmarkModel.yml", paths.last()));
+    }
+
+    // Загрузочный запрос каждой модели отдаёт 1000 строк
+    const QueryHandler handler = [](const QueryContext&) {
+        QueryResult result;
+        result.ok = true;
+        result.rows = generateRows(0, 1000);
+        return result;
+    };
+
+    const QString previousDirectory = SchemaCache::directory();
+    SchemaCache::setDirectory(QString());
+
+    QBENCHMARK {
+        SchemaRegistry::instance().clear();
+        if (bulk) {
+            ModelFactory factory(handler);
+            QSignalSpy finished(&factory, &ModelFactory::finished);
+            QVERIFY(factory.create(paths));
+            QVERIFY(finished.wait(60000));
+            const ModelFactory::Timings timings = factory.timings();
+            qInfo().noquote() << QString("factory phases: parse %1 ms, construct %2 ms, load %3 ms, total %4 ms")
+                                     .arg(timings.parseMs).arg(timings.constructMs)
+                                     .arg(timings.loadMs).arg(timings.totalMs);
+        } else {
+            QList<TableModel*> models;
+            for (const QString& path : paths) {
+                models.append(new TableModel(path, handler));
+                QVERIFY(models.last()->execute(models.last()->getSchema().loadQuery).ok);
+            }
+            qDeleteAll(models);
+        }
+    }
+
+    SchemaCache::setDirectory(previousDirectory);
+}
+
+void ModelBenchmarks::columnLookup_data()
+{
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("linear") << false;
+    QTest::newRow("hashed") << true;
+}
+
+void ModelBenchmarks::columnLookup()
+{
+    QFETCH(bool, indexed);
+
+    // Широкая модель: 200 колонок, каждое имя ищется по разу
+    QForge::ModelSchema schema;
+    QStringList names;
+    for (int i = 0; i < kWideColumns; ++i) {
+        QForge::Column column;
+        column.name = QString("column_%1").arg(i);
+        schema.columns.append(column);
+        names.append(column.name);
+    }
+    // Без индекса поиск идёт перебором (колонки добавлены напрямую)
+    if (indexed) {
+        schema.rebuildColumnIndex();
+    }
+
+    int found = 0;
+    QBENCHMARK {
+        for (const QString& name : std::as_const(names)) {
+            found += schema.findColumn(name) != nullptr;
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void ModelBenchmarks::editCommit_data()
+{
+    QTest::addColumn<bool>("buffered");
+    QTest::newRow("update per edit") << false;
+    QTest::newRow("edit buffer") << true;
+}
+
+void ModelBenchmarks::editCommit()
+{
+    QFETCH(bool, buffered);
+
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("Драйвер QSQLITE недоступен");
+    }
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench_edits");
+        db.setDatabaseName(":memory:");
+        QVERIFY(db.open());
+        QSqlQuery setup(db);
+        QVERIFY(setup.exec("CREATE TABLE bench (id INTEGER PRIMARY KEY, name TEXT, price REAL, updated_at TEXT)"));
+        QVERIFY(setup.exec(QString("INSERT INTO bench (id) WITH RECURSIVE n(i) AS "
+                                   "(SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < %1) SELECT i FROM n")
+                               .arg(kEditedRows - 1)));
+
+        TableModel edited(getProjectRoot() + "/benchmarks/BenchmarkModel.yml", SqlQueryHandlerFactory::getHandler(&db));
+        QVERIFY2(edited.isValid(), qPrintable(edited.getLastError()));
+        edited.appendRows(generateRows(0, kEditedRows));
+        edited.setEditStrategy(buffered ? TableModel::EditStrategy::OnManualSubmit
+                                        : TableModel::EditStrategy::OnFieldChange);
+
+        // Каждая правка - новое значение, чтобы ни одна не была пропущена как неизменившая ячейку
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK_ONCE {
+            for (int row = 0; row < kEditedRows; ++row) {
+                QVERIFY(edited.setData(edited.index(row, 2), -1.0 - row));
+            }
+            if (buffered) {
+                QVERIFY2(edited.submitAll(), qPrintable(edited.getLastError()));
+            }
+        }
+        const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+        qInfo().noquote() << QString("%1: %2 edited rows/s")
+                                 .arg(QTest::currentDataTag())
+                                 .arg(kEditedRows / seconds, 0, 'f', 0);
+
+        QVERIFY(setup.exec("SELECT COUNT(*) FROM bench WHERE price < 0") && setup.next());
+        QCOMPARE(setup.value(0).toInt(), kEditedRows);
+        setup.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("bench_edits");
+}
+
+void ModelBenchmarks::pasteBlock_data()
+{
+    QTest::addColumn<bool>("block");
+    QTest::newRow("setData per cell") << false;
+    QTest::newRow("setDataBlock") << true;
+}
+
+void ModelBenchmarks::pasteBlock()
+{
+    QFETCH(bool, block);
+
+    TableModel pasted(getProjectRoot() + "/benchmarks/BenchmarkModel.yml", emptyQueryHandler);
+    QVERIFY2(pasted.isValid(), qPrintable(pasted.getLastError()));
+    pasted.appendRows(generateRows(0, kPastedRows * 4));
+    pasted.sort(2, Qt::AscendingOrder);
+
+    // Колонки name и price: цена - колонка сортировки, каждая строка меняет место
+    QList<QVariantList> values;
+    values.reserve(kPastedRows);
+    for (int row = 0; row < kPastedRows; ++row) {
+        values.append({QString("pasted-%1").arg(row), -1.0 - row});
+    }
+
+    QSignalSpy changed(&pasted, &QAbstractItemModel::dataChanged);
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        if (block) {
+            QVERIFY(pasted.setDataBlock(pasted.index(kPastedRows, 1), values));
+        } else {
+            // Как вставка представлением по одной ячейке: каждая цена перемещает строку
+            for (int row = 0; row < kPastedRows; ++row) {
+                for (int column = 0; column < 2; ++column) {
+                    pasted.setData(pasted.index(kPastedRows + row, column + 1), values[row][column]);
+                }
+            }
+        }
+    }
+    const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+    qInfo().noquote() << QString("%1: %2 cells/s, %3 dataChanged")
+                             .arg(QTest::currentDataTag())
+                             .arg(kPastedRows * 2 / seconds, 0, 'f', 0)
+                             .arg(changed.size());
+}
+
+void ModelBenchmarks::exportStore_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::newRow("csv") << QString("csv");
+    QTest::newRow("json") << QString("json");
+    QTest::newRow("xml") << QString("xml");
+}
+
+void ModelBenchmarks::exportStore()
+{
+    QFETCH(QString, format);
+
+    NullDevice device;
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    qint64 bytes = 0;
+    const auto connection = connect(model, &TableModel::exportProgress, this,
+                                    [&bytes](qint64, qint64 written) { bytes = written; });
+    auto body = [&]() {
+        QVERIFY2(model->exportRows(&device, format), qPrintable(model->getLastError()));
+    };
+    QBENCHMARK_ONCE {
+        body();
+    }
+    reportBandwidth(QString("export %1 (%2 rows)").arg(format).arg(model->rowCount()), bytes, 3, body);
+    disconnect(connection);
+}
+
+QString ModelBenchmarks::getProjectRoot()
+{
+    QString projectRoot = QDir::currentPath();
+    // Находим корень проекта, поднимаясь по каталогам до QMetaModel.pro
+    while (!projectRoot.isEmpty() && !QFile::exists(projectRoot + "/QMetaModel.pro")) {
+        QDir dir(projectRoot);
+        if (!dir.cdUp()) break;
+        projectRoot = dir.absolutePath();
+    }
+    return projectRoot;
+}
+
+QList<QVariantMap> ModelBenchmarks::generateRows(int first, int count)
+{
+    QRandomGenerator rng(quint32(first) + 1);
+    const QDateTime base(QDate(2024, 1, 1), QTime(0, 0));
+
+    QList<QVariantMap> rows;
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QVariantMap row;
+        row["id"] = first + i;
+        row["name"] = QString("item-%1").arg(rng.bounded(1000000));
+        row["price"] = rng.bounded(100000.0);
+        row["updated_at"] = base.addSecs(rng.bounded(365 * 24 * 3600));
+        rows.append(row);
+    }
+    return rows;
+}
+
+QByteArray ModelBenchmarks::generateCsv(int rows)
+{
+    // Колонки BenchmarkModel.yml; каждое пятое имя в кавычках с разделителем внутри
+    QRandomGenerator rng(11);
+    const QDateTime base(QDate(2024, 1, 1), QTime(0, 0));
+
+    QByteArray text = "id,name,price,updated_at\n";
+    text.reserve(rows * 64);
+    for (int i = 0; i < rows; ++i) {
+        const QByteArray name = "item-" + QByteArray::number(rng.bounded(1000000));
+        text += QByteArray::number(i) + ',';
+        text += (i % 5 == 0) ? "\"" + name + ", \"\"special\"\"\"" : name;
+        text += ',' + QByteArray::number(rng.bounded(100000.0), 'f', 2) + ',';
+        text += base.addSecs(rng.bounded(365 * 24 * 3600)).toString(Qt::ISODate).toLatin1() + '\n';
+    }
+    return text;
+}
+
+void ModelBenchmarks::addIsaRows()
+{
+    QTest::addColumn<int>("isa");
+    for (int isa = 0; isa <= int(PredicateKernels::supportedIsa()); ++isa) {
+        QTest::newRow(PredicateKernels::isaName(PredicateKernels::Isa(isa))) << isa;
+    }
+}
+
+void ModelBenchmarks::reportThroughput(const QString& label, int rows, const std::function<void()>& body)
+{
+    // QBENCHMARK печатает время итерации; пропускную способность на ядро считаем отдельно
+    const int repeats = 20;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < repeats; ++i) {
+        body();
+    }
+    const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+    qInfo().noquote() << QString("%1: %2 M rows/s per core")
+                             .arg(label)
+                             .arg(double(rows) * repeats / seconds / 1e6, 0, 'f', 0);
+}
+
+void ModelBenchmarks::reportBandwidth(const QString& label, qint64 bytes, int repeats, const std::function<void()>& body)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < repeats; ++i) {
+        body();
+    }
+    const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+    qInfo().noquote() << QString("%1: %2 GB/s").arg(label).arg(double(bytes) * repeats / seconds / 1e9, 0, 'f', 2);
+}
+
+QueryResult ModelBenchmarks::emptyQueryHandler(const QueryContext& context)
+{
+    Q_UNUSED(context)
+
+    QueryResult result;
+    result.ok = true;
+    return result;
+}
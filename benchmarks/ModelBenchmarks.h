@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QtTest>
+
+#include "QueryResult.hpp"
+#include "QueryContext.hpp"
+#include "TableModel.h"
+
+#include <functional>
+
+using QForge::nsModel::QueryContext;
+using QForge::nsModel::QueryResult;
+using QForge::nsModel::TableModel;
+
+/**
+ * @brief Замеры производительности модели на синтетических данных (QBENCHMARK).
+ *
+ * Запуск: ./QMetaModelBenchmarks [-tickcounter | -callgrind] [имя_замера]
+ */
+class ModelBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Сортировка и её поддержание (1M строк)
+    void sortDoubleColumn();
+    void sortStringColumn();
+    void toggleSortDirection();
+    void singleEditSorted();
+    void singleInsertSorted();
+
+    // Ядра предикатов (один поток, 1M значений) и фильтрация модели
+    void int64Kernel_data();
+    void int64Kernel();
+    void doubleKernel_data();
+    void doubleKernel();
+    void filterNumericColumn();
+
+    // CSV: поиск границ строк (один поток) и загрузка файла в колонки (все ядра)
+    void csvRowBoundaries_data();
+    void csvRowBoundaries();
+    void csvIngest();
+
+    // Запуск приложения: создание моделей из файлов схем без кэша и с двоичным кэшем,
+    // по одной в потоке GUI и пакетом через ModelFactory
+    void schemaStartup_data();
+    void schemaStartup();
+    void bulkModelStartup_data();
+    void bulkModelStartup();
+
+    // Поиск колонки по имени в широкой схеме (200 колонок): перебор и хеш-индекс
+    void columnLookup_data();
+    void columnLookup();
+
+    // Запись 10k изменённых строк в SQLite: отдельный UPDATE на правку и один пакет буфера правок
+    void editCommit_data();
+    void editCommit();
+
+    // Вставка блока 5000x2 в отсортированную модель: setData на ячейку и один setDataBlock
+    void pasteBlock_data();
+    void pasteBlock();
+
+    // Потоковая выгрузка 1M строк модели в csv/json/xml (устройство отбрасывает данные)
+    void exportStore_data();
+    void exportStore();
+
+private:
+    QString getProjectRoot();
+    static QList<QVariantMap> generateRows(int first, int count);
+    static QueryResult emptyQueryHandler(const QueryContext& context);
+    static void addIsaRows();
+    static QByteArray generateCsv(int rows);
+    static void reportThroughput(const QString& label, int rows, const std::function<void()>& body);
+    static void reportBandwidth(const QString& label, qint64 bytes, int repeats, const std::function<void()>& body);
+
+    static constexpr int kRowCount = 1000000;
+    static constexpr int kStartupModels = 80;
+    static constexpr int kWideColumns = 200;
+    static constexpr int kEditedRows = 10000;
+    static constexpr int kPastedRows = 5000;
+
+    TableModel* model = nullptr;
+    int nextId = kRowCount;
+};
@@ -0,0 +1,6 @@
+SOURCES += \
+    $$PWD/main.cpp \
+    $$PWD/ModelBenchmarks.cpp
+
+HEADERS += \
+    $$PWD/ModelBenchmarks.h
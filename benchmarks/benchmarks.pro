@@ -0,0 +1,32 @@
+QT += core testlib concurrent sql
+
+CONFIG += console c++17
+TEMPLATE = app
+TARGET = QMetaModelBenchmarks
+
+include(benchmarks.pri)
+
+# Путь к заголовкам библиотеки
+INCLUDEPATH += $$PWD/../src $$PWD/../src/private
+
+# yaml-cpp integration (копируем из tests.pro)
+DEFINES += YAML_CPP_STATIC_DEFINE
+INCLUDEPATH += $$PWD/../external/yaml-cpp/include
+
+win32 {
+    LIBS += $$PWD/../build/external/yaml-cpp-win/libyaml-cpp.a
+    QMAKE_LFLAGS += -Wl,--allow-multiple-definition
+} else {
+    LIBS += $$PWD/../build/external/yaml-cpp/libyaml-cpp.a
+}
+
+# Путь к собранной библиотеке
+unix {
+    LIBS += $$PWD/../src/libQMetaModel.so
+} else {
+    contains(CONFIG, debug, debug|release) {
+        LIBS += -L$$OUT_PWD/../src/debug -lQMetaModel
+    } else {
+        LIBS += -L$$OUT_PWD/../src/release -lQMetaModel
+    }
+}
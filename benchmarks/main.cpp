@@ -0,0 +1,14 @@
+#include <QCoreApplication>
+#include <QtTest>
+
+#include "ModelBenchmarks.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int status = 0;
+    status |= QTest::qExec(new ModelBenchmarks, argc, argv);
+
+    return status;
+}
@@ -1,13 +1,12 @@
 #pragma once
 
 #include <QString>
-#include <QFile>
-#include <QTextStream>
 #include <QDebug>
-#include <QDateTime>
 #include "QueryHandler.hpp"
 #include "QueryResult.hpp"
 #include "QueryContext.hpp"
+#include "private/CsvFileSource.h"
+#include "private/ModelSchema.h"
 
 namespace QForge {
 namespace nsModel {
@@ -15,25 +14,20 @@ namespace nsModel {
 class CsvQueryHandler
 {
 public:
-    explicit CsvQueryHandler(const QString& csvFilePath);
+    // Типы колонок и формат файла (import_settings) берутся из схемы модели
+    CsvQueryHandler(const QString& csvFilePath, const ModelSchema& schema);
     
     // Главный обработчик запросов
     QueryResult operator()(const QueryContext& context);
     
-private:
-    QString csvPath;
-    QList<QVariantMap> csvData;
-    QStringList headers;
-    
-    // Загрузка данных из CSV
-    bool loadCsvData();
+    // Источник строк: дочитывает дописанные в файл строки и сообщает о них
+    CsvFileSource* source() { return &csvSource; }
     
-    // Парсинг значения в зависимости от типа
-    QVariant parseValue(const QString& value, const QString& header);
+private:
+    Q_DISABLE_COPY(CsvQueryHandler)
     
-    // Применение фильтра
-    QList<QVariantMap> applyFilter(const QString& filterExpression);
+    CsvFileSource csvSource;
 };
 
 } // namespace nsModel
-} // namespace QForge
\ No newline at end of file
+} // namespace QForge
@@ -1,6 +1,8 @@
 #include "ProductWidget.h"
 #include "CsvQueryHandler.h"
 #include "../../src/TableModel.h"
+#include "private/CsvFileSource.h"
+#include "private/ModelCore.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -53,7 +55,9 @@ ProductWidget::ProductWidget(QWidget *parent)
     
     qDebug() << "Files exist, creating handler...";
     
-    auto csvHandler = std::make_shared<QForge::nsModel::CsvQueryHandler>(csvPath);
+    // Обработчику нужна схема: по ней выбираются разборщики колонок CSV
+    const QForge::nsModel::ModelCore schemaCore(schemaPath);
+    auto csvHandler = std::make_shared<QForge::nsModel::CsvQueryHandler>(csvPath, schemaCore.getSchema());
     
     // Создаем функцию-обертку для обработчика
     QForge::nsModel::QueryHandler handler = [csvHandler](const QForge::nsModel::QueryContext& ctx) {
@@ -76,6 +80,7 @@ ProductWidget::ProductWidget(QWidget *parent)
     qDebug() << "Model is valid!";
     
     tableView->setModel(model);
+    followCsv(csvHandler->source());
     
     // Подключаем сигналы асинхронного выполнения (старый синтаксис для совместимости)
     connect(model, SIGNAL(executionStarted(QUuid)), this, SLOT(onQueryStarted(QUuid)));
@@ -160,8 +165,29 @@ void ProductWidget::connectSignals()
     connect(categoryCombo, &QComboBox::currentTextChanged, this, &ProductWidget::onCategoryFilterChanged);
 }
 
+void ProductWidget::followCsv(QForge::nsModel::CsvFileSource* source)
+{
+    using QForge::nsModel::CsvFileSource;
+    
+    // Дописанные в файл строки добавляются в таблицу без перечитывания файла
+    connect(source, &CsvFileSource::rowsAppended, model, [this, source](int first, int count) {
+        if (showingAll) {
+            model->appendRows(source->rows(first, count));
+            statusLabel->setText(QString("Добавлено записей из файла: %1").arg(count));
+        }
+    });
+    // Файл переписан - загружаем заново
+    connect(source, &CsvFileSource::reloaded, model, [this] {
+        if (showingAll) {
+            model->execute("load_all");
+        }
+    });
+    source->setWatching(true);
+}
+
 void ProductWidget::onLoadAllClicked()
 {
+    showingAll = true;
     statusLabel->setText("Загрузка всех данных...");
     
     // Полная блокировка интерфейса
@@ -174,6 +200,7 @@ void ProductWidget::onLoadAllClicked()
 
 void ProductWidget::onFilterInStockClicked()
 {
+    showingAll = false;
     statusLabel->setText("Фильтрация по наличию...");
     
     // Полная блокировка интерфейса
@@ -189,6 +216,7 @@ void ProductWidget::onCategoryFilterChanged(const QString& category)
     if (category == "Все") {
         onLoadAllClicked();
     } else {
+        showingAll = false;
         statusLabel->setText(QString("Фильтрация по категории '%1'...").arg(category));
         
         // Полная блокировка интерфейса
@@ -205,6 +233,8 @@ void ProductWidget::onCategoryFilterChanged(const QString& category)
 
 void ProductWidget::onRefreshClicked()
 {
+    showingAll = true;
+    
     // Перезагружаем CSV файл и пересоздаем модель для обновления схемы
     if (model) {
         model->deleteLater();
@@ -225,7 +255,8 @@ void ProductWidget::onRefreshClicked()
     QString csvPath = projectRoot + "/examples/csv_demo/products.csv";
     QString schemaPath = projectRoot + "/examples/csv_demo/ProductModel.yml";
     
-    auto csvHandler = std::make_shared<QForge::nsModel::CsvQueryHandler>(csvPath);
+    const QForge::nsModel::ModelCore schemaCore(schemaPath);
+    auto csvHandler = std::make_shared<QForge::nsModel::CsvQueryHandler>(csvPath, schemaCore.getSchema());
     QForge::nsModel::QueryHandler handler = [csvHandler](const QForge::nsModel::QueryContext& ctx) {
         return (*csvHandler)(ctx);
     };
@@ -234,6 +265,7 @@ void ProductWidget::onRefreshClicked()
     
     if (model->isValid()) {
         tableView->setModel(model);
+        followCsv(csvHandler->source());
         
         // Подключаем сигналы асинхронного выполнения (старый синтаксис для совместимости)
         connect(model, SIGNAL(executionStarted(QUuid)), this, SLOT(onQueryStarted(QUuid)));
@@ -13,6 +13,7 @@
 namespace QForge {
 namespace nsModel {
     class TableModel;
+    class CsvFileSource;
 }
 }
 
@@ -39,6 +40,7 @@ public slots:
 private:
     void setupUi();
     void connectSignals();
+    void followCsv(QForge::nsModel::CsvFileSource* source);
     
     // UI элементы
     QTableView* tableView;
@@ -52,4 +54,5 @@ private:
     
     // Модель
     QForge::nsModel::TableModel* model;
+    bool showingAll = true; // В таблице все строки файла (а не результат фильтра)
 };
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "ModelFactory.h"
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QUuid>
+#include <QtConcurrent>
+
+#include "HandlerRegistry.h"
+#include "TableModel.h"
+#include "private/ModelSchema.h"
+#include "private/SchemaCache.h"
+#include "private/SchemaRegistry.h"
+
+namespace QForge {
+namespace nsModel {
+
+struct ModelFactory::State
+{
+    struct Item
+    {
+        QString path;
+        std::shared_ptr<const ModelSchema> schema;
+        QStringList errors;
+        TableModel* model = nullptr;
+        QUuid load; //!< Загрузочный запрос модели (executeAsync).
+        QMetaObject::Connection finished;
+        QMetaObject::Connection failed;
+    };
+
+    QVector<Item> items;
+    QFutureWatcher<void> parseWatcher;
+    QElapsedTimer clock;
+    qint64 phaseStart = 0;
+    Timings timings;
+    QueryHandler handler;
+    int pending = 0;
+    bool running = false;
+
+    qint64 lap() {
+        const qint64 now = clock.elapsed();
+        const qint64 phase = now - phaseStart;
+        phaseStart = now;
+        return phase;
+    }
+};
+
+ModelFactory::ModelFactory(const QueryHandler& handler, QObject* parent)
+    : QObject(parent)
+    , handler(handler)
+    , state(std::make_unique<State>())
+{
+    connect(&state->parseWatcher, &QFutureWatcher<void>::finished, this, &ModelFactory::onParsed);
+}
+
+ModelFactory::~ModelFactory()
+{
+    // Разбор идёт по state->items: дожидаемся его до удаления состояния
+    state->parseWatcher.waitForFinished();
+}
+
+bool ModelFactory::create(const QStringList& configPaths)
+{
+    if (state->running) {
+        return false;
+    }
+
+    // Не забранные модели предыдущего вызова удаляются
+    for (const State::Item& item : state->items) {
+        delete item.model;
+    }
+    state->items.clear();
+    state->timings = Timings();
+    state->pending = 0;
+    state->handler = handler ? handler : HandlerRegistry::defaultHandler();
+    state->running = true;
+
+    state->items.reserve(configPaths.size());
+    for (const QString& path : configPaths) {
+        State::Item item;
+        item.path = path;
+        state->items.append(item);
+    }
+
+    // Фаза 1: разбор и проверка схем в пуле потоков; один файл разбирается один раз
+    state->clock.start();
+    state->phaseStart = 0;
+    state->parseWatcher.setFuture(QtConcurrent::map(state->items, [](State::Item& item) {
+        item.schema = SchemaRegistry::instance().acquire(item.path, &item.errors);
+    }));
+    return true;
+}
+
+bool ModelFactory::isRunning() const
+{
+    return state->running;
+}
+
+void ModelFactory::setSchemaCacheDirectory(const QString& path)
+{
+    SchemaCache::setDirectory(path);
+}
+
+QList<TableModel*> ModelFactory::models() const
+{
+    QList<TableModel*> result;
+    result.reserve(state->items.size());
+    for (const State::Item& item : state->items) {
+        result.append(item.model);
+    }
+    return result;
+}
+
+QList<TableModel*> ModelFactory::takeModels()
+{
+    if (state->running) {
+        return {};
+    }
+
+    QList<TableModel*> result = models();
+    for (State::Item& item : state->items) {
+        if (item.model) {
+            QObject::disconnect(item.finished);
+            QObject::disconnect(item.failed);
+            item.model->setParent(nullptr);
+            item.model = nullptr;
+        }
+    }
+    return result;
+}
+
+QStringList ModelFactory::errors() const
+{
+    QStringList result;
+    for (const State::Item& item : state->items) {
+        for (const QString& error : item.errors) {
+            result.append(QString("%1: %2").arg(item.path, error));
+        }
+    }
+    return result;
+}
+
+ModelFactory::Timings ModelFactory::timings() const
+{
+    return state->timings;
+}
+
+void ModelFactory::onParsed()
+{
+    state->timings.parseMs = state->lap();
+
+    // Фаза 2: модели создаются в потоке фабрики; схемы уже в реестре
+    for (State::Item& item : state->items) {
+        if (!item.schema) {
+            continue;
+        }
+        item.model = new TableModel(item.path, state->handler, this);
+        if (!item.model->isValid()) {
+            item.errors.append(item.model->getLastError());
+            delete item.model;
+            item.model = nullptr;
+        }
+    }
+    state->timings.constructMs = state->lap();
+
+    // Фаза 3: все загрузочные запросы запускаются сразу
+    for (State::Item& item : state->items) {
+        if (!item.model || item.schema->source != DataSource::Query) {
+            continue;
+        }
+        TableModel* model = item.model;
+        const QUuid load = model->executeAsync(item.schema->loadQuery);
+        item.load = load;
+        item.finished = connect(model, &TableModel::executionFinished, this, [this, model, load](const QUuid& id) {
+            if (id == load) {
+                onLoaded(model, QString());
+            }
+        });
+        item.failed = connect(model, &TableModel::executionFailed, this,
+                              [this, model, load](const QUuid& id, const QString& error) {
+            if (id == load) {
+                onLoaded(model, error);
+            }
+        });
+        ++state->pending;
+    }
+
+    if (state->pending == 0) {
+        finish();
+    }
+}
+
+void ModelFactory::onLoaded(TableModel* model, const QString& error)
+{
+    for (State::Item& item : state->items) {
+        if (item.model != model) {
+            continue;
+        }
+        QObject::disconnect(item.finished);
+        QObject::disconnect(item.failed);
+        if (!error.isEmpty()) {
+            item.errors.append(error);
+        }
+    }
+
+    if (--state->pending == 0) {
+        finish();
+    }
+}
+
+void ModelFactory::finish()
+{
+    state->timings.loadMs = state->lap();
+    state->timings.totalMs = state->clock.elapsed();
+    state->running = false;
+    emit finished();
+}
+
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+#include <memory>
+
+#include "QueryHandler.hpp"
+
+namespace QForge {
+namespace nsModel {
+
+class TableModel;
+
+/**
+ * @brief Пакетное создание моделей при запуске приложения.
+ *
+ * create() разбирает и проверяет файлы схем параллельно (общий SchemaRegistry),
+ * затем создаёт модели в потоке фабрики и сразу запускает все загрузочные запросы
+ * (load_query) через executeAsync: обработчик вызывается для них одновременно
+ * из пула потоков и должен это допускать. Когда завершится последний запрос,
+ * испускается один сигнал finished(). Длительность каждой фазы - в timings().
+ */
+class ModelFactory : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief Длительность фаз последнего create(), мс.
+     */
+    struct Timings
+    {
+        qint64 parseMs = 0;     //!< Разбор и проверка схем (параллельно).
+        qint64 constructMs = 0; //!< Создание моделей.
+        qint64 loadMs = 0;      //!< Загрузочные запросы (одновременно).
+        qint64 totalMs = 0;
+    };
+
+    /*!
+     * \brief Пустой обработчик - HandlerRegistry::defaultHandler().
+     */
+    explicit ModelFactory(const QueryHandler& handler = {}, QObject* parent = nullptr);
+    ~ModelFactory() override;
+
+    /*!
+     * \brief Запускает создание моделей по файлам схем.
+     * \return false, если предыдущий create() ещё не завершился.
+     */
+    bool create(const QStringList& configPaths);
+    bool isRunning() const;
+
+    /*!
+     * \brief Включает двоичный кэш разобранных схем в каталоге path (например,
+     * <QStandardPaths::CacheLocation>/qforge-schemas); пустая строка выключает его.
+     * \details По умолчанию кэш выключен. Действует на все модели процесса.
+     */
+    static void setSchemaCacheDirectory(const QString& path);
+
+    /*!
+     * \brief Модели в порядке путей; nullptr на месте файла с ошибкой.
+     * \details Модели принадлежат фабрике, пока их не забрали takeModels() (после finished()).
+     */
+    QList<TableModel*> models() const;
+    QList<TableModel*> takeModels();
+
+    /*!
+     * \brief Ошибки разбора и загрузки в виде "путь: ошибка".
+     */
+    QStringList errors() const;
+    Timings timings() const;
+
+signals:
+    void finished();
+
+private:
+    struct State;
+
+    void onParsed();
+    void onLoaded(TableModel* model, const QString& error);
+    void finish();
+
+    QueryHandler handler;
+    std::unique_ptr<State> state;
+};
+
+}
+
+}
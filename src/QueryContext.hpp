@@ -1,7 +1,10 @@
 #ifndef QUERYCONTEXT_HPP
 #define QUERYCONTEXT_HPP
 
+#include <QList>
 #include <QString>
+#include <QStringList>
+#include <QVariant>
 #include <QVariantMap>
 
 namespace QForge
@@ -9,6 +12,53 @@ namespace QForge
 
 namespace nsModel {
 
+/**
+ * @brief Условие фильтра модели над одной колонкой
+ */
+struct QueryPredicate
+{
+    QString column; //!< Имя колонки.
+    QString op; //!< "=", "!=", "<", "<=", ">", ">=", "between", "in", "contains", "starts_with", "is_null", "is_not_null".
+    QVariant value; //!< Значение (нижняя граница для between, QVariantList для in).
+    QVariant upperValue; //!< Верхняя граница для between.
+    bool caseInsensitive = false; //!< Строковое сравнение без учёта регистра.
+};
+
+/**
+ * @brief Группа условий, объединённых через AND (matchAll) или OR
+ */
+struct QueryPredicateGroup
+{
+    bool matchAll = true;
+    QList<QueryPredicate> predicates;
+};
+
+/**
+ * @brief Фильтр модели, который обработчик может выполнить на своей стороне.
+ *
+ * Группы объединяются через AND (matchAll) или OR. Обработчик, выполнивший
+ * фильтр, сообщает об этом через QueryResult::filterApplied; иначе модель
+ * фильтрует полученные строки сама.
+ */
+struct QueryFilter
+{
+    bool matchAll = true;
+    QList<QueryPredicateGroup> groups;
+
+    bool isEmpty() const { return groups.isEmpty(); }
+};
+
+/**
+ * @brief Шаг пакетной записи: один запрос, выполняемый для каждого набора аргументов
+ */
+struct QueryBatchStep
+{
+    QString queryName; //!< Название запроса схемы.
+    QString sql; //!< Содержание запроса.
+    QList<QVariantMap> bindings; //!< Аргументы для каждого выполнения (одинаковый набор ключей).
+    QStringList returning; //!< Колонки, сгенерированные источником (ключ добавленной строки): по строке на выполнение в QueryResult::rows.
+};
+
 /**
  * @brief Контекст запроса, передаваемый в пользовательский обработчик
  */
@@ -17,6 +67,9 @@ struct QueryContext
     QString queryName; //!< Название запроса.
     QString sql; //!< Содержание запроса (вместе со всеми :placeholders).
     QVariantMap bindings; //!< Аргументы.
+    QueryFilter filter; //!< Фильтр модели для выполнения на стороне источника (может быть пуст).
+    QList<QueryBatchStep> batch; //!< Пакет записи (сохранение правок модели); если не пуст, sql и bindings не заданы.
+    bool transactional = false; //!< Выполнить весь пакет в одной транзакции.
 };
 
 }
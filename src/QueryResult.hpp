@@ -16,6 +16,8 @@ struct QueryResult
     bool ok; //!< Флаг успешного завершения.
     QList<QVariantMap> rows; //!< Ответ (строки).
     QStringList errors_log; //!< Лог ошибок.
+    bool filterApplied = false; //!< Обработчик выполнил QueryContext::filter сам.
+    int completedSteps = 0; //!< Шаги пакета, записанные в источник (и при ok == false, если пакет не откатан).
 
     inline void log(const QString& error) { errors_log.append(error); }
 };
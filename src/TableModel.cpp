@@ -4,6 +4,9 @@
 #include "private/ModelSchema.h"
 #include <QDebug>
 
+#include <algorithm>
+#include <type_traits>
+
 namespace QForge {
 namespace nsModel {
 
@@ -115,7 +118,7 @@ int TableModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent)
     Q_D(const TableModel);
-    return d->modelData.size();
+    return d->rowCount();
 }
 
 int TableModel::columnCount(const QModelIndex& parent) const
@@ -128,25 +131,105 @@ int TableModel::columnCount(const QModelIndex& parent) const
     return d->schema->columns.size();
 }
 
-QVariant TableModel::data(const QModelIndex& index, int role) const
+QString TableModel::columnName(int column) const
 {
     Q_D(const TableModel);
     
-    if (!index.isValid() || index.row() >= d->modelData.size()) {
-        return QVariant();
+    if (!d->schema || column < 0 || column >= d->schema->columns.size()) {
+        return QString();
+    }
+    return d->schema->columns[column].name;
+}
+
+int TableModel::columnIndex(const QString& name) const
+{
+    Q_D(const TableModel);
+    return d->store.columnIndex(name);
+}
+
+template <typename T>
+std::optional<T> TableModel::typedValue(int row, int column) const
+{
+    Q_D(const TableModel);
+    
+    if (row < 0 || row >= d->rowCount() || column < 0 || column >= d->store.columnCount()) {
+        return std::nullopt;
+    }
+    const TypedColumn& typed = d->store.column(column);
+    const int source = d->sourceRow(row);
+    if (typed.isNull(source)) {
+        return std::nullopt;
     }
     
-    const QVariantList& row = d->modelData[index.row()];
-    if (index.column() >= row.size()) {
-        return QVariant();
+    // Представление хранилища совпадает с T - значение читается из массива напрямую
+    const bool ints = typed.kind == StorageKind::Int64;
+    if constexpr (std::is_same_v<T, qint64>) {
+        if (ints && typed.type == ColumnType::Integer) {
+            return typed.ints[source];
+        }
+    } else if constexpr (std::is_same_v<T, bool>) {
+        if (ints && typed.type == ColumnType::Boolean) {
+            return typed.ints[source] != 0;
+        }
+    } else if constexpr (std::is_same_v<T, QDate>) {
+        if (ints && typed.type == ColumnType::Date) {
+            return QDate::fromJulianDay(typed.ints[source]);
+        }
+    } else if constexpr (std::is_same_v<T, QTime>) {
+        if (ints && typed.type == ColumnType::Time) {
+            return QTime::fromMSecsSinceStartOfDay(int(typed.ints[source]));
+        }
+    } else if constexpr (std::is_same_v<T, QDateTime>) {
+        if (ints && typed.type == ColumnType::DateTime) {
+            return QDateTime::fromMSecsSinceEpoch(typed.ints[source]);
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        if (typed.kind == StorageKind::Double) {
+            return typed.doubles[source];
+        }
+    } else if constexpr (std::is_same_v<T, QString>) {
+        if (typed.kind == StorageKind::String) {
+            return typed.strings[source];
+        }
+    }
+    
+    // Колонка другого типа (например, после смены схемы) - через QVariant
+    const QVariant value = typed.value(source);
+    if constexpr (std::is_same_v<T, QVariant>) {
+        return value;
+    } else {
+        if (!value.canConvert<T>()) {
+            return std::nullopt;
+        }
+        return value.value<T>();
     }
+}
+
+template std::optional<qint64> TableModel::typedValue<qint64>(int, int) const;
+template std::optional<double> TableModel::typedValue<double>(int, int) const;
+template std::optional<bool> TableModel::typedValue<bool>(int, int) const;
+template std::optional<QString> TableModel::typedValue<QString>(int, int) const;
+template std::optional<QDate> TableModel::typedValue<QDate>(int, int) const;
+template std::optional<QTime> TableModel::typedValue<QTime>(int, int) const;
+template std::optional<QDateTime> TableModel::typedValue<QDateTime>(int, int) const;
+template std::optional<QUuid> TableModel::typedValue<QUuid>(int, int) const;
+template std::optional<QByteArray> TableModel::typedValue<QByteArray>(int, int) const;
+template std::optional<QVariant> TableModel::typedValue<QVariant>(int, int) const;
+
+QVariant TableModel::data(const QModelIndex& index, int role) const
+{
+    Q_D(const TableModel);
     
-    const QVariant& value = row[index.column()];
+    if (!index.isValid() || index.row() >= d->rowCount() || index.column() >= d->store.columnCount()) {
+        return QVariant();
+    }
     
     switch (role) {
         case Qt::DisplayRole:
+            return d->lookupDisplay(d->store.value(d->sourceRow(index.row()), index.column()), index.column());
+            
         case Qt::EditRole:
-            return d->processColumnValue(value, index.column());
+            return d->processColumnValue(d->store.value(d->sourceRow(index.row()), index.column()), index.column());
             
         case Qt::ToolTipRole:
             if (d->schema && index.column() < d->schema->columns.size()) {
@@ -257,7 +340,7 @@ bool TableModel::setData(const QModelIndex& index, const QVariant& value, int ro
         return false;
     }
     
-    if (index.row() >= d->modelData.size() || index.column() >= d->modelData[index.row()].size()) {
+    if (index.row() >= d->rowCount() || index.column() >= d->store.columnCount()) {
         return false;
     }
     
@@ -278,10 +361,255 @@ bool TableModel::setData(const QModelIndex& index, const QVariant& value, int ro
         }
     }
     
-    d->modelData[index.row()][index.column()] = value;
-    emit dataChanged(index, index, {role});
+    const int source = d->sourceRow(index.row());
+    QVariant before;
+    if (d->editStrategy != EditStrategy::LocalOnly || d->journal.isEnabled()) {
+        before = d->store.value(source, index.column());
+    }
+    if (!d->store.setValue(source, index.column(), value)) {
+        return true;
+    }
+    d->recordEdit(source, index.column(), before);
+    d->journal.beginStep();
+    d->journal.recordCell(source, index.column(), before, d->store.value(source, index.column()));
+    d->journal.endStep();
+    
+    // Пересчитываются только вычисляемые колонки, зависящие от изменённой; изменённая ячейка
+    // и зависимые объявляются одним dataChanged по охватывающему диапазону строки
+    QVector<int> changed = d->recalculateDependents(source, index.column());
+    d->loadLookups(source, 1);
+    changed.append(index.column());
+    const auto [first, last] = std::minmax_element(changed.cbegin(), changed.cend());
+    if (changed.size() == 1) {
+        emit dataChanged(index, index, {role});
+    } else {
+        emit dataChanged(this->index(index.row(), *first), this->index(index.row(), *last));
+    }
+    
+    // Перемещаем строку на новое место или скрываем её вместо пересортировки и перефильтрации
+    d->rowChanged(index.row(), changed);
+    
+    return d->submitOnFieldChange();
+}
+
+bool TableModel::setDataBlock(const QModelIndex& topLeft, const QList<QVariantList>& block)
+{
+    Q_D(TableModel);
+    
+    // Индекс другой модели (в том числе прокси) - не координаты этой
+    if (!checkIndex(topLeft, CheckIndexOption::IndexIsValid)) {
+        return false;
+    }
+    
+    QVector<CellValue> cells;
+    for (int i = 0; i < block.size(); ++i) {
+        for (int j = 0; j < block[i].size(); ++j) {
+            cells.append({topLeft.row() + i, topLeft.column() + j, block[i][j]});
+        }
+    }
+    
+    // Весь блок - один шаг отмены
+    d->journal.beginStep();
+    const bool ok = d->setCells(cells);
+    d->journal.endStep();
+    return ok;
+}
+
+bool TableModel::setDataCells(const QList<QPair<QModelIndex, QVariant>>& cells)
+{
+    Q_D(TableModel);
+    
+    QVector<CellValue> values;
+    values.reserve(cells.size());
+    for (const auto& [index, value] : cells) {
+        if (!checkIndex(index, CheckIndexOption::IndexIsValid)) {
+            return false;
+        }
+        values.append({index.row(), index.column(), value});
+    }
     
-    return true;
+    d->journal.beginStep();
+    const bool ok = d->setCells(values);
+    d->journal.endStep();
+    return ok;
+}
+
+bool TableModel::removeRows(int row, int count, const QModelIndex& parent)
+{
+    Q_D(TableModel);
+    
+    if (!d->schema || parent.isValid() || row < 0 || count <= 0 || row + count > d->rowCount()) {
+        return false;
+    }
+    
+    QVector<int> sources;
+    sources.reserve(count);
+    d->journal.beginStep();
+    for (int i = row; i < row + count; ++i) {
+        sources.append(d->sourceRow(i));
+        d->recordRemoval(sources.last());
+        if (d->journal.isEnabled()) {
+            d->journal.recordRow(sources.last(), d->rowValues(sources.last()), false);
+        }
+    }
+    d->journal.endStep();
+    d->removeSourceRows(sources);
+    
+    return d->submitOnFieldChange();
+}
+
+void TableModel::appendRows(const QList<QVariantMap>& rows)
+{
+    Q_D(TableModel);
+    
+    if (!d->schema) {
+        return;
+    }
+    
+    const int first = d->store.rowCount();
+    d->appendRows(rows);
+    if (d->journal.isEnabled()) {
+        d->journal.beginStep();
+        for (int i = 0; i < rows.size(); ++i) {
+            d->journal.recordRow(first + i, d->rowValues(first + i), true);
+        }
+        d->journal.endStep();
+    }
+    if (d->editStrategy == EditStrategy::LocalOnly) {
+        return;
+    }
+    for (int i = 0; i < rows.size(); ++i) {
+        d->edits.recordInsert(first + i);
+    }
+    d->submitOnFieldChange();
+}
+
+void TableModel::setEditStrategy(EditStrategy strategy)
+{
+    Q_D(TableModel);
+    
+    if (strategy == EditStrategy::LocalOnly) {
+        d->edits.clear();
+    }
+    d->editStrategy = strategy;
+}
+
+TableModel::EditStrategy TableModel::editStrategy() const
+{
+    Q_D(const TableModel);
+    return d->editStrategy;
+}
+
+bool TableModel::submitAll()
+{
+    Q_D(TableModel);
+    return d->submitEdits();
+}
+
+void TableModel::revertAll()
+{
+    Q_D(TableModel);
+    d->revertEdits();
+}
+
+bool TableModel::isDirty() const
+{
+    Q_D(const TableModel);
+    return !d->edits.isEmpty();
+}
+
+bool TableModel::isDirty(const QModelIndex& index) const
+{
+    Q_D(const TableModel);
+    
+    if (!index.isValid() || index.row() >= d->rowCount() || index.column() >= d->store.columnCount()) {
+        return false;
+    }
+    return d->edits.isModified(d->sourceRow(index.row()), d->schema->columns[index.column()].name);
+}
+
+void TableModel::setUndoEnabled(bool enabled)
+{
+    Q_D(TableModel);
+    
+    if (enabled != d->journal.isEnabled()) {
+        d->journal.setEnabled(enabled, d->store.rowCount());
+    }
+}
+
+bool TableModel::isUndoEnabled() const
+{
+    Q_D(const TableModel);
+    return d->journal.isEnabled();
+}
+
+void TableModel::setUndoLimit(int steps)
+{
+    Q_D(TableModel);
+    d->journal.setLimit(steps);
+}
+
+bool TableModel::canUndo() const
+{
+    Q_D(const TableModel);
+    return d->journal.canUndo();
+}
+
+bool TableModel::canRedo() const
+{
+    Q_D(const TableModel);
+    return d->journal.canRedo();
+}
+
+bool TableModel::undo()
+{
+    Q_D(TableModel);
+    return d->applyJournalStep(false);
+}
+
+bool TableModel::redo()
+{
+    Q_D(TableModel);
+    return d->applyJournalStep(true);
+}
+
+void TableModel::clearUndo()
+{
+    Q_D(TableModel);
+    d->journal.clear();
+}
+
+bool TableModel::exportRows(QIODevice* device, const QString& format)
+{
+    Q_D(TableModel);
+    return d->exportRows(device, format);
+}
+
+bool TableModel::exportQuery(QIODevice* device, const QString& query, const QVariantMap& params, const QString& format)
+{
+    Q_D(TableModel);
+    return d->exportQuery(device, query, params, format);
+}
+
+void TableModel::cancelExport()
+{
+    Q_D(TableModel);
+    d->exportCancelled = true;
+}
+
+bool TableModel::submit()
+{
+    Q_D(TableModel);
+    return d->editStrategy == EditStrategy::OnManualSubmit || d->submitEdits();
+}
+
+void TableModel::revert()
+{
+    Q_D(TableModel);
+    
+    if (d->editStrategy != EditStrategy::OnManualSubmit) {
+        d->revertEdits();
+    }
 }
 
 Qt::ItemFlags TableModel::flags(const QModelIndex& index) const
@@ -305,6 +633,157 @@ Qt::ItemFlags TableModel::flags(const QModelIndex& index) const
     return flags;
 }
 
+void TableModel::sort(int column, Qt::SortOrder order)
+{
+    Q_D(TableModel);
+    
+    if (!d->schema || !d->schema->isSortingEnabled || column < 0 || column >= d->schema->columns.size()) {
+        return;
+    }
+    
+    const ::QForge::Column& schemaColumn = d->schema->columns[column];
+    if (!schemaColumn.isSortable) {
+        return;
+    }
+    
+    ::QForge::SortRule rule;
+    rule.columnName = schemaColumn.name;
+    rule.order = (order == Qt::AscendingOrder) ? ::QForge::SortOrder::Ascending : ::QForge::SortOrder::Descending;
+    
+    QVector<::QForge::SortRule> rules = {rule};
+    
+    // При многоколоночной сортировке выбранная колонка становится главной, остальные сохраняются
+    if (d->schema->isMultiColumnSortingEnabled) {
+        for (const ::QForge::SortRule& previous : d->sortRules) {
+            if (previous.columnName != rule.columnName) {
+                rules.append(previous);
+            }
+        }
+    }
+    for (int i = 0; i < rules.size(); ++i) {
+        rules[i].priority = i;
+    }
+    
+    d->applySort(rules);
+}
+
+void TableModel::setSortRules(const QVector<::QForge::SortRule>& rules)
+{
+    Q_D(TableModel);
+    
+    if (!d->schema) {
+        return;
+    }
+    
+    d->applySort(rules);
+}
+
+QVector<::QForge::SortRule> TableModel::sortRules() const
+{
+    Q_D(const TableModel);
+    return d->sortRules;
+}
+
+bool TableModel::setFilter(const ::QForge::Filter& filter)
+{
+    Q_D(TableModel);
+    return d->applyFilter(filter);
+}
+
+::QForge::Filter TableModel::filter() const
+{
+    Q_D(const TableModel);
+    return d->filter;
+}
+
+bool TableModel::setColumnFilter(const QString& columnName, const QVariant& value)
+{
+    Q_D(TableModel);
+    
+    // Правило колонки заменяется на равенство; невалидное значение снимает его
+    ::QForge::Filter filter = d->filter;
+    filter.rules.erase(std::remove_if(filter.rules.begin(), filter.rules.end(),
+                                      [&columnName](const ::QForge::FilterRule& rule) {
+                                          return rule.columnName == columnName;
+                                      }),
+                       filter.rules.end());
+    if (value.isValid()) {
+        ::QForge::FilterRule rule;
+        rule.columnName = columnName;
+        rule.value = value;
+        filter.rules.append(rule);
+    }
+    
+    return d->applyFilter(filter);
+}
+
+void TableModel::clearFilter()
+{
+    Q_D(TableModel);
+    d->applyFilter(::QForge::Filter());
+}
+
+bool TableModel::isFilterPushedDown() const
+{
+    Q_D(const TableModel);
+    return d->isFiltered() && d->filterPushedDown;
+}
+
+QVariantMap TableModel::filterPushDownStats() const
+{
+    Q_D(const TableModel);
+    
+    QVariantMap stats;
+    for (auto it = d->filterPushDowns.constBegin(); it != d->filterPushDowns.constEnd(); ++it) {
+        stats.insert(it.key(), QVariantMap{{"pushed_down", it->pushedDown}, {"local", it->local}});
+    }
+    return stats;
+}
+
+void TableModel::resetFilterPushDownStats()
+{
+    Q_D(TableModel);
+    d->filterPushDowns.clear();
+}
+
+bool TableModel::reloadSchema()
+{
+    Q_D(TableModel);
+    return d->reloadSchema(true);
+}
+
+void TableModel::setSchemaWatching(bool enabled)
+{
+    Q_D(TableModel);
+    d->setSchemaWatching(enabled && d->isInitialized);
+}
+
+bool TableModel::isSchemaWatching() const
+{
+    Q_D(const TableModel);
+    return d->schemaWatcher != nullptr;
+}
+
+void TableModel::invalidateLookups()
+{
+    Q_D(TableModel);
+    
+    QStringList tables;
+    for (const auto& lookup : std::as_const(d->lookups)) {
+        if (lookup && !tables.contains(lookup->table)) {
+            tables.append(lookup->table);
+        }
+    }
+    for (const QString& table : std::as_const(tables)) {
+        LookupCache::instance().invalidate(table);
+    }
+}
+
+void TableModel::invalidateLookup(const QString& referenceTable)
+{
+    LookupCache::instance().invalidate(referenceTable);
+}
+
 QString TableModel::validateValue(const QVariant& value, const QForge::Column& column) const
 {
     const QForge::Validator& validator = column.validator;
@@ -344,8 +823,13 @@ QString TableModel::validateValue(const QVariant& value, const QForge::Column& c
         
         case QForge::ValidatorType::Regexp: {
             QString strValue = value.toString();
-            QRegularExpression regex(validator.pattern);
-            if (!regex.match(strValue).hasMatch()) {
+            // Шаблон компилируется один раз, а не для каждого значения (вставка блока)
+            static thread_local QHash<QString, QRegularExpression> patterns;
+            auto regex = patterns.constFind(validator.pattern);
+            if (regex == patterns.constEnd()) {
+                regex = patterns.insert(validator.pattern, QRegularExpression(validator.pattern));
+            }
+            if (!regex->match(strValue).hasMatch()) {
                 return QString("Значение не соответствует требуемому формату");
             }
             break;
@@ -4,18 +4,24 @@
 #include <QUuid>
 #include <QVariantMap>
 
+#include <optional>
+
 #include "QueryHandler.hpp"
 #include "QueryResult.hpp"
 
+class QIODevice;
+class QSqlDatabase;
+
 namespace QForge {
 
 class ModelSchema; // В namespace QForge
 struct Column;     // Forward declaration для Column
+struct SortRule;
+struct Filter;
 
 namespace nsModel {
 
 class TableModelPrivate;
-class QSqlDatabase;
 
 class TableModel : public QAbstractTableModel {
     Q_OBJECT
@@ -24,6 +30,16 @@ class TableModel : public QAbstractTableModel {
     TableModelPrivate* const d_ptr;
 
 public:
+    /*!
+     * \brief Когда правки модели (setData, appendRows, removeRows) записываются в источник.
+     */
+    enum class EditStrategy {
+        LocalOnly,      //!< Правки остаются в модели (по умолчанию).
+        OnFieldChange,  //!< Каждая правка сразу записывается запросами update/insert/remove схемы; не принятая источником откатывается.
+        OnManualSubmit  //!< Правки копятся в буфере до submitAll() / revertAll().
+    };
+    Q_ENUM(EditStrategy)
+
     explicit TableModel(const QString& config_path, QObject* parent = nullptr);
     explicit TableModel(const QString& config_path, const QueryHandler& queryHandler = {}, QObject* parent = nullptr);
     explicit TableModel(const QString& config_path, QSqlDatabase* db, QObject* parent = nullptr);
@@ -44,18 +60,102 @@ public:
 
     QString getLastError() const;
 
+    const ::QForge::ModelSchema& getSchema() const;
+
+    QString columnName(int column) const;
+    int columnIndex(const QString& name) const;
+
+    // Значение прямо из типизированного хранилища, без форматирования и QVariant
+    // (сгенерированные модели qforge-schemagen); пусто для NULL и не приводимых к T значений
+    template <typename T>
+    std::optional<T> typedValue(int row, int column) const;
+
     //... QAbstractTableModel interface methods
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
     Qt::ItemFlags flags(const QModelIndex& index) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Локальная (многоколоночная) сортировка по правилам схемы
+    void setSortRules(const QVector<::QForge::SortRule>& rules);
+    QVector<::QForge::SortRule> sortRules() const;
+
+    // Локальная фильтрация без прокси-модели (требует enable_filtering в схеме)
+    bool setFilter(const ::QForge::Filter& filter);
+    ::QForge::Filter filter() const;
+    bool setColumnFilter(const QString& columnName, const QVariant& value);
+    void clearFilter();
+    bool isFilterPushedDown() const; //!< Фильтр выполнен источником последнего запроса (SQL WHERE)
+    QVariantMap filterPushDownStats() const; //!< Запрос -> {"pushed_down": n, "local": n}: кто выполнял фильтр модели
+    void resetFilterPushDownStats();
+
+    // Пакетная запись (вставка из буфера обмена): все значения проверяются до записи, при ошибке
+    // ничего не меняется; изменённые строки объявляются минимальным числом dataChanged, порядок
+    // и фильтр пересчитываются один раз. Блок пишется начиная с topLeft, строка блока - строка модели
+    bool setDataBlock(const QModelIndex& topLeft, const QList<QVariantList>& block);
+    bool setDataCells(const QList<QPair<QModelIndex, QVariant>>& cells);
+
+    // Добавление строк (в отсортированной модели строки встают на свои места); при буфере
+    // правок строки записываются запросом insert
+    void appendRows(const QList<QVariantMap>& rows);
+
+    // Буфер правок: изменённые, добавленные и удалённые строки по первичному ключу записываются
+    // в источник одним пакетом (запросы update/insert/remove схемы, execBatch для БД; в одной
+    // транзакции, если один из запросов is_transactional). Переключение на LocalOnly оставляет
+    // несохранённые правки только в модели
+    void setEditStrategy(EditStrategy strategy);
+    EditStrategy editStrategy() const;
+    bool submitAll();   //!< Записывает буфер в источник; при ошибке в буфере остаются незаписанные правки
+    void revertAll();   //!< Возвращает исходные значения, удалённые строки и убирает добавленные
+    bool isDirty() const;
+    bool isDirty(const QModelIndex& index) const;
+    bool submit() override; //!< submitAll(), кроме OnManualSubmit
+    void revert() override; //!< revertAll(), кроме OnManualSubmit
+
+    // Отмена и повтор правок: setData, setDataBlock/setDataCells, appendRows и removeRows - по
+    // шагу на вызов, повторная правка той же ячейки сливается с предыдущим шагом. Отмена идёт
+    // через буфер правок, поэтому в источник записывается только итоговое изменение.
+    // Выключено по умолчанию; перезагрузка данных, revertAll() и смена схемы очищают журнал
+    void setUndoEnabled(bool enabled);
+    bool isUndoEnabled() const;
+    void setUndoLimit(int steps); //!< 0 - без ограничения (по умолчанию)
+    bool canUndo() const;
+    bool canRedo() const;
+    bool undo();
+    bool redo();
+    void clearUndo();
+
+    // Потоковая выгрузка в csv, json или xml по export_settings схемы (формат по умолчанию -
+    // default_format). Строки кодируются в буфер фиксированного размера и сбрасываются
+    // в устройство, память не растёт с числом строк. exportRows пишет видимые строки модели
+    // в порядке представления; exportQuery - результат запроса схемы, с БД через курсор
+    // только вперёд (обработчик запросов возвращает строки целиком). Прогресс сообщается
+    // раз в пакет строк, cancelExport() прерывает выгрузку на границе пакета
+    bool exportRows(QIODevice* device, const QString& format = {});
+    bool exportQuery(QIODevice* device, const QString& query, const QVariantMap& params = {},
+                     const QString& format = {});
+    void cancelExport();
+
+    // Горячая перезагрузка схемы: колонки меняются точечными сигналами, данные сохраняются
+    bool reloadSchema();
+    void setSchemaWatching(bool enabled); //!< Перезагружать схему при изменении файла
+    bool isSchemaWatching() const;
+
+    // Справочники внешних ключей (reference в схеме) общие для всех моделей;
+    // сброс перезагружает их во всех моделях, ссылающихся на те же таблицы
+    void invalidateLookups();
+    static void invalidateLookup(const QString& referenceTable);
 
 signals:
     void executionStarted(const QUuid& queryId);
     void executionFinished(const QUuid& queryId);
     void executionFailed(const QUuid& queryId, const QString& error);
+    void schemaReloaded();
+    void exportProgress(qint64 rows, qint64 bytes);
 
 protected:
     virtual void onExecutionStarted(const QString& queryName, const QVariantMap& params);
@@ -64,8 +164,6 @@ protected:
     
     // Валидация данных
     QString validateValue(const QVariant& value, const QForge::Column& column) const;
-    
-    const ::QForge::ModelSchema& getSchema() const;
 };
 
 }
@@ -0,0 +1,229 @@
+#include "TreeModel.h"
+#include "private/SqlQueryHandlerFactory.h"
+#include "private/TreeModelPrivate.h"
+
+namespace QForge {
+namespace nsModel {
+
+TreeModel::TreeModel(const QString& config_path, const QueryHandler& queryHandler, QObject* parent)
+    : QAbstractItemModel(parent)
+    , d_ptr(new TreeModelPrivate(this))
+{
+    Q_D(TreeModel);
+    d->queryHandler = queryHandler;
+    d->loadSchema(config_path);
+}
+
+TreeModel::TreeModel(const QString& config_path, QSqlDatabase* db, QObject* parent)
+    : QAbstractItemModel(parent)
+    , d_ptr(new TreeModelPrivate(this))
+{
+    Q_D(TreeModel);
+    // ${имя} и массивы уже переведены в именованные параметры; сами массивы в БД не передаются
+    d->queryHandler = [handler = SqlQueryHandlerFactory::getHandler(db)](const QueryContext& context) {
+        QueryContext bound = context;
+        for (auto it = bound.bindings.begin(); it != bound.bindings.end();) {
+            it = it.value().typeId() == QMetaType::QVariantList ? bound.bindings.erase(it) : std::next(it);
+        }
+        return handler(bound);
+    };
+    d->loadSchema(config_path);
+}
+
+TreeModel::~TreeModel()
+{
+    delete d_ptr;
+}
+
+QueryResult TreeModel::execute(const QString& query, const QVariantMap& params)
+{
+    Q_D(TreeModel);
+    return d->executeTree(query, params);
+}
+
+bool TreeModel::refreshSubtree(const QVariant& key, const QString& query, const QVariantMap& params)
+{
+    Q_D(TreeModel);
+
+    const int node = d->tree.node(key.toString());
+    if (node < 0) {
+        d->lastError = QString("Node '%1' not found").arg(key.toString());
+        return false;
+    }
+    return d->refreshSubtree(node, query, params);
+}
+
+bool TreeModel::moveNode(const QVariant& key, const QVariant& newParentKey, int row)
+{
+    Q_D(TreeModel);
+
+    const int node = d->tree.node(key.toString());
+    const int parent = newParentKey.isValid() ? d->tree.node(newParentKey.toString()) : TreeIndex::kRoot;
+    if (node < 0 || (newParentKey.isValid() && parent < 0)) {
+        d->lastError = QString("Node '%1' not found").arg(node < 0 ? key.toString() : newParentKey.toString());
+        return false;
+    }
+    if (d->tree.isAncestor(node, parent)) {
+        d->lastError = QString("Node '%1' cannot be moved into its own subtree").arg(key.toString());
+        return false;
+    }
+    return d->moveNode(node, parent, row);
+}
+
+bool TreeModel::isValid() const
+{
+    Q_D(const TreeModel);
+    return d->isInitialized;
+}
+
+QString TreeModel::getLastError() const
+{
+    Q_D(const TreeModel);
+    return d->lastError;
+}
+
+const ::QForge::ModelSchema& TreeModel::getSchema() const
+{
+    Q_D(const TreeModel);
+    static const ::QForge::ModelSchema empty;
+    return d->schema ? *d->schema : empty;
+}
+
+void TreeModel::fetchPending()
+{
+    Q_D(TreeModel);
+    d->fetchPending();
+}
+
+QModelIndex TreeModel::indexOfKey(const QVariant& key, int column) const
+{
+    Q_D(const TreeModel);
+    const int node = d->tree.node(key.toString());
+    return node < 0 ? QModelIndex() : d->indexOf(node, column);
+}
+
+QModelIndex TreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+    Q_D(const TreeModel);
+
+    if (column < 0 || column >= columnCount() || (parent.isValid() && parent.column() != 0)) {
+        return QModelIndex();
+    }
+    const QVector<int>& children = d->tree.children(d->nodeOf(parent));
+    if (row < 0 || row >= children.size()) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, quintptr(children[row]));
+}
+
+QModelIndex TreeModel::parent(const QModelIndex& index) const
+{
+    Q_D(const TreeModel);
+
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
+    return d->indexOf(d->tree.parent(d->nodeOf(index)));
+}
+
+int TreeModel::rowCount(const QModelIndex& parent) const
+{
+    Q_D(const TreeModel);
+
+    if (parent.isValid() && parent.column() != 0) {
+        return 0;
+    }
+    return d->tree.children(d->nodeOf(parent)).size();
+}
+
+int TreeModel::columnCount(const QModelIndex& parent) const
+{
+    Q_D(const TreeModel);
+    Q_UNUSED(parent)
+    return d->store.columnCount();
+}
+
+bool TreeModel::hasChildren(const QModelIndex& parent) const
+{
+    Q_D(const TreeModel);
+
+    if (!parent.isValid()) {
+        return rowCount() > 0;
+    }
+    // Пока дети не загружены, узел считается раскрываемым
+    if (parent.column() != 0) {
+        return false;
+    }
+    const int node = d->nodeOf(parent);
+    return d->tree.state(node) != TreeIndex::ChildrenState::Loaded || !d->tree.children(node).isEmpty();
+}
+
+bool TreeModel::canFetchMore(const QModelIndex& parent) const
+{
+    Q_D(const TreeModel);
+
+    if (!d->schema || !parent.isValid() || parent.column() != 0 || d->schema->tree.childrenQuery.isEmpty()) {
+        return false;
+    }
+    return d->tree.state(d->nodeOf(parent)) == TreeIndex::ChildrenState::Unknown;
+}
+
+void TreeModel::fetchMore(const QModelIndex& parent)
+{
+    Q_D(TreeModel);
+
+    if (canFetchMore(parent)) {
+        d->requestChildren(d->nodeOf(parent));
+    }
+}
+
+QVariant TreeModel::data(const QModelIndex& index, int role) const
+{
+    Q_D(const TreeModel);
+
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    switch (role) {
+        case Qt::DisplayRole:
+        case Qt::EditRole:
+            return d->store.value(d->nodeOf(index), index.column());
+
+        case Qt::ToolTipRole:
+            return d->schema->columns[index.column()].tooltip;
+
+        default:
+            break;
+    }
+    return QVariant();
+}
+
+QVariant TreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    Q_D(const TreeModel);
+
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal || !d->schema
+        || section < 0 || section >= d->schema->columns.size()) {
+        return QVariant();
+    }
+
+    const ::QForge::HeaderSettings& headers = d->schema->horizontalHeaders;
+    if (headers.type == ::QForge::HeaderType::Custom && section < headers.customLabels.size()) {
+        return headers.customLabels[section];
+    }
+    const ::QForge::Column& column = d->schema->columns[section];
+    return column.displayName.isEmpty() ? column.name : column.displayName;
+}
+
+Qt::ItemFlags TreeModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QVariantMap>
+
+#include "QueryHandler.hpp"
+#include "QueryResult.hpp"
+
+class QSqlDatabase;
+
+namespace QForge {
+
+class ModelSchema;
+
+namespace nsModel {
+
+class TreeModelPrivate;
+
+/**
+ * @brief Иерархическая модель для схем с type: tree.
+ *
+ * execute() строит дерево из плоского результата за один проход: строка, родитель которой
+ * (tree.parent_column) есть в результате, становится его ребёнком, остальные - узлами
+ * верхнего уровня. Дети узла загружаются по требованию представления
+ * (canFetchMore/fetchMore) запросом tree.children_query схемы: узлы, раскрытые в одном
+ * проходе цикла событий, собираются и загружаются одним запросом на уровень с массивом
+ * ключей родителей в аргументе tree.parents_argument (${parent_ids} разворачивается
+ * в ":parent_ids_0, :parent_ids_1, ..."). Родитель строки - колонка tree.parent_column
+ * результата, узлы ключуются первичным ключом схемы.
+ */
+class TreeModel : public QAbstractItemModel {
+    Q_OBJECT
+    Q_DISABLE_COPY(TreeModel)
+    Q_DECLARE_PRIVATE(TreeModel)
+    TreeModelPrivate* const d_ptr;
+
+public:
+    explicit TreeModel(const QString& config_path, const QueryHandler& queryHandler = {}, QObject* parent = nullptr);
+    explicit TreeModel(const QString& config_path, QSqlDatabase* db, QObject* parent = nullptr);
+    ~TreeModel() override;
+
+    /*!
+     * \brief Выполняет запрос и строит по нему дерево заново.
+     */
+    QueryResult execute(const QString& query, const QVariantMap& params = {});
+
+    /*!
+     * \brief Перечитывает поддерево узла key запросом, возвращающим всех его потомков.
+     * \details Изменённые значения, новые, удалённые и перенесённые узлы применяются
+     * точечными сигналами модели, без сброса.
+     */
+    bool refreshSubtree(const QVariant& key, const QString& query, const QVariantMap& params = {});
+
+    /*!
+     * \brief Переносит узел с поддеревом к newParentKey (невалидный - на верхний уровень).
+     * \param row Позиция среди новых соседей; -1 - в конец.
+     */
+    bool moveNode(const QVariant& key, const QVariant& newParentKey, int row = -1);
+
+    bool isValid() const;
+    QString getLastError() const;
+    const ::QForge::ModelSchema& getSchema() const;
+
+    /*!
+     * \brief Сразу выполняет отложенные fetchMore (иначе - в следующем проходе цикла событий).
+     */
+    void fetchPending();
+
+    /*!
+     * \brief Индекс загруженного узла по первичному ключу (невалидный, если узла нет).
+     */
+    QModelIndex indexOfKey(const QVariant& key, int column = 0) const;
+
+    //... QAbstractItemModel interface methods
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& index) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+};
+
+}
+
+}
@@ -0,0 +1,579 @@
+#include "ColumnStore.h"
+
+#include <QDate>
+#include <QTime>
+#include <QDateTime>
+
+#include <cmath>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static StorageKind storageKindFor(ColumnType type) {
+    switch (type) {
+        case ColumnType::Integer:
+        case ColumnType::Boolean:
+        case ColumnType::Date:
+        case ColumnType::Time:
+        case ColumnType::DateTime:
+            return StorageKind::Int64;
+        case ColumnType::Double:
+            return StorageKind::Double;
+        case ColumnType::String:
+            return StorageKind::String;
+        default:
+            return StorageKind::Variant;
+    }
+}
+
+static bool toBoolean(const QVariant& value, qint64& out) {
+    switch (value.typeId()) {
+        case QMetaType::Bool:
+            out = value.toBool() ? 1 : 0;
+            return true;
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Double:
+            out = value.toDouble() != 0.0 ? 1 : 0;
+            return true;
+        case QMetaType::QString: {
+            const QString str = value.toString().trimmed().toLower();
+            if (str == "true" || str == "1" || str == "yes") {
+                out = 1;
+                return true;
+            }
+            if (str == "false" || str == "0" || str == "no") {
+                out = 0;
+                return true;
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool isScalar(const QVariant& value) {
+    switch (value.typeId()) {
+        case QMetaType::QVariantList:
+        case QMetaType::QStringList:
+        case QMetaType::QVariantMap:
+        case QMetaType::QVariantHash:
+            return false;
+        default:
+            return value.canConvert<QString>();
+    }
+}
+
+// ========== TypedColumn ==========
+
+TypedColumn::TypedColumn(ColumnType columnType)
+    : type(columnType)
+    , kind(storageKindFor(columnType))
+{
+}
+
+QVariant TypedColumn::value(int row) const {
+    if (isNull(row)) {
+        return QVariant();
+    }
+
+    switch (kind) {
+        case StorageKind::Int64: {
+            const qint64 v = ints[row];
+            switch (type) {
+                case ColumnType::Boolean:
+                    return QVariant(v != 0);
+                case ColumnType::Date:
+                    return QDate::fromJulianDay(v);
+                case ColumnType::Time:
+                    return QTime::fromMSecsSinceStartOfDay(int(v));
+                case ColumnType::DateTime:
+                    return QDateTime::fromMSecsSinceEpoch(v);
+                default:
+                    return QVariant(v);
+            }
+        }
+        case StorageKind::Double:
+            return doubles[row];
+        case StorageKind::String:
+            return strings[row];
+        case StorageKind::Variant:
+            return variants[row];
+    }
+
+    return QVariant();
+}
+
+bool TypedColumn::toInt64(ColumnType type, const QVariant& value, qint64& out) {
+    bool ok = false;
+    switch (type) {
+        case ColumnType::Boolean:
+            return toBoolean(value, out);
+        case ColumnType::Date: {
+            const QDate date = value.toDate();
+            out = date.toJulianDay();
+            return date.isValid();
+        }
+        case ColumnType::Time: {
+            const QTime time = value.toTime();
+            out = time.msecsSinceStartOfDay();
+            return time.isValid();
+        }
+        case ColumnType::DateTime: {
+            const QDateTime dateTime = value.toDateTime();
+            out = dateTime.toMSecsSinceEpoch();
+            return dateTime.isValid();
+        }
+        default:
+            out = value.toLongLong(&ok);
+            // Дробное значение в целочисленной колонке не усекаем молча
+            if (ok && value.typeId() == QMetaType::Double && double(out) != value.toDouble()) {
+                ok = false;
+            }
+            return ok;
+    }
+}
+
+bool TypedColumn::setValue(int row, const QVariant& newValue) {
+    if (value(row) == newValue && isNull(row) == newValue.isNull()) {
+        return false;
+    }
+
+    if (!store(row, newValue)) {
+        demoteToVariant();
+        store(row, newValue);
+    }
+    return true;
+}
+
+void TypedColumn::setNumbers(int first, int count, const double* values, const quint8* nullFlags) {
+    // Целочисленное хранилище принимает только значения, которые помещаются в qint64
+    constexpr double kInt64Limit = 9.2e18;
+
+    for (int i = 0; i < count; ++i) {
+        const int row = first + i;
+        const double v = values[i];
+        const bool null = nullFlags[i] || !std::isfinite(v);
+        switch (kind) {
+            case StorageKind::Double:
+                doubles[row] = null ? 0.0 : v;
+                setNull(row, null);
+                break;
+            case StorageKind::Int64: {
+                const bool fits = !null && std::fabs(v) < kInt64Limit;
+                ints[row] = !fits ? 0 : (type == ColumnType::Boolean ? qint64(v != 0.0) : qint64(std::llround(v)));
+                setNull(row, !fits);
+                break;
+            }
+            default:
+                store(row, null ? QVariant() : QVariant(v));
+                break;
+        }
+    }
+}
+
+void TypedColumn::append(const QVariant& newValue) {
+    const int row = rows++;
+
+    switch (kind) {
+        case StorageKind::Int64:   ints.append(0); break;
+        case StorageKind::Double:  doubles.append(0.0); break;
+        case StorageKind::String:  strings.append(QString()); break;
+        case StorageKind::Variant: variants.append(QVariant()); break;
+    }
+
+    if (nulls.size() < (rows + 63) / 64) {
+        nulls.append(0);
+    }
+
+    if (!store(row, newValue)) {
+        demoteToVariant();
+        store(row, newValue);
+    }
+}
+
+void TypedColumn::removeAt(int row) {
+    switch (kind) {
+        case StorageKind::Int64:   ints.removeAt(row); break;
+        case StorageKind::Double:  doubles.removeAt(row); break;
+        case StorageKind::String:  strings.removeAt(row); break;
+        case StorageKind::Variant: variants.removeAt(row); break;
+    }
+
+    // Сдвигаем биты NULL-маски вслед за значениями
+    for (int i = row; i < rows - 1; ++i) {
+        setNull(i, isNull(i + 1));
+    }
+    --rows;
+    nulls.resize((rows + 63) / 64);
+    if (rows % 64) {
+        nulls.last() &= (quint64(1) << (rows % 64)) - 1;
+    }
+}
+
+// Сдвигает оставшиеся значения на место удалённых, начиная с первой удалённой строки
+template <typename T>
+static void compactValues(QVector<T>& values, const QVector<int>& removed) {
+    int write = removed.first();
+    int next = 0;
+    for (int read = removed.first(); read < values.size(); ++read) {
+        if (next < removed.size() && removed[next] == read) {
+            ++next;
+            continue;
+        }
+        values[write++] = std::move(values[read]);
+    }
+    values.resize(write);
+}
+
+void TypedColumn::removeRows(const QVector<int>& removed) {
+    if (removed.isEmpty()) {
+        return;
+    }
+    switch (kind) {
+        case StorageKind::Int64:   compactValues(ints, removed); break;
+        case StorageKind::Double:  compactValues(doubles, removed); break;
+        case StorageKind::String:  compactValues(strings, removed); break;
+        case StorageKind::Variant: compactValues(variants, removed); break;
+    }
+
+    int write = removed.first();
+    int next = 0;
+    for (int read = removed.first(); read < rows; ++read) {
+        if (next < removed.size() && removed[next] == read) {
+            ++next;
+            continue;
+        }
+        setNull(write++, isNull(read));
+    }
+    rows = write;
+    nulls.resize((rows + 63) / 64);
+    if (rows % 64) {
+        nulls.last() &= (quint64(1) << (rows % 64)) - 1;
+    }
+}
+
+// Раздвигает значения под вставленные строки; их значения дописаны в конец values
+template <typename T>
+static void spreadValues(QVector<T>& values, const QVector<int>& positions) {
+    const int count = positions.size();
+    QVector<T> inserted;
+    inserted.reserve(count);
+    for (int i = values.size() - count; i < values.size(); ++i) {
+        inserted.append(std::move(values[i]));
+    }
+    int read = values.size() - count - 1;
+    int next = count - 1;
+    for (int write = values.size() - 1; write >= positions.first(); --write) {
+        if (next >= 0 && positions[next] == write) {
+            values[write] = std::move(inserted[next--]);
+        } else {
+            values[write] = std::move(values[read--]);
+        }
+    }
+}
+
+void TypedColumn::insertRows(const QVector<int>& positions, const QVariantList& values) {
+    if (positions.isEmpty()) {
+        return;
+    }
+    // Значения дописываются в конец (с приведением к типу), затем встают на свои места
+    for (const QVariant& value : values) {
+        append(value);
+    }
+    switch (kind) {
+        case StorageKind::Int64:   spreadValues(ints, positions); break;
+        case StorageKind::Double:  spreadValues(doubles, positions); break;
+        case StorageKind::String:  spreadValues(strings, positions); break;
+        case StorageKind::Variant: spreadValues(variants, positions); break;
+    }
+
+    const int count = positions.size();
+    QVector<bool> insertedNulls(count);
+    for (int i = 0; i < count; ++i) {
+        insertedNulls[i] = isNull(rows - count + i);
+    }
+    int read = rows - count - 1;
+    int next = count - 1;
+    for (int write = rows - 1; write >= positions.first(); --write) {
+        setNull(write, next >= 0 && positions[next] == write ? insertedNulls[next--] : isNull(read--));
+    }
+}
+
+void TypedColumn::reserve(int size) {
+    switch (kind) {
+        case StorageKind::Int64:   ints.reserve(size); break;
+        case StorageKind::Double:  doubles.reserve(size); break;
+        case StorageKind::String:  strings.reserve(size); break;
+        case StorageKind::Variant: variants.reserve(size); break;
+    }
+    nulls.reserve((size + 63) / 64);
+}
+
+void TypedColumn::resize(int size) {
+    switch (kind) {
+        case StorageKind::Int64:   ints.resize(size); break;
+        case StorageKind::Double:  doubles.resize(size); break;
+        case StorageKind::String:  strings.resize(size); break;
+        case StorageKind::Variant: variants.resize(size); break;
+    }
+
+    // Биты NULL за пределами строк всегда сброшены
+    nulls.resize((size + 63) / 64);
+    if (size < rows && size % 64) {
+        nulls.last() &= (quint64(1) << (size % 64)) - 1;
+    }
+    rows = size;
+}
+
+void TypedColumn::clear() {
+    ints.clear();
+    doubles.clear();
+    strings.clear();
+    variants.clear();
+    nulls.clear();
+    rows = 0;
+    kind = storageKindFor(type);
+}
+
+void TypedColumn::setNull(int row, bool null) {
+    const quint64 bit = quint64(1) << (row & 63);
+    if (null) {
+        nulls[row >> 6] |= bit;
+    } else {
+        nulls[row >> 6] &= ~bit;
+    }
+}
+
+bool TypedColumn::store(int row, const QVariant& newValue) {
+    if (newValue.isNull()) {
+        switch (kind) {
+            case StorageKind::Int64:   ints[row] = 0; break;
+            case StorageKind::Double:  doubles[row] = 0.0; break;
+            case StorageKind::String:  strings[row] = QString(); break;
+            case StorageKind::Variant: variants[row] = QVariant(); break;
+        }
+        setNull(row, true);
+        return true;
+    }
+
+    bool ok = false;
+    switch (kind) {
+        case StorageKind::Int64: {
+            qint64 v = 0;
+            ok = toInt64(type, newValue, v);
+            if (ok) {
+                ints[row] = v;
+            }
+            break;
+        }
+        case StorageKind::Double: {
+            const double v = newValue.toDouble(&ok);
+            if (ok) {
+                doubles[row] = v;
+            }
+            break;
+        }
+        case StorageKind::String:
+            ok = isScalar(newValue);
+            if (ok) {
+                strings[row] = newValue.toString();
+            }
+            break;
+        case StorageKind::Variant:
+            variants[row] = newValue;
+            ok = true;
+            break;
+    }
+
+    if (ok) {
+        setNull(row, false);
+    }
+    return ok;
+}
+
+void TypedColumn::demoteToVariant() {
+    if (kind == StorageKind::Variant) {
+        return;
+    }
+
+    QVector<QVariant> converted;
+    converted.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        converted.append(value(row));
+    }
+
+    ints.clear();
+    doubles.clear();
+    strings.clear();
+    variants = converted;
+    kind = StorageKind::Variant;
+}
+
+// ========== ColumnStore ==========
+
+void ColumnStore::reset(const QVector<Column>& schemaColumns) {
+    columns.clear();
+    names.clear();
+    for (const Column& column : schemaColumns) {
+        columns.append(TypedColumn(column.type));
+        names.append(column.name);
+    }
+    rows = 0;
+    reindex();
+}
+
+void ColumnStore::clear() {
+    for (TypedColumn& column : columns) {
+        column.clear();
+    }
+    rows = 0;
+}
+
+QVariant ColumnStore::value(int row, int column) const {
+    if (row < 0 || row >= rows || column < 0 || column >= columns.size()) {
+        return QVariant();
+    }
+    return columns[column].value(row);
+}
+
+bool ColumnStore::setValue(int row, int column, const QVariant& value) {
+    if (row < 0 || row >= rows || column < 0 || column >= columns.size()) {
+        return false;
+    }
+    return columns[column].setValue(row, value);
+}
+
+int ColumnStore::appendRows(const QList<QVariantMap>& rowMaps) {
+    const int first = rows;
+
+    // Заполняем колонку за колонкой: так запись идёт в один массив подряд
+    for (int c = 0; c < columns.size(); ++c) {
+        TypedColumn& column = columns[c];
+        const QString& name = names[c];
+        column.reserve(first + rowMaps.size());
+        for (const QVariantMap& rowMap : rowMaps) {
+            column.append(rowMap.value(name));
+        }
+    }
+
+    rows += rowMaps.size();
+    return first;
+}
+
+int ColumnStore::appendRow(const QVariantList& values) {
+    for (int c = 0; c < columns.size(); ++c) {
+        columns[c].append(c < values.size() ? values[c] : QVariant());
+    }
+    return rows++;
+}
+
+int ColumnStore::appendDefaultRows(int count) {
+    const int first = rows;
+    for (TypedColumn& column : columns) {
+        column.resize(first + count);
+    }
+    rows += count;
+    return first;
+}
+
+void ColumnStore::insertColumn(int index, const Column& column) {
+    TypedColumn inserted(column.type);
+    inserted.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        inserted.append(QVariant());
+    }
+    columns.insert(index, inserted);
+    names.insert(index, column.name);
+    reindex();
+}
+
+void ColumnStore::removeColumn(int index) {
+    columns.remove(index);
+    names.removeAt(index);
+    reindex();
+}
+
+void ColumnStore::moveColumn(int from, int to) {
+    columns.move(from, to);
+    names.move(from, to);
+    reindex();
+}
+
+void ColumnStore::retypeColumn(int index, ColumnType type) {
+    const TypedColumn& previous = columns[index];
+    TypedColumn retyped(type);
+    retyped.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        retyped.append(previous.value(row));
+    }
+    columns[index] = std::move(retyped);
+}
+
+void ColumnStore::removeRow(int row) {
+    if (row < 0 || row >= rows) {
+        return;
+    }
+    for (TypedColumn& column : columns) {
+        column.removeAt(row);
+    }
+    --rows;
+}
+
+void ColumnStore::removeRows(const QVector<int>& removed) {
+    if (removed.isEmpty()) {
+        return;
+    }
+    for (TypedColumn& column : columns) {
+        column.removeRows(removed);
+    }
+    rows -= removed.size();
+}
+
+void ColumnStore::insertRows(const QVector<int>& positions, const QList<QVariantMap>& rowMaps) {
+    if (positions.isEmpty()) {
+        return;
+    }
+    for (int c = 0; c < columns.size(); ++c) {
+        QVariantList values;
+        values.reserve(rowMaps.size());
+        for (const QVariantMap& rowMap : rowMaps) {
+            values.append(rowMap.value(names[c]));
+        }
+        columns[c].insertRows(positions, values);
+    }
+    rows += rowMaps.size();
+}
+
+QVariantList ColumnStore::rowValues(int row) const {
+    QVariantList values;
+    values.reserve(columns.size());
+    for (const TypedColumn& column : columns) {
+        values.append(column.value(row));
+    }
+    return values;
+}
+
+QVariantMap ColumnStore::rowMap(int row) const {
+    QVariantMap map;
+    for (int c = 0; c < columns.size(); ++c) {
+        map.insert(names[c], columns[c].value(row));
+    }
+    return map;
+}
+
+void ColumnStore::reindex() {
+    indexes.clear();
+    indexes.reserve(names.size());
+    for (int i = 0; i < names.size(); ++i) {
+        if (!indexes.contains(names[i])) {
+            indexes.insert(names[i], i);
+        }
+    }
+}
+
+}
@@ -0,0 +1,188 @@
+#ifndef QFORGE_COLUMNSTORE_H
+#define QFORGE_COLUMNSTORE_H
+
+#include <QHash>
+#include <QVector>
+#include <QVariant>
+#include <QVariantMap>
+#include <QString>
+#include <QStringList>
+
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Способ физического хранения значений колонки.
+ */
+enum class StorageKind {
+    Int64,   //!< Integer, Boolean, Date (юлианский день), Time (мс от полуночи), DateTime (мс от эпохи).
+    Double,  //!< Double.
+    String,  //!< String.
+    Variant  //!< Остальные типы и колонки, значения которых не приводятся к типу из схемы.
+};
+
+/**
+ * @brief Колонка с типизированным хранилищем и битовой маской NULL-значений.
+ *
+ * Значения лежат в одном непрерывном массиве, соответствующем kind.
+ * Для NULL-строк в массив пишется значение по умолчанию, а в nulls взводится бит.
+ */
+struct TypedColumn
+{
+    ColumnType type = ColumnType::String;
+    StorageKind kind = StorageKind::String;
+    int rows = 0;
+
+    QVector<qint64> ints;
+    QVector<double> doubles;
+    QVector<QString> strings;
+    QVector<QVariant> variants;
+    QVector<quint64> nulls; //!< Бит (row % 64) слова (row / 64) выставлен для NULL.
+
+    explicit TypedColumn(ColumnType columnType = ColumnType::String);
+
+    inline bool isNull(int row) const { return (nulls[row >> 6] >> (row & 63)) & 1u; }
+
+    QVariant value(int row) const;
+
+    /*!
+     * \brief Приводит значение к представлению Int64-хранилища для типа колонки.
+     * \return false, если значение не приводится без потерь.
+     */
+    static bool toInt64(ColumnType type, const QVariant& value, qint64& out);
+
+    /*!
+     * \brief Записывает значение в строку.
+     * \return true, если значение изменилось.
+     */
+    bool setValue(int row, const QVariant& value);
+
+    /*!
+     * \brief Записывает числа в строки [first, first + count) без QVariant (вычисляемые колонки).
+     * \details Ненулевой флаг в nullFlags, а также NaN и бесконечность дают NULL.
+     */
+    void setNumbers(int first, int count, const double* values, const quint8* nullFlags);
+
+    void append(const QVariant& value);
+    void removeAt(int row);
+    void removeRows(const QVector<int>& rows); //!< rows упорядочены по возрастанию, без повторов.
+    void insertRows(const QVector<int>& positions, const QVariantList& values); //!< positions - номера после вставки, по возрастанию.
+    void reserve(int size);
+
+    /*!
+     * \brief Меняет число строк; новые строки получают значение по умолчанию (не NULL).
+     */
+    void resize(int size);
+    void clear();
+
+private:
+    void setNull(int row, bool null);
+    bool store(int row, const QVariant& value);
+    void demoteToVariant();
+};
+
+/**
+ * @brief Колоночное хранилище строк модели.
+ *
+ * Строки добавляются в конец (удалённые возвращаются на прежние места) или удаляются; видимый порядок строк
+ * задаётся перестановками поверх хранилища (сортировка, фильтрация).
+ * Колонки можно вставлять, удалять и перемещать, не трогая строки (смена схемы).
+ */
+class ColumnStore
+{
+public:
+    /*!
+     * \brief Пересоздаёт колонки по описанию из схемы, удаляя все строки.
+     * \param columns Колонки схемы.
+     */
+    void reset(const QVector<Column>& columns);
+
+    /*!
+     * \brief Удаляет все строки, сохраняя набор колонок.
+     */
+    void clear();
+
+    int rowCount() const { return rows; }
+    int columnCount() const { return columns.size(); }
+
+    /*!
+     * \brief Возвращает индекс колонки по имени или -1.
+     */
+    int columnIndex(const QString& name) const { return indexes.value(name, -1); }
+
+    const TypedColumn& column(int index) const { return columns[index]; }
+    TypedColumn& column(int index) { return columns[index]; }
+
+    QVariant value(int row, int column) const;
+
+    /*!
+     * \brief Записывает значение ячейки.
+     * \return true, если значение изменилось.
+     */
+    bool setValue(int row, int column, const QVariant& value);
+
+    /*!
+     * \brief Добавляет строки из результата запроса (значения берутся по именам колонок).
+     * \return Индекс первой добавленной строки.
+     */
+    int appendRows(const QList<QVariantMap>& rowMaps);
+
+    /*!
+     * \brief Добавляет строку, значения которой идут в порядке колонок.
+     * \return Индекс добавленной строки.
+     */
+    int appendRow(const QVariantList& values);
+
+    /*!
+     * \brief Добавляет count строк со значениями по умолчанию для заполнения колонок напрямую
+     * (например, параллельно по непересекающимся диапазонам строк).
+     * \return Индекс первой добавленной строки.
+     */
+    int appendDefaultRows(int count);
+
+    void removeRow(int row);
+
+    /*!
+     * \brief Удаляет строки за один проход по каждой колонке.
+     * \param rows Номера строк по возрастанию, без повторов.
+     */
+    void removeRows(const QVector<int>& rows);
+
+    /*!
+     * \brief Вставляет строки за один проход по каждой колонке (возврат удалённых строк).
+     * \param positions Номера строк после вставки по возрастанию; строки rowMaps - в том же порядке.
+     */
+    void insertRows(const QVector<int>& positions, const QList<QVariantMap>& rowMaps);
+
+    /*!
+     * \brief Вставляет колонку на позицию index; во всех строках NULL.
+     */
+    void insertColumn(int index, const Column& column);
+    void removeColumn(int index);
+
+    /*!
+     * \brief Перемещает колонку; to - её позиция после перемещения.
+     */
+    void moveColumn(int from, int to);
+
+    /*!
+     * \brief Меняет тип колонки, сохраняя значения (не приводимые к типу хранятся как есть).
+     */
+    void retypeColumn(int index, ColumnType type);
+
+    QVariantList rowValues(int row) const;
+    QVariantMap rowMap(int row) const;
+
+private:
+    void reindex();
+
+    QVector<TypedColumn> columns;
+    QStringList names;
+    QHash<QString, int> indexes; //!< Имя -> индекс колонки (первой при повторах).
+    int rows = 0;
+};
+
+}
+
+#endif // QFORGE_COLUMNSTORE_H
@@ -0,0 +1,224 @@
+#include "CsvFileSource.h"
+
+#include <QFileInfo>
+
+#include <cstring>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static constexpr int kFingerprintBytes = 256;
+static constexpr int kRefreshDelayMs = 50;
+
+// ========== PUBLIC METHODS ==========
+
+CsvFileSource::CsvFileSource(const QString& path, const ModelSchema& schema, QObject* parent)
+    : QObject(parent)
+    , filePath(path)
+    , format(CsvFormat::fromSettings(schema.importSettings))
+    , columns(schema.columns)
+    , engine(store)
+{
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(kRefreshDelayMs);
+    connect(&refreshTimer, &QTimer::timeout, this, [this] { refresh(); });
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &CsvFileSource::onFileChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &CsvFileSource::onDirectoryChanged);
+
+    store.reset(columns);
+    reload();
+}
+
+QString CsvFileSource::errorString() const {
+    QReadLocker locker(&lock);
+    return error;
+}
+
+int CsvFileSource::rowCount() const {
+    QReadLocker locker(&lock);
+    return store.rowCount();
+}
+
+qint64 CsvFileSource::offset() const {
+    QReadLocker locker(&lock);
+    return nextOffset;
+}
+
+QList<QVariantMap> CsvFileSource::rows(int first, int count) const {
+    QReadLocker locker(&lock);
+    QList<QVariantMap> result;
+    const int last = qMin(store.rowCount(), first + count);
+    result.reserve(qMax(0, last - first));
+    for (int row = qMax(0, first); row < last; ++row) {
+        result.append(store.rowMap(row));
+    }
+    return result;
+}
+
+QueryResult CsvFileSource::execute(const QueryContext& context) const {
+    QReadLocker locker(&lock);
+    return engine.execute(context);
+}
+
+bool CsvFileSource::createIndex(const QString& column) {
+    QWriteLocker locker(&lock);
+    return engine.createIndex(column);
+}
+
+void CsvFileSource::setWatching(bool enabled) {
+    if (watching == enabled) {
+        return;
+    }
+    watching = enabled;
+    if (!watching) {
+        refreshTimer.stop();
+        if (!watcher.files().isEmpty() || !watcher.directories().isEmpty()) {
+            watcher.removePaths(watcher.files() + watcher.directories());
+        }
+        return;
+    }
+
+    // Каталог отслеживается, чтобы заметить замену файла (запись во временный и переименование)
+    watcher.addPath(QFileInfo(filePath).absolutePath());
+    if (QFileInfo::exists(filePath)) {
+        watcher.addPath(filePath);
+    }
+    refreshTimer.start();
+}
+
+bool CsvFileSource::reload() {
+    int first = 0;
+    int count = 0;
+    bool reset = false;
+    bool ok = false;
+    {
+        QWriteLocker locker(&lock);
+        ok = update(true, first, count, reset);
+    }
+    return finish(ok, first, count, reset, true);
+}
+
+bool CsvFileSource::refresh(bool notify) {
+    int first = 0;
+    int count = 0;
+    bool reset = false;
+    bool ok = false;
+    {
+        QWriteLocker locker(&lock);
+        ok = update(false, first, count, reset);
+    }
+    return finish(ok, first, count, reset, notify);
+}
+
+// ========== PRIVATE METHODS ==========
+
+bool CsvFileSource::update(bool full, int& first, int& count, bool& reset) {
+    CsvReader reader(format);
+    if (!reader.open(filePath)) {
+        error = reader.errorString();
+        return false;
+    }
+
+    reset = full || !loaded || !isContinuation(reader);
+    if (reset) {
+        store.reset(columns);
+        nextOffset = reader.dataOffset();
+        pendingEnd = 0;
+        pendingRows = 0;
+    }
+
+    first = store.rowCount();
+    count = 0;
+    // Незавершённая строка, загруженная прошлым чтением, разбирается заново, если файл вырос
+    const bool reparse = pendingEnd > 0 && reader.size() != pendingEnd;
+    const bool hadPendingRow = reparse && pendingRows > 0;
+    QVariantMap pendingRow;
+    if (hadPendingRow) {
+        pendingRow = store.rowMap(first - 1);
+        store.removeRows({--first});
+    }
+    if (reparse || reset) {
+        pendingEnd = 0;
+        pendingRows = 0;
+    }
+
+    if (reader.size() > nextOffset) {
+        count = reader.read(store, nextOffset, &nextOffset);
+    }
+    // Дочитывание откладывает незавершённую строку; полное чтение и повторный разбор - нет
+    if ((reset || reparse) && reader.size() > nextOffset) {
+        pendingRows = reader.read(store, nextOffset);
+        pendingEnd = reader.size();
+        count += pendingRows;
+    }
+    if (hadPendingRow) {
+        // Строка уже отдана: не изменилась - остаётся на месте, иначе данные перечитаны
+        if (count > 0 && store.rowMap(first) == pendingRow) {
+            ++first;
+            --count;
+        } else {
+            reset = true;
+        }
+    }
+    remember(reader);
+    loaded = true;
+    error.clear();
+
+    if (reset) {
+        engine.rebuildIndexes();
+    } else if (count > 0) {
+        engine.updateIndexes(first);
+    }
+    return true;
+}
+
+bool CsvFileSource::isContinuation(const CsvReader& reader) const {
+    // Укороченный файл или выросший заголовок - файл переписан
+    if (reader.size() < nextOffset || nextOffset < reader.dataOffset()) {
+        return false;
+    }
+    // Начало файла и байты перед смещением должны совпадать с прочитанными ранее
+    const char* data = reader.constData();
+    return (head.isEmpty() || std::memcmp(data, head.constData(), head.size()) == 0)
+        && (tail.isEmpty() || std::memcmp(data + nextOffset - tail.size(), tail.constData(), tail.size()) == 0);
+}
+
+void CsvFileSource::remember(const CsvReader& reader) {
+    const char* data = reader.constData();
+    const int headSize = int(qMin<qint64>(nextOffset, kFingerprintBytes));
+    const int tailSize = int(qMin<qint64>(nextOffset, kFingerprintBytes));
+    head = data ? QByteArray(data, headSize) : QByteArray();
+    tail = data ? QByteArray(data + nextOffset - tailSize, tailSize) : QByteArray();
+}
+
+bool CsvFileSource::finish(bool ok, int first, int count, bool reset, bool notify) {
+    if (!notify) {
+        return ok;
+    }
+    if (!ok) {
+        emit loadFailed(errorString());
+    } else if (reset) {
+        emit reloaded();
+    } else if (count > 0) {
+        emit rowsAppended(first, count);
+    }
+    return ok;
+}
+
+void CsvFileSource::onFileChanged() {
+    // Заменённый или удалённый файл пропадает из наблюдения
+    if (QFileInfo::exists(filePath) && !watcher.files().contains(filePath)) {
+        watcher.addPath(filePath);
+    }
+    refreshTimer.start();
+}
+
+void CsvFileSource::onDirectoryChanged() {
+    if (QFileInfo::exists(filePath) && !watcher.files().contains(filePath)) {
+        watcher.addPath(filePath);
+        refreshTimer.start();
+    }
+}
+
+}
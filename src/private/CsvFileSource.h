@@ -0,0 +1,114 @@
+#ifndef QFORGE_CSVFILESOURCE_H
+#define QFORGE_CSVFILESOURCE_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QTimer>
+
+#include "ColumnStore.h"
+#include "CsvReader.h"
+#include "ModelSchema.h"
+#include "QueryEngine.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief CSV-файл, который дописывается в конец (журнал), как источник данных.
+ *
+ * Строки хранятся в ColumnStore, запросы выполняет QueryEngine. Запоминается
+ * смещение после последней прочитанной строки: refresh() разбирает только
+ * дописанные с тех пор строки (незавершённая последняя строка ждёт следующего
+ * чтения) и сообщает о них rowsAppended. При полном чтении последняя строка без
+ * перевода строки загружается сразу и разбирается заново, когда файл вырастет;
+ * если она при этом изменилась, файл считается перечитанным. Если файл укорочен,
+ * заменён или изменился до запомненного смещения, он перечитывается целиком (reloaded).
+ * При setWatching(true) refresh() вызывается по изменению файла (QFileSystemWatcher).
+ * Хранилище защищено блокировкой: запросы можно выполнять из других потоков.
+ */
+class CsvFileSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief Колонки и формат (import_settings) берутся из схемы; файл читается сразу.
+     */
+    CsvFileSource(const QString& path, const ModelSchema& schema, QObject* parent = nullptr);
+
+    QString path() const { return filePath; }
+    QString errorString() const;
+
+    int rowCount() const;
+
+    /*!
+     * \brief Смещение в файле, с которого начнётся следующее чтение.
+     */
+    qint64 offset() const;
+
+    /*!
+     * \brief Строки хранилища [first, first + count) в виде результата запроса.
+     */
+    QList<QVariantMap> rows(int first, int count) const;
+
+    /*!
+     * \brief Выполняет запрос над строками источника (см. QueryEngine::execute).
+     */
+    QueryResult execute(const QueryContext& context) const;
+
+    /*!
+     * \brief Строит индекс колонки; индексы поддерживаются при дочитывании и перезагрузке.
+     */
+    bool createIndex(const QString& column);
+
+    void setWatching(bool watching);
+    bool isWatching() const { return watching; }
+
+public slots:
+    /*!
+     * \brief Перечитывает файл целиком.
+     */
+    bool reload();
+
+    /*!
+     * \brief Дочитывает дописанные строки или перечитывает файл, если он переписан.
+     * \param notify false - без сигналов (вызывающий сам отдаёт все строки, например запрос загрузки).
+     */
+    bool refresh(bool notify = true);
+
+signals:
+    void rowsAppended(int first, int count);
+    void reloaded();
+    void loadFailed(const QString& error);
+
+private:
+    bool update(bool full, int& first, int& count, bool& reset);
+    bool isContinuation(const CsvReader& reader) const;
+    void remember(const CsvReader& reader);
+    bool finish(bool ok, int first, int count, bool reset, bool notify);
+    void onFileChanged();
+    void onDirectoryChanged();
+
+    QString filePath;
+    CsvFormat format;
+    QVector<Column> columns;
+
+    mutable QReadWriteLock lock;
+    ColumnStore store;
+    QueryEngine engine;
+    bool loaded = false;
+    qint64 nextOffset = 0;
+    qint64 pendingEnd = 0; //!< Размер файла, если загружена незавершённая последняя строка (с nextOffset), иначе 0.
+    int pendingRows = 0;   //!< Строк хранилища из незавершённой строки (0 - пустая).
+    QByteArray head; //!< Начало файла до nextOffset (не больше kFingerprintBytes).
+    QByteArray tail; //!< Байты перед nextOffset (не больше kFingerprintBytes).
+    QString error;
+
+    bool watching = false;
+    QFileSystemWatcher watcher;
+    QTimer refreshTimer; //!< Объединяет серию изменений файла в одно чтение.
+};
+
+}
+
+#endif // QFORGE_CSVFILESOURCE_H
@@ -0,0 +1,485 @@
+#include "CsvReader.h"
+
+#include "FieldParser.h"
+#include "Parallel.h"
+#include "PredicateKernels.h"
+
+#include <cstring>
+
+#if defined(Q_PROCESSOR_X86)
+#  include <immintrin.h>
+#  define QFORGE_X86_KERNELS
+#  if defined(Q_CC_MSVC) && !defined(Q_CC_CLANG)
+#    define QFORGE_TARGET(isa)
+#  else
+#    define QFORGE_TARGET(isa) __attribute__((target(isa)))
+#  endif
+#endif
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static constexpr qint64 kMinChunkBytes = qint64(1) << 20;
+static constexpr qint64 kMaxChunkBytes = qint64(1) << 30; // Смещения внутри куска хранятся в quint32
+
+namespace {
+
+// Позиции кавычек и переводов строки в блоке из 64 байт
+struct BlockMasks
+{
+    quint64 quotes;
+    quint64 newlines;
+};
+
+// Отложенная запись ячейки: NULL или значение, требующее перевода колонки в Variant
+struct Fixup
+{
+    int row;
+    int column;
+    QVariant value;
+};
+
+}
+
+using MaskFn = BlockMasks (*)(const char* block, char quote);
+
+static BlockMasks masksScalar(const char* block, char quote) {
+    BlockMasks masks{0, 0};
+    for (int i = 0; i < 64; ++i) {
+        masks.quotes |= quint64(block[i] == quote ? 1 : 0) << i;
+        masks.newlines |= quint64(block[i] == '\n' ? 1 : 0) << i;
+    }
+    return masks;
+}
+
+#ifdef QFORGE_X86_KERNELS
+
+QFORGE_TARGET("sse2")
+static BlockMasks masksSse2(const char* block, char quote) {
+    const __m128i quotes = _mm_set1_epi8(quote);
+    const __m128i newlines = _mm_set1_epi8('\n');
+    BlockMasks masks{0, 0};
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        masks.quotes |= quint64(quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quotes)))) << (i * 16);
+        masks.newlines |= quint64(quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newlines)))) << (i * 16);
+    }
+    return masks;
+}
+
+QFORGE_TARGET("avx2")
+static BlockMasks masksAvx2(const char* block, char quote) {
+    const __m256i quotes = _mm256_set1_epi8(quote);
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    BlockMasks masks;
+    masks.quotes = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quotes))))
+                 | quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quotes)))) << 32;
+    masks.newlines = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newlines))))
+                   | quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newlines)))) << 32;
+    return masks;
+}
+
+#endif // QFORGE_X86_KERNELS
+
+static MaskFn activeMasks() {
+#ifdef QFORGE_X86_KERNELS
+    switch (PredicateKernels::activeIsa()) {
+        case PredicateKernels::Isa::Avx2: return masksAvx2;
+        case PredicateKernels::Isa::Sse2: return masksSse2;
+        case PredicateKernels::Isa::Scalar: break;
+    }
+#endif
+    return masksScalar;
+}
+
+// Бит i - чётность числа единиц в битах [0, i]: выставлен внутри кавычек
+static inline quint64 prefixXor(quint64 x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Обходит [begin, end) блоками по 64 байта; fn(ends, base) получает маску переводов строки
+// вне кавычек для блока с началом base. carry - все единицы, если позиция внутри кавычек.
+template <typename Fn>
+static void scanBlocks(const char* text, qint64 begin, qint64 end, char quote, quint64& carry, const Fn& fn) {
+    const MaskFn masks = activeMasks();
+    auto process = [&](const BlockMasks& block, qint64 base) {
+        const quint64 inside = prefixXor(block.quotes) ^ carry;
+        carry = quint64(qint64(inside) >> 63);
+        fn(block.newlines & ~inside, base);
+    };
+
+    qint64 pos = begin;
+    for (; pos + 64 <= end; pos += 64) {
+        process(masks(text + pos, quote), pos);
+    }
+    if (pos < end) {
+        // Хвост дополняется нулями: они не кавычки и не переводы строки
+        char tail[64] = {};
+        std::memcpy(tail, text + pos, size_t(end - pos));
+        BlockMasks block = masksScalar(tail, quote);
+        if (quote == '\0') {
+            block.quotes &= (quint64(1) << (end - pos)) - 1;
+        }
+        process(block, pos);
+    }
+}
+
+template <typename Fn>
+static inline void forEachBit(quint64 bits, qint64 base, const Fn& fn) {
+    while (bits) {
+        fn(base + qCountTrailingZeroBits(bits));
+        bits &= bits - 1;
+    }
+}
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline qint64 findDelimiter(const char* text, qint64 pos, qint64 end, char delimiter) {
+    if (pos >= end) {
+        return end;
+    }
+    const void* next = std::memchr(text + pos, delimiter, size_t(end - pos));
+    return next ? static_cast<const char*>(next) - text : end;
+}
+
+// Вызывает fn(field, text, size, quoted) для полей строки [begin, end);
+// поле в кавычках с экранированными кавычками раскрывается в scratch
+template <typename Fn>
+static void splitFields(const char* text, qint64 begin, qint64 end, const CsvFormat& format,
+                        QByteArray& scratch, const Fn& fn) {
+    qint64 pos = begin;
+    for (int field = 0;; ++field) {
+        qint64 lead = pos;
+        while (lead < end && (text[lead] == ' ' || text[lead] == '\t')) {
+            ++lead;
+        }
+        if (lead < end && text[lead] == format.quote) {
+            pos = lead;
+            const qint64 first = ++pos;
+            bool escaped = false;
+            scratch.clear();
+            qint64 run = first;
+            while (pos < end) {
+                if (text[pos] == format.quote) {
+                    if (pos + 1 < end && text[pos + 1] == format.quote) {
+                        scratch.append(text + run, pos + 1 - run);
+                        pos += 2;
+                        run = pos;
+                        escaped = true;
+                        continue;
+                    }
+                    break;
+                }
+                ++pos;
+            }
+            if (escaped) {
+                scratch.append(text + run, pos - run);
+                fn(field, scratch.constData(), int(scratch.size()), true);
+            } else {
+                fn(field, text + first, int(pos - first), true);
+            }
+            // Всё между закрывающей кавычкой и разделителем отбрасывается
+            pos = findDelimiter(text, pos, end, format.delimiter);
+        } else {
+            const qint64 fieldEnd = findDelimiter(text, pos, end, format.delimiter);
+            qint64 a = pos;
+            qint64 b = fieldEnd;
+            while (a < b && isBlank(text[a])) {
+                ++a;
+            }
+            while (b > a && isBlank(text[b - 1])) {
+                --b;
+            }
+            fn(field, text + a, int(b - a), false);
+            pos = fieldEnd;
+        }
+
+        if (pos >= end) {
+            return;
+        }
+        ++pos; // Разделитель
+    }
+}
+
+// Конец строки без '\r' перед переводом строки
+static inline qint64 trimRowEnd(const char* text, qint64 begin, qint64 end) {
+    return (end > begin && text[end - 1] == '\r') ? end - 1 : end;
+}
+
+// Пишет поле в строку колонки; NULL и неприводимые значения откладываются в fixups
+static inline void storeField(const FieldParser& parser, TypedColumn& column, int columnIndex, int row,
+                              const char* text, int size, bool quoted, QVector<Fixup>& fixups) {
+    if (size == 0 && !quoted) {
+        fixups.append({row, columnIndex, QVariant()});
+    } else if (!parser.store(text, size, column, row)) {
+        fixups.append({row, columnIndex, QString::fromUtf8(text, size)});
+    }
+}
+
+// ========== PUBLIC METHODS ==========
+
+CsvFormat CsvFormat::fromSettings(const ImportSettings& settings) {
+    CsvFormat format;
+    if (!settings.csvDelimiter.isEmpty()) {
+        format.delimiter = settings.csvDelimiter.at(0).toLatin1();
+    }
+    if (!settings.csvQuoteChar.isEmpty()) {
+        format.quote = settings.csvQuoteChar.at(0).toLatin1();
+    }
+    format.hasHeaders = settings.csvHasHeaders;
+    return format;
+}
+
+CsvReader::CsvReader(const CsvFormat& format)
+    : csvFormat(format)
+{
+}
+
+CsvReader::~CsvReader() {
+    close();
+}
+
+bool CsvReader::open(const QString& path) {
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("Cannot open CSV file %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    length = file.size();
+    if (length > 0) {
+        data = reinterpret_cast<const char*>(file.map(0, length));
+        if (!data) {
+            error = QString("Cannot map CSV file %1: %2").arg(path, file.errorString());
+            file.close();
+            length = 0;
+            return false;
+        }
+    }
+
+    // UTF-8 BOM
+    if (length >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        dataBegin = 3;
+    }
+
+    if (csvFormat.hasHeaders && dataBegin < length) {
+        qint64 headerEnd = length;
+        quint64 carry = 0;
+        const qint64 probe = qMin(length, dataBegin + kMinChunkBytes);
+        scanBlocks(data, dataBegin, probe, csvFormat.quote, carry, [&](quint64 ends, qint64 base) {
+            if (ends && headerEnd == length) {
+                headerEnd = base + qCountTrailingZeroBits(ends);
+            }
+        });
+        if (headerEnd == length && probe < length) {
+            const QVector<qint64> ends = rowEnds(data + dataBegin, length - dataBegin, csvFormat.quote);
+            headerEnd = ends.isEmpty() ? length : dataBegin + ends.first();
+        }
+
+        QByteArray scratch;
+        splitFields(data, dataBegin, trimRowEnd(data, dataBegin, headerEnd), csvFormat, scratch,
+                    [this](int, const char* text, int size, bool) {
+                        headerNames.append(QString::fromUtf8(text, size));
+                    });
+        dataBegin = qMin(length, headerEnd + 1);
+    }
+
+    return true;
+}
+
+void CsvReader::close() {
+    if (data) {
+        file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        data = nullptr;
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    length = 0;
+    dataBegin = 0;
+    headerNames.clear();
+    error.clear();
+}
+
+int CsvReader::read(ColumnStore& store, qint64 from, qint64* end) {
+    if (!isOpen()) {
+        error = "CSV file is not open";
+        return -1;
+    }
+    const qint64 dataStart = qBound(dataBegin, from < 0 ? dataBegin : from, length);
+    if (end) {
+        *end = dataStart;
+    }
+
+    // Поле файла -> колонка хранилища
+    QVector<int> fieldColumns;
+    if (csvFormat.hasHeaders) {
+        for (const QString& name : std::as_const(headerNames)) {
+            fieldColumns.append(store.columnIndex(name));
+        }
+    } else {
+        for (int c = 0; c < store.columnCount(); ++c) {
+            fieldColumns.append(c);
+        }
+    }
+
+    const qint64 bytes = length - dataStart;
+    if (bytes <= 0) {
+        return 0;
+    }
+
+    const int tasks = int(qBound<qint64>(1, QThreadPool::globalInstance()->maxThreadCount(),
+                                         bytes / kMinChunkBytes));
+    const qint64 chunkBytes = qMin(kMaxChunkBytes, (bytes + tasks - 1) / tasks);
+    const int chunks = int((bytes + chunkBytes - 1) / chunkBytes);
+    const char* const text = data;
+    const char quote = csvFormat.quote;
+    auto chunkBegin = [&](int k) { return dataStart + k * chunkBytes; };
+    auto chunkEnd = [&](int k) { return qMin(length, dataStart + (k + 1) * chunkBytes); };
+
+    // 1. Чётность кавычек каждого куска задаёт состояние в начале следующего
+    QVector<quint64> carries(chunks, 0);
+    quint64* const carry = carries.data();
+    if (chunks > 1) {
+        Parallel::run(chunks, [&](int k) {
+            scanBlocks(text, chunkBegin(k), chunkEnd(k), quote, carry[k], [](quint64, qint64) {});
+        });
+        for (int k = 0, inside = 0; k < chunks; ++k) {
+            const quint64 parity = carry[k];
+            carry[k] = inside ? ~quint64(0) : 0;
+            inside ^= parity ? 1 : 0;
+        }
+    }
+
+    // 2. Концы строк каждого куска (смещения от начала куска)
+    QVector<QVector<quint32>> ends(chunks);
+    QVector<quint32>* const chunkEnds = ends.data();
+    Parallel::run(chunks, [&](int k) {
+        const qint64 begin = chunkBegin(k);
+        QVector<quint32>& offsets = chunkEnds[k];
+        quint64 state = carry[k];
+        scanBlocks(text, begin, chunkEnd(k), quote, state, [&](quint64 rowEnds, qint64 base) {
+            forEachBit(rowEnds, base - begin, [&](qint64 offset) { offsets.append(quint32(offset)); });
+        });
+    });
+
+    // Начало первой строки каждого куска; строка без завершающего перевода строки - последняя
+    // (при чтении дописываемого файла она откладывается до следующего чтения)
+    QVector<qint64> firstStarts(chunks);
+    qint64 start = dataStart;
+    for (int k = 0; k < chunks; ++k) {
+        firstStarts[k] = start;
+        if (!ends[k].isEmpty()) {
+            start = chunkBegin(k) + ends[k].last() + 1;
+        }
+    }
+    if (end) {
+        *end = start;
+    } else if (start < length) {
+        ends[chunks - 1].append(quint32(length - chunkBegin(chunks - 1)));
+    }
+
+    // 3. Непустые строки кусков -> номера строк хранилища
+    QVector<int> firstRows(chunks + 1, 0);
+    int* const firstRow = firstRows.data();
+    Parallel::run(chunks, [&](int k) {
+        qint64 rowBegin = firstStarts[k];
+        int count = 0;
+        for (quint32 offset : std::as_const(chunkEnds[k])) {
+            const qint64 rowEnd = chunkBegin(k) + offset;
+            count += trimRowEnd(text, rowBegin, rowEnd) > rowBegin ? 1 : 0;
+            rowBegin = rowEnd + 1;
+        }
+        firstRow[k + 1] = count;
+    });
+    for (int k = 0; k < chunks; ++k) {
+        firstRow[k + 1] += firstRow[k];
+    }
+    const int rowCount = firstRow[chunks];
+    const int base = store.appendDefaultRows(rowCount);
+
+    // Разборщик каждой колонки выбирается один раз по её типу
+    QVector<TypedColumn*> targets;
+    QVector<FieldParser> parsers;
+    for (int c = 0; c < store.columnCount(); ++c) {
+        targets.append(&store.column(c));
+        parsers.append(FieldParser(store.column(c)));
+    }
+
+    // 4. Разбор полей прямо в колонки; строки кусков не пересекаются
+    QVector<QVector<Fixup>> fixups(chunks);
+    QVector<Fixup>* const chunkFixups = fixups.data();
+    Parallel::run(chunks, [&](int k) {
+        QVector<Fixup>& deferred = chunkFixups[k];
+        const QVector<FieldParser> chunkParsers(parsers.begin(), parsers.end()); // Своя копия кэша на поток
+        QByteArray scratch;
+        qint64 rowBegin = firstStarts[k];
+        int row = base + firstRow[k];
+        for (quint32 offset : std::as_const(chunkEnds[k])) {
+            const qint64 rowEnd = chunkBegin(k) + offset;
+            const qint64 contentEnd = trimRowEnd(text, rowBegin, rowEnd);
+            if (contentEnd > rowBegin) {
+                int fields = 0;
+                splitFields(text, rowBegin, contentEnd, csvFormat, scratch,
+                            [&](int field, const char* value, int size, bool quoted) {
+                                fields = field + 1;
+                                const int column = field < fieldColumns.size() ? fieldColumns[field] : -1;
+                                if (column >= 0) {
+                                    storeField(chunkParsers[column], *targets[column], column, row, value, size,
+                                               quoted, deferred);
+                                }
+                            });
+                // Недостающие поля - NULL
+                for (int field = fields; field < fieldColumns.size(); ++field) {
+                    if (fieldColumns[field] >= 0) {
+                        deferred.append({row, fieldColumns[field], QVariant()});
+                    }
+                }
+                ++row;
+            }
+            rowBegin = rowEnd + 1;
+        }
+    });
+
+    // Колонки, которых нет в файле, - NULL
+    for (int c = 0; c < store.columnCount(); ++c) {
+        if (!fieldColumns.contains(c)) {
+            for (int row = base; row < base + rowCount; ++row) {
+                store.setValue(row, c, QVariant());
+            }
+        }
+    }
+
+    // NULL-маска и перевод колонок в Variant - последовательно
+    for (const QVector<Fixup>& deferred : std::as_const(fixups)) {
+        for (const Fixup& fixup : deferred) {
+            store.setValue(fixup.row, fixup.column, fixup.value);
+        }
+    }
+
+    return rowCount;
+}
+
+QVector<qint64> CsvReader::rowEnds(const char* text, qint64 size, char quote) {
+    QVector<qint64> result;
+    quint64 carry = 0;
+    scanBlocks(text, 0, size, quote, carry, [&](quint64 ends, qint64 base) {
+        forEachBit(ends, base, [&](qint64 position) { result.append(position); });
+    });
+    return result;
+}
+
+}
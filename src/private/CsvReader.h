@@ -0,0 +1,101 @@
+#ifndef QFORGE_CSVREADER_H
+#define QFORGE_CSVREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "ColumnStore.h"
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Формат CSV-файла.
+ */
+struct CsvFormat
+{
+    char delimiter = ',';
+    char quote = '"';
+    bool hasHeaders = true;
+
+    /*!
+     * \brief Формат из import_settings схемы (берётся первый символ csv_delimiter/csv_quote_char).
+     */
+    static CsvFormat fromSettings(const ImportSettings& settings);
+};
+
+/**
+ * @brief Чтение CSV-файла, отображённого в память, в типизированные колонки.
+ *
+ * Перевод строки внутри кавычек не завершает строку, удвоенная кавычка внутри
+ * поля - экранированная кавычка. Границы строк ищутся по 64 байта за шаг
+ * (AVX2/SSE2/скалярно - по PredicateKernels::activeIsa()). Файл делится на куски:
+ * чётность кавычек, границы строк и разбор полей в колонки ColumnStore
+ * выполняются по кускам параллельно.
+ */
+class CsvReader
+{
+public:
+    explicit CsvReader(const CsvFormat& format = CsvFormat());
+    ~CsvReader();
+
+    /*!
+     * \brief Отображает файл в память и читает заголовок.
+     */
+    bool open(const QString& path);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    QString errorString() const { return error; }
+    const CsvFormat& format() const { return csvFormat; }
+
+    /*!
+     * \brief Имена полей заголовка (пусто, если hasHeaders == false).
+     */
+    QStringList headers() const { return headerNames; }
+
+    qint64 size() const { return length; }
+
+    /*!
+     * \brief Отображённое содержимое файла (size() байт).
+     */
+    const char* constData() const { return data; }
+
+    /*!
+     * \brief Смещение первой строки данных (после BOM и заголовка).
+     */
+    qint64 dataOffset() const { return dataBegin; }
+
+    /*!
+     * \brief Разбирает строки данных и добавляет их в хранилище.
+     * \details Поля сопоставляются колонкам по имени из заголовка, без заголовка - по позиции,
+     * и разбираются FieldParser по типу колонки. Пустое поле без кавычек - NULL; значение
+     * в другом формате приводится как в ColumnStore::setValue (при неудаче колонка
+     * переводится в Variant). Пустые строки пропускаются.
+     * \param from Начало первой читаемой строки (-1 - начало данных); должно быть границей строки.
+     * \param end Если задан, читаются только строки, завершённые переводом строки, а в *end
+     * записывается позиция, с которой продолжать чтение дописанного файла.
+     * \return Число добавленных строк или -1, если файл не открыт.
+     */
+    int read(ColumnStore& store, qint64 from = -1, qint64* end = nullptr);
+
+    /*!
+     * \brief Позиции переводов строки вне кавычек в text[0, size).
+     */
+    static QVector<qint64> rowEnds(const char* text, qint64 size, char quote);
+
+private:
+    CsvFormat csvFormat;
+    QFile file;
+    const char* data = nullptr;
+    qint64 length = 0;
+    qint64 dataBegin = 0; //!< Начало первой строки данных (после заголовка).
+    QStringList headerNames;
+    QString error;
+};
+
+}
+
+#endif // QFORGE_CSVREADER_H
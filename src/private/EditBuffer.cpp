@@ -0,0 +1,171 @@
+#include "EditBuffer.h"
+
+#include <algorithm>
+
+namespace QForge::nsModel {
+
+// Ключи добавленных строк не пересекаются с первичными ключами
+static constexpr QChar kInsertedPrefix = QChar(0x1E);
+
+void EditBuffer::clear() {
+    changes.clear();
+    rowKeys.clear();
+    inserted = 0;
+}
+
+bool EditBuffer::isModified(int row, const QString& column) const {
+    const auto key = rowKeys.constFind(row);
+    if (key == rowKeys.constEnd()) {
+        return false;
+    }
+    const RowChange& change = changes[*key];
+    return change.state == RowState::Inserted || change.original.contains(column);
+}
+
+void EditBuffer::recordUpdate(int row, const QString& key, const QVariantMap& keyValues,
+                              const QString& column, const QVariant& before) {
+    const auto existing = rowKeys.constFind(row);
+    if (existing != rowKeys.constEnd()) {
+        RowChange& change = changes[*existing];
+        if (change.state == RowState::Updated && !change.original.contains(column)) {
+            change.original.insert(column, before);
+        }
+        return;
+    }
+
+    RowChange change;
+    change.row = row;
+    change.key = keyValues;
+    change.original.insert(column, before);
+    changes.insert(key, change);
+    rowKeys.insert(row, key);
+}
+
+void EditBuffer::recordInsert(int row) {
+    const QString key = kInsertedPrefix + QString::number(inserted++);
+    RowChange change;
+    change.state = RowState::Inserted;
+    change.row = row;
+    changes.insert(key, change);
+    rowKeys.insert(row, key);
+}
+
+void EditBuffer::recordRemove(int row, const QString& key, const QVariantMap& keyValues, const QVariantMap& values,
+                              quint32 rowId) {
+    const QString existing = rowKeys.take(row);
+    if (!existing.isNull()) {
+        RowChange& change = changes[existing];
+        if (change.state == RowState::Inserted) {
+            changes.remove(existing);
+            return;
+        }
+        change.position = originalPosition(row);
+        change.rowId = rowId;
+        change.state = RowState::Removed;
+        change.row = -1;
+        change.values = values;
+        change.values.insert(change.original);
+        change.original.clear();
+        return;
+    }
+
+    RowChange change;
+    change.state = RowState::Removed;
+    change.key = keyValues;
+    change.values = values;
+    change.position = originalPosition(row);
+    change.rowId = rowId;
+    changes.insert(key, change);
+}
+
+void EditBuffer::dropUnchanged(int row, const QString& column, const QVariant& current) {
+    const auto key = rowKeys.constFind(row);
+    if (key == rowKeys.constEnd()) {
+        return;
+    }
+    RowChange& change = changes[*key];
+    if (change.state != RowState::Updated || !change.original.contains(column)
+        || change.original.value(column) != current) {
+        return;
+    }
+    change.original.remove(column);
+    if (change.original.isEmpty()) {
+        changes.remove(*key);
+        rowKeys.remove(row);
+    }
+}
+
+void EditBuffer::recordRestore(int row, const QString& key, const QVariantMap& values) {
+    const auto existing = changes.find(key);
+    if (existing == changes.end() || existing->state != RowState::Removed) {
+        recordInsert(row);
+        return;
+    }
+
+    // У удалённой строки values - исходные значения; отличающиеся становятся правками
+    QVariantMap original;
+    for (auto it = existing->values.constBegin(); it != existing->values.constEnd(); ++it) {
+        if (values.value(it.key()) != it.value()) {
+            original.insert(it.key(), it.value());
+        }
+    }
+    if (original.isEmpty()) {
+        changes.erase(existing);
+        return;
+    }
+    existing->state = RowState::Updated;
+    existing->row = row;
+    existing->original = original;
+    existing->values.clear();
+    rowKeys.insert(row, key);
+}
+
+void EditBuffer::dropState(RowState state) {
+    for (auto it = changes.begin(); it != changes.end();) {
+        if (it->state != state) {
+            ++it;
+            continue;
+        }
+        if (it->row >= 0) {
+            rowKeys.remove(it->row);
+        }
+        it = changes.erase(it);
+    }
+}
+
+int EditBuffer::originalPosition(int row) const {
+    // Строки до правок - оставшиеся (без добавленных) и удалённые; удалённые занимают
+    // свои места, оставшиеся по порядку заполняют свободные
+    int position = row;
+    QVector<int> removed;
+    for (const RowChange& change : changes) {
+        if (change.state == RowState::Inserted && change.row >= 0 && change.row < row) {
+            --position;
+        } else if (change.state == RowState::Removed) {
+            removed.append(change.position);
+        }
+    }
+    std::sort(removed.begin(), removed.end());
+    for (int taken : std::as_const(removed)) {
+        if (taken > position) {
+            break;
+        }
+        ++position;
+    }
+    return position;
+}
+
+void EditBuffer::remapRows(const QVector<int>& newRows) {
+    QHash<int, QString> remapped;
+    remapped.reserve(rowKeys.size());
+    for (auto it = rowKeys.constBegin(); it != rowKeys.constEnd(); ++it) {
+        RowChange& change = changes[it.value()];
+        change.row = newRows[it.key()];
+        if (change.row >= 0) {
+            remapped.insert(change.row, it.value());
+        }
+    }
+    rowKeys = remapped;
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef QFORGE_EDITBUFFER_H
+#define QFORGE_EDITBUFFER_H
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Несохранённые правки модели: одна запись на строку, ключ - первичный ключ строки.
+ *
+ * Текущие значения строк остаются в ColumnStore; буфер хранит только то, что нужно
+ * для записи в источник и для отката: исходный ключ, значения правленых колонок до первой
+ * правки, значения удалённых строк. У добавленной строки ключа может ещё не быть
+ * (его выдаёт источник), такие записи ключуются порядковым номером добавления.
+ */
+class EditBuffer
+{
+public:
+    enum class RowState { Updated, Inserted, Removed };
+
+    struct RowChange {
+        RowState state = RowState::Updated;
+        int row = -1;         //!< Строка хранилища; -1 у удалённых.
+        QVariantMap key;      //!< Первичный ключ до правок (Updated, Removed).
+        QVariantMap original; //!< Updated: колонка -> значение до первой правки.
+        QVariantMap values;   //!< Removed: строка в исходном виде (для отката).
+        int position = -1;    //!< Removed: место строки среди строк хранилища до правок.
+        quint32 rowId = 0;    //!< Removed: стабильный номер строки в журнале отмены.
+    };
+
+    bool isEmpty() const { return changes.isEmpty(); }
+    int size() const { return changes.size(); }
+    void clear();
+
+    bool contains(int row) const { return rowKeys.contains(row); }
+    bool isModified(int row, const QString& column) const;
+    const QMap<QString, RowChange>& entries() const { return changes; }
+
+    /*!
+     * \brief Запоминает правку колонки; before сохраняется только при первой правке.
+     * \details key и keyValues нужны, только если строки ещё нет в буфере.
+     */
+    void recordUpdate(int row, const QString& key, const QVariantMap& keyValues,
+                      const QString& column, const QVariant& before);
+    void recordInsert(int row);
+
+    /*!
+     * \brief Запоминает удаление строки с текущими значениями values.
+     * \details Удаление добавленной строки просто отменяет её добавление; у изменённой
+     * строки в values возвращаются исходные значения. Запоминается и место строки
+     * до правок: откат возвращает её туда же.
+     */
+    void recordRemove(int row, const QString& key, const QVariantMap& keyValues, const QVariantMap& values,
+                      quint32 rowId = 0);
+
+    /*!
+     * \brief Забывает правку колонки, значение которой вернулось к исходному current.
+     * \details Строка без оставшихся правок уходит из буфера: записывается только итог.
+     */
+    void dropUnchanged(int row, const QString& column, const QVariant& current);
+
+    /*!
+     * \brief Запоминает возврат удалённой строки (отмена удаления) с текущими значениями values.
+     * \details Удаление из буфера снимается, а колонки, отличающиеся от исходных, становятся
+     * правками; строка, которой в буфере нет, считается добавленной.
+     */
+    void recordRestore(int row, const QString& key, const QVariantMap& values);
+
+    /*!
+     * \brief Забывает записи с состоянием state (их шаг пакета записан в источник).
+     */
+    void dropState(RowState state);
+
+    /*!
+     * \brief Переводит номера строк после удаления строк хранилища.
+     * \param newRows Старая строка -> новая (-1 - строка удалена).
+     */
+    void remapRows(const QVector<int>& newRows);
+
+private:
+    int originalPosition(int row) const; //!< Место строки хранилища row среди строк до правок.
+
+    QMap<QString, RowChange> changes;
+    QHash<int, QString> rowKeys; //!< Строка хранилища -> ключ записи.
+    int inserted = 0;            //!< Счётчик для ключей добавленных строк.
+};
+
+}
+
+#endif // QFORGE_EDITBUFFER_H
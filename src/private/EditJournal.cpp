@@ -0,0 +1,329 @@
+#include "EditJournal.h"
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace QForge::nsModel {
+
+// Метка типа перед значением в arena
+enum ValueTag : quint8 { NullValue, BoolValue, IntegerValue, RealValue, TextValue, OtherValue };
+
+template <typename T>
+static T read(const char*& data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return value;
+}
+
+static QVariant decode(const char*& data) {
+    switch (ValueTag(read<quint8>(data))) {
+        case BoolValue:
+            return bool(read<quint8>(data));
+
+        case IntegerValue:
+            return read<qint64>(data);
+
+        case RealValue:
+            return read<double>(data);
+
+        case TextValue: {
+            const qint32 size = read<qint32>(data);
+            QString text(size, Qt::Uninitialized);
+            std::memcpy(text.data(), data, size * sizeof(QChar));
+            data += size * sizeof(QChar);
+            return text;
+        }
+
+        case OtherValue: {
+            const qint32 size = read<qint32>(data);
+            QByteArray blob = QByteArray::fromRawData(data, size);
+            data += size;
+            QDataStream in(&blob, QIODevice::ReadOnly);
+            QVariant value;
+            in >> value;
+            return value;
+        }
+
+        case NullValue:
+            break;
+    }
+    return QVariant();
+}
+
+void EditJournal::setEnabled(bool on, int rowCount) {
+    enabled = on;
+    clear();
+    ids.clear();
+    ids.squeeze();
+    resetRows(rowCount);
+}
+
+void EditJournal::setLimit(int count) {
+    limit = qMax(0, count);
+    while (limit > 0 && steps.size() > limit) {
+        if (position > 0) {
+            dropOldest();
+        } else {
+            truncate(limit);
+        }
+    }
+}
+
+void EditJournal::clear() {
+    steps.clear();
+    deltas.clear();
+    arena.clear();
+    position = 0;
+    recording = kNotRecording;
+    mergeable = false;
+}
+
+void EditJournal::resetRows(int count) {
+    ids.clear();
+    appendRows(count);
+}
+
+void EditJournal::appendRows(int count) {
+    if (!enabled || count <= 0) {
+        return;
+    }
+    const int first = ids.size();
+    ids.resize(first + count);
+    std::iota(ids.begin() + first, ids.end(), nextId);
+    nextId += quint32(count);
+}
+
+void EditJournal::remapRows(const QVector<int>& newRows) {
+    if (!enabled) {
+        return;
+    }
+    // Порядок оставшихся строк не меняется, номера остаются возрастающими
+    int write = 0;
+    for (int row = 0; row < ids.size(); ++row) {
+        if (newRows[row] >= 0) {
+            ids[write++] = ids[row];
+        }
+    }
+    ids.resize(write);
+}
+
+int EditJournal::row(quint32 id) const {
+    const auto it = std::lower_bound(ids.cbegin(), ids.cend(), id);
+    return it != ids.cend() && *it == id ? int(it - ids.cbegin()) : -1;
+}
+
+int EditJournal::position(quint32 id) const {
+    return int(std::lower_bound(ids.cbegin(), ids.cend(), id) - ids.cbegin());
+}
+
+void EditJournal::insertRows(const QVector<int>& rows, const QVector<quint32>& rowIds) {
+    if (!enabled || rows.isEmpty()) {
+        return;
+    }
+    // Раздвигаем номера с конца, как и значения колонок
+    int read = ids.size() - 1;
+    int next = rows.size() - 1;
+    ids.resize(ids.size() + rows.size());
+    for (int write = ids.size() - 1; next >= 0; --write) {
+        ids[write] = rows[next] == write ? rowIds[next--] : ids[read--];
+    }
+}
+
+void EditJournal::beginStep() {
+    if (enabled) {
+        recording = kStepStarted;
+    }
+}
+
+bool EditJournal::startDelta() {
+    if (recording == kNotRecording) {
+        return false;
+    }
+    // Первая правка после отмены: отменённые шаги повторить уже нельзя
+    if (recording == kStepStarted) {
+        truncate(position);
+        recording = deltas.size();
+    }
+    return true;
+}
+
+void EditJournal::recordCell(int row, int column, const QVariant& before, const QVariant& after) {
+    if (!startDelta()) {
+        return;
+    }
+    const quint32 beforeOffset = append(before);
+    deltas.append({ids[row], column, beforeOffset, append(after)});
+}
+
+void EditJournal::recordRow(int row, const QVariantList& values, bool inserted) {
+    if (!startDelta()) {
+        return;
+    }
+    const quint32 offset = quint32(arena.size());
+    for (const QVariant& value : values) {
+        append(value);
+    }
+    deltas.append({ids[row], -1, inserted ? kNoValue : offset, inserted ? offset : kNoValue});
+}
+
+void EditJournal::endStep() {
+    const int first = recording;
+    recording = kNotRecording;
+    if (first < 0) {
+        return;
+    }
+    const int count = deltas.size() - first;
+
+    if (count == 1 && mergeable && position > 0 && steps[position - 1].count == 1) {
+        Delta& previous = deltas[steps[position - 1].first];
+        const Delta current = deltas[first];
+        if (current.column >= 0 && current.column == previous.column && current.row == previous.row) {
+            // В arena: [previous.before][previous.after][current.before][current.after];
+            // новое значение встаёт на место прежнего, остальное отбрасывается
+            const QByteArray after = arena.mid(current.after);
+            arena.truncate(previous.after);
+            arena.append(after);
+            deltas.removeLast();
+            if (value(previous.before) == value(previous.after)) {
+                truncate(position - 1);
+                mergeable = false;
+            }
+            return;
+        }
+    }
+
+    steps.append({first, count});
+    position = steps.size();
+    mergeable = count == 1 && deltas[first].column >= 0;
+    if (limit > 0 && steps.size() > limit) {
+        dropOldest();
+    }
+}
+
+bool EditJournal::undo(Step& step) {
+    if (!canUndo()) {
+        return false;
+    }
+    step = steps[--position];
+    mergeable = false;
+    return true;
+}
+
+bool EditJournal::redo(Step& step) {
+    if (!canRedo()) {
+        return false;
+    }
+    step = steps[position++];
+    mergeable = false;
+    return true;
+}
+
+QVariant EditJournal::value(quint32 offset) const {
+    const char* data = arena.constData() + offset;
+    return decode(data);
+}
+
+QVariantList EditJournal::values(quint32 offset, int count) const {
+    QVariantList result;
+    result.reserve(count);
+    const char* data = arena.constData() + offset;
+    for (int i = 0; i < count; ++i) {
+        result.append(decode(data));
+    }
+    return result;
+}
+
+quint32 EditJournal::append(const QVariant& value) {
+    const quint32 offset = quint32(arena.size());
+    auto write = [this](const auto& item) {
+        arena.append(reinterpret_cast<const char*>(&item), sizeof(item));
+    };
+
+    if (value.isNull()) {
+        write(quint8(NullValue));
+        return offset;
+    }
+    switch (value.typeId()) {
+        case QMetaType::Bool:
+            write(quint8(BoolValue));
+            write(quint8(value.toBool()));
+            break;
+
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+            write(quint8(IntegerValue));
+            write(value.toLongLong());
+            break;
+
+        case QMetaType::Double:
+        case QMetaType::Float:
+            write(quint8(RealValue));
+            write(value.toDouble());
+            break;
+
+        case QMetaType::QString: {
+            const QString text = value.toString();
+            write(quint8(TextValue));
+            write(qint32(text.size()));
+            arena.append(reinterpret_cast<const char*>(text.constData()), text.size() * sizeof(QChar));
+            break;
+        }
+
+        default: {
+            // Даты и прочие типы - через QDataStream
+            QByteArray blob;
+            QDataStream out(&blob, QIODevice::WriteOnly);
+            out << value;
+            write(quint8(OtherValue));
+            write(qint32(blob.size()));
+            arena.append(blob);
+            break;
+        }
+    }
+    return offset;
+}
+
+quint32 EditJournal::firstOffset(const Delta& delta) const {
+    return delta.before != kNoValue ? delta.before : delta.after;
+}
+
+void EditJournal::truncate(int step) {
+    if (step >= steps.size()) {
+        return;
+    }
+    const int first = steps[step].first;
+    arena.truncate(firstOffset(deltas[first]));
+    deltas.resize(first);
+    steps.resize(step);
+    position = qMin(position, step);
+}
+
+void EditJournal::dropOldest() {
+    steps.removeFirst();
+    --position;
+
+    // Значения шагов лежат в arena подряд: отброшенный шаг остаётся мёртвым началом arena
+    // и deltas. Сжатие со сдвигом смещений - только когда мёртвая часть больше живой,
+    // поэтому на каждый отброшенный шаг приходится O(1) в среднем
+    const int deadDeltas = steps.isEmpty() ? int(deltas.size()) : steps.first().first;
+    const quint32 deadBytes = steps.isEmpty() ? quint32(arena.size()) : firstOffset(deltas[deadDeltas]);
+    if (deadBytes <= quint32(arena.size()) - deadBytes) {
+        return;
+    }
+    arena = arena.sliced(deadBytes);
+    deltas = deltas.sliced(deadDeltas);
+    for (Delta& delta : deltas) {
+        delta.before = delta.before != kNoValue ? delta.before - deadBytes : kNoValue;
+        delta.after = delta.after != kNoValue ? delta.after - deadBytes : kNoValue;
+    }
+    for (Step& step : steps) {
+        step.first -= deadDeltas;
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef QFORGE_EDITJOURNAL_H
+#define QFORGE_EDITJOURNAL_H
+
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Журнал отмены правок модели: компактные дельты и значения в одном буфере.
+ *
+ * Шаг журнала - одна операция (setData, пакетная запись ячеек, добавление или удаление
+ * строк) и непрерывный отрезок дельт. Дельта - стабильный номер строки, колонка и смещения
+ * значений до и после правки в arena. Значения кодируются по типу (число - 9 байт, строка -
+ * длина и UTF-16), а не хранятся как QVariant. Стабильный номер не меняется при удалении
+ * других строк, поэтому дельта находит свою строку и после сдвигов; номера возрастают
+ * по строкам хранилища, поиск строки - двоичный. У удалённой строки номер сохраняется
+ * и при отмене задаёт её прежнее место среди оставшихся.
+ */
+class EditJournal
+{
+public:
+    static constexpr quint32 kNoValue = 0xFFFFFFFF;
+
+    struct Delta {
+        quint32 row;    //!< Стабильный номер строки.
+        qint32 column;  //!< -1 - строка целиком (добавление или удаление).
+        quint32 before; //!< Смещение значения до правки; kNoValue у добавленной строки.
+        quint32 after;  //!< Смещение значения после правки; kNoValue у удалённой строки.
+    };
+
+    struct Step {
+        int first; //!< Первая дельта шага.
+        int count;
+    };
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool on, int rowCount);
+    void setLimit(int count); //!< Число хранимых шагов; 0 - без ограничения.
+    void clear();             //!< Удаляет шаги; стабильные номера строк сохраняются.
+
+    // Стабильные номера строк хранилища
+    void resetRows(int count);
+    void appendRows(int count);
+    void remapRows(const QVector<int>& newRows); //!< Старая строка -> новая (-1 - удалена).
+    quint32 rowId(int row) const { return ids[row]; }
+    int row(quint32 id) const;      //!< Строка хранилища или -1, если строки больше нет.
+    int position(quint32 id) const; //!< Место строки с номером id среди текущих строк.
+
+    /*!
+     * \brief Возвращает строки с прежними номерами.
+     * \param rows Номера строк хранилища после вставки по возрастанию.
+     */
+    void insertRows(const QVector<int>& rows, const QVector<quint32>& rowIds);
+
+    // Запись шага; вне beginStep/endStep правки не записываются
+    void beginStep();
+    void recordCell(int row, int column, const QVariant& before, const QVariant& after);
+    void recordRow(int row, const QVariantList& values, bool inserted);
+
+    /*!
+     * \brief Завершает шаг: пустой отбрасывается, правка той же ячейки, что и в предыдущем
+     * шаге, сливается с ним (если значение вернулось к исходному - шаг исчезает).
+     */
+    void endStep();
+
+    bool canUndo() const { return position > 0; }
+    bool canRedo() const { return position < steps.size(); }
+    bool undo(Step& step); //!< Шаг для отката; дельты применяются с конца.
+    bool redo(Step& step);
+    const Delta& delta(int index) const { return deltas[index]; }
+
+    QVariant value(quint32 offset) const;
+    QVariantList values(quint32 offset, int count) const;
+
+private:
+    static constexpr int kNotRecording = -1;
+    static constexpr int kStepStarted = -2; //!< Шаг начат, правок ещё нет.
+
+    bool startDelta(); //!< false вне шага; при первой правке шага отбрасывает отменённые шаги.
+    quint32 append(const QVariant& value);
+    quint32 firstOffset(const Delta& delta) const;
+    void truncate(int step); //!< Удаляет шаги начиная со step вместе с их значениями.
+    void dropOldest(); //!< Значения отброшенного шага сжимаются, когда их больше, чем живых.
+
+    bool enabled = false;
+    int limit = 0;
+    QVector<Step> steps;
+    QVector<Delta> deltas;
+    QByteArray arena;
+    int position = 0;              //!< Число применённых шагов.
+    int recording = kNotRecording; //!< Первая дельта записываемого шага.
+    bool mergeable = false;        //!< Последний шаг можно дополнить правкой той же ячейки.
+
+    QVector<quint32> ids; //!< Строка хранилища -> стабильный номер (по возрастанию).
+    quint32 nextId = 0;
+};
+
+}
+
+#endif // QFORGE_EDITJOURNAL_H
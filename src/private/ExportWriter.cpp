@@ -0,0 +1,424 @@
+#include "ExportWriter.h"
+
+#include <QDateTime>
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace QForge::nsModel {
+
+bool ExportWriter::parseFormat(const QString& name, Format& format) {
+    const QString lower = name.trimmed().toLower();
+    if (lower == QLatin1String("csv")) {
+        format = Format::Csv;
+    } else if (lower == QLatin1String("json")) {
+        format = Format::Json;
+    } else if (lower == QLatin1String("xml")) {
+        format = Format::Xml;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ExportWriter::ExportWriter(QIODevice* device, Format format, const ExportSettings& settings, const QStringList& columns)
+    : device(device)
+    , format(format)
+    , settings(settings)
+    , columns(columns)
+    , delimiter(settings.csvDelimiter.isEmpty() ? QChar(',') : settings.csvDelimiter.at(0))
+    , quote(settings.csvQuoteChar.isEmpty() ? QChar('"') : settings.csvQuoteChar.at(0))
+    , encoder(QStringConverter::Utf8)
+{
+    buffer.reserve(kBufferSize);
+
+    if (format == Format::Json) {
+        rowOpen = settings.jsonPrettyPrint ? "\n  {" : "{";
+        rowClose = settings.jsonPrettyPrint ? "\n  }" : "}";
+    } else if (format == Format::Xml) {
+        const QByteArray row = settings.xmlRowElement.isEmpty() ? QByteArray("row") : settings.xmlRowElement.toUtf8();
+        rowOpen = "  <" + row + '>';
+        rowClose = "</" + row + ">\n";
+    } else {
+        rowClose = "\r\n";
+    }
+
+    // Обрамление полей не зависит от строки: готовим его один раз
+    openTags.reserve(columns.size());
+    closeTags.reserve(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+        QByteArray open;
+        QByteArray close;
+        switch (format) {
+            case Format::Csv:
+                if (i > 0) {
+                    open = QString(delimiter).toUtf8();
+                }
+                break;
+
+            case Format::Json: {
+                if (i > 0) {
+                    open += ',';
+                }
+                if (settings.jsonPrettyPrint) {
+                    open += "\n    ";
+                }
+                QString key = columns[i];
+                key.replace(QLatin1Char('\\'), QLatin1String("\\\\")).replace(QLatin1Char('"'), QLatin1String("\\\""));
+                open += '"' + key.toUtf8() + "\":";
+                if (settings.jsonPrettyPrint) {
+                    open += ' ';
+                }
+                break;
+            }
+
+            case Format::Xml:
+                open = '<' + columns[i].toUtf8() + '>';
+                close = "</" + columns[i].toUtf8() + '>';
+                break;
+        }
+        openTags.append(open);
+        closeTags.append(close);
+    }
+}
+
+bool ExportWriter::begin() {
+    switch (format) {
+        case Format::Csv:
+            if (settings.csvIncludeHeaders) {
+                for (int i = 0; i < columns.size(); ++i) {
+                    append(openTags[i]);
+                    appendCsvField(columns[i]);
+                }
+                append("\r\n", 2);
+            }
+            break;
+
+        case Format::Json:
+            append('[');
+            break;
+
+        case Format::Xml:
+            append(QByteArrayLiteral("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<"));
+            append(rootElement());
+            append(">\n", 2);
+            break;
+    }
+    return !hasError();
+}
+
+bool ExportWriter::finish() {
+    switch (format) {
+        case Format::Csv:
+            break;
+
+        case Format::Json:
+            append(rows > 0 && settings.jsonPrettyPrint ? QByteArrayLiteral("\n]\n") : QByteArrayLiteral("]\n"));
+            break;
+
+        case Format::Xml:
+            append("</", 2);
+            append(rootElement());
+            append(">\n", 2);
+            break;
+    }
+    return flush();
+}
+
+void ExportWriter::writeRow(const ColumnStore& store, int row) {
+    beginRow();
+    const int count = qMin(int(columns.size()), store.columnCount());
+    for (int i = 0; i < count; ++i) {
+        writeStoreValue(store.column(i), i, row);
+    }
+    endRow();
+}
+
+void ExportWriter::writeRow(const QVariantList& values) {
+    beginRow();
+    const int count = qMin(columns.size(), values.size());
+    for (int i = 0; i < count; ++i) {
+        writeValue(i, values[i]);
+    }
+    endRow();
+}
+
+QByteArray ExportWriter::rootElement() const {
+    return settings.xmlRootElement.isEmpty() ? QByteArray("data") : settings.xmlRootElement.toUtf8();
+}
+
+void ExportWriter::beginRow() {
+    if (format == Format::Json && rows > 0) {
+        append(',');
+    }
+    append(rowOpen);
+}
+
+void ExportWriter::endRow() {
+    append(rowClose);
+    ++rows;
+}
+
+void ExportWriter::writeNull(int column) {
+    // В XML NULL - отсутствующий элемент, в CSV - пустое поле
+    if (format == Format::Xml) {
+        return;
+    }
+    append(openTags[column]);
+    if (format == Format::Json) {
+        append("null", 4);
+    }
+}
+
+void ExportWriter::writeInt(int column, qint64 value) {
+    char text[24];
+    const auto result = std::to_chars(text, text + sizeof(text), value);
+    append(openTags[column]);
+    append(text, result.ptr - text);
+    append(closeTags[column]);
+}
+
+void ExportWriter::writeDouble(int column, double value) {
+    if (!std::isfinite(value)) {
+        if (format == Format::Json) {
+            writeNull(column);
+        } else {
+            writeText(column, std::isnan(value) ? u"nan" : value > 0 ? u"inf" : u"-inf");
+        }
+        return;
+    }
+    // Кратчайшая запись, читаемая обратно без потерь; не зависит от локали
+    char text[32];
+    const auto result = std::to_chars(text, text + sizeof(text), value);
+    append(openTags[column]);
+    append(text, result.ptr - text);
+    append(closeTags[column]);
+}
+
+void ExportWriter::writeBool(int column, bool value) {
+    append(openTags[column]);
+    append(value ? QByteArrayLiteral("true") : QByteArrayLiteral("false"));
+    append(closeTags[column]);
+}
+
+void ExportWriter::writeText(int column, QStringView text) {
+    append(openTags[column]);
+    switch (format) {
+        case Format::Csv:
+            appendCsvField(text);
+            break;
+
+        case Format::Json:
+            append('"');
+            appendEscaped(text);
+            append('"');
+            break;
+
+        case Format::Xml:
+            appendEscaped(text);
+            break;
+    }
+    append(closeTags[column]);
+}
+
+void ExportWriter::writeValue(int column, const QVariant& value) {
+    if (value.isNull()) {
+        writeNull(column);
+        return;
+    }
+    switch (value.typeId()) {
+        case QMetaType::Bool:
+            writeBool(column, value.toBool());
+            break;
+
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::LongLong:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+            writeInt(column, value.toLongLong());
+            break;
+
+        case QMetaType::ULongLong:
+        case QMetaType::ULong:
+            writeText(column, value.toString());
+            break;
+
+        case QMetaType::Double:
+        case QMetaType::Float:
+            writeDouble(column, value.toDouble());
+            break;
+
+        case QMetaType::QString:
+            writeText(column, *static_cast<const QString*>(value.constData()));
+            break;
+
+        case QMetaType::QDateTime:
+            writeText(column, value.toDateTime().toString(Qt::ISODateWithMs));
+            break;
+
+        case QMetaType::QByteArray:
+            writeText(column, QString::fromLatin1(value.toByteArray().toBase64()));
+            break;
+
+        default:
+            writeText(column, value.toString());
+            break;
+    }
+}
+
+void ExportWriter::writeStoreValue(const TypedColumn& column, int index, int row) {
+    if (column.isNull(row)) {
+        writeNull(index);
+        return;
+    }
+    switch (column.kind) {
+        case StorageKind::Int64:
+            if (column.type == ColumnType::Integer) {
+                writeInt(index, column.ints[row]);
+            } else if (column.type == ColumnType::Boolean) {
+                writeBool(index, column.ints[row] != 0);
+            } else {
+                // Даты и время хранятся числом; текст формирует QVariant
+                writeValue(index, column.value(row));
+            }
+            break;
+
+        case StorageKind::Double:
+            writeDouble(index, column.doubles[row]);
+            break;
+
+        case StorageKind::String:
+            writeText(index, column.strings[row]);
+            break;
+
+        case StorageKind::Variant:
+            writeValue(index, column.variants[row]);
+            break;
+    }
+}
+
+void ExportWriter::append(const char* data, qsizetype size) {
+    if (buffer.size() + size > kBufferSize && !flush()) {
+        return;
+    }
+    if (size > kBufferSize) {
+        if (device->write(data, size) != size) {
+            error = device->errorString();
+            return;
+        }
+        written += size;
+        return;
+    }
+    buffer.append(data, size);
+}
+
+void ExportWriter::appendUtf8(QStringView text) {
+    if (text.isEmpty()) {
+        return;
+    }
+    const qsizetype required = encoder.requiredSpace(text.size());
+    if (buffer.size() + required > kBufferSize && !flush()) {
+        return;
+    }
+    if (required > kBufferSize) {
+        append(text.toUtf8());
+        return;
+    }
+    const qsizetype at = buffer.size();
+    buffer.resize(at + required);
+    char* end = encoder.appendToBuffer(buffer.data() + at, text);
+    buffer.resize(end - buffer.constData());
+}
+
+void ExportWriter::appendEscaped(QStringView text) {
+    // Отрезки без спецсимволов копируются одним appendUtf8
+    qsizetype run = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t c = text[i].unicode();
+        const char* escape = nullptr;
+        char code[8];
+
+        switch (format) {
+            case Format::Csv:
+                if (c == quote.unicode()) {
+                    appendUtf8(text.sliced(run, i + 1 - run)); // кавычка удваивается
+                    run = i;
+                }
+                continue;
+
+            case Format::Json:
+                if (c == u'"') {
+                    escape = "\\\"";
+                } else if (c == u'\\') {
+                    escape = "\\\\";
+                } else if (c == u'\n') {
+                    escape = "\\n";
+                } else if (c == u'\r') {
+                    escape = "\\r";
+                } else if (c == u'\t') {
+                    escape = "\\t";
+                } else if (c < 0x20) {
+                    std::snprintf(code, sizeof(code), "\\u%04x", unsigned(c));
+                    escape = code;
+                }
+                break;
+
+            case Format::Xml:
+                if (c == u'&') {
+                    escape = "&amp;";
+                } else if (c == u'<') {
+                    escape = "&lt;";
+                } else if (c == u'>') {
+                    escape = "&gt;";
+                } else if (c < 0x20 && c != u'\n' && c != u'\r' && c != u'\t') {
+                    escape = ""; // недопустим в XML 1.0
+                }
+                break;
+        }
+        if (!escape) {
+            continue;
+        }
+        appendUtf8(text.sliced(run, i - run));
+        append(escape, qsizetype(std::strlen(escape)));
+        run = i + 1;
+    }
+    appendUtf8(text.sliced(run));
+}
+
+void ExportWriter::appendCsvField(QStringView text) {
+    bool quoted = false;
+    for (const QChar c : text) {
+        if (c == delimiter || c == quote || c == u'\n' || c == u'\r') {
+            quoted = true;
+            break;
+        }
+    }
+    if (!quoted) {
+        appendUtf8(text);
+        return;
+    }
+    appendUtf8(QStringView(&quote, 1));
+    appendEscaped(text);
+    appendUtf8(QStringView(&quote, 1));
+}
+
+bool ExportWriter::flush() {
+    if (hasError()) {
+        return false;
+    }
+    if (!buffer.isEmpty()) {
+        if (device->write(buffer) != buffer.size()) {
+            error = device->errorString();
+            return false;
+        }
+        written += buffer.size();
+        buffer.resize(0);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef QFORGE_EXPORTWRITER_H
+#define QFORGE_EXPORTWRITER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QStringConverter>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include "ColumnStore.h"
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Потоковая запись строк в csv, json или xml по export_settings схемы.
+ *
+ * Поля кодируются прямо в выходной буфер фиксированного размера: текст - в UTF-8
+ * через QStringEncoder, числа - в стековый массив, без промежуточных QString и QByteArray
+ * на поле или строку. Заполненный буфер сбрасывается в устройство, поэтому память
+ * не зависит от числа строк. Строки хранилища пишутся из типизированных колонок,
+ * строки курсора - из QVariant.
+ */
+class ExportWriter
+{
+public:
+    enum class Format { Csv, Json, Xml };
+
+    static constexpr int kBufferSize = 1 << 16;
+
+    /*!
+     * \brief Формат по имени ("csv", "json", "xml"; без учёта регистра).
+     */
+    static bool parseFormat(const QString& name, Format& format);
+
+    ExportWriter(QIODevice* device, Format format, const ExportSettings& settings, const QStringList& columns);
+
+    bool begin();  //!< Заголовок CSV, "[" или корневой элемент XML.
+    bool finish(); //!< Закрывает документ и сбрасывает буфер.
+
+    void writeRow(const ColumnStore& store, int row);
+    void writeRow(const QVariantList& values);
+
+    qint64 bytesWritten() const { return written + buffer.size(); }
+    bool hasError() const { return !error.isEmpty(); }
+    QString errorString() const { return error; }
+
+private:
+    QByteArray rootElement() const;
+    void beginRow();
+    void endRow();
+
+    void writeNull(int column);
+    void writeInt(int column, qint64 value);
+    void writeDouble(int column, double value);
+    void writeBool(int column, bool value);
+    void writeText(int column, QStringView text);
+    void writeValue(int column, const QVariant& value);
+    void writeStoreValue(const TypedColumn& column, int index, int row);
+
+    void append(const char* data, qsizetype size);
+    void append(char c) { append(&c, 1); }
+    void append(const QByteArray& data) { append(data.constData(), data.size()); }
+    void appendUtf8(QStringView text);
+    void appendEscaped(QStringView text); //!< Экранирование по формату (кавычки CSV, JSON, сущности XML).
+    void appendCsvField(QStringView text);
+    bool flush();
+
+    QIODevice* device;
+    Format format;
+    ExportSettings settings;
+    QStringList columns;
+    QVector<QByteArray> openTags;  //!< Начало поля: разделитель CSV, ключ JSON, открывающий тег XML.
+    QVector<QByteArray> closeTags; //!< Конец поля: закрывающий тег XML.
+    QByteArray rowOpen;
+    QByteArray rowClose;
+    QChar delimiter;
+    QChar quote;
+    QStringEncoder encoder;
+    QByteArray buffer;
+    qint64 written = 0;
+    qint64 rows = 0;
+    QString error;
+};
+
+}
+
+#endif // QFORGE_EXPORTWRITER_H
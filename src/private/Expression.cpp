@@ -0,0 +1,569 @@
+#include "Expression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace QForge::nsModel {
+
+using Op = ExpressionProgram::Op;
+
+// ========== HELPER FUNCTIONS ==========
+
+static bool isNumericType(ColumnType type) {
+    switch (type) {
+        case ColumnType::Integer:
+        case ColumnType::Double:
+        case ColumnType::Boolean:
+        case ColumnType::Date:
+        case ColumnType::Time:
+        case ColumnType::DateTime:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Поэлементные циклы над пачкой: без ветвлений по типам, векторизуются компилятором
+template <typename F>
+static inline void unary(int n, const double* a, const quint8* an, double* d, quint8* dn, F f) {
+    for (int i = 0; i < n; ++i) {
+        d[i] = f(a[i]);
+        dn[i] = an[i];
+    }
+}
+
+template <typename F>
+static inline void binary(int n, const double* a, const quint8* an, const double* b, const quint8* bn,
+                          double* d, quint8* dn, F f) {
+    for (int i = 0; i < n; ++i) {
+        d[i] = f(a[i], b[i]);
+        dn[i] = an[i] | bn[i];
+    }
+}
+
+namespace {
+
+/**
+ * @brief Разбор выражения рекурсивным спуском с выдачей байткода по ходу разбора.
+ *
+ * Каждый узел получает собственный регистр; результат узла - номер регистра.
+ */
+struct Parser
+{
+    const QString& text;
+    const QVector<Column>& columns;
+    int target;
+    ExpressionProgram& program;
+    QString error;
+    int pos = 0;
+
+    bool failed() const { return !error.isEmpty(); }
+
+    void fail(const QString& message) {
+        if (error.isEmpty()) {
+            error = QString("%1 at position %2").arg(message).arg(pos + 1);
+        }
+    }
+
+    void skipSpaces() {
+        while (pos < text.size() && text[pos].isSpace()) {
+            ++pos;
+        }
+    }
+
+    bool match(const char* token) {
+        skipSpaces();
+        const QLatin1String literal(token);
+        if (QStringView(text).mid(pos).startsWith(literal)) {
+            pos += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    int append(Op op, int a = 0, int b = 0, int c = 0, int operand = 0) {
+        if (program.registers >= 0xFFFF) {
+            fail("Expression is too long");
+            return 0;
+        }
+        ExpressionProgram::Instruction instruction;
+        instruction.op = op;
+        instruction.dst = quint16(program.registers++);
+        instruction.a = quint16(a);
+        instruction.b = quint16(b);
+        instruction.c = quint16(c);
+        instruction.operand = operand;
+        program.code.append(instruction);
+        return instruction.dst;
+    }
+
+    int constant(double value) {
+        program.constants.append(value);
+        return append(Op::Const, 0, 0, 0, program.constants.size() - 1);
+    }
+
+    // ternary := or ('?' ternary ':' ternary)?
+    int ternary() {
+        const int condition = logicalOr();
+        if (failed() || !match("?")) {
+            return condition;
+        }
+        const int whenTrue = ternary();
+        if (!failed() && !match(":")) {
+            fail("Expected ':'");
+        }
+        const int whenFalse = failed() ? 0 : ternary();
+        return failed() ? 0 : append(Op::Select, condition, whenTrue, whenFalse);
+    }
+
+    int logicalOr() {
+        int lhs = logicalAnd();
+        while (!failed() && match("||")) {
+            lhs = append(Op::Or, lhs, logicalAnd());
+        }
+        return lhs;
+    }
+
+    int logicalAnd() {
+        int lhs = comparison();
+        while (!failed() && match("&&")) {
+            lhs = append(Op::And, lhs, comparison());
+        }
+        return lhs;
+    }
+
+    int comparison() {
+        const int lhs = additive();
+        if (failed()) {
+            return lhs;
+        }
+        // Двухсимвольные операторы проверяются раньше односимвольных
+        static const struct { const char* token; Op op; } operators[] = {
+            {"<=", Op::Le}, {">=", Op::Ge}, {"==", Op::Eq}, {"!=", Op::Ne}, {"<", Op::Lt}, {">", Op::Gt}
+        };
+        for (const auto& candidate : operators) {
+            if (match(candidate.token)) {
+                return append(candidate.op, lhs, additive());
+            }
+        }
+        return lhs;
+    }
+
+    int additive() {
+        int lhs = multiplicative();
+        while (!failed()) {
+            if (match("+")) {
+                lhs = append(Op::Add, lhs, multiplicative());
+            } else if (match("-")) {
+                lhs = append(Op::Sub, lhs, multiplicative());
+            } else {
+                break;
+            }
+        }
+        return lhs;
+    }
+
+    int multiplicative() {
+        int lhs = unaryOp();
+        while (!failed()) {
+            if (match("*")) {
+                lhs = append(Op::Mul, lhs, unaryOp());
+            } else if (match("/")) {
+                lhs = append(Op::Div, lhs, unaryOp());
+            } else if (match("%")) {
+                lhs = append(Op::Mod, lhs, unaryOp());
+            } else {
+                break;
+            }
+        }
+        return lhs;
+    }
+
+    int unaryOp() {
+        if (match("-")) {
+            return append(Op::Neg, unaryOp());
+        }
+        if (match("!")) {
+            return append(Op::Not, unaryOp());
+        }
+        if (match("+")) {
+            return unaryOp();
+        }
+        return primary();
+    }
+
+    int primary() {
+        skipSpaces();
+        if (pos >= text.size()) {
+            fail("Unexpected end of expression");
+            return 0;
+        }
+
+        if (match("(")) {
+            const int inner = ternary();
+            if (!failed() && !match(")")) {
+                fail("Expected ')'");
+            }
+            return inner;
+        }
+
+        const QChar ch = text[pos];
+        if (ch.isDigit() || ch == '.') {
+            return number();
+        }
+        if (ch.isLetter() || ch == '_') {
+            return name();
+        }
+
+        fail(QString("Unexpected '%1'").arg(ch));
+        return 0;
+    }
+
+    int number() {
+        const int start = pos;
+        while (pos < text.size() && (text[pos].isDigit() || text[pos] == '.')) {
+            ++pos;
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            ++pos;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+                ++pos;
+            }
+            while (pos < text.size() && text[pos].isDigit()) {
+                ++pos;
+            }
+        }
+        bool ok = false;
+        const double value = QStringView(text).mid(start, pos - start).toDouble(&ok);
+        if (!ok) {
+            pos = start;
+            fail("Invalid number");
+            return 0;
+        }
+        return constant(value);
+    }
+
+    int name() {
+        const int start = pos;
+        while (pos < text.size() && (text[pos].isLetterOrNumber() || text[pos] == '_')) {
+            ++pos;
+        }
+        const QString identifier = text.mid(start, pos - start);
+
+        if (match("(")) {
+            return function(identifier);
+        }
+        if (identifier == "true" || identifier == "false") {
+            return constant(identifier == "true" ? 1.0 : 0.0);
+        }
+        return column(identifier, start);
+    }
+
+    int function(const QString& functionName) {
+        QVector<int> arguments;
+        if (!match(")")) {
+            do {
+                arguments.append(ternary());
+            } while (!failed() && match(","));
+            if (!failed() && !match(")")) {
+                fail("Expected ')'");
+            }
+        }
+        if (failed()) {
+            return 0;
+        }
+
+        static const struct { const char* name; Op op; } unaryFunctions[] = {
+            {"abs", Op::Abs}, {"sqrt", Op::Sqrt}, {"round", Op::Round}, {"floor", Op::Floor}, {"ceil", Op::Ceil}
+        };
+        for (const auto& candidate : unaryFunctions) {
+            if (functionName == QLatin1String(candidate.name)) {
+                if (arguments.size() != 1) {
+                    fail(QString("Function '%1' takes one argument").arg(functionName));
+                    return 0;
+                }
+                return append(candidate.op, arguments[0]);
+            }
+        }
+
+        if (functionName == "min" || functionName == "max") {
+            if (arguments.size() < 2) {
+                fail(QString("Function '%1' takes at least two arguments").arg(functionName));
+                return 0;
+            }
+            const Op op = functionName == "min" ? Op::Min : Op::Max;
+            int result = arguments[0];
+            for (int i = 1; i < arguments.size(); ++i) {
+                result = append(op, result, arguments[i]);
+            }
+            return result;
+        }
+
+        fail(QString("Unknown function '%1'").arg(functionName));
+        return 0;
+    }
+
+    int column(const QString& columnName, int start) {
+        int index = -1;
+        for (int i = 0; i < columns.size(); ++i) {
+            if (columns[i].name == columnName) {
+                index = i;
+                break;
+            }
+        }
+
+        pos = start;
+        if (index < 0) {
+            fail(QString("Unknown column '%1'").arg(columnName));
+            return 0;
+        }
+        if (index == target) {
+            fail(QString("Column '%1' refers to itself").arg(columnName));
+            return 0;
+        }
+        if (!isNumericType(columns[index].type)) {
+            fail(QString("Column '%1' is not numeric").arg(columnName));
+            return 0;
+        }
+        pos = start + columnName.size();
+
+        if (!program.columns.contains(index)) {
+            program.columns.append(index);
+        }
+        return append(Op::Load, 0, 0, 0, index);
+    }
+};
+
+}
+
+// ========== ExpressionCompiler ==========
+
+bool ExpressionCompiler::compile(const QString& expression, const QVector<Column>& columns, int target,
+                                 ExpressionProgram& program, QString& error) {
+    ExpressionProgram compiled;
+    Parser parser{expression, columns, target, compiled, QString()};
+
+    compiled.result = parser.ternary();
+    parser.skipSpaces();
+    if (!parser.failed() && parser.pos < expression.size()) {
+        parser.fail(QString("Unexpected '%1'").arg(expression[parser.pos]));
+    }
+    if (parser.failed()) {
+        error = parser.error;
+        return false;
+    }
+
+    program = std::move(compiled);
+    return true;
+}
+
+// ========== CalculationPlan ==========
+
+bool CalculationPlan::build(const QVector<Column>& columns, QStringList& errors) {
+    clear();
+
+    // Выражения компилируются в порядке схемы; slot[i] - номер колонки i среди вычисляемых
+    QVector<CalculatedColumn> compiled;
+    QVector<int> slot(columns.size(), -1);
+    bool ok = true;
+    for (int i = 0; i < columns.size(); ++i) {
+        if (!columns[i].isCalculated) {
+            continue;
+        }
+        CalculatedColumn entry;
+        entry.column = i;
+        QString error;
+        if (!ExpressionCompiler::compile(columns[i].calculationExpression, columns, i, entry.program, error)) {
+            errors.append(QString("Calculated column '%1': %2").arg(columns[i].name, error));
+            ok = false;
+            continue;
+        }
+        slot[i] = compiled.size();
+        compiled.append(entry);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // Топологическая сортировка обходом в глубину; путь обхода нужен для текста ошибки
+    enum State : quint8 { Unvisited, Visiting, Done };
+    QVector<State> state(compiled.size(), Unvisited);
+    QVector<int> path;
+    std::function<bool(int)> visit = [&](int node) {
+        if (state[node] == Done) {
+            return true;
+        }
+        if (state[node] == Visiting) {
+            QStringList cycle;
+            for (int i = path.indexOf(node); i < path.size(); ++i) {
+                cycle.append(columns[compiled[path[i]].column].name);
+            }
+            cycle.append(columns[compiled[node].column].name);
+            errors.append(QString("Calculated columns form a cycle: %1").arg(cycle.join(" -> ")));
+            return false;
+        }
+        state[node] = Visiting;
+        path.append(node);
+        for (int dependency : std::as_const(compiled[node].program.columns)) {
+            if (slot[dependency] >= 0 && !visit(slot[dependency])) {
+                return false;
+            }
+        }
+        path.removeLast();
+        state[node] = Done;
+        ordered.append(compiled[node]);
+        return true;
+    };
+    for (int i = 0; i < compiled.size(); ++i) {
+        if (!visit(i)) {
+            clear();
+            return false;
+        }
+    }
+
+    // Транзитивные источники каждой колонки: свои плюс источники вычисляемых, от которых
+    // она зависит (они уже обработаны). Обход по порядку даёт списки в порядке пересчёта.
+    QVector<int> position(columns.size(), -1);
+    QVector<QVector<bool>> sources(ordered.size());
+    affected.resize(columns.size());
+    for (int p = 0; p < ordered.size(); ++p) {
+        position[ordered[p].column] = p;
+        QVector<bool>& reach = sources[p];
+        reach.fill(false, columns.size());
+        for (int dependency : std::as_const(ordered[p].program.columns)) {
+            reach[dependency] = true;
+            if (position[dependency] >= 0) {
+                const QVector<bool>& inherited = sources[position[dependency]];
+                for (int c = 0; c < columns.size(); ++c) {
+                    reach[c] = reach[c] || inherited[c];
+                }
+            }
+        }
+        for (int c = 0; c < columns.size(); ++c) {
+            if (reach[c]) {
+                affected[c].append(p);
+            }
+        }
+    }
+    return true;
+}
+
+void CalculationPlan::clear() {
+    ordered.clear();
+    affected.clear();
+}
+
+const QVector<int>& CalculationPlan::dependents(int column) const {
+    static const QVector<int> none;
+    return column >= 0 && column < affected.size() ? affected[column] : none;
+}
+
+// ========== ExpressionVM ==========
+
+void ExpressionVM::run(const ExpressionProgram& program, const ColumnStore& store, int first, int count,
+                       TypedColumn& out) {
+    if (program.isEmpty() || count <= 0) {
+        return;
+    }
+
+    values.resize(program.registers * kBatchSize);
+    nulls.resize(program.registers * kBatchSize);
+
+    for (int start = first; start < first + count; start += kBatchSize) {
+        const int n = qMin(kBatchSize, first + count - start);
+
+        for (const ExpressionProgram::Instruction& instruction : program.code) {
+            double* d = values.data() + instruction.dst * kBatchSize;
+            quint8* dn = nulls.data() + instruction.dst * kBatchSize;
+            const double* a = values.constData() + instruction.a * kBatchSize;
+            const quint8* an = nulls.constData() + instruction.a * kBatchSize;
+            const double* b = values.constData() + instruction.b * kBatchSize;
+            const quint8* bn = nulls.constData() + instruction.b * kBatchSize;
+
+            switch (instruction.op) {
+                case Op::Load:
+                    load(store.column(instruction.operand), start, n, d, dn);
+                    break;
+                case Op::Const:
+                    std::fill(d, d + n, program.constants[instruction.operand]);
+                    std::fill(dn, dn + n, quint8(0));
+                    break;
+                case Op::Add: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x + y; }); break;
+                case Op::Sub: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x - y; }); break;
+                case Op::Mul: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x * y; }); break;
+                case Op::Div:
+                case Op::Mod:
+                    // Деление на ноль - NULL, а не бесконечность
+                    for (int i = 0; i < n; ++i) {
+                        const bool zero = b[i] == 0.0;
+                        const double divisor = zero ? 1.0 : b[i];
+                        d[i] = instruction.op == Op::Div ? a[i] / divisor : std::fmod(a[i], divisor);
+                        dn[i] = an[i] | bn[i] | quint8(zero);
+                    }
+                    break;
+                case Op::Neg: unary(n, a, an, d, dn, [](double x) { return -x; }); break;
+                case Op::Not: unary(n, a, an, d, dn, [](double x) { return x == 0.0 ? 1.0 : 0.0; }); break;
+                case Op::Lt: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x < y ? 1.0 : 0.0; }); break;
+                case Op::Le: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x <= y ? 1.0 : 0.0; }); break;
+                case Op::Gt: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x > y ? 1.0 : 0.0; }); break;
+                case Op::Ge: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x >= y ? 1.0 : 0.0; }); break;
+                case Op::Eq: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x == y ? 1.0 : 0.0; }); break;
+                case Op::Ne: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return x != y ? 1.0 : 0.0; }); break;
+                case Op::And:
+                    binary(n, a, an, b, bn, d, dn, [](double x, double y) { return (x != 0.0 && y != 0.0) ? 1.0 : 0.0; });
+                    break;
+                case Op::Or:
+                    binary(n, a, an, b, bn, d, dn, [](double x, double y) { return (x != 0.0 || y != 0.0) ? 1.0 : 0.0; });
+                    break;
+                case Op::Abs: unary(n, a, an, d, dn, [](double x) { return std::fabs(x); }); break;
+                case Op::Sqrt: unary(n, a, an, d, dn, [](double x) { return std::sqrt(x); }); break;
+                case Op::Round: unary(n, a, an, d, dn, [](double x) { return std::round(x); }); break;
+                case Op::Floor: unary(n, a, an, d, dn, [](double x) { return std::floor(x); }); break;
+                case Op::Ceil: unary(n, a, an, d, dn, [](double x) { return std::ceil(x); }); break;
+                case Op::Min: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return y < x ? y : x; }); break;
+                case Op::Max: binary(n, a, an, b, bn, d, dn, [](double x, double y) { return y > x ? y : x; }); break;
+                case Op::Select: {
+                    const double* c = values.constData() + instruction.c * kBatchSize;
+                    const quint8* cn = nulls.constData() + instruction.c * kBatchSize;
+                    for (int i = 0; i < n; ++i) {
+                        const bool pick = a[i] != 0.0;
+                        d[i] = pick ? b[i] : c[i];
+                        dn[i] = an[i] | (pick ? bn[i] : cn[i]);
+                    }
+                    break;
+                }
+            }
+        }
+
+        out.setNumbers(start, n, values.constData() + program.result * kBatchSize,
+                       nulls.constData() + program.result * kBatchSize);
+    }
+}
+
+void ExpressionVM::load(const TypedColumn& column, int first, int count, double* target, quint8* targetNulls) const {
+    switch (column.kind) {
+        case StorageKind::Int64:
+            for (int i = 0; i < count; ++i) {
+                target[i] = double(column.ints[first + i]);
+                targetNulls[i] = column.isNull(first + i);
+            }
+            break;
+        case StorageKind::Double:
+            for (int i = 0; i < count; ++i) {
+                target[i] = column.doubles[first + i];
+                targetNulls[i] = column.isNull(first + i);
+            }
+            break;
+        default:
+            // Колонка с нетипизированными значениями (например, после неудачного приведения)
+            for (int i = 0; i < count; ++i) {
+                bool ok = false;
+                target[i] = column.value(first + i).toDouble(&ok);
+                targetNulls[i] = !ok || column.isNull(first + i);
+            }
+            break;
+    }
+}
+
+}
@@ -0,0 +1,145 @@
+#ifndef QFORGE_EXPRESSION_H
+#define QFORGE_EXPRESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "ColumnStore.h"
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Скомпилированное выражение вычисляемой колонки.
+ *
+ * Байткод над регистрами: каждый регистр - пачка значений (double) и флагов NULL
+ * для подряд идущих строк. Инструкция обрабатывает пачку целиком простым циклом
+ * без ветвлений по типам, который компилятор может векторизовать.
+ */
+struct ExpressionProgram
+{
+    enum class Op : quint8 {
+        Load,   //!< dst = колонка operand хранилища.
+        Const,  //!< dst = constants[operand].
+        Add, Sub, Mul, Div, Mod,
+        Neg, Not,
+        Lt, Le, Gt, Ge, Eq, Ne,
+        And, Or,
+        Abs, Sqrt, Round, Floor, Ceil,
+        Min, Max,
+        Select  //!< dst = a ? b : c.
+    };
+
+    struct Instruction
+    {
+        Op op = Op::Const;
+        quint16 dst = 0;
+        quint16 a = 0;
+        quint16 b = 0;
+        quint16 c = 0;
+        int operand = 0;
+    };
+
+    QVector<Instruction> code;
+    QVector<double> constants;
+    QVector<int> columns; //!< Колонки хранилища, которые читает выражение (без повторов).
+    int registers = 0;
+    int result = 0;       //!< Регистр с результатом.
+
+    bool isEmpty() const { return code.isEmpty(); }
+};
+
+/**
+ * @brief Вычисляемая колонка модели и её скомпилированное выражение.
+ */
+struct CalculatedColumn
+{
+    int column = -1;
+    ExpressionProgram program;
+};
+
+/**
+ * @brief Компилятор выражений вычисляемых колонок.
+ *
+ * Поддерживаются числа, true/false, имена колонок, арифметика (+ - * / %),
+ * сравнения, && || !, тернарный оператор ?: и функции abs, sqrt, round, floor,
+ * ceil, min, max. Колонки читаются как числа (логические - 0/1, даты - по
+ * представлению в хранилище); строковые колонки в выражениях не допускаются.
+ * NULL в любом операнде, деление на ноль и нечисловой результат дают NULL.
+ */
+class ExpressionCompiler
+{
+public:
+    /*!
+     * \brief Компилирует выражение колонки target схемы.
+     * \details Ссылаться можно на любые числовые колонки, кроме самой target;
+     * циклы между вычисляемыми колонками отсекает CalculationPlan.
+     * \param error Описание ошибки (если выражение не скомпилировано).
+     * \return Флаг успеха.
+     */
+    static bool compile(const QString& expression, const QVector<Column>& columns, int target,
+                        ExpressionProgram& program, QString& error);
+};
+
+/**
+ * @brief Вычисляемые колонки схемы, упорядоченные по зависимостям.
+ *
+ * Граф зависимостей строится один раз при загрузке схемы: колонки сортируются
+ * топологически (цикл - ошибка), и для каждой колонки хранилища запоминается
+ * список вычисляемых колонок, прямо или через другие вычисляемые зависящих от неё.
+ * Правка ячейки пересчитывает только этот список - O(зависимых), а не O(всех).
+ */
+class CalculationPlan
+{
+public:
+    /*!
+     * \brief Компилирует выражения колонок и строит граф зависимостей.
+     * \param errors Ошибки выражений и найденный цикл в виде "a -> b -> a".
+     * \return Флаг успеха; при ошибке план пуст.
+     */
+    bool build(const QVector<Column>& columns, QStringList& errors);
+    void clear();
+
+    bool isEmpty() const { return ordered.isEmpty(); }
+
+    /*!
+     * \brief Вычисляемые колонки: каждая идёт после тех, от которых зависит.
+     */
+    const QVector<CalculatedColumn>& columns() const { return ordered; }
+
+    /*!
+     * \brief Номера в columns() колонок, зависящих от column, в порядке пересчёта.
+     */
+    const QVector<int>& dependents(int column) const;
+
+private:
+    QVector<CalculatedColumn> ordered;
+    QVector<QVector<int>> affected; //!< По номеру колонки хранилища.
+};
+
+/**
+ * @brief Исполнитель байткода: вычисляет выражение пачками по kBatchSize строк.
+ *
+ * Хранит рабочие регистры между вызовами; один экземпляр не используется из разных потоков.
+ */
+class ExpressionVM
+{
+public:
+    static constexpr int kBatchSize = 1024;
+
+    /*!
+     * \brief Вычисляет строки [first, first + count) и записывает их в колонку out.
+     */
+    void run(const ExpressionProgram& program, const ColumnStore& store, int first, int count, TypedColumn& out);
+
+private:
+    void load(const TypedColumn& column, int first, int count, double* values, quint8* nulls) const;
+
+    QVector<double> values;
+    QVector<quint8> nulls;
+};
+
+}
+
+#endif // QFORGE_EXPRESSION_H
@@ -0,0 +1,307 @@
+#include "FieldParser.h"
+
+#include <QDate>
+#include <QDateTime>
+#include <QTime>
+
+#include <charconv>
+#include <limits>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static constexpr qint64 kEpochJulianDay = 2440588; // 1970-01-01
+static constexpr qint64 kMsecsPerDay = 86400000;
+
+static inline void trim(const char*& text, int& size) {
+    while (size > 0 && (*text == ' ' || *text == '\t')) {
+        ++text;
+        --size;
+    }
+    while (size > 0 && (text[size - 1] == ' ' || text[size - 1] == '\t')) {
+        --size;
+    }
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Ровно count цифр с позиции pos
+static inline bool digits(const char* text, int size, int pos, int count, int& out) {
+    if (pos + count > size) {
+        return false;
+    }
+    out = 0;
+    for (int i = pos; i < pos + count; ++i) {
+        if (!isDigit(text[i])) {
+            return false;
+        }
+        out = out * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+static inline bool equalsLower(const char* text, int size, const char* word) {
+    int i = 0;
+    for (; i < size && word[i]; ++i) {
+        const char c = (text[i] >= 'A' && text[i] <= 'Z') ? char(text[i] - 'A' + 'a') : text[i];
+        if (c != word[i]) {
+            return false;
+        }
+    }
+    return i == size && !word[i];
+}
+
+// yyyy-MM-dd
+static bool parseDatePart(const char* text, int size, qint64& julianDay) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (size < 10 || !digits(text, size, 0, 4, year) || text[4] != '-'
+        || !digits(text, size, 5, 2, month) || text[7] != '-' || !digits(text, size, 8, 2, day)
+        || !QDate::isValid(year, month, day)) {
+        return false;
+    }
+    julianDay = QDate(year, month, day).toJulianDay();
+    return true;
+}
+
+// hh:mm[:ss[.zzz]]; возвращает число разобранных символов или 0
+static int parseTimePart(const char* text, int size, qint64& msecs) {
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int ms = 0;
+    if (!digits(text, size, 0, 2, hour) || size < 5 || text[2] != ':' || !digits(text, size, 3, 2, minute)) {
+        return 0;
+    }
+    int pos = 5;
+    if (pos < size && text[pos] == ':') {
+        if (!digits(text, size, pos + 1, 2, second)) {
+            return 0;
+        }
+        pos += 3;
+        if (pos < size && (text[pos] == '.' || text[pos] == ',')) {
+            // Доли секунды: берутся первые три цифры
+            int scale = 100;
+            ++pos;
+            const int first = pos;
+            for (; pos < size && isDigit(text[pos]); ++pos) {
+                ms += (text[pos] - '0') * scale;
+                scale /= 10;
+            }
+            if (pos == first) {
+                return 0;
+            }
+        }
+    }
+    if (hour > 23 || minute > 59 || second > 59) {
+        return 0;
+    }
+    msecs = ((hour * 60 + minute) * 60 + second) * 1000LL + ms;
+    return pos;
+}
+
+// Z | ±hh | ±hh:mm | ±hhmm
+static bool parseZone(const char* text, int size, qint64& offsetMsecs) {
+    if (size == 1 && (text[0] == 'Z' || text[0] == 'z')) {
+        offsetMsecs = 0;
+        return true;
+    }
+    if (size < 3 || (text[0] != '+' && text[0] != '-')) {
+        return false;
+    }
+    int hours = 0;
+    int minutes = 0;
+    if (!digits(text, size, 1, 2, hours)) {
+        return false;
+    }
+    if (size == 6 && text[3] == ':') {
+        if (!digits(text, size, 4, 2, minutes)) {
+            return false;
+        }
+    } else if (size == 5) {
+        if (!digits(text, size, 3, 2, minutes)) {
+            return false;
+        }
+    } else if (size != 3) {
+        return false;
+    }
+    offsetMsecs = (hours * 60 + minutes) * 60000LL * (text[0] == '-' ? -1 : 1);
+    return true;
+}
+
+// Дата, время и (если есть) смещение зоны
+static bool parseDateTimeParts(const char* text, int size, qint64& julianDay, qint64& timeMsecs,
+                               bool& hasZone, qint64& zoneMsecs) {
+    if (!parseDatePart(text, size, julianDay) || size < 16 || (text[10] != 'T' && text[10] != ' ')) {
+        return false;
+    }
+    const int consumed = parseTimePart(text + 11, size - 11, timeMsecs);
+    if (consumed == 0) {
+        return false;
+    }
+    const int rest = size - 11 - consumed;
+    hasZone = rest > 0;
+    return !hasZone || parseZone(text + 11 + consumed, rest, zoneMsecs);
+}
+
+// ========== PUBLIC METHODS ==========
+
+FieldParser::FieldParser(const TypedColumn& column) {
+    switch (column.kind) {
+        case StorageKind::Int64:
+            switch (column.type) {
+                case ColumnType::Boolean:  target = Target::Boolean; break;
+                case ColumnType::Date:     target = Target::Date; break;
+                case ColumnType::Time:     target = Target::Time; break;
+                case ColumnType::DateTime: target = Target::DateTime; break;
+                default:                   target = Target::Int64; break;
+            }
+            break;
+        case StorageKind::Double:
+            target = Target::Double;
+            break;
+        case StorageKind::String:
+            target = Target::String;
+            break;
+        case StorageKind::Variant:
+            target = Target::Variant;
+            break;
+    }
+}
+
+bool FieldParser::store(const char* text, int size, TypedColumn& column, int row) const {
+    qint64 value = 0;
+    bool ok = false;
+    switch (target) {
+        case Target::Int64:    ok = parseInt64(text, size, value); break;
+        case Target::Boolean:  ok = parseBoolean(text, size, value); break;
+        case Target::Date:     ok = parseDate(text, size, value); break;
+        case Target::Time:     ok = parseTime(text, size, value); break;
+        case Target::DateTime: ok = parseLocalDateTime(text, size, value); break;
+        case Target::Double:
+            return parseDouble(text, size, column.doubles[row]);
+        case Target::String:
+            column.strings[row] = QString::fromUtf8(text, size);
+            return true;
+        case Target::Variant:
+            column.variants[row] = QString::fromUtf8(text, size);
+            return true;
+    }
+    if (ok) {
+        column.ints[row] = value;
+    }
+    return ok;
+}
+
+bool FieldParser::parseInt64(const char* text, int size, qint64& out) {
+    trim(text, size);
+    if (size > 1 && text[0] == '+' && text[1] != '-') {
+        ++text;
+        --size;
+    }
+    qint64 value = 0;
+    const std::from_chars_result result = std::from_chars(text, text + size, value);
+    if (size == 0 || result.ec != std::errc() || result.ptr != text + size) {
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+bool FieldParser::parseDouble(const char* text, int size, double& out) {
+    trim(text, size);
+    if (size > 1 && text[0] == '+' && text[1] != '-') {
+        ++text;
+        --size;
+    }
+    if (size == 0) {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    double value = 0.0;
+    const std::from_chars_result result = std::from_chars(text, text + size, value);
+    if (result.ec != std::errc() || result.ptr != text + size) {
+        return false;
+    }
+    out = value;
+    return true;
+#else
+    bool ok = false;
+    const double value = QByteArray::fromRawData(text, size).toDouble(&ok);
+    if (ok) {
+        out = value;
+    }
+    return ok;
+#endif
+}
+
+bool FieldParser::parseBoolean(const char* text, int size, qint64& out) {
+    trim(text, size);
+    if (equalsLower(text, size, "true") || equalsLower(text, size, "1") || equalsLower(text, size, "yes")) {
+        out = 1;
+        return true;
+    }
+    if (equalsLower(text, size, "false") || equalsLower(text, size, "0") || equalsLower(text, size, "no")) {
+        out = 0;
+        return true;
+    }
+    return false;
+}
+
+bool FieldParser::parseDate(const char* text, int size, qint64& julianDay) {
+    trim(text, size);
+    return size == 10 && parseDatePart(text, size, julianDay);
+}
+
+bool FieldParser::parseTime(const char* text, int size, qint64& msecs) {
+    trim(text, size);
+    return size > 0 && parseTimePart(text, size, msecs) == size;
+}
+
+bool FieldParser::parseDateTime(const char* text, int size, qint64& msecs) {
+    trim(text, size);
+    qint64 julianDay = 0;
+    qint64 timeMsecs = 0;
+    qint64 zoneMsecs = 0;
+    bool hasZone = false;
+    if (!parseDateTimeParts(text, size, julianDay, timeMsecs, hasZone, zoneMsecs)) {
+        return false;
+    }
+    if (hasZone) {
+        msecs = (julianDay - kEpochJulianDay) * kMsecsPerDay + timeMsecs - zoneMsecs;
+    } else {
+        msecs = QDateTime(QDate::fromJulianDay(julianDay), QTime::fromMSecsSinceStartOfDay(int(timeMsecs)))
+                    .toMSecsSinceEpoch();
+    }
+    return true;
+}
+
+bool FieldParser::parseLocalDateTime(const char* text, int size, qint64& msecs) const {
+    trim(text, size);
+    qint64 julianDay = 0;
+    qint64 timeMsecs = 0;
+    qint64 zoneMsecs = 0;
+    bool hasZone = false;
+    if (!parseDateTimeParts(text, size, julianDay, timeMsecs, hasZone, zoneMsecs)) {
+        return false;
+    }
+
+    // Смещение местного времени меняется не чаще раза в час: запрашиваем его у QDateTime один раз на час
+    if (!hasZone) {
+        const int hour = int(timeMsecs / 3600000);
+        const qint64 key = julianDay * 24 + hour;
+        if (key != offsetHour) {
+            offsetHour = key;
+            offsetMsecs = QDateTime(QDate::fromJulianDay(julianDay), QTime(hour, 0)).offsetFromUtc() * 1000LL;
+        }
+        zoneMsecs = offsetMsecs;
+    }
+    msecs = (julianDay - kEpochJulianDay) * kMsecsPerDay + timeMsecs - zoneMsecs;
+    return true;
+}
+
+}
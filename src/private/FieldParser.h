@@ -0,0 +1,62 @@
+#ifndef QFORGE_FIELDPARSER_H
+#define QFORGE_FIELDPARSER_H
+
+#include <QtGlobal>
+
+#include "ColumnStore.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Разбор текстовых полей (UTF-8) прямо в хранилище колонки.
+ *
+ * Разборщик выбирается один раз на колонку по её типу и способу хранения;
+ * числа, даты и время разбираются из байтов без временных QString.
+ * Принимаются форматы: целые и числа с точкой (включая экспоненту),
+ * true/false/yes/no/1/0, yyyy-MM-dd, hh:mm[:ss[.zzz]] и
+ * yyyy-MM-dd[T| ]hh:mm[:ss[.zzz]][Z|±hh[:mm]] (без зоны - местное время).
+ * Кэширует смещение местного времени, поэтому каждому потоку нужна своя копия.
+ */
+class FieldParser
+{
+public:
+    FieldParser() = default;
+    explicit FieldParser(const TypedColumn& column);
+
+    /*!
+     * \brief Записывает значение поля в строку колонки.
+     * \return false, если текст не приводится к типу колонки (колонка не изменяется).
+     */
+    bool store(const char* text, int size, TypedColumn& column, int row) const;
+
+    static bool parseInt64(const char* text, int size, qint64& out);
+    static bool parseDouble(const char* text, int size, double& out);
+    static bool parseBoolean(const char* text, int size, qint64& out);
+    static bool parseDate(const char* text, int size, qint64& julianDay);
+    static bool parseTime(const char* text, int size, qint64& msecs);
+    static bool parseDateTime(const char* text, int size, qint64& msecs);
+
+private:
+    enum class Target {
+        Int64,
+        Double,
+        Boolean,
+        Date,
+        Time,
+        DateTime,
+        String,
+        Variant
+    };
+
+    Target target = Target::String;
+
+    // Смещение местного времени от UTC для последнего часа (юлианский день * 24 + час)
+    mutable qint64 offsetHour = -1;
+    mutable qint64 offsetMsecs = 0;
+
+    bool parseLocalDateTime(const char* text, int size, qint64& msecs) const;
+};
+
+}
+
+#endif // QFORGE_FIELDPARSER_H
@@ -0,0 +1,653 @@
+#include "FilterEngine.h"
+
+#include "Parallel.h"
+#include "PredicateKernels.h"
+
+#include <algorithm>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static constexpr int kBlockRows = 4096;
+static constexpr int kBlockWords = kBlockRows / 64;
+
+static int compareVariants(const QVariant& lhs, const QVariant& rhs) {
+    const QPartialOrdering order = QVariant::compare(lhs, rhs);
+    if (order == QPartialOrdering::Less) {
+        return -1;
+    }
+    if (order == QPartialOrdering::Greater) {
+        return 1;
+    }
+    if (order == QPartialOrdering::Equivalent) {
+        return 0;
+    }
+    return lhs.toString().compare(rhs.toString());
+}
+
+static bool isTextOperator(FilterOperator op) {
+    return op == FilterOperator::Contains || op == FilterOperator::StartsWith;
+}
+
+// Результат упорядочивающего оператора по результатам сравнения с границами
+static inline bool testOrder(FilterOperator op, int low, int high) {
+    switch (op) {
+        case FilterOperator::Equal:          return low == 0;
+        case FilterOperator::NotEqual:       return low != 0;
+        case FilterOperator::Less:           return low < 0;
+        case FilterOperator::LessOrEqual:    return low <= 0;
+        case FilterOperator::Greater:        return low > 0;
+        case FilterOperator::GreaterOrEqual: return low >= 0;
+        case FilterOperator::Between:        return low >= 0 && high <= 0;
+        default:                             return false;
+    }
+}
+
+// Прямые сравнения (а не через -1/0/1), чтобы NaN вёл себя так же, как в PredicateKernels
+template <typename T>
+static inline bool testValue(FilterOperator op, T value, T low, T high) {
+    switch (op) {
+        case FilterOperator::Equal:          return value == low;
+        case FilterOperator::NotEqual:       return value != low;
+        case FilterOperator::Less:           return value < low;
+        case FilterOperator::LessOrEqual:    return value <= low;
+        case FilterOperator::Greater:        return value > low;
+        case FilterOperator::GreaterOrEqual: return value >= low;
+        case FilterOperator::Between:        return value >= low && value <= high;
+        default:                             return false;
+    }
+}
+
+// Записывает pred(values[row]) в биты; begin кратен 64, words[0] соответствует строке begin
+template <typename T, typename Pred>
+static void scanValues(const T* values, int begin, int end, quint64* words, const Pred& pred) {
+    for (int row = begin; row < end;) {
+        const int stop = qMin(end, row + 64);
+        quint64 word = 0;
+        for (int bit = 0; row < stop; ++row, ++bit) {
+            word |= quint64(pred(values[row]) ? 1 : 0) << bit;
+        }
+        words[(row - 1 - begin) >> 6] = word;
+    }
+}
+
+namespace {
+
+// Правило, привязанное к колонке хранилища, с операндами в представлении её хранилища
+struct CompiledRule
+{
+    const TypedColumn* column = nullptr;
+    StorageKind kind = StorageKind::Variant; //!< Хранение колонки при компиляции (операнды - в нём).
+    ColumnType type = ColumnType::String;
+    FilterOperator op = FilterOperator::Equal;
+    Qt::CaseSensitivity cs = Qt::CaseInsensitive;
+    bool valid = false;
+
+    qint64 intLow = 0;
+    qint64 intHigh = 0;
+    QVector<qint64> intSet;
+    double doubleLow = 0.0;
+    double doubleHigh = 0.0;
+    QVector<double> doubleSet;
+    QString textLow;
+    QString textHigh;
+    QStringList textSet;
+    QVariant low;
+    QVariant high;
+    QVariantList set;
+
+    bool matches(int row) const;
+    void scan(int begin, int end, quint64* words) const;
+
+private:
+    bool matchesText(const QString& value) const;
+    bool matchesVariant(const QVariant& value) const;
+};
+
+bool CompiledRule::matchesText(const QString& value) const {
+    switch (op) {
+        case FilterOperator::Contains:
+            return value.contains(textLow, cs);
+        case FilterOperator::StartsWith:
+            return value.startsWith(textLow, cs);
+        case FilterOperator::In:
+            return textSet.contains(value, cs);
+        default: {
+            const int lowResult = value.compare(textLow, cs);
+            const int highResult = op == FilterOperator::Between ? value.compare(textHigh, cs) : 0;
+            return testOrder(op, lowResult, highResult);
+        }
+    }
+}
+
+bool CompiledRule::matchesVariant(const QVariant& value) const {
+    switch (op) {
+        case FilterOperator::Contains:
+        case FilterOperator::StartsWith:
+            return matchesText(value.toString());
+        case FilterOperator::In:
+            return std::any_of(set.begin(), set.end(), [&value](const QVariant& item) {
+                return compareVariants(value, item) == 0;
+            });
+        default: {
+            const int lowResult = compareVariants(value, low);
+            const int highResult = op == FilterOperator::Between ? compareVariants(value, high) : 0;
+            return testOrder(op, lowResult, highResult);
+        }
+    }
+}
+
+bool CompiledRule::matches(int row) const {
+    if (!column) {
+        return false;
+    }
+
+    const bool null = column->isNull(row);
+    if (op == FilterOperator::IsNull) {
+        return null;
+    }
+    if (op == FilterOperator::IsNotNull) {
+        return !null;
+    }
+    if (null || !valid) {
+        return false;
+    }
+
+    if (isTextOperator(op) && column->kind != StorageKind::String) {
+        return matchesText(column->value(row).toString());
+    }
+
+    switch (column->kind) {
+        case StorageKind::Int64: {
+            const qint64 value = column->ints[row];
+            if (op == FilterOperator::In) {
+                return std::binary_search(intSet.begin(), intSet.end(), value);
+            }
+            return testValue(op, value, intLow, intHigh);
+        }
+        case StorageKind::Double: {
+            const double value = column->doubles[row];
+            if (op == FilterOperator::In) {
+                return std::binary_search(doubleSet.begin(), doubleSet.end(), value);
+            }
+            return testValue(op, value, doubleLow, doubleHigh);
+        }
+        case StorageKind::String:
+            return matchesText(column->strings[row]);
+        case StorageKind::Variant:
+            return matchesVariant(column->variants[row]);
+    }
+    return false;
+}
+
+void CompiledRule::scan(int begin, int end, quint64* words) const {
+    const int wordCount = (end - begin + 63) / 64;
+    std::fill(words, words + wordCount, 0);
+    if (!column) {
+        return;
+    }
+
+    const quint64* nulls = column->nulls.constData() + (begin >> 6);
+    if (op == FilterOperator::IsNull || op == FilterOperator::IsNotNull) {
+        const quint64 flip = op == FilterOperator::IsNotNull ? ~quint64(0) : 0;
+        for (int w = 0; w < wordCount; ++w) {
+            words[w] = nulls[w] ^ flip;
+        }
+    } else if (!valid) {
+        return;
+    } else {
+        // Сравнения числовых колонок - векторизованными ядрами, остальное - построчно
+        const bool ordered = PredicateKernels::isSupported(op);
+        bool scanned = false;
+        if (column->kind == StorageKind::Int64 && ordered) {
+            scanned = PredicateKernels::compareInt64(column->ints.constData() + begin, end - begin, op,
+                                                     intLow, intHigh, words);
+        } else if (column->kind == StorageKind::Double && ordered) {
+            scanned = PredicateKernels::compareDouble(column->doubles.constData() + begin, end - begin, op,
+                                                      doubleLow, doubleHigh, words);
+        } else if (column->kind == StorageKind::Int64 && op == FilterOperator::In) {
+            scanValues(column->ints.constData(), begin, end, words, [this](qint64 v) {
+                return std::binary_search(intSet.begin(), intSet.end(), v);
+            });
+            scanned = true;
+        } else if (column->kind == StorageKind::Double && op == FilterOperator::In) {
+            scanValues(column->doubles.constData(), begin, end, words, [this](double v) {
+                return std::binary_search(doubleSet.begin(), doubleSet.end(), v);
+            });
+            scanned = true;
+        }
+        if (!scanned) {
+            for (int row = begin; row < end; ++row) {
+                if (matches(row)) {
+                    words[(row - begin) >> 6] |= quint64(1) << (row & 63);
+                }
+            }
+        }
+        PredicateKernels::andNotWords(words, nulls, wordCount);
+    }
+
+    if ((end - begin) & 63) {
+        words[wordCount - 1] &= (quint64(1) << ((end - begin) & 63)) - 1;
+    }
+}
+
+struct CompiledGroup
+{
+    FilterLogic logic = FilterLogic::And;
+    QVector<CompiledRule> rules;
+};
+
+struct CompiledFilter
+{
+    FilterLogic logic = FilterLogic::And;
+    QVector<CompiledRule> rules;
+    QVector<CompiledGroup> groups;
+};
+
+}
+
+static CompiledRule compileRule(const ColumnStore& store, const FilterRule& rule, Qt::CaseSensitivity cs) {
+    CompiledRule compiled;
+    compiled.op = rule.op;
+    compiled.cs = cs;
+
+    const int index = store.columnIndex(rule.columnName);
+    if (index < 0) {
+        return compiled;
+    }
+    compiled.column = &store.column(index);
+    compiled.kind = compiled.column->kind;
+    compiled.type = compiled.column->type;
+
+    const QVariantList items = rule.value.toList();
+    switch (compiled.column->kind) {
+        case StorageKind::Int64:
+            if (isTextOperator(rule.op)) {
+                compiled.textLow = rule.value.toString();
+                compiled.valid = true;
+            } else if (rule.op == FilterOperator::In) {
+                for (const QVariant& item : items) {
+                    qint64 value = 0;
+                    if (TypedColumn::toInt64(compiled.column->type, item, value)) {
+                        compiled.intSet.append(value);
+                    }
+                }
+                std::sort(compiled.intSet.begin(), compiled.intSet.end());
+                compiled.valid = true;
+            } else {
+                compiled.valid = TypedColumn::toInt64(compiled.column->type, rule.value, compiled.intLow)
+                    && (rule.op != FilterOperator::Between
+                        || TypedColumn::toInt64(compiled.column->type, rule.upperValue, compiled.intHigh));
+            }
+            break;
+        case StorageKind::Double:
+            if (isTextOperator(rule.op)) {
+                compiled.textLow = rule.value.toString();
+                compiled.valid = true;
+            } else if (rule.op == FilterOperator::In) {
+                for (const QVariant& item : items) {
+                    bool ok = false;
+                    const double value = item.toDouble(&ok);
+                    if (ok) {
+                        compiled.doubleSet.append(value);
+                    }
+                }
+                std::sort(compiled.doubleSet.begin(), compiled.doubleSet.end());
+                compiled.valid = true;
+            } else {
+                bool lowOk = false;
+                bool highOk = rule.op != FilterOperator::Between;
+                compiled.doubleLow = rule.value.toDouble(&lowOk);
+                if (!highOk) {
+                    compiled.doubleHigh = rule.upperValue.toDouble(&highOk);
+                }
+                compiled.valid = lowOk && highOk;
+            }
+            break;
+        case StorageKind::String:
+            compiled.textLow = rule.value.toString();
+            compiled.textHigh = rule.upperValue.toString();
+            for (const QVariant& item : items) {
+                compiled.textSet.append(item.toString());
+            }
+            compiled.valid = true;
+            break;
+        case StorageKind::Variant:
+            compiled.low = rule.value;
+            compiled.high = rule.upperValue;
+            compiled.set = items;
+            compiled.textLow = rule.value.toString();
+            compiled.valid = true;
+            break;
+    }
+    return compiled;
+}
+
+static CompiledFilter compileFilter(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs) {
+    CompiledFilter compiled;
+    compiled.logic = filter.logic;
+    for (const FilterRule& rule : filter.rules) {
+        compiled.rules.append(compileRule(store, rule, cs));
+    }
+    for (const FilterGroup& group : filter.groups) {
+        CompiledGroup compiledGroup;
+        compiledGroup.logic = group.logic;
+        for (const FilterRule& rule : group.rules) {
+            compiledGroup.rules.append(compileRule(store, rule, cs));
+        }
+        compiled.groups.append(compiledGroup);
+    }
+    return compiled;
+}
+
+static inline void combine(FilterLogic logic, quint64* target, const quint64* source, int words) {
+    if (logic == FilterLogic::And) {
+        PredicateKernels::andWords(target, source, words);
+    } else {
+        PredicateKernels::orWords(target, source, words);
+    }
+}
+
+// Маска правил группы для блока строк [begin, end) (не длиннее kBlockRows)
+static void evaluateRules(FilterLogic logic, const QVector<CompiledRule>& rules,
+                          int begin, int end, quint64* words) {
+    const int wordCount = (end - begin + 63) / 64;
+    std::fill(words, words + wordCount, logic == FilterLogic::And ? ~quint64(0) : 0);
+
+    quint64 scratch[kBlockWords];
+    for (const CompiledRule& rule : rules) {
+        rule.scan(begin, end, scratch);
+        combine(logic, words, scratch, wordCount);
+    }
+}
+
+static void evaluateBlock(const CompiledFilter& filter, int begin, int end, quint64* words) {
+    const int wordCount = (end - begin + 63) / 64;
+    evaluateRules(filter.logic, filter.rules, begin, end, words);
+
+    quint64 scratch[kBlockWords];
+    for (const CompiledGroup& group : filter.groups) {
+        evaluateRules(group.logic, group.rules, begin, end, scratch);
+        combine(filter.logic, words, scratch, wordCount);
+    }
+
+    if ((end - begin) & 63) {
+        words[wordCount - 1] &= (quint64(1) << ((end - begin) & 63)) - 1;
+    }
+}
+
+static bool matchesRules(FilterLogic logic, const QVector<CompiledRule>& rules, int row) {
+    if (logic == FilterLogic::And) {
+        return std::all_of(rules.begin(), rules.end(), [row](const CompiledRule& rule) {
+            return rule.matches(row);
+        });
+    }
+    return std::any_of(rules.begin(), rules.end(), [row](const CompiledRule& rule) {
+        return rule.matches(row);
+    });
+}
+
+static bool matchesFilter(const CompiledFilter& filter, int row) {
+    auto groupMatches = [row](const CompiledGroup& group) {
+        return matchesRules(group.logic, group.rules, row);
+    };
+
+    if (filter.logic == FilterLogic::And) {
+        return matchesRules(FilterLogic::And, filter.rules, row)
+            && std::all_of(filter.groups.begin(), filter.groups.end(), groupMatches);
+    }
+    return matchesRules(FilterLogic::Or, filter.rules, row)
+        || std::any_of(filter.groups.begin(), filter.groups.end(), groupMatches);
+}
+
+// ========== PUBLIC METHODS ==========
+
+Filter FilterEngine::fromDefaults(const QHash<QString, QVariant>& defaults) {
+    QStringList names = defaults.keys();
+    names.sort();
+
+    Filter filter;
+    for (const QString& name : std::as_const(names)) {
+        const QVariant value = defaults.value(name);
+
+        FilterRule rule;
+        rule.columnName = name;
+        if (value.typeId() == QMetaType::QVariantMap) {
+            const QVariantMap options = value.toMap();
+            rule.op = operatorFromString(options.value("op", options.value("operator", "=")).toString());
+            rule.value = options.value("value");
+            rule.upperValue = options.value("to");
+        } else if (value.typeId() == QMetaType::QVariantList || value.typeId() == QMetaType::QStringList) {
+            rule.op = FilterOperator::In;
+            rule.value = value.toList();
+        } else {
+            rule.value = value;
+        }
+        filter.rules.append(rule);
+    }
+    return filter;
+}
+
+FilterOperator FilterEngine::operatorFromString(const QString& op, bool* ok) {
+    static const QHash<QString, FilterOperator> operatorMap = {
+        {"=", FilterOperator::Equal},
+        {"==", FilterOperator::Equal},
+        {"eq", FilterOperator::Equal},
+        {"!=", FilterOperator::NotEqual},
+        {"<>", FilterOperator::NotEqual},
+        {"ne", FilterOperator::NotEqual},
+        {"<", FilterOperator::Less},
+        {"lt", FilterOperator::Less},
+        {"<=", FilterOperator::LessOrEqual},
+        {"le", FilterOperator::LessOrEqual},
+        {">", FilterOperator::Greater},
+        {"gt", FilterOperator::Greater},
+        {">=", FilterOperator::GreaterOrEqual},
+        {"ge", FilterOperator::GreaterOrEqual},
+        {"between", FilterOperator::Between},
+        {"in", FilterOperator::In},
+        {"contains", FilterOperator::Contains},
+        {"starts_with", FilterOperator::StartsWith},
+        {"is_null", FilterOperator::IsNull},
+        {"is_not_null", FilterOperator::IsNotNull}
+    };
+
+    const QString key = op.trimmed().toLower();
+    if (ok) {
+        *ok = operatorMap.contains(key);
+    }
+    return operatorMap.value(key, FilterOperator::Equal);
+}
+
+QString FilterEngine::operatorToString(FilterOperator op) {
+    switch (op) {
+        case FilterOperator::Equal:          return "=";
+        case FilterOperator::NotEqual:       return "!=";
+        case FilterOperator::Less:           return "<";
+        case FilterOperator::LessOrEqual:    return "<=";
+        case FilterOperator::Greater:        return ">";
+        case FilterOperator::GreaterOrEqual: return ">=";
+        case FilterOperator::Between:        return "between";
+        case FilterOperator::In:             return "in";
+        case FilterOperator::Contains:       return "contains";
+        case FilterOperator::StartsWith:     return "starts_with";
+        case FilterOperator::IsNull:         return "is_null";
+        case FilterOperator::IsNotNull:      return "is_not_null";
+    }
+    return "=";
+}
+
+QueryFilter FilterEngine::toQueryFilter(const Filter& filter, const ModelSchema& schema, Qt::CaseSensitivity cs) {
+    auto toPredicate = [&](const FilterRule& rule) {
+        QueryPredicate predicate;
+        predicate.column = rule.columnName;
+        predicate.op = operatorToString(rule.op);
+        predicate.value = rule.value;
+        predicate.upperValue = rule.upperValue;
+        if (cs == Qt::CaseInsensitive) {
+            const Column* column = schema.findColumn(rule.columnName);
+            predicate.caseInsensitive = column && column->type == ColumnType::String;
+        }
+        return predicate;
+    };
+
+    QueryFilter result;
+    result.matchAll = filter.logic == FilterLogic::And;
+    for (const FilterRule& rule : filter.rules) {
+        QueryPredicateGroup group;
+        group.predicates.append(toPredicate(rule));
+        result.groups.append(group);
+    }
+    for (const FilterGroup& filterGroup : filter.groups) {
+        QueryPredicateGroup group;
+        group.matchAll = filterGroup.logic == FilterLogic::And;
+        for (const FilterRule& rule : filterGroup.rules) {
+            group.predicates.append(toPredicate(rule));
+        }
+        result.groups.append(group);
+    }
+    return result;
+}
+
+bool FilterEngine::fromQueryFilter(const QueryFilter& queryFilter, Filter& filter, Qt::CaseSensitivity& cs) {
+    filter = Filter();
+    filter.logic = queryFilter.matchAll ? FilterLogic::And : FilterLogic::Or;
+    cs = Qt::CaseSensitive;
+
+    bool ok = true;
+    auto toRule = [&](const QueryPredicate& predicate) {
+        bool known = false;
+        FilterRule rule;
+        rule.columnName = predicate.column;
+        rule.op = operatorFromString(predicate.op, &known);
+        rule.value = predicate.value;
+        rule.upperValue = predicate.upperValue;
+        ok = ok && known;
+        if (predicate.caseInsensitive) {
+            cs = Qt::CaseInsensitive;
+        }
+        return rule;
+    };
+
+    for (const QueryPredicateGroup& group : queryFilter.groups) {
+        // Группа из одного условия - правило верхнего уровня (как в toQueryFilter)
+        if (group.predicates.size() == 1) {
+            filter.rules.append(toRule(group.predicates.first()));
+            continue;
+        }
+        FilterGroup filterGroup;
+        filterGroup.logic = group.matchAll ? FilterLogic::And : FilterLogic::Or;
+        for (const QueryPredicate& predicate : group.predicates) {
+            filterGroup.rules.append(toRule(predicate));
+        }
+        filter.groups.append(filterGroup);
+    }
+    return ok;
+}
+
+QVector<int> FilterEngine::columns(const ColumnStore& store, const Filter& filter) {
+    QVector<int> indexes;
+    auto add = [&](const FilterRule& rule) {
+        const int index = store.columnIndex(rule.columnName);
+        if (index >= 0 && !indexes.contains(index)) {
+            indexes.append(index);
+        }
+    };
+    for (const FilterRule& rule : filter.rules) {
+        add(rule);
+    }
+    for (const FilterGroup& group : filter.groups) {
+        for (const FilterRule& rule : group.rules) {
+            add(rule);
+        }
+    }
+    return indexes;
+}
+
+void FilterEngine::evaluate(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs,
+                            RowBitmap& mask, int first) {
+    const int rows = store.rowCount();
+    mask.resize(rows);
+
+    // Пересчёт начинается с границы слова, чтобы задачи писали в разные слова
+    const int begin = qMax(0, first) & ~63;
+    if (begin >= rows) {
+        return;
+    }
+
+    const CompiledFilter compiled = compileFilter(store, filter, cs);
+    const int blocks = (rows - begin + kBlockRows - 1) / kBlockRows;
+    const int tasks = qMin(blocks, Parallel::taskCount(rows - begin));
+    const int blocksPerTask = (blocks + tasks - 1) / tasks;
+    quint64* words = mask.words();
+
+    Parallel::run(tasks, [&](int t) {
+        const int lastBlock = qMin(blocks, (t + 1) * blocksPerTask);
+        for (int block = t * blocksPerTask; block < lastBlock; ++block) {
+            const int blockBegin = begin + block * kBlockRows;
+            const int blockEnd = qMin(rows, blockBegin + kBlockRows);
+            evaluateBlock(compiled, blockBegin, blockEnd, words + (blockBegin >> 6));
+        }
+    });
+}
+
+// Скомпилированный фильтр и то, для чего он скомпилирован
+struct FilterMatcher::Compiled
+{
+    Filter filter;
+    Qt::CaseSensitivity cs;
+    CompiledFilter rules;
+
+    bool isCurrent(const ColumnStore& store, const Filter& wanted, Qt::CaseSensitivity wantedCs) const {
+        if (cs != wantedCs || !(filter == wanted)) {
+            return false;
+        }
+        // Правила привязаны к колонкам: те же колонки с тем же хранением
+        auto bound = [&store](const FilterRule& rule, const CompiledRule& compiled) {
+            const int index = store.columnIndex(rule.columnName);
+            if (index < 0) {
+                return compiled.column == nullptr;
+            }
+            return compiled.column == &store.column(index) && compiled.kind == compiled.column->kind
+                && compiled.type == compiled.column->type;
+        };
+        for (int i = 0; i < filter.rules.size(); ++i) {
+            if (!bound(filter.rules[i], rules.rules[i])) {
+                return false;
+            }
+        }
+        for (int g = 0; g < filter.groups.size(); ++g) {
+            for (int i = 0; i < filter.groups[g].rules.size(); ++i) {
+                if (!bound(filter.groups[g].rules[i], rules.groups[g].rules[i])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+FilterMatcher::FilterMatcher() = default;
+FilterMatcher::~FilterMatcher() = default;
+
+bool FilterMatcher::matches(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs, int row) {
+    if (!compiled || !compiled->isCurrent(store, filter, cs)) {
+        compiled.reset(new Compiled{filter, cs, compileFilter(store, filter, cs)});
+    }
+    return matchesFilter(compiled->rules, row);
+}
+
+bool FilterEngine::matches(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs, int row) {
+    return matchesFilter(compileFilter(store, filter, cs), row);
+}
+
+void FilterEngine::filterRows(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs,
+                              QVector<int>& rows) {
+    const CompiledFilter compiled = compileFilter(store, filter, cs);
+    rows.erase(std::remove_if(rows.begin(), rows.end(), [&compiled](int row) {
+        return !matchesFilter(compiled, row);
+    }), rows.end());
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef QFORGE_FILTERENGINE_H
+#define QFORGE_FILTERENGINE_H
+
+#include <QHash>
+#include <QVector>
+#include <QVariant>
+
+#include <memory>
+
+#include "ColumnStore.h"
+#include "ModelSchema.h"
+#include "QueryContext.hpp"
+#include "RowBitmap.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Локальная фильтрация строк модели.
+ *
+ * Каждое правило вычисляется по типизированной колонке в битовую маску строк,
+ * маски правил и групп комбинируются пословно по AND/OR. Строки обрабатываются
+ * блоками, на больших объёмах - параллельно в QThreadPool.
+ * NULL-значения удовлетворяют только IsNull (и не удовлетворяют NotEqual).
+ */
+class FilterEngine
+{
+public:
+    /*!
+     * \brief Строит фильтр из default_filters схемы.
+     * \details Скалярное значение - равенство, список - In,
+     * словарь - {op, value, to} (to - верхняя граница для between).
+     */
+    static Filter fromDefaults(const QHash<QString, QVariant>& defaults);
+
+    /*!
+     * \brief Разбирает оператор ("=", "!=", "<", ">=", "between", "in", "contains", ...).
+     * \param ok Флаг успешного разбора; при ошибке возвращается Equal.
+     */
+    static FilterOperator operatorFromString(const QString& op, bool* ok = nullptr);
+
+    /*!
+     * \brief Каноническая запись оператора (как в QueryPredicate::op).
+     */
+    static QString operatorToString(FilterOperator op);
+
+    /*!
+     * \brief Переводит фильтр модели в QueryFilter для выполнения на стороне обработчика.
+     * \details Правило верхнего уровня становится группой из одного условия.
+     * Для строковых колонок без учёта регистра выставляется caseInsensitive.
+     */
+    static QueryFilter toQueryFilter(const Filter& filter, const ModelSchema& schema, Qt::CaseSensitivity cs);
+
+    /*!
+     * \brief Обратное преобразование: QueryFilter из контекста запроса в фильтр модели.
+     * \param cs Без учёта регистра, если этого требует хотя бы одно условие.
+     * \return false, если встретился неизвестный оператор.
+     */
+    static bool fromQueryFilter(const QueryFilter& queryFilter, Filter& filter, Qt::CaseSensitivity& cs);
+
+    /*!
+     * \brief Возвращает индексы колонок хранилища, от которых зависит фильтр.
+     */
+    static QVector<int> columns(const ColumnStore& store, const Filter& filter);
+
+    /*!
+     * \brief Вычисляет маску строк, удовлетворяющих фильтру.
+     * \param mask Маска; приводится к размеру хранилища.
+     * \param first Пересчитываются только строки начиная с first (например, добавленные).
+     */
+    static void evaluate(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs,
+                         RowBitmap& mask, int first = 0);
+
+    /*!
+     * \brief Проверяет одну строку хранилища; фильтр компилируется на каждый вызов.
+     * \details Для повторных проверок отдельных строк - FilterMatcher, для набора строк - filterRows.
+     */
+    static bool matches(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs, int row);
+
+    /*!
+     * \brief Оставляет в rows только строки, удовлетворяющие фильтру (порядок сохраняется).
+     * \details Фильтр компилируется один раз; подходит для проверки кандидатов из индекса.
+     */
+    static void filterRows(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs,
+                           QVector<int>& rows);
+};
+
+/**
+ * @brief Проверка отдельных строк (после правки, добавления) без повторной компиляции фильтра.
+ *
+ * Фильтр компилируется при первой проверке и заново - только если сменились фильтр,
+ * чувствительность к регистру или колонки хранилища, к которым привязаны его правила
+ * (перестроение хранилища, смена типа хранения).
+ */
+class FilterMatcher
+{
+public:
+    FilterMatcher();
+    ~FilterMatcher();
+
+    bool matches(const ColumnStore& store, const Filter& filter, Qt::CaseSensitivity cs, int row);
+
+private:
+    struct Compiled;
+    std::unique_ptr<Compiled> compiled;
+};
+
+}
+
+#endif // QFORGE_FILTERENGINE_H
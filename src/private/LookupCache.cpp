@@ -0,0 +1,219 @@
+#include "LookupCache.h"
+
+#include <chrono>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static qint64 monotonicMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static QString lookupKey(const QString& table, const QString& keyColumn, const QString& displayColumn) {
+    return table + QChar(0x1F) + keyColumn + QChar(0x1F) + displayColumn;
+}
+
+// ========== LookupTable ==========
+
+LookupTable::LookupTable(const QString& table, const QString& keyColumn, const QString& displayColumn)
+    : table(table)
+    , keyColumn(keyColumn)
+    , displayColumn(displayColumn) {
+}
+
+bool LookupTable::lookup(const QVariant& key, QVariant& display) const {
+    if (key.isNull()) {
+        return false;
+    }
+    QReadLocker locker(&lock);
+    const auto it = displays.constFind(key.toString());
+    if (it == displays.constEnd()) {
+        return false;
+    }
+    display = it.value();
+    return true;
+}
+
+bool LookupTable::loadAll(const QueryHandler& handler, QString* error) {
+    QMutexLocker loading(&loadMutex);
+    if (isComplete()) {
+        return true;
+    }
+    if (!handler) {
+        if (error) *error = "No query handler for lookup";
+        return false;
+    }
+
+    const QueryResult result = handler(context());
+    if (!insert(result, error)) {
+        return false;
+    }
+    QWriteLocker locker(&lock);
+    complete = true;
+    return true;
+}
+
+bool LookupTable::loadKeys(const QueryHandler& handler, const QVariantList& keys, QString* error) {
+    QMutexLocker loading(&loadMutex);
+
+    // Только незагруженные ключи; отсутствующие в таблице - после интервала повтора
+    const qint64 now = monotonicMs();
+    QVariantList wanted;
+    QSet<QString> seen;
+    {
+        QReadLocker locker(&lock);
+        if (complete) {
+            return true;
+        }
+        for (const QVariant& key : keys) {
+            if (key.isNull()) {
+                continue;
+            }
+            const QString text = key.toString();
+            if (displays.contains(text) || seen.contains(text)) {
+                continue;
+            }
+            const auto it = missing.constFind(text);
+            if (it != missing.constEnd() && now - it.value() < retryMs) {
+                continue;
+            }
+            seen.insert(text);
+            wanted.append(key);
+        }
+    }
+    if (wanted.isEmpty()) {
+        return true;
+    }
+    if (!handler) {
+        if (error) *error = "No query handler for lookup";
+        return false;
+    }
+
+    for (int start = 0; start < wanted.size(); start += kBatchSize) {
+        QueryPredicate predicate;
+        predicate.column = keyColumn;
+        predicate.op = "in";
+        predicate.value = wanted.mid(start, kBatchSize);
+        QueryPredicateGroup group;
+        group.predicates.append(predicate);
+
+        QueryContext batch = context();
+        batch.filter.groups.append(group);
+        if (!insert(handler(batch), error)) {
+            return false;
+        }
+    }
+
+    QWriteLocker locker(&lock);
+    for (const QString& key : std::as_const(seen)) {
+        if (displays.contains(key)) {
+            missing.remove(key);
+        } else {
+            missing.insert(key, now);
+        }
+    }
+    return true;
+}
+
+bool LookupTable::isComplete() const {
+    QReadLocker locker(&lock);
+    return complete;
+}
+
+int LookupTable::size() const {
+    QReadLocker locker(&lock);
+    return int(displays.size());
+}
+
+int LookupTable::missingRetryInterval() const {
+    QReadLocker locker(&lock);
+    return retryMs;
+}
+
+void LookupTable::setMissingRetryInterval(int ms) {
+    QWriteLocker locker(&lock);
+    retryMs = qMax(0, ms);
+}
+
+void LookupTable::invalidate() {
+    QMutexLocker loading(&loadMutex);
+    QWriteLocker locker(&lock);
+    displays.clear();
+    missing.clear();
+    complete = false;
+}
+
+QueryContext LookupTable::context() const {
+    QueryContext context;
+    context.queryName = kQueryName;
+    context.sql = QString("SELECT %1, %2 FROM %3").arg(keyColumn, displayColumn, table);
+    context.bindings.insert("table", table);
+    context.bindings.insert("key_column", keyColumn);
+    context.bindings.insert("display_column", displayColumn);
+    return context;
+}
+
+bool LookupTable::insert(const QueryResult& result, QString* error) {
+    if (!result.ok) {
+        if (error) *error = QString("Lookup '%1' failed: %2").arg(table, result.errors_log.join("; "));
+        return false;
+    }
+
+    QWriteLocker locker(&lock);
+    displays.reserve(displays.size() + result.rows.size());
+    for (const QVariantMap& row : result.rows) {
+        const QVariant key = row.value(keyColumn);
+        if (!key.isNull()) {
+            displays.insert(key.toString(), row.value(displayColumn));
+        }
+    }
+    return true;
+}
+
+// ========== LookupCache ==========
+
+LookupCache& LookupCache::instance() {
+    static LookupCache cache;
+    return cache;
+}
+
+std::shared_ptr<LookupTable> LookupCache::table(const QString& table, const QString& keyColumn,
+                                                const QString& displayColumn) {
+    QMutexLocker locker(&mutex);
+    std::shared_ptr<LookupTable>& slot = tables[lookupKey(table, keyColumn, displayColumn)];
+    if (!slot) {
+        slot = std::make_shared<LookupTable>(table, keyColumn, displayColumn);
+    }
+    return slot;
+}
+
+void LookupCache::invalidate(const QString& table) {
+    QList<std::shared_ptr<LookupTable>> stale;
+    {
+        QMutexLocker locker(&mutex);
+        for (const std::shared_ptr<LookupTable>& entry : std::as_const(tables)) {
+            if (table.isEmpty() || entry->table == table) {
+                stale.append(entry);
+            }
+        }
+    }
+    // Экземпляры остаются у моделей: сбрасывается содержимое, а не указатель
+    for (const std::shared_ptr<LookupTable>& entry : std::as_const(stale)) {
+        entry->invalidate();
+    }
+    emit invalidated(table);
+}
+
+void LookupCache::clear() {
+    QMutexLocker locker(&mutex);
+    tables.clear();
+}
+
+int LookupCache::count() const {
+    QMutexLocker locker(&mutex);
+    return int(tables.size());
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef QFORGE_LOOKUPCACHE_H
+#define QFORGE_LOOKUPCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QVariant>
+
+#include <memory>
+
+#include "../QueryHandler.hpp"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Отображение ключ -> отображаемое значение одной справочной таблицы.
+ *
+ * Загружается через QueryHandler модели запросом с именем kQueryName:
+ * sql - "SELECT <ключ>, <display> FROM <таблица>", в bindings - имена таблицы
+ * и колонок (для обработчиков без SQL). Догрузка по ключам передаёт тот же запрос
+ * с фильтром "<ключ> in (...)" пачками по kBatchSize. Ключ, которого в таблице
+ * не оказалось, повторно запрашивается не раньше чем через missingRetryInterval().
+ * Ключи сравниваются по строковому представлению; поиск - O(1).
+ */
+class LookupTable
+{
+public:
+    static constexpr int kBatchSize = 500;
+    static constexpr int kMissingRetryMs = 30000;
+    static constexpr const char* kQueryName = "qforge_lookup";
+
+    LookupTable(const QString& table, const QString& keyColumn, const QString& displayColumn);
+
+    const QString table;
+    const QString keyColumn;
+    const QString displayColumn;
+
+    /*!
+     * \brief Отображаемое значение ключа.
+     * \return false, если ключ не загружен или его нет в таблице.
+     */
+    bool lookup(const QVariant& key, QVariant& display) const;
+
+    /*!
+     * \brief Загружает таблицу целиком, если она ещё не загружена.
+     */
+    bool loadAll(const QueryHandler& handler, QString* error = nullptr);
+
+    /*!
+     * \brief Догружает ключи, которых ещё нет в отображении (отсутствующие в таблице -
+     * не чаще раза в missingRetryInterval()).
+     */
+    bool loadKeys(const QueryHandler& handler, const QVariantList& keys, QString* error = nullptr);
+
+    bool isComplete() const;
+    int size() const;
+
+    int missingRetryInterval() const;
+    void setMissingRetryInterval(int ms);
+
+    /*!
+     * \brief Сбрасывает загруженное; следующая загрузка обращается к источнику заново.
+     */
+    void invalidate();
+
+private:
+    QueryContext context() const;
+    bool insert(const QueryResult& result, QString* error);
+
+    mutable QReadWriteLock lock;   //!< Чтение из data(), запись при загрузке.
+    QMutex loadMutex;              //!< Одна загрузка таблицы за раз.
+    QHash<QString, QVariant> displays;
+    QHash<QString, qint64> missing; //!< Ключ, которого нет в таблице -> время запроса (мс, монотонно).
+    int retryMs = kMissingRetryMs;
+    bool complete = false;
+};
+
+/**
+ * @brief Общий на процесс кеш справочников для колонок с внешним ключом.
+ *
+ * Модели с одинаковыми (таблица, ключ, display) получают один экземпляр LookupTable,
+ * поэтому справочник загружается один раз для всех. invalidate() сбрасывает
+ * справочники таблицы, и все модели, которые на них ссылаются, загружают их заново.
+ */
+class LookupCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LookupCache& instance();
+
+    std::shared_ptr<LookupTable> table(const QString& table, const QString& keyColumn,
+                                       const QString& displayColumn);
+
+    /*!
+     * \brief Сбрасывает справочники таблицы (пустое имя - все) и сообщает об этом моделям.
+     */
+    void invalidate(const QString& table = QString());
+    void clear();
+    int count() const;
+
+signals:
+    /*!
+     * \brief Справочники таблицы сброшены (пустое имя - все).
+     */
+    void invalidated(const QString& table);
+
+private:
+    LookupCache() = default;
+
+    mutable QMutex mutex;
+    QHash<QString, std::shared_ptr<LookupTable>> tables;
+};
+
+}
+
+#endif // QFORGE_LOOKUPCACHE_H
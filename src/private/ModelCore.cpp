@@ -1,11 +1,13 @@
 #include "ModelCore.h"
+#include "Expression.h"
+#include "SchemaCache.h"
+#include "SchemaRegistry.h"
 
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
 #include <QDebug>
 
 #include <yaml-cpp/yaml.h>
@@ -44,6 +46,19 @@ static TextAlignment stringToAlignment(const QString& alignStr) {
     return alignMap.value(alignStr.toLower(), TextAlignment::Left);
 }
 
+static ReferenceLoading stringToReferenceLoading(const QString& loadStr) {
+    return loadStr.toLower() == "keys" ? ReferenceLoading::Keys : ReferenceLoading::All;
+}
+
+static QueryEffect stringToQueryEffect(const QString& effectStr) {
+    static const QHash<QString, QueryEffect> effectMap = {
+        {"insert", QueryEffect::Insert},
+        {"update", QueryEffect::Update},
+        {"remove", QueryEffect::Remove}
+    };
+    return effectMap.value(effectStr.toLower(), QueryEffect::None);
+}
+
 static SortOrder stringToSortOrder(const QString& orderStr) {
     return (orderStr.toLower() == "desc" || orderStr.toLower() == "descending") 
            ? SortOrder::Descending : SortOrder::Ascending;
@@ -77,6 +92,34 @@ static DataSource stringToDataSource(const QString& sourceStr) {
     return (sourceStr.toLower() == "manual") ? DataSource::Manual : DataSource::Query;
 }
 
+static QVariant yamlNodeToVariant(const YAML::Node& node) {
+    if (node.IsSequence()) {
+        QVariantList list;
+        for (const auto& item : node) {
+            list.append(yamlNodeToVariant(item));
+        }
+        return list;
+    }
+    if (node.IsMap()) {
+        QVariantMap map;
+        for (const auto& pair : node) {
+            map.insert(QString::fromStdString(pair.first.as<std::string>()), yamlNodeToVariant(pair.second));
+        }
+        return map;
+    }
+    if (node.IsScalar()) {
+        return QString::fromStdString(node.as<std::string>());
+    }
+    return QVariant();
+}
+
+// Копия готовой схемы с построенным индексом колонок
+static std::shared_ptr<const ModelSchema> indexedSchema(const ModelSchema& source) {
+    auto schema = std::make_shared<ModelSchema>(source);
+    schema->rebuildColumnIndex();
+    return schema;
+}
+
 static bool isValidHeaderLetter(const QString& letter) {
     if (letter.length() != 1) return false;
     QChar ch = letter[0].toUpper();
@@ -88,7 +131,7 @@ static bool isValidHeaderLetter(const QString& letter) {
 ModelCore::ModelCore(const QString& configPath, const QueryHandler& handler)
     : handler(handler)
     , path(configPath)
-    , schema(std::make_unique<ModelSchema>())
+    , schema(std::make_shared<const ModelSchema>())
 {
     loadFromFile();
 }
@@ -96,7 +139,7 @@ ModelCore::ModelCore(const QString& configPath, const QueryHandler& handler)
 ModelCore::ModelCore(const ModelSchema& modelSchema, const QueryHandler& handler)
     : handler(handler)
     , isValidFlag(true)
-    , schema(std::make_unique<ModelSchema>(modelSchema))
+    , schema(indexedSchema(modelSchema))
 {
     // Validate the provided schema
     QStringList validationErrors = schema->validate();
@@ -149,6 +192,10 @@ const ModelSchema& ModelCore::getSchema() const {
     return *schema;
 }
 
+std::shared_ptr<const ModelSchema> ModelCore::sharedSchema() const {
+    return schema;
+}
+
 QJsonObject ModelCore::getJsonSchema() const {
     QJsonObject schemaJson;
     
@@ -199,6 +246,16 @@ QJsonObject ModelCore::getJsonSchema() const {
     for (auto it = schema->queries.begin(); it != schema->queries.end(); ++it) {
         QJsonObject queryObj;
         queryObj["sql"] = it.value().sql;
+        if (it.value().isTransactional) {
+            queryObj["is_transactional"] = true;
+        }
+        if (!it.value().isReadOnly) {
+            queryObj["is_read_only"] = false;
+        }
+        if (it.value().effect != QueryEffect::None) {
+            static const char* effects[] = {"none", "insert", "update", "remove"};
+            queryObj["effect"] = effects[int(it.value().effect)];
+        }
         
         if (!it.value().arguments.isEmpty()) {
             QJsonArray argsArray;
@@ -232,15 +289,32 @@ bool ModelCore::reload() {
         return false;
     }
     
-    ModelCore newCore(path, handler);
-    if (!newCore.isValid()) {
+    // Схема перечитывается в реестре: новые модели этого файла получат её же
+    QStringList errors;
+    std::shared_ptr<const ModelSchema> reloaded = SchemaRegistry::instance().reload(path, &errors);
+    if (!reloaded) {
         errors_log.append(QString("Failed to reload configuration from '%1'").arg(path));
-        errors_log.append(newCore.getErrors());
+        errors_log.append(errors);
         return false;
     }
 
-    // Replace current state with new one
-    *this = std::move(newCore);
+    schema = std::move(reloaded);
+    errors_log.clear();
+    isValidFlag = true;
+    return true;
+}
+
+bool ModelCore::refresh(QStringList* errors) {
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    // Ошибка разбора не портит модель: остаётся прежняя схема
+    std::shared_ptr<const ModelSchema> loaded = SchemaRegistry::instance().acquire(path, errors);
+    if (!loaded) {
+        return false;
+    }
+    schema = std::move(loaded);
     return true;
 }
 
@@ -252,58 +326,102 @@ void ModelCore::clearErrors() {
     errors_log.clear();
 }
 
-// ========== PRIVATE METHODS ==========
-
-bool ModelCore::loadFromFile() {
+bool ModelCore::parseFile(const QString& path, ModelSchema& target, QStringList& errors) {
     QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        errors_log.append(QString("Failed to open config file: %1").arg(path));
-        isValidFlag = false;
+    if (!file.open(QIODevice::ReadOnly)) {
+        errors.append(QString("Failed to open config file: %1").arg(path));
         return false;
     }
 
-    QTextStream in(&file);
-    QString content = in.readAll();
+    const QByteArray source = file.readAll();
     file.close();
 
+    // Схема, уже разобранная из этого же текста, читается из двоичного кэша без разбора;
+    // проверка выполняется и для неё (правила проверки могли измениться)
+    const QByteArray sourceHash = SchemaCache::sourceHash(source);
+    if (SchemaCache::load(path, sourceHash, target)) {
+        if (target.validate().isEmpty()) {
+            return true;
+        }
+        target = ModelSchema();
+    }
+
+    QString content = QString::fromUtf8(source);
+    if (content.startsWith(QChar(0xFEFF))) {
+        content.remove(0, 1);
+    }
+    content.replace("\r\n", "\n");
+
     // Determine file format by extension
     QFileInfo fileInfo(path);
     QString extension = fileInfo.suffix().toLower();
     
     bool parseok = false;
     if (extension == "yml" || extension == "yaml") {
-        parseok = parseYaml(content);
+        parseok = parseYaml(content, &target, errors);
     } else if (extension == "json") {
-        parseok = parseJson(content);
+        parseok = parseJson(content, &target, errors);
     } else {
         // Try to auto-detect format
         content = content.trimmed();
         if (content.startsWith('{')) {
-            parseok = parseJson(content);
+            parseok = parseJson(content, &target, errors);
         } else {
-            parseok = parseYaml(content);
+            parseok = parseYaml(content, &target, errors);
+        }
+    }
+    
+    if (parseok) {
+        target.rebuildColumnIndex();
+        
+        // Выражения вычисляемых колонок и граф их зависимостей проверяются при разборе;
+        // колонки, от которых зависит выражение, записываются в dependentColumns
+        CalculationPlan plan;
+        if (!plan.build(target.columns, errors)) {
+            parseok = false;
+        }
+        for (const CalculatedColumn& entry : plan.columns()) {
+            Column& column = target.columns[entry.column];
+            column.dependentColumns.clear();
+            for (int dependency : entry.program.columns) {
+                column.dependentColumns.append(target.columns[dependency].name);
+            }
         }
     }
     
     if (parseok) {
         // Validate parsed schema
-        QStringList validationErrors = schema->validate();
+        QStringList validationErrors = target.validate();
         if (!validationErrors.isEmpty()) {
-            errors_log.append("Schema validation failed:");
-            errors_log.append(validationErrors);
-            isValidFlag = false;
+            errors.append("Schema validation failed:");
+            errors.append(validationErrors);
             return false;
         }
         
-        isValidFlag = true;
+        SchemaCache::save(path, sourceHash, target);
         return true;
     }
     
-    isValidFlag = false;
     return false;
 }
 
-bool ModelCore::parseYaml(const QString& content) {
+// ========== PRIVATE METHODS ==========
+
+bool ModelCore::loadFromFile() {
+    QStringList errors;
+    std::shared_ptr<const ModelSchema> loaded = SchemaRegistry::instance().acquire(path, &errors);
+    if (!loaded) {
+        errors_log.append(errors);
+        isValidFlag = false;
+        return false;
+    }
+
+    schema = std::move(loaded);
+    isValidFlag = true;
+    return true;
+}
+
+bool ModelCore::parseYaml(const QString& content, ModelSchema* schema, QStringList& errors_log) {
     try {
         YAML::Node root = YAML::Load(content.toStdString());
         if (!root.IsMap()) {
@@ -335,6 +453,20 @@ bool ModelCore::parseYaml(const QString& content) {
         if (root["load_query"]) {
             schema->loadQuery = QString::fromStdString(root["load_query"].as<std::string>());
         }
+        
+        // Иерархия (type: tree): колонка родителя и запрос детей нескольких узлов сразу
+        if (root["tree"]) {
+            const auto& treeNode = root["tree"];
+            if (treeNode["parent_column"]) {
+                schema->tree.parentColumn = QString::fromStdString(treeNode["parent_column"].as<std::string>());
+            }
+            if (treeNode["children_query"]) {
+                schema->tree.childrenQuery = QString::fromStdString(treeNode["children_query"].as<std::string>());
+            }
+            if (treeNode["parents_argument"]) {
+                schema->tree.parentsArgument = QString::fromStdString(treeNode["parents_argument"].as<std::string>());
+            }
+        }
 
         // Parse horizontal headers
         if (root["horizontal_headers"]) {
@@ -428,6 +560,30 @@ bool ModelCore::parseYaml(const QString& content) {
                     column.alignment = stringToAlignment(QString::fromStdString(colNode["alignment"].as<std::string>()));
                 }
                 
+                // Вычисляемая колонка: значение по выражению над другими колонками строки
+                if (colNode["expression"]) {
+                    column.isCalculated = true;
+                    column.isEditable = false;
+                    column.calculationExpression = QString::fromStdString(colNode["expression"].as<std::string>());
+                }
+                
+                // Внешний ключ: в DisplayRole показывается display из справочной таблицы
+                if (colNode["reference"]) {
+                    const auto& referenceNode = colNode["reference"];
+                    if (referenceNode["table"]) {
+                        column.referenceTable = QString::fromStdString(referenceNode["table"].as<std::string>());
+                    }
+                    if (referenceNode["column"]) {
+                        column.referenceColumn = QString::fromStdString(referenceNode["column"].as<std::string>());
+                    }
+                    if (referenceNode["display"]) {
+                        column.displayColumn = QString::fromStdString(referenceNode["display"].as<std::string>());
+                    }
+                    if (referenceNode["load"]) {
+                        column.referenceLoading = stringToReferenceLoading(QString::fromStdString(referenceNode["load"].as<std::string>()));
+                    }
+                }
+                
                 // Parse validator
                 if (colNode["validator"]) {
                     const auto& validatorNode = colNode["validator"];
@@ -480,6 +636,66 @@ bool ModelCore::parseYaml(const QString& content) {
             }
         }
 
+        // Parse filtering
+        if (root["enable_filtering"]) {
+            schema->enableFiltering = root["enable_filtering"].as<bool>();
+        }
+        if (root["case_sensitive_filtering"]) {
+            schema->caseSensitiveFiltering = root["case_sensitive_filtering"].as<bool>();
+        }
+        if (root["default_filters"] && root["default_filters"].IsMap()) {
+            schema->defaultFilters.clear();
+            for (const auto& filterPair : root["default_filters"]) {
+                const QString columnName = QString::fromStdString(filterPair.first.as<std::string>());
+                schema->defaultFilters.insert(columnName, yamlNodeToVariant(filterPair.second));
+            }
+        }
+
+        if (root["export_settings"] && root["export_settings"].IsMap()) {
+            const auto& exportNode = root["export_settings"];
+            ExportSettings& settings = schema->exportSettings;
+            if (exportNode["supported_formats"] && exportNode["supported_formats"].IsSequence()) {
+                settings.supportedFormats.clear();
+                for (const auto& format : exportNode["supported_formats"]) {
+                    settings.supportedFormats.append(QString::fromStdString(format.as<std::string>()));
+                }
+            }
+            if (exportNode["default_format"]) {
+                settings.defaultFormat = QString::fromStdString(exportNode["default_format"].as<std::string>());
+            }
+            if (exportNode["csv_delimiter"]) {
+                settings.csvDelimiter = QString::fromStdString(exportNode["csv_delimiter"].as<std::string>());
+            }
+            if (exportNode["csv_quote_char"]) {
+                settings.csvQuoteChar = QString::fromStdString(exportNode["csv_quote_char"].as<std::string>());
+            }
+            if (exportNode["csv_include_headers"]) {
+                settings.csvIncludeHeaders = exportNode["csv_include_headers"].as<bool>();
+            }
+            if (exportNode["json_pretty_print"]) {
+                settings.jsonPrettyPrint = exportNode["json_pretty_print"].as<bool>();
+            }
+            if (exportNode["xml_root_element"]) {
+                settings.xmlRootElement = QString::fromStdString(exportNode["xml_root_element"].as<std::string>());
+            }
+            if (exportNode["xml_row_element"]) {
+                settings.xmlRowElement = QString::fromStdString(exportNode["xml_row_element"].as<std::string>());
+            }
+        }
+
+        if (root["import_settings"] && root["import_settings"].IsMap()) {
+            const auto& importNode = root["import_settings"];
+            if (importNode["csv_delimiter"]) {
+                schema->importSettings.csvDelimiter = QString::fromStdString(importNode["csv_delimiter"].as<std::string>());
+            }
+            if (importNode["csv_quote_char"]) {
+                schema->importSettings.csvQuoteChar = QString::fromStdString(importNode["csv_quote_char"].as<std::string>());
+            }
+            if (importNode["csv_has_headers"]) {
+                schema->importSettings.csvHasHeaders = importNode["csv_has_headers"].as<bool>();
+            }
+        }
+
         // Parse queries
         if (root["queries"] && root["queries"].IsMap()) {
             schema->queries.clear();
@@ -496,6 +712,18 @@ bool ModelCore::parseYaml(const QString& content) {
                     query.onError = stringToErrorHandling(QString::fromStdString(queryNode["on_error"].as<std::string>()));
                 }
                 
+                if (queryNode["is_transactional"]) {
+                    query.isTransactional = queryNode["is_transactional"].as<bool>();
+                }
+                
+                if (queryNode["is_read_only"]) {
+                    query.isReadOnly = queryNode["is_read_only"].as<bool>();
+                }
+                
+                if (queryNode["effect"]) {
+                    query.effect = stringToQueryEffect(QString::fromStdString(queryNode["effect"].as<std::string>()));
+                }
+                
                 // Parse arguments
                 if (queryNode["arguments"] && queryNode["arguments"].IsSequence()) {
                     for (const auto& argNode : queryNode["arguments"]) {
@@ -607,7 +835,7 @@ bool ModelCore::parseYaml(const QString& content) {
     }
 }
 
-bool ModelCore::parseJson(const QString& content) {
+bool ModelCore::parseJson(const QString& content, ModelSchema* schema, QStringList& errors_log) {
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(content.toUtf8(), &parseError);
     
@@ -644,6 +872,13 @@ bool ModelCore::parseJson(const QString& content) {
         schema->isEditable = root["is_editable"].toBool();
     }
     
+    if (root.contains("tree")) {
+        const QJsonObject treeObj = root["tree"].toObject();
+        schema->tree.parentColumn = treeObj.value("parent_column").toString(schema->tree.parentColumn);
+        schema->tree.childrenQuery = treeObj.value("children_query").toString();
+        schema->tree.parentsArgument = treeObj.value("parents_argument").toString(schema->tree.parentsArgument);
+    }
+    
     // Parse horizontal headers
     if (root.contains("horizontal_headers")) {
         QJsonValue hhValue = root["horizontal_headers"];
@@ -721,6 +956,18 @@ bool ModelCore::parseJson(const QString& content) {
             column.isPrimaryKey = colObj.value("is_primary_key").toBool(false);
             column.tooltip = colObj.value("tooltip").toString();
             column.alignment = stringToAlignment(colObj.value("alignment").toString());
+            if (colObj.contains("expression")) {
+                column.isCalculated = true;
+                column.isEditable = false;
+                column.calculationExpression = colObj.value("expression").toString();
+            }
+            if (colObj.contains("reference")) {
+                const QJsonObject referenceObj = colObj.value("reference").toObject();
+                column.referenceTable = referenceObj.value("table").toString();
+                column.referenceColumn = referenceObj.value("column").toString();
+                column.displayColumn = referenceObj.value("display").toString();
+                column.referenceLoading = stringToReferenceLoading(referenceObj.value("load").toString());
+            }
             
             if (column.isPrimaryKey) {
                 schema->primaryKeyColumns.append(column.name);
@@ -760,6 +1007,37 @@ bool ModelCore::parseJson(const QString& content) {
         }
     }
 
+    // Parse filtering
+    schema->enableFiltering = root.value("enable_filtering").toBool(schema->enableFiltering);
+    schema->caseSensitiveFiltering = root.value("case_sensitive_filtering").toBool(schema->caseSensitiveFiltering);
+    if (root.contains("default_filters") && root["default_filters"].isObject()) {
+        schema->defaultFilters = root["default_filters"].toObject().toVariantHash();
+    }
+    if (root.contains("export_settings") && root["export_settings"].isObject()) {
+        const QJsonObject exportObj = root["export_settings"].toObject();
+        ExportSettings& settings = schema->exportSettings;
+        if (exportObj.value("supported_formats").isArray()) {
+            settings.supportedFormats.clear();
+            for (const QJsonValue& format : exportObj.value("supported_formats").toArray()) {
+                settings.supportedFormats.append(format.toString());
+            }
+        }
+        settings.defaultFormat = exportObj.value("default_format").toString(settings.defaultFormat);
+        settings.csvDelimiter = exportObj.value("csv_delimiter").toString(settings.csvDelimiter);
+        settings.csvQuoteChar = exportObj.value("csv_quote_char").toString(settings.csvQuoteChar);
+        settings.csvIncludeHeaders = exportObj.value("csv_include_headers").toBool(settings.csvIncludeHeaders);
+        settings.jsonPrettyPrint = exportObj.value("json_pretty_print").toBool(settings.jsonPrettyPrint);
+        settings.xmlRootElement = exportObj.value("xml_root_element").toString(settings.xmlRootElement);
+        settings.xmlRowElement = exportObj.value("xml_row_element").toString(settings.xmlRowElement);
+    }
+    if (root.contains("import_settings") && root["import_settings"].isObject()) {
+        const QJsonObject importObj = root["import_settings"].toObject();
+        ImportSettings& settings = schema->importSettings;
+        settings.csvDelimiter = importObj.value("csv_delimiter").toString(settings.csvDelimiter);
+        settings.csvQuoteChar = importObj.value("csv_quote_char").toString(settings.csvQuoteChar);
+        settings.csvHasHeaders = importObj.value("csv_has_headers").toBool(settings.csvHasHeaders);
+    }
+
     // Parse queries
     if (root.contains("queries") && root["queries"].isObject()) {
         schema->queries.clear();
@@ -772,6 +1050,9 @@ bool ModelCore::parseJson(const QString& content) {
             Query query;
             query.sql = queryObj["sql"].toString();
             query.onError = stringToErrorHandling(queryObj.value("on_error").toString());
+            query.isTransactional = queryObj.value("is_transactional").toBool(false);
+            query.isReadOnly = queryObj.value("is_read_only").toBool(true);
+            query.effect = stringToQueryEffect(queryObj.value("effect").toString());
             
             // Parse arguments
             if (queryObj.contains("arguments") && queryObj["arguments"].isArray()) {
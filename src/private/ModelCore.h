@@ -52,6 +52,14 @@ public:
      */
     const ModelSchema& getSchema() const;
 
+    /*!
+     * \brief Возвращает разделяемую неизменяемую схему.
+     * \details Модели одного файла конфигурации получают один экземпляр из SchemaRegistry;
+     * схема остаётся жива, пока её держит хотя бы один владелец, в том числе после reload().
+     * \return Схема модели.
+     */
+    std::shared_ptr<const ModelSchema> sharedSchema() const;
+
     /*!
      * \brief Возвращает схему модели в виде JSON.
      * \return JSON-схема.
@@ -66,10 +74,22 @@ public:
 
     /*!
      * \brief Перезагружает данные конфигурации.
+     * \details Файл перечитывается в SchemaRegistry; новая схема заменяет старую
+     * для всех, кто затем обращается к реестру (SchemaRegistry::reloaded).
      * \return Флаг успеха.
      */
     bool reload();
 
+    /*!
+     * \brief Берёт из SchemaRegistry текущую схему файла конфигурации.
+     * \details Файл разбирается заново, только если изменился на диске
+     * или ещё не загружался; иначе - без обращения к содержимому файла.
+     * При ошибке остаётся прежняя схема, а модель - валидной.
+     * \param errors Ошибки разбора.
+     * \return Флаг успеха.
+     */
+    bool refresh(QStringList* errors = nullptr);
+
     /*!
      * \brief Возвращает список ошибок.
      * \return Список ошибок.
@@ -81,6 +101,15 @@ public:
      */
     void clearErrors();
 
+    /*!
+     * \brief Читает и проверяет файл схемы (YAML/JSON) минуя реестр.
+     * \param path Путь к конфигу.
+     * \param schema Схема, в которую записывается результат.
+     * \param errors Список, в который добавляются ошибки.
+     * \return Флаг успеха.
+     */
+    static bool parseFile(const QString& path, ModelSchema& schema, QStringList& errors);
+
 private:
     /*!
      * \brief Загружает данные из заданного файла конфигурации.
@@ -91,16 +120,20 @@ private:
     /*!
      * \brief Парсит YAML содержимое в схему.
      * \param content YAML содержимое.
+     * \param schema Схема.
+     * \param errors_log Список ошибок.
      * \return Флаг успеха.
      */
-    bool parseYaml(const QString& content);
+    static bool parseYaml(const QString& content, ModelSchema* schema, QStringList& errors_log);
 
     /*!
      * \brief Парсит JSON содержимое в схему.
      * \param content JSON содержимое.
+     * \param schema Схема.
+     * \param errors_log Список ошибок.
      * \return Флаг успеха.
      */
-    bool parseJson(const QString& content);
+    static bool parseJson(const QString& content, ModelSchema* schema, QStringList& errors_log);
 
     /*!
      * \brief Валидирует параметры запроса.
@@ -115,7 +148,7 @@ private:
     QueryHandler handler;
     QString path;
     bool isValidFlag = false;
-    std::unique_ptr<ModelSchema> schema;
+    std::shared_ptr<const ModelSchema> schema;
 };
 
 }
@@ -5,21 +5,46 @@ namespace QForge {
 // ========== UTILITY METHODS ==========
 
 Column* ModelSchema::findColumn(const QString& columnName) {
-    for (auto& column : columns) {
-        if (column.name == columnName) {
-            return &column;
-        }
-    }
-    return nullptr;
+    const int index = columnIndex(columnName);
+    return index >= 0 ? &columns[index] : nullptr;
 }
 
 const Column* ModelSchema::findColumn(const QString& columnName) const {
-    for (const auto& column : columns) {
-        if (column.name == columnName) {
-            return &column;
+    const int index = columnIndex(columnName);
+    return index >= 0 ? &columns[index] : nullptr;
+}
+
+int ModelSchema::columnIndex(const QString& columnName) const {
+    // Индекс перестраивается при каждом изменении колонок: промах означает, что колонки нет
+    const int index = columnIndexes.value(columnName, -1);
+    Q_ASSERT(index < 0 || (index < columns.size() && columns[index].name == columnName));
+    return index;
+}
+
+ColumnHandle ModelSchema::resolveColumn(const QString& columnName) const {
+    const int index = columnIndex(columnName);
+    return index >= 0 ? ColumnHandle(index, columnName) : ColumnHandle();
+}
+
+void ModelSchema::rebuildColumnIndex() {
+    columnIndexes.clear();
+    columnIndexes.reserve(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+        // При повторяющихся именах, как и при поиске перебором, находится первая колонка
+        if (!columnIndexes.contains(columns[i].name)) {
+            columnIndexes.insert(columns[i].name, i);
         }
     }
-    return nullptr;
+}
+
+const Column* ColumnHandle::column(const ModelSchema& schema) const {
+    if (columnIndex < 0) {
+        return nullptr;
+    }
+    if (columnIndex < schema.columns.size() && schema.columns[columnIndex].name == columnName) {
+        return &schema.columns[columnIndex];
+    }
+    return schema.findColumn(columnName);
 }
 
 Query* ModelSchema::findQuery(const QString& queryName) {
@@ -126,6 +151,24 @@ QStringList ModelSchema::validate() const {
         }
     }
     
+    // Check tree settings: nodes are keyed by the primary key
+    if (type == ModelType::Tree && !tree.childrenQuery.isEmpty()) {
+        if (primaryKeyColumns.isEmpty()) {
+            errors << "Tree model requires a primary key column";
+        }
+        if (!queries.contains(tree.childrenQuery)) {
+            errors << QString("Tree children query '%1' not found").arg(tree.childrenQuery);
+        }
+    }
+    
+    // Check write query effects: existing rows are found by the primary key
+    for (auto it = queries.constBegin(); it != queries.constEnd(); ++it) {
+        const QueryEffect effect = it.value().effect;
+        if ((effect == QueryEffect::Update || effect == QueryEffect::Remove) && primaryKeyColumns.isEmpty()) {
+            errors << QString("Query '%1' updates or removes rows but the schema has no primary key").arg(it.key());
+        }
+    }
+    
     // Check reference integrity for foreign key columns
     for (const auto& column : columns) {
         if (!column.referenceTable.isEmpty()) {
@@ -160,6 +203,7 @@ void ModelSchema::addColumn(const Column& column) {
     }
     
     columns.append(column);
+    columnIndexes.insert(column.name, columns.size() - 1);
     
     // Update primary key list if needed
     if (column.isPrimaryKey && !primaryKeyColumns.contains(column.name)) {
@@ -180,11 +224,10 @@ void ModelSchema::addColumn(const Column& column) {
 
 void ModelSchema::removeColumn(const QString& columnName) {
     // Remove from columns list
-    for (int i = 0; i < columns.size(); ++i) {
-        if (columns[i].name == columnName) {
-            columns.removeAt(i);
-            break;
-        }
+    const int index = columnIndex(columnName);
+    if (index >= 0) {
+        columns.removeAt(index);
+        rebuildColumnIndex();
     }
     
     // Remove from primary key list
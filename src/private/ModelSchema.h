@@ -51,6 +51,26 @@ enum class SortOrder {
     Descending
 };
 
+enum class FilterOperator {
+    Equal,
+    NotEqual,
+    Less,
+    LessOrEqual,
+    Greater,
+    GreaterOrEqual,
+    Between,
+    In,
+    Contains,
+    StartsWith,
+    IsNull,
+    IsNotNull
+};
+
+enum class FilterLogic {
+    And,
+    Or
+};
+
 enum class ErrorHandling {
     ShowMessage,
     Ignore,
@@ -96,6 +116,20 @@ enum class EditTrigger {
     AllEditTriggers
 };
 
+// How a foreign key column loads its lookup (key -> display) map
+enum class ReferenceLoading {
+    All,  // whole referenced table once
+    Keys  // only keys present in the model, in batches
+};
+
+// What a write query does to the loaded rows; the model applies it locally instead of reloading
+enum class QueryEffect {
+    None,   // result rows replace the model data
+    Insert, // arguments form a new row; returned row (RETURNING) is merged into it
+    Update, // row found by primary key arguments gets the other arguments
+    Remove  // row found by primary key arguments is removed
+};
+
 // ========== HELPER STRUCTURES ==========
 
 struct Range {
@@ -138,6 +172,7 @@ struct Query {
     int timeoutMs = 30000;
     bool isTransactional = false;
     bool isReadOnly = true;
+    QueryEffect effect = QueryEffect::None;
 };
 
 struct SortRule {
@@ -146,6 +181,40 @@ struct SortRule {
     int priority = 0;
 };
 
+struct FilterRule {
+    QString columnName;
+    FilterOperator op = FilterOperator::Equal;
+    QVariant value;      // Between: lower bound; In: QVariantList
+    QVariant upperValue; // Between only
+
+    bool operator==(const FilterRule& other) const {
+        return columnName == other.columnName && op == other.op &&
+               value == other.value && upperValue == other.upperValue;
+    }
+};
+
+struct FilterGroup {
+    FilterLogic logic = FilterLogic::And;
+    QVector<FilterRule> rules;
+
+    bool operator==(const FilterGroup& other) const {
+        return logic == other.logic && rules == other.rules;
+    }
+};
+
+// Top-level rules and groups are combined with logic; each group combines its own rules
+struct Filter {
+    FilterLogic logic = FilterLogic::And;
+    QVector<FilterRule> rules;
+    QVector<FilterGroup> groups;
+
+    bool isEmpty() const { return rules.isEmpty() && groups.isEmpty(); }
+
+    bool operator==(const Filter& other) const {
+        return logic == other.logic && rules == other.rules && groups == other.groups;
+    }
+};
+
 struct StyleSettings {
     QColor backgroundColor;
     QColor foregroundColor;
@@ -196,6 +265,12 @@ struct PerformanceSettings {
     int maxConcurrentQueries = 3;
 };
 
+struct TreeSettings {
+    QString parentColumn = "parent_id";      // Result column holding the parent's primary key
+    QString childrenQuery;                   // Loads children of several parents at once
+    QString parentsArgument = "parent_ids";  // Array argument of childrenQuery: IN (${parent_ids})
+};
+
 struct SecuritySettings {
     bool enableSqlInjectionProtection = true;
     QStringList allowedOperations;
@@ -244,6 +319,7 @@ struct Column {
     QString referenceTable;
     QString referenceColumn;
     QString displayColumn;
+    ReferenceLoading referenceLoading = ReferenceLoading::All;
     
     // Calculated field settings
     bool isCalculated = false;
@@ -294,6 +370,37 @@ struct ImportSettings {
     int batchSize = 1000;
 };
 
+// ========== COLUMN HANDLE ==========
+
+class ModelSchema;
+
+/**
+ * @brief Column resolved once by name (ModelSchema::resolveColumn).
+ *
+ * Hot paths keep the handle instead of the name. column() checks that the
+ * index still points at the same column and re-resolves it otherwise.
+ */
+class ColumnHandle {
+public:
+    ColumnHandle() = default;
+    ColumnHandle(int index, const QString& name) : columnIndex(index), columnName(name) {}
+    
+    bool isValid() const { return columnIndex >= 0; }
+    int index() const { return columnIndex; }
+    const QString& name() const { return columnName; }
+    
+    const Column* column(const ModelSchema& schema) const;
+    
+    bool operator==(const ColumnHandle& other) const {
+        return columnIndex == other.columnIndex && columnName == other.columnName;
+    }
+    bool operator!=(const ColumnHandle& other) const { return !(*this == other); }
+    
+private:
+    int columnIndex = -1;
+    QString columnName;
+};
+
 // ========== MAIN SCHEMA CLASS ==========
 
 class ModelSchema {
@@ -317,6 +424,9 @@ public:
     QVector<Column> columns;
     QStringList primaryKeyColumns;
     
+    // Hierarchy configuration (type: tree)
+    TreeSettings tree;
+    
     // Headers configuration
     HeaderSettings horizontalHeaders;
     HeaderSettings verticalHeaders;
@@ -404,9 +514,11 @@ public:
         localization.datetimeFormat = "yyyy-MM-dd hh:mm:ss";
     }
     
-    // Utility methods
+    // Utility methods (name lookups are O(1) through the column index)
     Column* findColumn(const QString& columnName);
     const Column* findColumn(const QString& columnName) const;
+    int columnIndex(const QString& columnName) const;
+    ColumnHandle resolveColumn(const QString& columnName) const;
     Query* findQuery(const QString& queryName);
     const Query* findQuery(const QString& queryName) const;
     
@@ -420,6 +532,13 @@ public:
     
     QStringList getEditableColumns() const;
     QStringList getPrimaryKeyColumns() const;
+    
+    // Must be called after editing `columns` directly (parsers and schema migration
+    // do it); lookups trust the index and return -1 for names it does not contain
+    void rebuildColumnIndex();
+    
+private:
+    QHash<QString, int> columnIndexes; // name -> position in columns
 };
 
 } // namespace QForge
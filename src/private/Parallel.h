@@ -0,0 +1,52 @@
+#ifndef QFORGE_PARALLEL_H
+#define QFORGE_PARALLEL_H
+
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <numeric>
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Общие помощники для распараллеливания обработки строк через QThreadPool.
+ */
+namespace Parallel {
+
+static constexpr int kThreshold = 1 << 16; //!< Число строк, начиная с которого работа распараллеливается.
+
+/*!
+ * \brief Возвращает число задач для обработки rows строк (1 - выполнять в текущем потоке).
+ */
+inline int taskCount(int rows)
+{
+    if (rows < kThreshold) {
+        return 1;
+    }
+    const int threads = QThreadPool::globalInstance()->maxThreadCount();
+    return qBound(1, threads, rows / (kThreshold / 4));
+}
+
+/*!
+ * \brief Выполняет fn(0..tasks-1) в пуле потоков и дожидается завершения.
+ */
+template <typename Fn>
+void run(int tasks, const Fn& fn)
+{
+    if (tasks <= 1) {
+        if (tasks == 1) {
+            fn(0);
+        }
+        return;
+    }
+    QVector<int> ids(tasks);
+    std::iota(ids.begin(), ids.end(), 0);
+    QtConcurrent::blockingMap(ids, [&fn](int& id) { fn(id); });
+}
+
+}
+
+}
+
+#endif // QFORGE_PARALLEL_H
@@ -0,0 +1,438 @@
+#include "PredicateKernels.h"
+
+#include <atomic>
+#include <type_traits>
+
+#if defined(Q_PROCESSOR_X86)
+#  include <immintrin.h>
+#  define QFORGE_X86_KERNELS
+#  if defined(Q_CC_MSVC) && !defined(Q_CC_CLANG)
+#    include <intrin.h>
+#    define QFORGE_TARGET(isa)
+#  else
+#    define QFORGE_TARGET(isa) __attribute__((target(isa)))
+#  endif
+#endif
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+using Isa = PredicateKernels::Isa;
+
+template <FilterOperator Op>
+using OpTag = std::integral_constant<FilterOperator, Op>;
+
+// Вызывает fn(OpTag<op>) для операторов сравнения; оператор становится параметром шаблона ядра
+template <typename Fn>
+static bool dispatchOperator(FilterOperator op, const Fn& fn) {
+    switch (op) {
+        case FilterOperator::Equal:          fn(OpTag<FilterOperator::Equal>()); return true;
+        case FilterOperator::NotEqual:       fn(OpTag<FilterOperator::NotEqual>()); return true;
+        case FilterOperator::Less:           fn(OpTag<FilterOperator::Less>()); return true;
+        case FilterOperator::LessOrEqual:    fn(OpTag<FilterOperator::LessOrEqual>()); return true;
+        case FilterOperator::Greater:        fn(OpTag<FilterOperator::Greater>()); return true;
+        case FilterOperator::GreaterOrEqual: fn(OpTag<FilterOperator::GreaterOrEqual>()); return true;
+        case FilterOperator::Between:        fn(OpTag<FilterOperator::Between>()); return true;
+        default:                             return false;
+    }
+}
+
+template <FilterOperator Op, typename T>
+static inline bool matchValue(T value, T low, T high) {
+    if constexpr (Op == FilterOperator::Equal) {
+        return value == low;
+    } else if constexpr (Op == FilterOperator::NotEqual) {
+        return value != low;
+    } else if constexpr (Op == FilterOperator::Less) {
+        return value < low;
+    } else if constexpr (Op == FilterOperator::LessOrEqual) {
+        return value <= low;
+    } else if constexpr (Op == FilterOperator::Greater) {
+        return value > low;
+    } else if constexpr (Op == FilterOperator::GreaterOrEqual) {
+        return value >= low;
+    } else {
+        return value >= low && value <= high;
+    }
+}
+
+// Скалярное ядро для строк [begin, count); begin кратен 64
+template <FilterOperator Op, typename T>
+static void compareScalar(const T* values, int begin, int count, T low, T high, quint64* words) {
+    for (int row = begin; row < count;) {
+        const int stop = qMin(count, row + 64);
+        quint64 word = 0;
+        for (int bit = 0; row < stop; ++row, ++bit) {
+            word |= quint64(matchValue<Op>(values[row], low, high) ? 1 : 0) << bit;
+        }
+        words[(row - 1) >> 6] = word;
+    }
+}
+
+#ifdef QFORGE_X86_KERNELS
+
+// ---------- SSE2 ----------
+
+// В SSE2 нет 64-битных сравнений: собираем их из 32-битных
+QFORGE_TARGET("sse2")
+static inline __m128i cmpeqInt64Sse2(__m128i a, __m128i b) {
+    const __m128i eq = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+// a > b: старшие половины сравниваются со знаком, при их равенстве решает заём из (b - a)
+QFORGE_TARGET("sse2")
+static inline __m128i cmpgtInt64Sse2(__m128i a, __m128i b) {
+    __m128i result = _mm_and_si128(_mm_cmpeq_epi32(a, b), _mm_sub_epi64(b, a));
+    result = _mm_or_si128(result, _mm_cmpgt_epi32(a, b));
+    return _mm_shuffle_epi32(result, _MM_SHUFFLE(3, 3, 1, 1));
+}
+
+template <FilterOperator Op>
+QFORGE_TARGET("sse2")
+static inline int bitsInt64Sse2(__m128i v, __m128i lo, __m128i hi) {
+    __m128i mask;
+    int invert = 0;
+    if constexpr (Op == FilterOperator::Equal) {
+        mask = cmpeqInt64Sse2(v, lo);
+    } else if constexpr (Op == FilterOperator::NotEqual) {
+        mask = cmpeqInt64Sse2(v, lo);
+        invert = 0x3;
+    } else if constexpr (Op == FilterOperator::Less) {
+        mask = cmpgtInt64Sse2(lo, v);
+    } else if constexpr (Op == FilterOperator::LessOrEqual) {
+        mask = cmpgtInt64Sse2(v, lo);
+        invert = 0x3;
+    } else if constexpr (Op == FilterOperator::Greater) {
+        mask = cmpgtInt64Sse2(v, lo);
+    } else if constexpr (Op == FilterOperator::GreaterOrEqual) {
+        mask = cmpgtInt64Sse2(lo, v);
+        invert = 0x3;
+    } else {
+        mask = _mm_or_si128(cmpgtInt64Sse2(lo, v), cmpgtInt64Sse2(v, hi));
+        invert = 0x3;
+    }
+    return _mm_movemask_pd(_mm_castsi128_pd(mask)) ^ invert;
+}
+
+template <FilterOperator Op>
+QFORGE_TARGET("sse2")
+static void compareInt64Sse2(const qint64* values, int count, qint64 low, qint64 high, quint64* words) {
+    const __m128i lo = _mm_set1_epi64x(low);
+    const __m128i hi = _mm_set1_epi64x(high);
+    const int fullWords = count / 64;
+    for (int w = 0; w < fullWords; ++w) {
+        const __m128i* base = reinterpret_cast<const __m128i*>(values + w * 64);
+        quint64 word = 0;
+        for (int i = 0; i < 32; ++i) {
+            word |= quint64(bitsInt64Sse2<Op>(_mm_loadu_si128(base + i), lo, hi)) << (i * 2);
+        }
+        words[w] = word;
+    }
+    compareScalar<Op>(values, fullWords * 64, count, low, high, words);
+}
+
+template <FilterOperator Op>
+QFORGE_TARGET("sse2")
+static inline int bitsDoubleSse2(__m128d v, __m128d lo, __m128d hi) {
+    if constexpr (Op == FilterOperator::Equal) {
+        return _mm_movemask_pd(_mm_cmpeq_pd(v, lo));
+    } else if constexpr (Op == FilterOperator::NotEqual) {
+        return _mm_movemask_pd(_mm_cmpneq_pd(v, lo));
+    } else if constexpr (Op == FilterOperator::Less) {
+        return _mm_movemask_pd(_mm_cmplt_pd(v, lo));
+    } else if constexpr (Op == FilterOperator::LessOrEqual) {
+        return _mm_movemask_pd(_mm_cmple_pd(v, lo));
+    } else if constexpr (Op == FilterOperator::Greater) {
+        return _mm_movemask_pd(_mm_cmpgt_pd(v, lo));
+    } else if constexpr (Op == FilterOperator::GreaterOrEqual) {
+        return _mm_movemask_pd(_mm_cmpge_pd(v, lo));
+    } else {
+        return _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(v, lo), _mm_cmple_pd(v, hi)));
+    }
+}
+
+template <FilterOperator Op>
+QFORGE_TARGET("sse2")
+static void compareDoubleSse2(const double* values, int count, double low, double high, quint64* words) {
+    const __m128d lo = _mm_set1_pd(low);
+    const __m128d hi = _mm_set1_pd(high);
+    const int fullWords = count / 64;
+    for (int w = 0; w < fullWords; ++w) {
+        const double* base = values + w * 64;
+        quint64 word = 0;
+        for (int i = 0; i < 32; ++i) {
+            word |= quint64(bitsDoubleSse2<Op>(_mm_loadu_pd(base + i * 2), lo, hi)) << (i * 2);
+        }
+        words[w] = word;
+    }
+    compareScalar<Op>(values, fullWords * 64, count, low, high, words);
+}
+
+// ---------- AVX2 ----------
+
+template <FilterOperator Op>
+QFORGE_TARGET("avx2")
+static inline int bitsInt64Avx2(__m256i v, __m256i lo, __m256i hi) {
+    __m256i mask;
+    int invert = 0;
+    if constexpr (Op == FilterOperator::Equal) {
+        mask = _mm256_cmpeq_epi64(v, lo);
+    } else if constexpr (Op == FilterOperator::NotEqual) {
+        mask = _mm256_cmpeq_epi64(v, lo);
+        invert = 0xF;
+    } else if constexpr (Op == FilterOperator::Less) {
+        mask = _mm256_cmpgt_epi64(lo, v);
+    } else if constexpr (Op == FilterOperator::LessOrEqual) {
+        mask = _mm256_cmpgt_epi64(v, lo);
+        invert = 0xF;
+    } else if constexpr (Op == FilterOperator::Greater) {
+        mask = _mm256_cmpgt_epi64(v, lo);
+    } else if constexpr (Op == FilterOperator::GreaterOrEqual) {
+        mask = _mm256_cmpgt_epi64(lo, v);
+        invert = 0xF;
+    } else {
+        mask = _mm256_or_si256(_mm256_cmpgt_epi64(lo, v), _mm256_cmpgt_epi64(v, hi));
+        invert = 0xF;
+    }
+    return _mm256_movemask_pd(_mm256_castsi256_pd(mask)) ^ invert;
+}
+
+template <FilterOperator Op>
+QFORGE_TARGET("avx2")
+static void compareInt64Avx2(const qint64* values, int count, qint64 low, qint64 high, quint64* words) {
+    const __m256i lo = _mm256_set1_epi64x(low);
+    const __m256i hi = _mm256_set1_epi64x(high);
+    const int fullWords = count / 64;
+    for (int w = 0; w < fullWords; ++w) {
+        const __m256i* base = reinterpret_cast<const __m256i*>(values + w * 64);
+        quint64 word = 0;
+        for (int i = 0; i < 16; ++i) {
+            word |= quint64(bitsInt64Avx2<Op>(_mm256_loadu_si256(base + i), lo, hi)) << (i * 4);
+        }
+        words[w] = word;
+    }
+    compareScalar<Op>(values, fullWords * 64, count, low, high, words);
+}
+
+// Упорядоченные предикаты ложны для NaN, NotEqual - истинен, как и в скалярном коде
+template <FilterOperator Op>
+QFORGE_TARGET("avx2")
+static inline int bitsDoubleAvx2(__m256d v, __m256d lo, __m256d hi) {
+    if constexpr (Op == FilterOperator::Equal) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(v, lo, _CMP_EQ_OQ));
+    } else if constexpr (Op == FilterOperator::NotEqual) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(v, lo, _CMP_NEQ_UQ));
+    } else if constexpr (Op == FilterOperator::Less) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(v, lo, _CMP_LT_OQ));
+    } else if constexpr (Op == FilterOperator::LessOrEqual) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(v, lo, _CMP_LE_OQ));
+    } else if constexpr (Op == FilterOperator::Greater) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(v, lo, _CMP_GT_OQ));
+    } else if constexpr (Op == FilterOperator::GreaterOrEqual) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(v, lo, _CMP_GE_OQ));
+    } else {
+        return _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(v, lo, _CMP_GE_OQ),
+                                                _mm256_cmp_pd(v, hi, _CMP_LE_OQ)));
+    }
+}
+
+template <FilterOperator Op>
+QFORGE_TARGET("avx2")
+static void compareDoubleAvx2(const double* values, int count, double low, double high, quint64* words) {
+    const __m256d lo = _mm256_set1_pd(low);
+    const __m256d hi = _mm256_set1_pd(high);
+    const int fullWords = count / 64;
+    for (int w = 0; w < fullWords; ++w) {
+        const double* base = values + w * 64;
+        quint64 word = 0;
+        for (int i = 0; i < 16; ++i) {
+            word |= quint64(bitsDoubleAvx2<Op>(_mm256_loadu_pd(base + i * 4), lo, hi)) << (i * 4);
+        }
+        words[w] = word;
+    }
+    compareScalar<Op>(values, fullWords * 64, count, low, high, words);
+}
+
+QFORGE_TARGET("avx2")
+static void andWordsAvx2(quint64* target, const quint64* source, int wordCount) {
+    int w = 0;
+    for (; w + 4 <= wordCount; w += 4) {
+        __m256i* dst = reinterpret_cast<__m256i*>(target + w);
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + w));
+        _mm256_storeu_si256(dst, _mm256_and_si256(_mm256_loadu_si256(dst), src));
+    }
+    for (; w < wordCount; ++w) {
+        target[w] &= source[w];
+    }
+}
+
+QFORGE_TARGET("avx2")
+static void orWordsAvx2(quint64* target, const quint64* source, int wordCount) {
+    int w = 0;
+    for (; w + 4 <= wordCount; w += 4) {
+        __m256i* dst = reinterpret_cast<__m256i*>(target + w);
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + w));
+        _mm256_storeu_si256(dst, _mm256_or_si256(_mm256_loadu_si256(dst), src));
+    }
+    for (; w < wordCount; ++w) {
+        target[w] |= source[w];
+    }
+}
+
+QFORGE_TARGET("avx2")
+static void andNotWordsAvx2(quint64* target, const quint64* source, int wordCount) {
+    int w = 0;
+    for (; w + 4 <= wordCount; w += 4) {
+        __m256i* dst = reinterpret_cast<__m256i*>(target + w);
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + w));
+        _mm256_storeu_si256(dst, _mm256_andnot_si256(src, _mm256_loadu_si256(dst)));
+    }
+    for (; w < wordCount; ++w) {
+        target[w] &= ~source[w];
+    }
+}
+
+static Isa detectIsa() {
+#  if defined(Q_CC_MSVC) && !defined(Q_CC_CLANG)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] >> 26) & 1;
+    const bool osxsave = (info[2] >> 27) & 1;
+    const bool avx = (info[2] >> 28) & 1;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] >> 5) & 1;
+    }
+#  else
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#  endif
+    if (avx2) {
+        return Isa::Avx2;
+    }
+    return sse2 ? Isa::Sse2 : Isa::Scalar;
+}
+
+#else
+
+static Isa detectIsa() {
+    return Isa::Scalar;
+}
+
+#endif // QFORGE_X86_KERNELS
+
+static std::atomic<int>& activeIsaStorage() {
+    static std::atomic<int> isa{int(detectIsa())};
+    return isa;
+}
+
+// ========== PUBLIC METHODS ==========
+
+PredicateKernels::Isa PredicateKernels::supportedIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+PredicateKernels::Isa PredicateKernels::activeIsa() {
+    return Isa(activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+void PredicateKernels::setActiveIsa(Isa isa) {
+    activeIsaStorage().store(int(qMin(isa, supportedIsa())), std::memory_order_relaxed);
+}
+
+const char* PredicateKernels::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "AVX2";
+        case Isa::Sse2: return "SSE2";
+        default:        return "Scalar";
+    }
+}
+
+bool PredicateKernels::isSupported(FilterOperator op) {
+    return dispatchOperator(op, [](auto) {});
+}
+
+bool PredicateKernels::compareInt64(const qint64* values, int count, FilterOperator op,
+                                    qint64 low, qint64 high, quint64* words) {
+    const Isa isa = activeIsa();
+    return dispatchOperator(op, [&](auto tag) {
+        constexpr FilterOperator Op = decltype(tag)::value;
+#ifdef QFORGE_X86_KERNELS
+        if (isa == Isa::Avx2) {
+            compareInt64Avx2<Op>(values, count, low, high, words);
+            return;
+        }
+        if (isa == Isa::Sse2) {
+            compareInt64Sse2<Op>(values, count, low, high, words);
+            return;
+        }
+#endif
+        Q_UNUSED(isa)
+        compareScalar<Op>(values, 0, count, low, high, words);
+    });
+}
+
+bool PredicateKernels::compareDouble(const double* values, int count, FilterOperator op,
+                                     double low, double high, quint64* words) {
+    const Isa isa = activeIsa();
+    return dispatchOperator(op, [&](auto tag) {
+        constexpr FilterOperator Op = decltype(tag)::value;
+#ifdef QFORGE_X86_KERNELS
+        if (isa == Isa::Avx2) {
+            compareDoubleAvx2<Op>(values, count, low, high, words);
+            return;
+        }
+        if (isa == Isa::Sse2) {
+            compareDoubleSse2<Op>(values, count, low, high, words);
+            return;
+        }
+#endif
+        Q_UNUSED(isa)
+        compareScalar<Op>(values, 0, count, low, high, words);
+    });
+}
+
+void PredicateKernels::andWords(quint64* target, const quint64* source, int wordCount) {
+#ifdef QFORGE_X86_KERNELS
+    if (activeIsa() == Isa::Avx2) {
+        andWordsAvx2(target, source, wordCount);
+        return;
+    }
+#endif
+    for (int w = 0; w < wordCount; ++w) {
+        target[w] &= source[w];
+    }
+}
+
+void PredicateKernels::orWords(quint64* target, const quint64* source, int wordCount) {
+#ifdef QFORGE_X86_KERNELS
+    if (activeIsa() == Isa::Avx2) {
+        orWordsAvx2(target, source, wordCount);
+        return;
+    }
+#endif
+    for (int w = 0; w < wordCount; ++w) {
+        target[w] |= source[w];
+    }
+}
+
+void PredicateKernels::andNotWords(quint64* target, const quint64* source, int wordCount) {
+#ifdef QFORGE_X86_KERNELS
+    if (activeIsa() == Isa::Avx2) {
+        andNotWordsAvx2(target, source, wordCount);
+        return;
+    }
+#endif
+    for (int w = 0; w < wordCount; ++w) {
+        target[w] &= ~source[w];
+    }
+}
+
+}
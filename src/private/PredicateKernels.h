@@ -0,0 +1,68 @@
+#ifndef QFORGE_PREDICATEKERNELS_H
+#define QFORGE_PREDICATEKERNELS_H
+
+#include <QtGlobal>
+
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Векторизованные ядра сравнения для Int64/Double-колонок и битовых масок.
+ *
+ * Результат сравнения values[0..count) пишется в слова маски: бит (i % 64)
+ * слова (i / 64). Набор инструкций (AVX2, SSE2 или скалярный код) выбирается
+ * при первом обращении по возможностям процессора. Boolean, Date, Time и DateTime
+ * хранятся как Int64, поэтому обрабатываются теми же ядрами.
+ */
+class PredicateKernels
+{
+public:
+    enum class Isa {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    /*!
+     * \brief Лучший набор инструкций, поддерживаемый процессором.
+     */
+    static Isa supportedIsa();
+
+    /*!
+     * \brief Набор инструкций, используемый ядрами сейчас.
+     */
+    static Isa activeIsa();
+
+    /*!
+     * \brief Принудительно выбирает набор инструкций (для замеров и тестов).
+     * \details Неподдерживаемый набор понижается до supportedIsa().
+     */
+    static void setActiveIsa(Isa isa);
+
+    static const char* isaName(Isa isa);
+
+    /*!
+     * \brief Проверяет, что оператор поддерживается ядрами сравнения.
+     * \details Поддерживаются Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual, Between.
+     */
+    static bool isSupported(FilterOperator op);
+
+    /*!
+     * \brief Сравнивает значения с границами; high используется только для Between.
+     * \return false, если оператор не поддерживается (маска не изменяется).
+     */
+    static bool compareInt64(const qint64* values, int count, FilterOperator op,
+                             qint64 low, qint64 high, quint64* words);
+    static bool compareDouble(const double* values, int count, FilterOperator op,
+                              double low, double high, quint64* words);
+
+    // Пословные операции над масками
+    static void andWords(quint64* target, const quint64* source, int wordCount);
+    static void orWords(quint64* target, const quint64* source, int wordCount);
+    static void andNotWords(quint64* target, const quint64* source, int wordCount);
+};
+
+}
+
+#endif // QFORGE_PREDICATEKERNELS_H
@@ -0,0 +1,698 @@
+#include "QueryEngine.h"
+
+#include "FilterEngine.h"
+#include "Parallel.h"
+#include "RowBitmap.h"
+#include "SortEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+// Индекс используется, если кандидатов не больше чем rows / kIndexSelectivity:
+// проверка строки по списку дороже, чем векторизованный просмотр блока колонки
+static constexpr int kIndexSelectivity = 16;
+
+// Частичная сортировка, если нужно не больше чем rows / kTopSelectivity первых строк
+static constexpr int kTopSelectivity = 8;
+
+static QString missingColumn(const ColumnStore& store, const Filter& filter) {
+    auto missing = [&store](const FilterRule& rule) {
+        return store.columnIndex(rule.columnName) < 0;
+    };
+    for (const FilterRule& rule : filter.rules) {
+        if (missing(rule)) {
+            return rule.columnName;
+        }
+    }
+    for (const FilterGroup& group : filter.groups) {
+        for (const FilterRule& rule : group.rules) {
+            if (missing(rule)) {
+                return rule.columnName;
+            }
+        }
+    }
+    return QString();
+}
+
+static inline double indexKey(double value) {
+    return value == 0.0 ? 0.0 : value; // -0.0 и 0.0 равны при сравнении
+}
+
+namespace {
+
+struct Token
+{
+    enum Kind {
+        End,
+        Word,   //!< Имя, ключевое слово, число или значение без кавычек.
+        Text,   //!< Строка в кавычках.
+        Param,  //!< ${name} или :name.
+        Symbol  //!< Оператор сравнения, скобка, запятая или *.
+    };
+
+    Kind kind = End;
+    QString text;
+};
+
+// Разбор текста запроса рекурсивным спуском
+class QueryParser
+{
+public:
+    QueryParser(const QString& text, const QVariantMap& bindings);
+
+    bool parse(LocalQuery& query);
+
+    QString error;
+
+private:
+    bool tokenize(const QString& text);
+
+    const Token& peek() const { return tokens[pos]; }
+    Token take() { return tokens[pos < tokens.size() - 1 ? pos++ : pos]; }
+    bool isKeyword(const char* keyword) const;
+    bool acceptKeyword(const char* keyword);
+    bool acceptSymbol(const char* symbol);
+    bool fail(const QString& message);
+
+    bool parseName(QString& name);
+    bool parseValue(QVariant& value);
+    bool parseCount(int& count);
+    bool parseExpression(Filter& filter);
+    bool parseCondition(FilterRule& rule);
+
+    const QVariantMap& bindings;
+    QVector<Token> tokens;
+    int pos = 0;
+};
+
+QueryParser::QueryParser(const QString& text, const QVariantMap& bindings)
+    : bindings(bindings)
+{
+    if (!tokenize(text)) {
+        tokens = {Token()};
+    }
+}
+
+bool QueryParser::tokenize(const QString& text) {
+    static const QString kSymbolChars = QStringLiteral("=<>!(),*");
+    static const QString kStopChars = QStringLiteral("=<>!(),'\"");
+
+    const int size = text.size();
+    int i = 0;
+    while (i < size) {
+        const QChar c = text[i];
+        if (c.isSpace()) {
+            ++i;
+            continue;
+        }
+
+        Token token;
+        if (c == '\'' || c == '"') {
+            // Удвоенная кавычка внутри строки - экранированная кавычка
+            token.kind = Token::Text;
+            ++i;
+            for (;;) {
+                if (i >= size) {
+                    return fail(QString("Unterminated string literal"));
+                }
+                if (text[i] == c) {
+                    if (i + 1 < size && text[i + 1] == c) {
+                        token.text += c;
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                token.text += text[i++];
+            }
+        } else if ((c == '$' && i + 1 < size && text[i + 1] == '{') || c == ':') {
+            token.kind = Token::Param;
+            const bool braced = c == '$';
+            i += braced ? 2 : 1;
+            const int start = i;
+            while (i < size && (text[i].isLetterOrNumber() || text[i] == '_')) {
+                ++i;
+            }
+            token.text = text.mid(start, i - start);
+            if (token.text.isEmpty() || (braced && (i >= size || text[i++] != '}'))) {
+                return fail(QString("Malformed parameter at position %1").arg(start));
+            }
+        } else if (kSymbolChars.contains(c)) {
+            token.kind = Token::Symbol;
+            token.text = c;
+            ++i;
+            // Двухсимвольные операторы: <=, >=, <>, !=, ==
+            if (i < size && text[i] == '=' && (c == '<' || c == '>' || c == '!' || c == '=')) {
+                token.text += text[i++];
+            } else if (c == '<' && i < size && text[i] == '>') {
+                token.text += text[i++];
+            }
+        } else {
+            token.kind = Token::Word;
+            const int start = i;
+            while (i < size && !text[i].isSpace() && !kStopChars.contains(text[i])) {
+                ++i;
+            }
+            token.text = text.mid(start, i - start);
+        }
+        tokens.append(token);
+    }
+    tokens.append(Token());
+    return true;
+}
+
+bool QueryParser::isKeyword(const char* keyword) const {
+    return peek().kind == Token::Word && peek().text.compare(QLatin1String(keyword), Qt::CaseInsensitive) == 0;
+}
+
+bool QueryParser::acceptKeyword(const char* keyword) {
+    if (!isKeyword(keyword)) {
+        return false;
+    }
+    ++pos;
+    return true;
+}
+
+bool QueryParser::acceptSymbol(const char* symbol) {
+    if (peek().kind != Token::Symbol || peek().text != QLatin1String(symbol)) {
+        return false;
+    }
+    ++pos;
+    return true;
+}
+
+bool QueryParser::fail(const QString& message) {
+    if (error.isEmpty()) {
+        error = message;
+    }
+    return false;
+}
+
+bool QueryParser::parseName(QString& name) {
+    if (peek().kind != Token::Word && peek().kind != Token::Text) {
+        return fail(QString("Column name expected near '%1'").arg(peek().text));
+    }
+    name = take().text;
+    return true;
+}
+
+bool QueryParser::parseValue(QVariant& value) {
+    const Token token = take();
+    switch (token.kind) {
+        case Token::Text:
+            value = token.text;
+            return true;
+        case Token::Param:
+            if (!bindings.contains(token.text)) {
+                return fail(QString("Unknown parameter '%1'").arg(token.text));
+            }
+            value = bindings.value(token.text);
+            return true;
+        case Token::Word: {
+            if (token.text.compare(QLatin1String("true"), Qt::CaseInsensitive) == 0) {
+                value = true;
+                return true;
+            }
+            if (token.text.compare(QLatin1String("false"), Qt::CaseInsensitive) == 0) {
+                value = false;
+                return true;
+            }
+            bool ok = false;
+            const qlonglong integer = token.text.toLongLong(&ok);
+            if (ok) {
+                value = integer;
+                return true;
+            }
+            const double number = token.text.toDouble(&ok);
+            value = ok ? QVariant(number) : QVariant(token.text);
+            return true;
+        }
+        default:
+            return fail(QString("Value expected near '%1'").arg(token.text));
+    }
+}
+
+bool QueryParser::parseCount(int& count) {
+    bool ok = false;
+    count = peek().kind == Token::Word ? peek().text.toInt(&ok) : 0;
+    if (!ok || count < 0) {
+        return fail(QString("Non-negative number expected near '%1'").arg(peek().text));
+    }
+    ++pos;
+    return true;
+}
+
+bool QueryParser::parseCondition(FilterRule& rule) {
+    if (!parseName(rule.columnName)) {
+        return false;
+    }
+
+    if (acceptKeyword("IS")) {
+        rule.op = acceptKeyword("NOT") ? FilterOperator::IsNotNull : FilterOperator::IsNull;
+        return acceptKeyword("NULL") || fail(QString("NULL expected after IS"));
+    }
+    if (acceptKeyword("IN")) {
+        rule.op = FilterOperator::In;
+        if (!acceptSymbol("(")) {
+            return fail(QString("'(' expected after IN"));
+        }
+        QVariantList items;
+        do {
+            QVariant item;
+            if (!parseValue(item)) {
+                return false;
+            }
+            items.append(item);
+        } while (acceptSymbol(","));
+        rule.value = items;
+        return acceptSymbol(")") || fail(QString("')' expected after IN list"));
+    }
+    if (acceptKeyword("BETWEEN")) {
+        rule.op = FilterOperator::Between;
+        return parseValue(rule.value)
+            && (acceptKeyword("AND") || fail(QString("AND expected in BETWEEN")))
+            && parseValue(rule.upperValue);
+    }
+    if (acceptKeyword("CONTAINS")) {
+        rule.op = FilterOperator::Contains;
+        return parseValue(rule.value);
+    }
+    if (acceptKeyword("STARTS_WITH")) {
+        rule.op = FilterOperator::StartsWith;
+        return parseValue(rule.value);
+    }
+
+    bool known = false;
+    if (peek().kind == Token::Symbol) {
+        rule.op = FilterEngine::operatorFromString(peek().text, &known);
+    }
+    if (!known || rule.op == FilterOperator::In || rule.op == FilterOperator::Between) {
+        return fail(QString("Comparison operator expected after '%1'").arg(rule.columnName));
+    }
+    ++pos;
+    return parseValue(rule.value);
+}
+
+bool QueryParser::parseExpression(Filter& filter) {
+    // AND связывает сильнее OR: выражение - OR групп, связанных AND
+    QVector<QVector<FilterRule>> groups(1);
+    do {
+        do {
+            FilterRule rule;
+            if (!parseCondition(rule)) {
+                return false;
+            }
+            groups.last().append(rule);
+        } while (acceptKeyword("AND"));
+        if (!acceptKeyword("OR")) {
+            break;
+        }
+        groups.append(QVector<FilterRule>());
+    } while (true);
+
+    if (groups.size() == 1) {
+        filter.logic = FilterLogic::And;
+        filter.rules = groups.first();
+        return true;
+    }
+    filter.logic = FilterLogic::Or;
+    for (const QVector<FilterRule>& rules : std::as_const(groups)) {
+        FilterGroup group;
+        group.logic = FilterLogic::And;
+        group.rules = rules;
+        filter.groups.append(group);
+    }
+    return true;
+}
+
+bool QueryParser::parse(LocalQuery& query) {
+    if (!error.isEmpty()) {
+        return false;
+    }
+
+    if (acceptKeyword("SELECT") && !acceptSymbol("*")) {
+        do {
+            QString name;
+            if (!parseName(name)) {
+                return false;
+            }
+            query.columns.append(name);
+        } while (acceptSymbol(","));
+    }
+
+    if (acceptKeyword("FILTER") || acceptKeyword("WHERE")) {
+        LocalQuery::Condition condition;
+        if (!parseExpression(condition.filter)) {
+            return false;
+        }
+        query.where.append(condition);
+    }
+
+    if (acceptKeyword("ORDER")) {
+        if (!acceptKeyword("BY")) {
+            return fail(QString("BY expected after ORDER"));
+        }
+        do {
+            SortRule rule;
+            if (!parseName(rule.columnName)) {
+                return false;
+            }
+            if (acceptKeyword("DESC")) {
+                rule.order = SortOrder::Descending;
+            } else {
+                acceptKeyword("ASC");
+            }
+            rule.priority = query.orderBy.size();
+            query.orderBy.append(rule);
+        } while (acceptSymbol(","));
+    }
+
+    if (acceptKeyword("LIMIT") && !parseCount(query.limit)) {
+        return false;
+    }
+    if (acceptKeyword("OFFSET") && !parseCount(query.offset)) {
+        return false;
+    }
+
+    if (peek().kind != Token::End) {
+        return fail(QString("Unexpected '%1'").arg(peek().text));
+    }
+    return true;
+}
+
+}
+
+// ========== PUBLIC METHODS ==========
+
+QueryEngine::QueryEngine(const ColumnStore& store)
+    : store(&store)
+{
+}
+
+bool QueryEngine::parse(const QString& text, const QVariantMap& bindings, LocalQuery& query, QString* error) {
+    query = LocalQuery();
+    QueryParser parser(text, bindings);
+    const bool ok = parser.parse(query);
+    if (!ok && error) {
+        *error = parser.error;
+    }
+    return ok;
+}
+
+bool QueryEngine::createIndex(const QString& column) {
+    const int index = store->columnIndex(column);
+    if (index < 0 || store->column(index).kind == StorageKind::Variant) {
+        return false;
+    }
+    Index& created = indexes[column];
+    created.column = index;
+    buildIndex(*store, created);
+    return true;
+}
+
+bool QueryEngine::hasIndex(const QString& column) const {
+    return indexes.contains(column);
+}
+
+void QueryEngine::dropIndexes() {
+    indexes.clear();
+}
+
+void QueryEngine::rebuildIndexes() {
+    // Набор колонок мог измениться, а колонка - перейти в Variant: такие индексы удаляются
+    for (auto it = indexes.begin(); it != indexes.end();) {
+        it->column = store->columnIndex(it.key());
+        if (it->column < 0 || store->column(it->column).kind == StorageKind::Variant) {
+            it = indexes.erase(it);
+            continue;
+        }
+        buildIndex(*store, *it);
+        ++it;
+    }
+}
+
+void QueryEngine::updateIndexes(int first) {
+    for (auto it = indexes.begin(); it != indexes.end();) {
+        // Колонка, перешедшая в Variant при добавлении строк, больше не индексируется
+        if (store->column(it->column).kind == StorageKind::Variant) {
+            it = indexes.erase(it);
+            continue;
+        }
+        buildIndex(*store, *it, first);
+        ++it;
+    }
+}
+
+bool QueryEngine::select(const LocalQuery& query, QVector<int>& rows, QString* error) const {
+    auto unknown = [error](const QString& name) {
+        if (error) {
+            *error = QString("Unknown column '%1'").arg(name);
+        }
+        return false;
+    };
+    for (const QString& name : query.columns) {
+        if (store->columnIndex(name) < 0) {
+            return unknown(name);
+        }
+    }
+    for (const SortRule& rule : query.orderBy) {
+        if (store->columnIndex(rule.columnName) < 0) {
+            return unknown(rule.columnName);
+        }
+    }
+    for (const LocalQuery::Condition& condition : query.where) {
+        const QString missing = missingColumn(*store, condition.filter);
+        if (!missing.isEmpty()) {
+            return unknown(missing);
+        }
+    }
+
+    const int rowCount = store->rowCount();
+    rows.clear();
+    if (indexedRows(query, rows)) {
+        for (const LocalQuery::Condition& condition : query.where) {
+            FilterEngine::filterRows(*store, condition.filter, condition.cs, rows);
+        }
+    } else if (query.where.isEmpty()) {
+        rows.resize(rowCount);
+        std::iota(rows.begin(), rows.end(), 0);
+    } else {
+        RowBitmap mask;
+        FilterEngine::evaluate(*store, query.where.first().filter, query.where.first().cs, mask);
+        for (int i = 1; i < query.where.size(); ++i) {
+            RowBitmap conditionMask;
+            FilterEngine::evaluate(*store, query.where[i].filter, query.where[i].cs, conditionMask);
+            mask &= conditionMask;
+        }
+        rows.reserve(mask.count());
+        mask.forEach([&rows](int row) { rows.append(row); });
+    }
+
+    const int offset = qMin(query.offset, int(rows.size()));
+    const int available = int(rows.size()) - offset;
+    const int count = query.limit < 0 ? available : qMin(query.limit, available);
+
+    if (!query.orderBy.isEmpty()) {
+        QVector<SortKey> keys;
+        for (const SortRule& rule : query.orderBy) {
+            keys.append(SortKey{store->columnIndex(rule.columnName), rule.order});
+        }
+        const int needed = offset + count;
+        if (needed < rows.size() && qint64(needed) * kTopSelectivity < rows.size()) {
+            // Нужны только первые строки: частичная сортировка; строки идут по возрастанию,
+            // поэтому сравнение индексов при равенстве ключей сохраняет устойчивость
+            std::partial_sort(rows.begin(), rows.begin() + needed, rows.end(), [&](int lhs, int rhs) {
+                const int result = SortEngine::compare(*store, keys, lhs, rhs);
+                return result < 0 || (result == 0 && lhs < rhs);
+            });
+        } else {
+            SortEngine::sortRows(*store, keys, rows);
+        }
+    }
+
+    if (offset > 0 || count < rows.size()) {
+        rows = rows.mid(offset, count);
+    }
+    return true;
+}
+
+QueryResult QueryEngine::run(const LocalQuery& query) const {
+    QueryResult result;
+    result.ok = false;
+
+    QVector<int> rows;
+    QString error;
+    if (!select(query, rows, &error)) {
+        result.log(error);
+        return result;
+    }
+
+    QVector<int> columns;
+    for (const QString& name : query.columns) {
+        columns.append(store->columnIndex(name));
+    }
+
+    // Строки результата собираются параллельно в заранее выделенный список
+    result.rows.resize(rows.size());
+    QVariantMap* out = result.rows.data();
+    const int* source = rows.constData();
+    const int total = rows.size();
+    const int tasks = Parallel::taskCount(total);
+    const int rowsPerTask = (total + tasks - 1) / tasks;
+    Parallel::run(tasks, [&](int t) {
+        const int end = qMin(total, (t + 1) * rowsPerTask);
+        for (int i = t * rowsPerTask; i < end; ++i) {
+            if (columns.isEmpty()) {
+                out[i] = store->rowMap(source[i]);
+                continue;
+            }
+            QVariantMap& row = out[i];
+            for (int c = 0; c < columns.size(); ++c) {
+                row.insert(query.columns[c], store->value(source[i], columns[c]));
+            }
+        }
+    });
+
+    result.ok = true;
+    return result;
+}
+
+QueryResult QueryEngine::execute(const QueryContext& context) const {
+    LocalQuery query;
+    QString error;
+    if (!parse(context.sql, context.bindings, query, &error)) {
+        QueryResult result;
+        result.ok = false;
+        result.log(QString("Cannot parse query '%1': %2").arg(context.queryName, error));
+        return result;
+    }
+
+    // Фильтр модели выполняется здесь же, если все его колонки есть в хранилище
+    bool filterApplied = false;
+    if (!context.filter.isEmpty()) {
+        LocalQuery::Condition condition;
+        if (FilterEngine::fromQueryFilter(context.filter, condition.filter, condition.cs)
+            && missingColumn(*store, condition.filter).isEmpty()) {
+            query.where.append(condition);
+            filterApplied = true;
+        }
+    }
+
+    QueryResult result = run(query);
+    result.filterApplied = filterApplied && result.ok;
+    return result;
+}
+
+QString QueryEngine::explain(const LocalQuery& query) const {
+    QVector<int> rows;
+    QString column;
+    return indexedRows(query, rows, &column) ? QString("index %1").arg(column) : QString("scan");
+}
+
+// ========== PRIVATE METHODS ==========
+
+bool QueryEngine::indexedRows(const LocalQuery& query, QVector<int>& rows, QString* column) const {
+    bool found = false;
+    for (const LocalQuery::Condition& condition : query.where) {
+        // Кандидаты дают только правила, обязательные для всего условия
+        const Filter& filter = condition.filter;
+        if (filter.logic != FilterLogic::And && filter.rules.size() + filter.groups.size() > 1) {
+            continue;
+        }
+        for (const FilterRule& rule : filter.rules) {
+            if (rule.op != FilterOperator::Equal && rule.op != FilterOperator::In) {
+                continue;
+            }
+            const auto it = indexes.constFind(rule.columnName);
+            QVector<int> candidates;
+            if (it == indexes.constEnd() || !probe(*it, rule, candidates)) {
+                continue;
+            }
+            if (!found || candidates.size() < rows.size()) {
+                rows = candidates;
+                found = true;
+                if (column) {
+                    *column = rule.columnName;
+                }
+            }
+        }
+    }
+    return found && qint64(rows.size()) * kIndexSelectivity <= store->rowCount();
+}
+
+bool QueryEngine::probe(const Index& index, const FilterRule& rule, QVector<int>& rows) const {
+    if (index.column < 0 || index.column >= store->columnCount()) {
+        return false;
+    }
+    const TypedColumn& column = store->column(index.column);
+    const QVariantList values = rule.op == FilterOperator::In ? rule.value.toList() : QVariantList{rule.value};
+
+    for (const QVariant& value : values) {
+        switch (column.kind) {
+            case StorageKind::Int64: {
+                qint64 key = 0;
+                if (TypedColumn::toInt64(column.type, value, key)) {
+                    rows += index.ints.value(key);
+                }
+                break;
+            }
+            case StorageKind::Double: {
+                bool ok = false;
+                const double key = value.toDouble(&ok);
+                if (ok) {
+                    rows += index.doubles.value(indexKey(key));
+                }
+                break;
+            }
+            case StorageKind::String:
+                rows += index.strings.value(value.toString().toCaseFolded());
+                break;
+            case StorageKind::Variant:
+                return false;
+        }
+    }
+
+    if (values.size() > 1) {
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    }
+    return true;
+}
+
+void QueryEngine::buildIndex(const ColumnStore& store, Index& index, int first) {
+    if (first <= 0) {
+        index.ints.clear();
+        index.doubles.clear();
+        index.strings.clear();
+    }
+
+    const TypedColumn& column = store.column(index.column);
+    for (int row = qMax(0, first); row < store.rowCount(); ++row) {
+        if (column.isNull(row)) {
+            continue;
+        }
+        switch (column.kind) {
+            case StorageKind::Int64:
+                index.ints[column.ints[row]].append(row);
+                break;
+            case StorageKind::Double:
+                if (!std::isnan(column.doubles[row])) {
+                    index.doubles[indexKey(column.doubles[row])].append(row);
+                }
+                break;
+            case StorageKind::String:
+                index.strings[column.strings[row].toCaseFolded()].append(row);
+                break;
+            case StorageKind::Variant:
+                return;
+        }
+    }
+}
+
+}
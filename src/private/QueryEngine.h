@@ -0,0 +1,131 @@
+#ifndef QFORGE_QUERYENGINE_H
+#define QFORGE_QUERYENGINE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+#include "ColumnStore.h"
+#include "ModelSchema.h"
+#include "QueryContext.hpp"
+#include "QueryResult.hpp"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Разобранный локальный запрос: проекция, отбор, порядок и ограничение.
+ */
+struct LocalQuery
+{
+    /*!
+     * \brief Условие отбора со своей чувствительностью к регистру.
+     */
+    struct Condition
+    {
+        Filter filter;
+        Qt::CaseSensitivity cs = Qt::CaseSensitive;
+    };
+
+    QStringList columns;       //!< Проекция; пусто - все колонки.
+    QVector<Condition> where;  //!< Условия объединяются через AND.
+    QVector<SortRule> orderBy; //!< Ключи сортировки по порядку важности.
+    int offset = 0;
+    int limit = -1;            //!< -1 - без ограничения.
+};
+
+/**
+ * @brief Встраиваемый движок запросов для локальных (не SQL) обработчиков.
+ *
+ * Выполняет запросы над ColumnStore, например загруженным из файла:
+ *
+ *     [SELECT col, ...] [FILTER|WHERE cond {AND|OR cond}] [ORDER BY col [ASC|DESC], ...]
+ *     [LIMIT n [OFFSET m]]
+ *
+ * Условие - col op value (=, ==, !=, <>, <, <=, >, >=), col BETWEEN a AND b,
+ * col IN (a, ...), col CONTAINS/STARTS_WITH value, col IS [NOT] NULL;
+ * AND связывает сильнее OR. Значение - строка в кавычках, число, true/false,
+ * параметр ${name} или :name (подставляется из bindings с сохранением типа)
+ * или слово без пробелов.
+ *
+ * Отбор выполняется FilterEngine (векторизованно по блокам колонок); если условие
+ * содержит равенство или IN по колонке с индексом и кандидатов мало, строки
+ * берутся из индекса и проверяются только они. Индексы строятся по состоянию
+ * хранилища и перестраиваются rebuildIndexes() после его изменения.
+ * Обработчик может целиком делегировать запрос: return engine.execute(context);
+ */
+class QueryEngine
+{
+public:
+    explicit QueryEngine(const ColumnStore& store);
+
+    /*!
+     * \brief Разбирает текст запроса.
+     * \return false с описанием в error, если текст не разобран.
+     */
+    static bool parse(const QString& text, const QVariantMap& bindings, LocalQuery& query,
+                      QString* error = nullptr);
+
+    /*!
+     * \brief Строит хеш-индекс значений колонки (Int64-, Double- и String-хранилища).
+     * \details Строки в индексе ключуются без учёта регистра, итог проверяется фильтром.
+     * \return false, если колонки нет или её хранилище не индексируется.
+     */
+    bool createIndex(const QString& column);
+    bool hasIndex(const QString& column) const;
+    void dropIndexes();
+
+    /*!
+     * \brief Перестраивает созданные индексы по текущему содержимому хранилища.
+     */
+    void rebuildIndexes();
+
+    /*!
+     * \brief Добавляет в индексы строки начиная с first (хранилище только дополнялось).
+     */
+    void updateIndexes(int first);
+
+    /*!
+     * \brief Индексы строк хранилища, отобранные и упорядоченные запросом.
+     * \return false с описанием в error, если запрос ссылается на неизвестные колонки.
+     */
+    bool select(const LocalQuery& query, QVector<int>& rows, QString* error = nullptr) const;
+
+    /*!
+     * \brief Выполняет запрос и возвращает строки с колонками проекции.
+     */
+    QueryResult run(const LocalQuery& query) const;
+
+    /*!
+     * \brief Разбирает context.sql с context.bindings и выполняет его вместе с context.filter.
+     * \details Пустой текст - все строки. filterApplied выставляется, если фильтр модели выполнен.
+     */
+    QueryResult execute(const QueryContext& context) const;
+
+    /*!
+     * \brief План отбора: "index <колонка>" или "scan".
+     */
+    QString explain(const LocalQuery& query) const;
+
+private:
+    struct Index
+    {
+        int column = -1;
+        QHash<qint64, QVector<int>> ints;
+        QHash<double, QVector<int>> doubles;
+        QHash<QString, QVector<int>> strings;
+    };
+
+    // Кандидаты из самого избирательного подходящего индекса; false - выгоднее полный просмотр
+    bool indexedRows(const LocalQuery& query, QVector<int>& rows, QString* column = nullptr) const;
+    bool probe(const Index& index, const FilterRule& rule, QVector<int>& rows) const;
+    static void buildIndex(const ColumnStore& store, Index& index, int first = 0);
+
+    const ColumnStore* store = nullptr;
+    QHash<QString, Index> indexes;
+};
+
+}
+
+#endif // QFORGE_QUERYENGINE_H
@@ -0,0 +1,96 @@
+#include "RowBitmap.h"
+
+namespace QForge::nsModel {
+
+RowBitmap::RowBitmap(int size, bool value)
+{
+    resize(size, value);
+}
+
+void RowBitmap::resize(int size, bool value) {
+    const int oldRows = rows;
+    rows = size;
+    bits.resize((size + 63) / 64);
+
+    if (value && size > oldRows) {
+        // Дописываем единицы в хвост прежнего последнего слова и в новые слова
+        const int firstWord = oldRows >> 6;
+        if (oldRows & 63) {
+            bits[firstWord] |= ~quint64(0) << (oldRows & 63);
+        }
+        for (int w = (oldRows + 63) / 64; w < bits.size(); ++w) {
+            bits[w] = ~quint64(0);
+        }
+    }
+    clearTail();
+}
+
+void RowBitmap::set(int row, bool value) {
+    const quint64 bit = quint64(1) << (row & 63);
+    if (value) {
+        bits[row >> 6] |= bit;
+    } else {
+        bits[row >> 6] &= ~bit;
+    }
+}
+
+void RowBitmap::fill(bool value) {
+    bits.fill(value ? ~quint64(0) : 0);
+    clearTail();
+}
+
+int RowBitmap::count() const {
+    int total = 0;
+    for (quint64 word : bits) {
+        total += qPopulationCount(word);
+    }
+    return total;
+}
+
+RowBitmap& RowBitmap::operator&=(const RowBitmap& other) {
+    quint64* dst = bits.data();
+    const quint64* src = other.bits.constData();
+    const int shared = qMin(bits.size(), other.bits.size());
+    for (int w = 0; w < shared; ++w) {
+        dst[w] &= src[w];
+    }
+    for (int w = shared; w < bits.size(); ++w) {
+        dst[w] = 0;
+    }
+    return *this;
+}
+
+RowBitmap& RowBitmap::operator|=(const RowBitmap& other) {
+    quint64* dst = bits.data();
+    const quint64* src = other.bits.constData();
+    const int shared = qMin(bits.size(), other.bits.size());
+    for (int w = 0; w < shared; ++w) {
+        dst[w] |= src[w];
+    }
+    clearTail();
+    return *this;
+}
+
+void RowBitmap::invert() {
+    for (quint64& word : bits) {
+        word = ~word;
+    }
+    clearTail();
+}
+
+void RowBitmap::subtract(const QVector<quint64>& mask) {
+    quint64* dst = bits.data();
+    const quint64* src = mask.constData();
+    const int shared = qMin(bits.size(), mask.size());
+    for (int w = 0; w < shared; ++w) {
+        dst[w] &= ~src[w];
+    }
+}
+
+void RowBitmap::clearTail() {
+    if (rows & 63) {
+        bits.last() &= (quint64(1) << (rows & 63)) - 1;
+    }
+}
+
+}
@@ -0,0 +1,77 @@
+#ifndef QFORGE_ROWBITMAP_H
+#define QFORGE_ROWBITMAP_H
+
+#include <QVector>
+#include <QtAlgorithms>
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Битовая маска строк хранилища: бит (row % 64) слова (row / 64).
+ *
+ * Используется как результат фильтрации; маски комбинируются пословно.
+ * Биты за пределами size() всегда сброшены.
+ */
+class RowBitmap
+{
+public:
+    RowBitmap() = default;
+    explicit RowBitmap(int size, bool value = false);
+
+    int size() const { return rows; }
+
+    /*!
+     * \brief Меняет размер маски; новые строки получают значение value.
+     */
+    void resize(int size, bool value = false);
+
+    inline bool test(int row) const { return (bits[row >> 6] >> (row & 63)) & 1u; }
+    void set(int row, bool value = true);
+    void fill(bool value);
+
+    /*!
+     * \brief Возвращает число выставленных битов.
+     */
+    int count() const;
+
+    RowBitmap& operator&=(const RowBitmap& other);
+    RowBitmap& operator|=(const RowBitmap& other);
+
+    /*!
+     * \brief Инвертирует маску в пределах size().
+     */
+    void invert();
+
+    /*!
+     * \brief Сбрасывает строки, выставленные в mask (например, NULL-маске колонки).
+     */
+    void subtract(const QVector<quint64>& mask);
+
+    int wordCount() const { return bits.size(); }
+    quint64* words() { return bits.data(); }
+    const quint64* words() const { return bits.constData(); }
+
+    /*!
+     * \brief Вызывает fn(row) для каждой выставленной строки по возрастанию.
+     */
+    template <typename Fn>
+    void forEach(const Fn& fn) const {
+        for (int w = 0; w < bits.size(); ++w) {
+            quint64 word = bits[w];
+            while (word) {
+                fn((w << 6) + qCountTrailingZeroBits(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    void clearTail();
+
+    QVector<quint64> bits;
+    int rows = 0;
+};
+
+}
+
+#endif // QFORGE_ROWBITMAP_H
@@ -0,0 +1,327 @@
+#include "SchemaCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <cstring>
+
+namespace QForge {
+
+// ========== SERIALIZATION ==========
+
+// Поля каждой структуры перечисляются один раз: Out пишет их в поток, In читает
+namespace {
+
+struct Out
+{
+    QDataStream& stream;
+
+    template <typename T>
+    Out& operator&(const T& value) {
+        stream << value;
+        return *this;
+    }
+};
+
+struct In
+{
+    QDataStream& stream;
+
+    template <typename T>
+    In& operator&(T& value) {
+        stream >> value;
+        return *this;
+    }
+};
+
+}
+
+// Операторы объявлены в QForge, чтобы их находил поиск по аргументам из шаблонов контейнеров Qt
+#define QFORGE_SCHEMA_STREAM(Type, fieldsFn)                                  \
+    static QDataStream& operator<<(QDataStream& stream, const Type& value) { \
+        Out out{stream};                                                       \
+        fieldsFn(out, value);                                                  \
+        return stream;                                                         \
+    }                                                                          \
+    static QDataStream& operator>>(QDataStream& stream, Type& value) {       \
+        In in{stream};                                                         \
+        fieldsFn(in, value);                                                   \
+        return stream;                                                         \
+    }
+
+template <typename A, typename T>
+static void rangeFields(A& a, T& v) {
+    a & v.min & v.max & v.includeMin & v.includeMax;
+}
+QFORGE_SCHEMA_STREAM(Range, rangeFields)
+
+template <typename A, typename T>
+static void lengthFields(A& a, T& v) {
+    a & v.minLength & v.maxLength;
+}
+QFORGE_SCHEMA_STREAM(LengthConstraint, lengthFields)
+
+template <typename A, typename T>
+static void validatorFields(A& a, T& v) {
+    a & v.type & v.pattern & v.range & v.length & v.customValidatorName & v.errorMessage & v.isRequired;
+}
+QFORGE_SCHEMA_STREAM(Validator, validatorFields)
+
+template <typename A, typename T>
+static void argumentFields(A& a, T& v) {
+    a & v.name & v.type & v.defaultValue & v.isOptional & v.description & v.validator;
+}
+QFORGE_SCHEMA_STREAM(QueryArgument, argumentFields)
+
+template <typename A, typename T>
+static void queryFields(A& a, T& v) {
+    a & v.sql & v.arguments & v.onError & v.errorMessage & v.description & v.timeoutMs
+      & v.isTransactional & v.isReadOnly & v.effect;
+}
+QFORGE_SCHEMA_STREAM(Query, queryFields)
+
+template <typename A, typename T>
+static void sortRuleFields(A& a, T& v) {
+    a & v.columnName & v.order & v.priority;
+}
+QFORGE_SCHEMA_STREAM(SortRule, sortRuleFields)
+
+template <typename A, typename T>
+static void styleFields(A& a, T& v) {
+    a & v.backgroundColor & v.foregroundColor & v.alternateBackgroundColor & v.selectionBackgroundColor
+      & v.selectionForegroundColor & v.font & v.rowHeight & v.columnWidth & v.showGrid & v.gridColor;
+}
+QFORGE_SCHEMA_STREAM(StyleSettings, styleFields)
+
+template <typename A, typename T>
+static void headerFields(A& a, T& v) {
+    a & v.type & v.customLabels & v.startIndex & v.startLetter & v.style & v.tooltip & v.isEnumerated;
+}
+QFORGE_SCHEMA_STREAM(HeaderSettings, headerFields)
+
+template <typename A, typename T>
+static void errorHandlingFields(A& a, T& v) {
+    a & v.onError & v.message & v.logFormat & v.showStackTrace;
+}
+QFORGE_SCHEMA_STREAM(ErrorHandlingSettings, errorHandlingFields)
+
+template <typename A, typename T>
+static void performanceFields(A& a, T& v) {
+    a & v.lazyLoading & v.batchSize & v.enableCaching & v.cacheSize & v.asyncOperations & v.maxConcurrentQueries;
+}
+QFORGE_SCHEMA_STREAM(PerformanceSettings, performanceFields)
+
+template <typename A, typename T>
+static void treeFields(A& a, T& v) {
+    a & v.parentColumn & v.childrenQuery & v.parentsArgument;
+}
+QFORGE_SCHEMA_STREAM(TreeSettings, treeFields)
+
+template <typename A, typename T>
+static void securityFields(A& a, T& v) {
+    a & v.enableSqlInjectionProtection & v.allowedOperations & v.forbiddenKeywords & v.enableInputSanitization
+      & v.requireAuthentication & v.requiredRoles;
+}
+QFORGE_SCHEMA_STREAM(SecuritySettings, securityFields)
+
+template <typename A, typename T>
+static void columnFields(A& a, T& v) {
+    a & v.name & v.type & v.displayName & v.tooltip
+      & v.isEditable & v.isPrimaryKey & v.isAutoIncrement & v.isUnique & v.isIndexed
+      & v.alignment & v.width & v.minWidth & v.maxWidth & v.isResizable & v.isSortable
+      & v.format & v.nullDisplayText & v.defaultValue
+      & v.validator & v.customProperties & v.style
+      & v.referenceTable & v.referenceColumn & v.displayColumn & v.referenceLoading
+      & v.isCalculated & v.calculationExpression & v.dependentColumns;
+}
+QFORGE_SCHEMA_STREAM(Column, columnFields)
+
+template <typename A, typename T>
+static void hookFields(A& a, T& v) {
+    a & v.preExecuteCallback & v.postExecuteCallback & v.rowMappedCallback & v.errorCaughtCallback
+      & v.dataChangedCallback & v.selectionChangedCallback & v.beforeEditCallback & v.afterEditCallback;
+}
+QFORGE_SCHEMA_STREAM(HookSettings, hookFields)
+
+template <typename A, typename T>
+static void localizationFields(A& a, T& v) {
+    a & v.locale & v.translations & v.dateFormat & v.timeFormat & v.datetimeFormat & v.numberFormat
+      & v.currencySymbol;
+}
+QFORGE_SCHEMA_STREAM(LocalizationSettings, localizationFields)
+
+template <typename A, typename T>
+static void exportFields(A& a, T& v) {
+    a & v.supportedFormats & v.defaultFormat & v.csvDelimiter & v.csvQuoteChar & v.csvIncludeHeaders
+      & v.jsonPrettyPrint & v.xmlRootElement & v.xmlRowElement;
+}
+QFORGE_SCHEMA_STREAM(ExportSettings, exportFields)
+
+template <typename A, typename T>
+static void importFields(A& a, T& v) {
+    a & v.supportedFormats & v.defaultFormat & v.csvDelimiter & v.csvQuoteChar & v.csvHasHeaders
+      & v.validateOnImport & v.replaceExistingData & v.batchSize;
+}
+QFORGE_SCHEMA_STREAM(ImportSettings, importFields)
+
+template <typename A, typename T>
+static void schemaFields(A& a, T& v) {
+    a & v.name & v.type & v.description & v.version & v.createdAt & v.modifiedAt & v.author
+      & v.source & v.loadQuery & v.isEditable & v.isReadOnly
+      & v.columns & v.primaryKeyColumns & v.tree
+      & v.horizontalHeaders & v.verticalHeaders
+      & v.sorting & v.isSortingEnabled & v.isMultiColumnSortingEnabled
+      & v.queries & v.defaultQuery
+      & v.defaultErrorHandling
+      & v.defaultRowTooltip & v.showNumeration & v.selectionBehavior & v.selectionMode & v.editTriggers
+      & v.style & v.alternatingRowColors & v.showVerticalHeader & v.showHorizontalHeader
+      & v.hooks & v.performance & v.security & v.localization & v.exportSettings & v.importSettings
+      & v.enablePagination & v.pageSize & v.currentPage & v.showPageControls
+      & v.enableFiltering & v.defaultFilters & v.caseSensitiveFiltering
+      & v.customProperties & v.metadata;
+}
+
+#undef QFORGE_SCHEMA_STREAM
+
+namespace nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static constexpr char kMagic[4] = {'Q', 'F', 'S', 'C'};
+static constexpr quint32 kFormatVersion = 8; // 2: вычисляемые колонки (expression), 3: загрузка справочников, 4: tree, 5: is_transactional, 6: effect, 7: export_settings, 8: is_read_only
+static constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+static constexpr int kHashSize = 20; // SHA-1
+
+// Заголовок файла кэша; файл читается только на той же машине, порядок байт - родной
+struct CacheHeader
+{
+    char magic[4];
+    quint32 formatVersion;
+    quint32 streamVersion;
+    quint32 payloadSize;
+    char hash[kHashSize];
+};
+
+static QMutex& directoryMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+static QString& directoryPath() {
+    static QString path;
+    return path;
+}
+
+// ========== PUBLIC METHODS ==========
+
+QString SchemaCache::directory() {
+    QMutexLocker locker(&directoryMutex());
+    return directoryPath();
+}
+
+void SchemaCache::setDirectory(const QString& path) {
+    QMutexLocker locker(&directoryMutex());
+    directoryPath() = path;
+}
+
+QByteArray SchemaCache::sourceHash(const QByteArray& source) {
+    return QCryptographicHash::hash(source, QCryptographicHash::Sha1);
+}
+
+QString SchemaCache::cacheFile(const QString& sourcePath) {
+    const QString dir = directory();
+    if (dir.isEmpty() || sourcePath.isEmpty()) {
+        return QString();
+    }
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(sourcePath).absoluteFilePath().toUtf8(),
+                                                    QCryptographicHash::Sha1);
+    return dir + "/" + QString::fromLatin1(key.toHex()) + ".qfs";
+}
+
+bool SchemaCache::load(const QString& sourcePath, const QByteArray& hash, ModelSchema& schema) {
+    const QString path = cacheFile(sourcePath);
+    if (path.isEmpty() || hash.size() != kHashSize) {
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(CacheHeader))) {
+        return false;
+    }
+    const uchar* data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const bool fresh = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+        && header.formatVersion == kFormatVersion
+        && header.streamVersion == quint32(kStreamVersion)
+        && std::memcmp(header.hash, hash.constData(), kHashSize) == 0
+        && qint64(sizeof(header)) + header.payloadSize == file.size();
+
+    const bool ok = fresh && deserialize(reinterpret_cast<const char*>(data) + sizeof(header),
+                                         header.payloadSize, schema);
+    file.unmap(const_cast<uchar*>(data));
+    return ok;
+}
+
+bool SchemaCache::save(const QString& sourcePath, const QByteArray& hash, const ModelSchema& schema) {
+    const QString path = cacheFile(sourcePath);
+    if (path.isEmpty() || hash.size() != kHashSize || !QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+
+    const QByteArray payload = serialize(schema);
+    CacheHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.streamVersion = quint32(kStreamVersion);
+    header.payloadSize = quint32(payload.size());
+    std::memcpy(header.hash, hash.constData(), kHashSize);
+
+    // Запись во временный файл и переименование: читатели не увидят недописанный кэш
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(payload);
+    return file.commit();
+}
+
+QByteArray SchemaCache::serialize(const ModelSchema& schema) {
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(kStreamVersion);
+    Out out{stream};
+    schemaFields(out, schema);
+    return bytes;
+}
+
+bool SchemaCache::deserialize(const char* data, qint64 size, ModelSchema& schema) {
+    // Данные не копируются: поток читает прямо из отображённого файла
+    const QByteArray bytes = QByteArray::fromRawData(data, size);
+    QDataStream stream(bytes);
+    stream.setVersion(kStreamVersion);
+
+    ModelSchema loaded;
+    In in{stream};
+    schemaFields(in, loaded);
+    if (stream.status() != QDataStream::Ok || !stream.atEnd()) {
+        return false;
+    }
+    loaded.rebuildColumnIndex();
+    schema = std::move(loaded);
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef QFORGE_SCHEMACACHE_H
+#define QFORGE_SCHEMACACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Кэш разобранных схем моделей в двоичном виде.
+ *
+ * Схема, разобранная из YAML/JSON и прошедшая проверку, сохраняется в файл
+ * каталога кэша (имя - хеш пути к исходному файлу) вместе с хешем исходного текста.
+ * Следующая загрузка того же текста отображает кэш в память и читает схему
+ * QDataStream - без разбора текста; проверка схемы выполняется и для неё. Кэш с другим
+ * хешем, версией формата или повреждённый пропускается и перезаписывается.
+ * Кэш выключен, пока приложение не задаст каталог (ModelFactory::setSchemaCacheDirectory).
+ * При добавлении полей в ModelSchema увеличивается kFormatVersion в SchemaCache.cpp.
+ */
+class SchemaCache
+{
+public:
+    /*!
+     * \brief Каталог кэша; по умолчанию пуст (кэш выключен).
+     */
+    static QString directory();
+
+    /*!
+     * \brief Задаёт каталог кэша; пустая строка выключает кэш.
+     */
+    static void setDirectory(const QString& path);
+
+    /*!
+     * \brief Хеш исходного текста схемы (ключ актуальности кэша).
+     */
+    static QByteArray sourceHash(const QByteArray& source);
+
+    /*!
+     * \brief Файл кэша для исходного файла схемы (пусто, если кэш выключен).
+     */
+    static QString cacheFile(const QString& sourcePath);
+
+    /*!
+     * \brief Загружает схему из кэша, если он построен по тексту с хешем hash.
+     */
+    static bool load(const QString& sourcePath, const QByteArray& hash, ModelSchema& schema);
+
+    /*!
+     * \brief Сохраняет схему в кэш (атомарно, через временный файл).
+     */
+    static bool save(const QString& sourcePath, const QByteArray& hash, const ModelSchema& schema);
+
+    static QByteArray serialize(const ModelSchema& schema);
+    static bool deserialize(const char* data, qint64 size, ModelSchema& schema);
+};
+
+}
+
+#endif // QFORGE_SCHEMACACHE_H
@@ -0,0 +1,142 @@
+#include "SchemaRegistry.h"
+#include "ModelCore.h"
+#include "SchemaCache.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static QString registryKey(const QString& path) {
+    return QFileInfo(path).absoluteFilePath();
+}
+
+// ========== PUBLIC METHODS ==========
+
+SchemaRegistry& SchemaRegistry::instance() {
+    static SchemaRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<const ModelSchema> SchemaRegistry::acquire(const QString& path, QStringList* errors) {
+    return load(registryKey(path), false, errors);
+}
+
+std::shared_ptr<const ModelSchema> SchemaRegistry::reload(const QString& path, QStringList* errors) {
+    return load(registryKey(path), true, errors);
+}
+
+std::shared_ptr<const ModelSchema> SchemaRegistry::schema(const QString& path) const {
+    std::shared_ptr<Entry> found;
+    {
+        QMutexLocker locker(&mutex);
+        found = entries.value(registryKey(path));
+    }
+    if (!found) {
+        return nullptr;
+    }
+    QMutexLocker locker(&found->mutex);
+    return found->schema.lock();
+}
+
+void SchemaRegistry::remove(const QString& path) {
+    QMutexLocker locker(&mutex);
+    entries.remove(registryKey(path));
+}
+
+void SchemaRegistry::clear() {
+    QMutexLocker locker(&mutex);
+    entries.clear();
+}
+
+int SchemaRegistry::count() const {
+    QMutexLocker locker(&mutex);
+    int live = 0;
+    for (const std::shared_ptr<Entry>& item : entries) {
+        live += item->schema.expired() ? 0 : 1;
+    }
+    return live;
+}
+
+// ========== PRIVATE METHODS ==========
+
+std::shared_ptr<SchemaRegistry::Entry> SchemaRegistry::entry(const QString& key) {
+    QMutexLocker locker(&mutex);
+    prune();
+    std::shared_ptr<Entry>& slot = entries[key];
+    if (!slot) {
+        slot = std::make_shared<Entry>();
+    }
+    return slot;
+}
+
+void SchemaRegistry::prune() {
+    // Запись, которую сейчас держит другой поток (идёт разбор), не трогаем
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it.value().use_count() == 1 && it.value()->schema.expired()) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::shared_ptr<const ModelSchema> SchemaRegistry::load(const QString& key, bool force, QStringList* errors) {
+    // Общий замок держится только на время поиска записи; разбор идёт под замком записи
+    const std::shared_ptr<Entry> current = entry(key);
+    QMutexLocker locker(&current->mutex);
+
+    const QFileInfo info(key);
+    std::shared_ptr<const ModelSchema> existing = current->schema.lock();
+    if (!force && existing) {
+        const bool sameStat = current->size == info.size() && current->modified == info.lastModified();
+        // Время изменения не старше разбора: правка того же размера в пределах точности
+        // времени файла не видна по нему, сверяем текст
+        const bool racy = info.lastModified() >= current->checked.addSecs(-2);
+        if (sameStat && !racy) {
+            return existing;
+        }
+        QFile file(key);
+        if (file.open(QIODevice::ReadOnly) && SchemaCache::sourceHash(file.readAll()) == current->hash) {
+            current->size = info.size();
+            current->modified = info.lastModified();
+            current->checked = QDateTime::currentDateTimeUtc();
+            return existing;
+        }
+    }
+
+    QByteArray hash;
+    {
+        QFile file(key);
+        if (file.open(QIODevice::ReadOnly)) {
+            hash = SchemaCache::sourceHash(file.readAll());
+        }
+    }
+    const QDateTime checked = QDateTime::currentDateTimeUtc();
+    auto parsed = std::make_shared<ModelSchema>();
+    QStringList parseErrors;
+    if (!ModelCore::parseFile(key, *parsed, parseErrors)) {
+        if (errors) {
+            errors->append(parseErrors);
+        }
+        return nullptr;
+    }
+
+    const bool replaced = existing != nullptr;
+    std::shared_ptr<const ModelSchema> result = std::move(parsed);
+    current->schema = result;
+    current->size = info.size();
+    current->modified = info.lastModified();
+    current->checked = checked;
+    current->hash = hash;
+    locker.unlock();
+
+    if (replaced) {
+        emit reloaded(key);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,93 @@
+#ifndef QFORGE_SCHEMAREGISTRY_H
+#define QFORGE_SCHEMAREGISTRY_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+#include <memory>
+
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Общий на процесс реестр схем, разобранных из файлов конфигурации.
+ *
+ * Каждый файл разбирается один раз (ModelCore::parseFile); все модели этого файла
+ * получают один неизменяемый экземпляр ModelSchema по shared_ptr. Файл, изменённый
+ * на диске, разбирается заново при следующем acquire(): изменение определяется по размеру
+ * и времени изменения, а если время изменения не старше проверки (правка в пределах его
+ * точности) - по хешу текста. Новая схема публикуется одной заменой указателя и сигналом
+ * reloaded(): TableModel по нему переходит на новую схему, ModelCore держит свой экземпляр
+ * до refresh(). Реестр не продлевает жизнь схем: запись без владельцев удаляется.
+ * Разные файлы можно разбирать параллельно из разных потоков, один файл разбирается
+ * только одним потоком.
+ */
+class SchemaRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SchemaRegistry& instance();
+
+    /*!
+     * \brief Схема файла: из реестра или разобранная сейчас.
+     * \param errors Ошибки разбора или проверки (если схема не получена).
+     * \return Схема или nullptr.
+     */
+    std::shared_ptr<const ModelSchema> acquire(const QString& path, QStringList* errors = nullptr);
+
+    /*!
+     * \brief Разбирает файл заново и заменяет схему в реестре.
+     * \details При ошибке в реестре остаётся прежняя схема.
+     * \return Новая схема или nullptr.
+     */
+    std::shared_ptr<const ModelSchema> reload(const QString& path, QStringList* errors = nullptr);
+
+    /*!
+     * \brief Текущая схема файла без обращения к диску (nullptr, если файл не загружался).
+     */
+    std::shared_ptr<const ModelSchema> schema(const QString& path) const;
+
+    /*!
+     * \brief Убирает файл из реестра; выданные схемы остаются у владельцев.
+     */
+    void remove(const QString& path);
+    void clear();
+    int count() const;
+
+signals:
+    /*!
+     * \brief Схема файла заменена (reload() или изменение файла на диске).
+     * \details Может испускаться из рабочего потока.
+     */
+    void reloaded(const QString& path);
+
+private:
+    struct Entry
+    {
+        QMutex mutex; //!< Держится на время разбора: один файл разбирается один раз.
+        std::weak_ptr<const ModelSchema> schema;
+        qint64 size = -1;
+        QDateTime modified;
+        QDateTime checked; //!< Время разбора; файл, изменённый не раньше, сверяется по хешу.
+        QByteArray hash;   //!< SchemaCache::sourceHash текста.
+    };
+
+    SchemaRegistry() = default;
+
+    std::shared_ptr<Entry> entry(const QString& key);
+    void prune(); //!< Удаляет записи без владельцев схемы; под mutex.
+    std::shared_ptr<const ModelSchema> load(const QString& key, bool force, QStringList* errors);
+
+    mutable QMutex mutex;
+    QHash<QString, std::shared_ptr<Entry>> entries;
+};
+
+}
+
+#endif // QFORGE_SCHEMAREGISTRY_H
@@ -0,0 +1,351 @@
+#include "SortEngine.h"
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+
+namespace QForge::nsModel {
+
+// ========== HELPER FUNCTIONS ==========
+
+static constexpr quint64 kSignBit = quint64(1) << 63;
+
+using Histogram = std::array<int, 256>;
+
+// Беззнаковые ключи, порядок которых совпадает с порядком исходных значений
+static inline quint64 radixKey(qint64 value) {
+    return quint64(value) ^ kSignBit;
+}
+
+static inline quint64 radixKey(double value) {
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & kSignBit) ? ~bits : (bits | kSignBit);
+}
+
+// LSD radix sort пар (ключ, строка) по байтам; устойчив. Ключи после вызова не определены.
+static void radixSort(QVector<quint64>& keys, QVector<int>& rows) {
+    const int n = keys.size();
+    if (n < 2) {
+        return;
+    }
+
+    const int tasks = Parallel::taskCount(n);
+    const int chunk = (n + tasks - 1) / tasks;
+
+    // Гистограммы по всем восьми байтам за один проход
+    std::array<Histogram, 8> total{};
+    {
+        QVector<std::array<Histogram, 8>> partial(tasks);
+        std::array<Histogram, 8>* histograms = partial.data();
+        const quint64* source = keys.constData();
+        Parallel::run(tasks, [&](int t) {
+            std::array<Histogram, 8>& h = histograms[t];
+            const int end = qMin(n, t * chunk + chunk);
+            for (int i = t * chunk; i < end; ++i) {
+                const quint64 key = source[i];
+                for (int d = 0; d < 8; ++d) {
+                    ++h[d][(key >> (d * 8)) & 0xFF];
+                }
+            }
+        });
+        for (const auto& h : partial) {
+            for (int d = 0; d < 8; ++d) {
+                for (int b = 0; b < 256; ++b) {
+                    total[d][b] += h[d][b];
+                }
+            }
+        }
+    }
+
+    QVector<quint64> keysBuffer(n);
+    QVector<int> rowsBuffer(n);
+    int* const rowsBase = rows.data();
+    quint64* srcKeys = keys.data();
+    int* srcRows = rowsBase;
+    quint64* dstKeys = keysBuffer.data();
+    int* dstRows = rowsBuffer.data();
+
+    for (int d = 0; d < 8; ++d) {
+        // Все ключи совпадают в этом байте - проход ничего не изменит
+        if (std::any_of(total[d].begin(), total[d].end(), [n](int count) { return count == n; })) {
+            continue;
+        }
+
+        const int shift = d * 8;
+        QVector<Histogram> offsets(tasks);
+        Histogram* offset = offsets.data();
+        if (tasks == 1) {
+            offset[0] = total[d];
+        } else {
+            Parallel::run(tasks, [&](int t) {
+                Histogram& h = offset[t];
+                const int end = qMin(n, t * chunk + chunk);
+                for (int i = t * chunk; i < end; ++i) {
+                    ++h[(srcKeys[i] >> shift) & 0xFF];
+                }
+            });
+        }
+
+        // Позиции: сначала по значению байта, внутри байта - в порядке задач
+        int position = 0;
+        for (int b = 0; b < 256; ++b) {
+            for (int t = 0; t < tasks; ++t) {
+                const int count = offset[t][b];
+                offset[t][b] = position;
+                position += count;
+            }
+        }
+
+        Parallel::run(tasks, [&](int t) {
+            Histogram& o = offset[t];
+            const int end = qMin(n, t * chunk + chunk);
+            for (int i = t * chunk; i < end; ++i) {
+                const int pos = o[(srcKeys[i] >> shift) & 0xFF]++;
+                dstKeys[pos] = srcKeys[i];
+                dstRows[pos] = srcRows[i];
+            }
+        });
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcRows, dstRows);
+    }
+
+    if (srcRows != rowsBase) {
+        std::copy(srcRows, srcRows + n, rowsBase);
+    }
+}
+
+// Устойчивая поразрядная сортировка строк по одной числовой колонке
+static void radixPass(const TypedColumn& column, bool descending, QVector<int>& rows) {
+    const int n = rows.size();
+    QVector<int> nullRows;
+    QVector<int> valueRows;
+    QVector<quint64> keys;
+    valueRows.reserve(n);
+    keys.reserve(n);
+
+    for (int row : std::as_const(rows)) {
+        if (column.isNull(row)) {
+            nullRows.append(row);
+            continue;
+        }
+        const quint64 key = column.kind == StorageKind::Int64
+            ? radixKey(column.ints[row])
+            : radixKey(column.doubles[row]);
+        keys.append(descending ? ~key : key);
+        valueRows.append(row);
+    }
+
+    radixSort(keys, valueRows);
+    rows = descending ? valueRows + nullRows : nullRows + valueRows;
+}
+
+static int compareVariants(const QVariant& lhs, const QVariant& rhs) {
+    const QPartialOrdering order = QVariant::compare(lhs, rhs);
+    if (order == QPartialOrdering::Less) {
+        return -1;
+    }
+    if (order == QPartialOrdering::Greater) {
+        return 1;
+    }
+    if (order == QPartialOrdering::Equivalent) {
+        return 0;
+    }
+    return lhs.toString().compare(rhs.toString());
+}
+
+namespace {
+
+// Компаратор одного ключа, привязанный к типу хранения колонки
+struct KeyComparator
+{
+    const TypedColumn* column;
+    bool descending;
+
+    int compare(int lhs, int rhs) const {
+        const bool lhsNull = column->isNull(lhs);
+        const bool rhsNull = column->isNull(rhs);
+
+        int result = 0;
+        if (lhsNull || rhsNull) {
+            result = (lhsNull ? 0 : 1) - (rhsNull ? 0 : 1);
+        } else {
+            switch (column->kind) {
+                case StorageKind::Int64: {
+                    const qint64 a = column->ints[lhs];
+                    const qint64 b = column->ints[rhs];
+                    result = (a > b) - (a < b);
+                    break;
+                }
+                case StorageKind::Double: {
+                    const double a = column->doubles[lhs];
+                    const double b = column->doubles[rhs];
+                    result = (a > b) - (a < b);
+                    break;
+                }
+                case StorageKind::String:
+                    result = column->strings[lhs].compare(column->strings[rhs]);
+                    break;
+                case StorageKind::Variant:
+                    result = compareVariants(column->variants[lhs], column->variants[rhs]);
+                    break;
+            }
+        }
+
+        return descending ? -result : result;
+    }
+};
+
+}
+
+template <typename Less>
+static void parallelStableSort(QVector<int>& rows, const Less& less) {
+    const int n = rows.size();
+    const int tasks = Parallel::taskCount(n);
+    int* const data = rows.data();
+
+    if (tasks == 1) {
+        std::stable_sort(data, data + n, less);
+        return;
+    }
+
+    // Сортируем куски параллельно, затем сливаем попарно
+    const int chunk = (n + tasks - 1) / tasks;
+    Parallel::run(tasks, [&](int t) {
+        const int begin = t * chunk;
+        const int end = qMin(n, begin + chunk);
+        if (begin < end) {
+            std::stable_sort(data + begin, data + end, less);
+        }
+    });
+
+    QVector<int> buffer(n);
+    int* src = data;
+    int* dst = buffer.data();
+    for (int width = chunk; width < n; width *= 2) {
+        const int pairs = (n + 2 * width - 1) / (2 * width);
+        Parallel::run(pairs, [&](int p) {
+            const int lo = p * 2 * width;
+            const int mid = qMin(n, lo + width);
+            const int hi = qMin(n, lo + 2 * width);
+            std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, less);
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != data) {
+        std::copy(src, src + n, data);
+    }
+}
+
+// ========== PUBLIC METHODS ==========
+
+QVector<SortKey> SortEngine::keysFromRules(const ModelSchema& schema, const QVector<SortRule>& rules) {
+    QVector<SortRule> ordered = rules;
+    std::stable_sort(ordered.begin(), ordered.end(), [](const SortRule& lhs, const SortRule& rhs) {
+        return lhs.priority < rhs.priority;
+    });
+
+    QVector<SortKey> keys;
+    for (const SortRule& rule : std::as_const(ordered)) {
+        const int i = schema.columnIndex(rule.columnName);
+        if (i < 0) {
+            continue;
+        }
+        const bool duplicate = std::any_of(keys.begin(), keys.end(), [i](const SortKey& key) {
+            return key.column == i;
+        });
+        if (!duplicate) {
+            SortKey key;
+            key.column = i;
+            key.order = rule.order;
+            keys.append(key);
+        }
+    }
+    return keys;
+}
+
+QVector<int> SortEngine::sort(const ColumnStore& store, const QVector<SortKey>& keys) {
+    QVector<int> rows(store.rowCount());
+    std::iota(rows.begin(), rows.end(), 0);
+    sortRows(store, keys, rows);
+    return rows;
+}
+
+void SortEngine::sortRows(const ColumnStore& store, const QVector<SortKey>& keys, QVector<int>& rows) {
+    if (keys.isEmpty() || rows.size() < 2) {
+        return;
+    }
+
+    const bool numericOnly = std::all_of(keys.begin(), keys.end(), [&store](const SortKey& key) {
+        const StorageKind kind = store.column(key.column).kind;
+        return kind == StorageKind::Int64 || kind == StorageKind::Double;
+    });
+
+    if (numericOnly) {
+        // LSD по ключам: от младшего к главному, каждый проход устойчив
+        for (int i = keys.size() - 1; i >= 0; --i) {
+            radixPass(store.column(keys[i].column), keys[i].order == SortOrder::Descending, rows);
+        }
+        return;
+    }
+
+    QVector<KeyComparator> comparators;
+    comparators.reserve(keys.size());
+    for (const SortKey& key : keys) {
+        comparators.append({&store.column(key.column), key.order == SortOrder::Descending});
+    }
+
+    parallelStableSort(rows, [&comparators](int lhs, int rhs) {
+        for (const KeyComparator& comparator : comparators) {
+            const int result = comparator.compare(lhs, rhs);
+            if (result != 0) {
+                return result < 0;
+            }
+        }
+        return false;
+    });
+}
+
+int SortEngine::compare(const ColumnStore& store, const QVector<SortKey>& keys, int lhs, int rhs) {
+    for (const SortKey& key : keys) {
+        const KeyComparator comparator{&store.column(key.column), key.order == SortOrder::Descending};
+        const int result = comparator.compare(lhs, rhs);
+        if (result != 0) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+void SortEngine::reverseOrder(const ColumnStore& store, const QVector<SortKey>& keys, QVector<int>& rows) {
+    std::reverse(rows.begin(), rows.end());
+    // Разворот переставил и равные строки: возвращаем их порядок внутри каждой группы
+    const int n = rows.size();
+    for (int first = 0; first < n;) {
+        int last = first + 1;
+        while (last < n && compare(store, keys, rows[first], rows[last]) == 0) {
+            ++last;
+        }
+        std::reverse(rows.begin() + first, rows.begin() + last);
+        first = last;
+    }
+}
+
+bool SortEngine::isReversal(const QVector<SortKey>& current, const QVector<SortKey>& requested) {
+    if (current.isEmpty() || current.size() != requested.size()) {
+        return false;
+    }
+    for (int i = 0; i < current.size(); ++i) {
+        if (current[i].column != requested[i].column || current[i].order == requested[i].order) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
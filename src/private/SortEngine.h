@@ -0,0 +1,74 @@
+#ifndef QFORGE_SORTENGINE_H
+#define QFORGE_SORTENGINE_H
+
+#include <QVector>
+
+#include "ColumnStore.h"
+#include "ModelSchema.h"
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Ключ сортировки: индекс колонки хранилища и направление.
+ */
+struct SortKey
+{
+    int column = -1;
+    SortOrder order = SortOrder::Ascending;
+
+    bool operator==(const SortKey& other) const {
+        return column == other.column && order == other.order;
+    }
+};
+
+/**
+ * @brief Локальная сортировка строк модели.
+ *
+ * Сортируется не содержимое хранилища, а перестановка индексов строк.
+ * Колонки с Int64/Double-хранилищем сортируются поразрядно (LSD radix),
+ * остальные - устойчивой сортировкой слиянием с компаратором под тип хранения.
+ * На больших объёмах работа распределяется по QThreadPool.
+ * NULL-значения идут первыми при возрастании и последними при убывании.
+ */
+class SortEngine
+{
+public:
+    /*!
+     * \brief Переводит правила сортировки из схемы в ключи по индексам колонок.
+     * \details Правила упорядочиваются по priority (меньше - важнее) устойчиво,
+     * правила для неизвестных колонок отбрасываются.
+     */
+    static QVector<SortKey> keysFromRules(const ModelSchema& schema, const QVector<SortRule>& rules);
+
+    /*!
+     * \brief Возвращает перестановку всех строк хранилища, упорядоченную по ключам.
+     */
+    static QVector<int> sort(const ColumnStore& store, const QVector<SortKey>& keys);
+
+    /*!
+     * \brief Устойчиво упорядочивает переданные индексы строк по ключам.
+     */
+    static void sortRows(const ColumnStore& store, const QVector<SortKey>& keys, QVector<int>& rows);
+
+    /*!
+     * \brief Сравнивает две строки хранилища по ключам.
+     * \return Отрицательное число, ноль или положительное число.
+     */
+    static int compare(const ColumnStore& store, const QVector<SortKey>& keys, int lhs, int rhs);
+
+    /*!
+     * \brief Проверяет, что ключи отличаются от текущих только инвертированным направлением.
+     * \details В этом случае готовую перестановку достаточно развернуть за O(n) (reverseOrder).
+     */
+    static bool isReversal(const QVector<SortKey>& current, const QVector<SortKey>& requested);
+
+    /*!
+     * \brief Переводит перестановку, упорядоченную по обратным ключам, в порядок keys за O(n).
+     * \details Равные строки сохраняют прежний взаимный порядок: сортировка остаётся устойчивой.
+     */
+    static void reverseOrder(const ColumnStore& store, const QVector<SortKey>& keys, QVector<int>& rows);
+};
+
+}
+
+#endif // QFORGE_SORTENGINE_H
@@ -3,6 +3,75 @@
 #include "QueryContext.hpp"
 #include "QueryResult.hpp"
 
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSqlDriver>
+
+namespace {
+
+// Колонки результата запросов, в которые уже оборачивался фильтр: подключение и текст запроса -> имена.
+// Обработчики выполняются и в пуле потоков, поэтому кэш под мьютексом
+constexpr int kMaxCachedQueries = 256;
+QMutex resultColumnsMutex;
+QHash<QString, QStringList> resultColumns;
+
+// Экранирование спецсимволов LIKE; '!' вместо '\\', чтобы не зависеть от диалекта строковых литералов
+QString escapeLike(const QString& value)
+{
+    QString escaped = value;
+    escaped.replace("!", "!!").replace("%", "!%").replace("_", "!_");
+    return escaped;
+}
+
+// Условие одного предиката; значения добавляются в bindings под уникальными именами
+bool predicateToSql(const QSqlDriver* driver, const QForge::nsModel::QueryPredicate& predicate,
+                    QVariantMap& bindings, QString& clause)
+{
+    const QString column = driver->escapeIdentifier(predicate.column, QSqlDriver::FieldName);
+    const QString op = predicate.op.toLower();
+
+    auto bind = [&bindings](const QVariant& value) {
+        const QString name = QString(":qforge_filter_%1").arg(bindings.size());
+        bindings.insert(name, value);
+        return name;
+    };
+    auto fold = [&predicate](const QString& expression) {
+        return predicate.caseInsensitive ? QString("LOWER(%1)").arg(expression) : expression;
+    };
+
+    static const QHash<QString, QString> comparisons = {
+        {"=", "="}, {"!=", "<>"}, {"<", "<"}, {"<=", "<="}, {">", ">"}, {">=", ">="}
+    };
+
+    if (comparisons.contains(op)) {
+        clause = QString("%1 %2 %3").arg(fold(column), comparisons.value(op), fold(bind(predicate.value)));
+    } else if (op == "between") {
+        clause = QString("%1 BETWEEN %2 AND %3")
+                     .arg(fold(column), fold(bind(predicate.value)), fold(bind(predicate.upperValue)));
+    } else if (op == "in") {
+        QStringList placeholders;
+        for (const QVariant& item : predicate.value.toList()) {
+            placeholders.append(fold(bind(item)));
+        }
+        clause = placeholders.isEmpty() ? QString("1 = 0")
+                                        : QString("%1 IN (%2)").arg(fold(column), placeholders.join(", "));
+    } else if (op == "contains" || op == "starts_with") {
+        const QString pattern = (op == "contains" ? "%" : "") + escapeLike(predicate.value.toString()) + "%";
+        clause = QString("%1 LIKE %2 ESCAPE '!'").arg(fold(column), fold(bind(pattern)));
+    } else if (op == "is_null") {
+        clause = QString("%1 IS NULL").arg(column);
+    } else if (op == "is_not_null") {
+        clause = QString("%1 IS NOT NULL").arg(column);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}
+
 QForge::nsModel::QueryHandler QForge::nsModel::SqlQueryHandlerFactory::getHandler(QSqlDatabase *db)
 {
     return [db](const QueryContext& ctx) -> QueryResult {
@@ -14,14 +83,26 @@ QForge::nsModel::QueryHandler QForge::nsModel::SqlQueryHandlerFactory::getHandle
             return result;
         }
 
+        if (!ctx.batch.isEmpty()) {
+            return executeBatch(db, ctx);
+        }
+
+        // Фильтр модели выполняется в БД, если все его условия переводятся в SQL
+        QString sql = ctx.sql;
+        QVariantMap bindings = ctx.bindings;
+        const bool filterApplied = !ctx.filter.isEmpty() && applyFilter(db, ctx.filter, sql, bindings);
+
         QSqlQuery query(*db);
-        if (!query.prepare(ctx.sql)) {
+        if (!query.prepare(sql)) {
+            if (filterApplied) {
+                clearResultColumns(); // структура таблиц могла измениться
+            }
             result.ok = false;
             result.log("Ошибка при подготовке SQL-запроса: " + query.lastError().text());
             return result;
         }
 
-        for (auto it = ctx.bindings.constBegin(); it != ctx.bindings.constEnd(); ++it) {
+        for (auto it = bindings.constBegin(); it != bindings.constEnd(); ++it) {
             query.bindValue(it.key(), it.value());
         }
 
@@ -41,6 +122,220 @@ QForge::nsModel::QueryHandler QForge::nsModel::SqlQueryHandlerFactory::getHandle
         }
 
         result.ok = true;
+        result.filterApplied = filterApplied;
         return result;
     };
 }
+
+bool QForge::nsModel::SqlQueryHandlerFactory::applyFilter(QSqlDatabase* db, const QueryFilter& filter,
+                                                          QString& sql, QVariantMap& bindings)
+{
+    if (!db || !db->driver() || filter.isEmpty()) {
+        return false;
+    }
+
+    QVariantMap filterBindings = bindings;
+    QStringList groups;
+    for (const QueryPredicateGroup& group : filter.groups) {
+        QStringList clauses;
+        for (const QueryPredicate& predicate : group.predicates) {
+            QString clause;
+            if (!predicateToSql(db->driver(), predicate, filterBindings, clause)) {
+                return false;
+            }
+            clauses.append(clause);
+        }
+        if (clauses.isEmpty()) {
+            groups.append(group.matchAll ? "1 = 1" : "1 = 0");
+        } else {
+            groups.append("(" + clauses.join(group.matchAll ? " AND " : " OR ") + ")");
+        }
+    }
+
+    // Подзапрос не зависит от наличия WHERE/ORDER BY в исходном запросе
+    QString source = sql.trimmed();
+    while (source.endsWith(';')) {
+        source.chop(1);
+    }
+    if (!isSelect(source)) {
+        return false;
+    }
+
+    // Обёртка видит только колонки результата: колонка вне проекции дала бы ошибку,
+    // а в SQLite - строковый литерал вместо значения и неверные строки. Колонки узнаются
+    // пустым запросом один раз на текст запроса
+    const QString cacheKey = db->connectionName() + QLatin1Char('\n') + source;
+    QStringList columns;
+    {
+        QMutexLocker locker(&resultColumnsMutex);
+        columns = resultColumns.value(cacheKey);
+    }
+    if (columns.isEmpty()) {
+        QSqlQuery probe(*db);
+        if (!probe.prepare(QString("SELECT * FROM (%1) qforge_filtered WHERE 1 = 0").arg(source))) {
+            return false;
+        }
+        for (auto it = bindings.constBegin(); it != bindings.constEnd(); ++it) {
+            probe.bindValue(it.key(), it.value());
+        }
+        if (!probe.exec()) {
+            return false;
+        }
+        const QSqlRecord record = probe.record();
+        for (int i = 0; i < record.count(); ++i) {
+            columns.append(record.fieldName(i));
+        }
+        QMutexLocker locker(&resultColumnsMutex);
+        if (resultColumns.size() >= kMaxCachedQueries) {
+            resultColumns.clear();
+        }
+        resultColumns.insert(cacheKey, columns);
+    }
+    for (const QueryPredicateGroup& group : filter.groups) {
+        for (const QueryPredicate& predicate : group.predicates) {
+            if (!columns.contains(predicate.column, Qt::CaseInsensitive)) {
+                return false;
+            }
+        }
+    }
+
+    sql = QString("SELECT * FROM (%1) qforge_filtered WHERE %2")
+              .arg(source, groups.join(filter.matchAll ? " AND " : " OR "));
+    bindings = filterBindings;
+    return true;
+}
+
+void QForge::nsModel::SqlQueryHandlerFactory::clearResultColumns()
+{
+    QMutexLocker locker(&resultColumnsMutex);
+    resultColumns.clear();
+}
+
+bool QForge::nsModel::SqlQueryHandlerFactory::isSelect(const QString& sql)
+{
+    static const QRegularExpression select(R"(^\s*\(*\s*(SELECT|WITH)\b)",
+                                           QRegularExpression::CaseInsensitiveOption);
+    return select.match(sql).hasMatch();
+}
+
+bool QForge::nsModel::SqlQueryHandlerFactory::isModifying(const QString& sql)
+{
+    static const QRegularExpression modifying(
+        R"(^\s*(INSERT|UPDATE|DELETE|REPLACE|MERGE|UPSERT|CREATE|DROP|ALTER|TRUNCATE)\b)",
+        QRegularExpression::CaseInsensitiveOption);
+    return modifying.match(sql).hasMatch();
+}
+
+QForge::nsModel::QueryResult QForge::nsModel::SqlQueryHandlerFactory::executeBatch(QSqlDatabase* db,
+                                                                                   const QueryContext& context)
+{
+    QueryResult result;
+    result.ok = false;
+
+    if (!db || !db->isValid() || !db->isOpen()) {
+        result.log("Ошибка подключения к базе данных: указатель невалиден или база не открыта.");
+        return result;
+    }
+
+    const bool transaction = context.transactional && db->driver()->hasFeature(QSqlDriver::Transactions);
+    if (transaction && !db->transaction()) {
+        result.log("Не удалось начать транзакцию: " + db->lastError().text());
+        return result;
+    }
+
+    static const QRegularExpression templateArgument(R"(\$\{(\w+)\})");
+    static const QRegularExpression placeholder(R"((?<!:):(\w+))");
+
+    int completed = 0;
+    for (const QueryBatchStep& step : context.batch) {
+        if (step.bindings.isEmpty()) {
+            ++completed;
+            continue;
+        }
+
+        QString sql = step.sql;
+        sql.replace(templateArgument, ":\\1");
+
+        QSqlQuery query(*db);
+        if (!query.prepare(sql)) {
+            result.log(QString("Ошибка при подготовке запроса '%1': %2").arg(step.queryName, query.lastError().text()));
+            break;
+        }
+
+        QSet<QString> names;
+        if (!step.returning.isEmpty()) {
+            // Сгенерированные значения читаются после каждого выполнения: из RETURNING
+            // или lastInsertId() для единственной колонки
+            bool ok = true;
+            for (const QVariantMap& bindings : step.bindings) {
+                for (auto it = placeholder.globalMatch(sql); it.hasNext();) {
+                    const QString name = it.next().captured(1);
+                    query.bindValue(":" + name, bindings.value(name));
+                }
+                if (!query.exec()) {
+                    result.log(QString("Ошибка при выполнении запроса '%1': %2").arg(step.queryName, query.lastError().text()));
+                    ok = false;
+                    break;
+                }
+                QVariantMap row;
+                if (query.isSelect() && query.next()) {
+                    const QSqlRecord record = query.record();
+                    for (const QString& column : step.returning) {
+                        if (record.indexOf(column) >= 0) {
+                            row.insert(column, record.value(column));
+                        }
+                    }
+                } else if (step.returning.size() == 1 && query.lastInsertId().isValid()) {
+                    row.insert(step.returning.first(), query.lastInsertId());
+                }
+                query.finish();
+                result.rows.append(row);
+            }
+            if (!ok) {
+                break;
+            }
+            ++completed;
+            continue;
+        }
+
+        // Значения привязываются колонками: один массив на параметр
+        for (auto it = placeholder.globalMatch(sql); it.hasNext();) {
+            const QString name = it.next().captured(1);
+            if (names.contains(name)) {
+                continue;
+            }
+            names.insert(name);
+            QVariantList values;
+            values.reserve(step.bindings.size());
+            for (const QVariantMap& bindings : step.bindings) {
+                values.append(bindings.value(name));
+            }
+            query.bindValue(":" + name, values);
+        }
+
+        if (!query.execBatch()) {
+            result.log(QString("Ошибка при выполнении запроса '%1': %2").arg(step.queryName, query.lastError().text()));
+            break;
+        }
+        ++completed;
+    }
+
+    if (!result.errors_log.isEmpty()) {
+        // Без транзакции выполненные шаги остаются в базе
+        if (transaction) {
+            db->rollback();
+        } else {
+            result.completedSteps = completed;
+        }
+        return result;
+    }
+    if (transaction && !db->commit()) {
+        result.log("Не удалось зафиксировать транзакцию: " + db->lastError().text());
+        db->rollback();
+        return result;
+    }
+
+    result.ok = true;
+    result.completedSteps = completed;
+    return result;
+}
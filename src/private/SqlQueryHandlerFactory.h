@@ -28,6 +28,44 @@ public:
      * @return QueryHandler, выполняющий запросы через указанную БД.
      */
     static QueryHandler getHandler(QSqlDatabase* db);
+
+    /**
+     * @brief Оборачивает запрос в SELECT с параметризованным WHERE по фильтру модели.
+     * @param db База данных (для экранирования имён колонок).
+     * @param filter Фильтр из QueryContext.
+     * @param sql Запрос; при успехе заменяется обёрнутым.
+     * @param bindings Аргументы; при успехе дополняются значениями фильтра.
+     * @return false, если фильтр содержит неподдерживаемый оператор, запрос не SELECT или
+     * колонки фильтра нет среди колонок результата (sql и bindings не меняются).
+     * Колонки результата запоминаются по подключению и тексту запроса: пробный запрос
+     * выполняется только при первом фильтре.
+     */
+    static bool applyFilter(QSqlDatabase* db, const QueryFilter& filter, QString& sql, QVariantMap& bindings);
+
+    /**
+     * @brief Забывает запомненные колонки результатов (после изменения структуры БД).
+     */
+    static void clearResultColumns();
+
+    /**
+     * @brief Запрос читающий: начинается с SELECT или WITH.
+     */
+    static bool isSelect(const QString& sql);
+
+    /**
+     * @brief Запрос изменяет данные или структуру БД (INSERT, UPDATE, DELETE, ...).
+     * @details Команды пользовательских обработчиков (не SQL) изменяющими не считаются.
+     */
+    static bool isModifying(const QString& sql);
+
+    /**
+     * @brief Выполняет пакет записи QueryContext::batch.
+     * @details Каждый шаг готовится один раз и выполняется через QSqlQuery::execBatch
+     * (драйверы без пакетных операций Qt эмулирует циклом). ${name} в запросе заменяется
+     * на :name. При context.transactional весь пакет выполняется в одной транзакции и
+     * откатывается при ошибке любого шага.
+     */
+    static QueryResult executeBatch(QSqlDatabase* db, const QueryContext& context);
 };
 
 }
@@ -1,4 +1,7 @@
 #include "TableModelPrivate.h"
+#include "LookupCache.h"
+#include "SchemaRegistry.h"
+#include "SqlQueryHandlerFactory.h"
 #include "../TableModel.h"
 #include <QDebug>
 #include <QtConcurrent>
@@ -6,19 +9,65 @@
 #include <QSqlError>
 #include <QSqlRecord>
 #include <QDateTime>
+#include <QFileInfo>
+#include <QSet>
+
+#include <algorithm>
+#include <numeric>
 
 namespace QForge {
 namespace nsModel {
 
+// Сколько групп вставки допускается, прежде чем выгоднее сбросить модель и пересортировать
+static constexpr int kMaxInsertGroups = 1024;
+
+// Задержка перезагрузки схемы после изменения файла: серия записей объединяется в одну
+static constexpr int kSchemaReloadDelayMs = 50;
+
+// Запросы схемы, в которые отображаются правки, и имя контекста пакетной записи
+static constexpr char kUpdateQuery[] = "update";
+static constexpr char kInsertQuery[] = "insert";
+static constexpr char kRemoveQuery[] = "remove";
+static constexpr char kCommitQueryName[] = "qforge_commit";
+
+// Отмечает элементы наибольшей строго возрастающей подпоследовательности (O(n log n))
+static QVector<bool> increasingSubsequence(const QVector<int>& values)
+{
+    QVector<int> tails;    // Индекс последнего элемента подпоследовательности каждой длины
+    QVector<int> previous(values.size(), -1);
+    for (int i = 0; i < values.size(); ++i) {
+        const auto pos = std::lower_bound(tails.begin(), tails.end(), values[i],
+                                          [&values](int index, int value) { return values[index] < value; });
+        if (pos != tails.begin()) {
+            previous[i] = *(pos - 1);
+        }
+        if (pos == tails.end()) {
+            tails.append(i);
+        } else {
+            *pos = i;
+        }
+    }
+    
+    QVector<bool> marked(values.size(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous[i]) {
+        marked[i] = true;
+    }
+    return marked;
+}
+
 TableModelPrivate::TableModelPrivate(TableModel* q)
     : QObject(nullptr)
     , q_ptr(q)
     , modelCore(nullptr)
-    , schema(nullptr)
+    , schema()
     , database(nullptr)
     , isInitialized(false)
+    , filterPushedDown(false)
+    , schemaWatcher(nullptr)
+    , schemaTimer(nullptr)
 {
     // modelCore будет создан в loadSchema
+    connect(&LookupCache::instance(), &LookupCache::invalidated, this, &TableModelPrivate::onLookupInvalidated);
 }
 
 TableModelPrivate::~TableModelPrivate()
@@ -32,12 +81,13 @@ TableModelPrivate::~TableModelPrivate()
     activeOperations.clear();
     
     delete modelCore;
-    // schema удаляется в ModelCore
+    // schema разделяется с ModelCore и SchemaRegistry
 }
 
 bool TableModelPrivate::loadSchema(const QString& configPath)
 {
     // Создаем ModelCore с путем к конфигу
+    schemaPath = QFileInfo(configPath).absoluteFilePath();
     if (!modelCore) {
         modelCore = new ModelCore(configPath, queryHandler);
     }
@@ -50,7 +100,19 @@ bool TableModelPrivate::loadSchema(const QString& configPath)
     }
     
     // Получаем схему из ModelCore
-    schema = const_cast<QForge::ModelSchema*>(&modelCore->getSchema());
+    schema = modelCore->sharedSchema();
+    
+    store.reset(schema->columns);
+    compileCalculatedColumns();
+    bindLookups();
+    if (schema->isSortingEnabled) {
+        sortRules = schema->sorting;
+        sortKeys = SortEngine::keysFromRules(*schema, sortRules);
+    }
+    if (schema->enableFiltering) {
+        filter = FilterEngine::fromDefaults(schema->defaultFilters);
+        filterColumns = FilterEngine::columns(store, filter);
+    }
     
     // Заголовки теперь генерируются в TableModel на основе HeaderSettings
     
@@ -86,57 +148,274 @@ bool TableModelPrivate::validateSchema()
 }
 
 QueryResult TableModelPrivate::executeQuery(const QString& queryName, const QVariantMap& params)
+{
+    QueryContext context;
+    QueryResult result;
+    if (prepareQuery(queryName, params, context, result)) {
+        if (schema->queries[queryName].effect == QueryEffect::None) {
+            result = runQuery(context);
+            finishQuery(context, result);
+        } else {
+            // Записывающий запрос: изменение видно сразу, ответ источника его подтверждает или откатывает
+            const LocalEffect effect = applyEffect(queryName, params);
+            result = runQuery(context);
+            finishEffect(effect, result);
+        }
+    }
+    
+    if (!result.ok) {
+        lastError = result.errors_log.join("; ");
+    }
+    
+    return result;
+}
+
+bool TableModelPrivate::prepareQuery(const QString& queryName, const QVariantMap& params,
+                                     QueryContext& context, QueryResult& result) const
 {
     if (!isInitialized) {
-        QueryResult result;
         result.ok = false;
         result.log("Model not initialized");
-        return result;
+        return false;
     }
     
     if (!schema->queries.contains(queryName)) {
-        QueryResult result;
         result.ok = false;
         result.log(QString("Query '%1' not found").arg(queryName));
-        return result;
+        return false;
     }
     
     // Создаем контекст запроса
-    QueryContext context;
     context.queryName = queryName;
     context.bindings = params;
     
     const QForge::Query& queryDef = schema->queries[queryName];
     context.sql = queryDef.sql;
     
+    // Фильтр предлагается источнику только для читающих запросов; если источник его
+    // не выполнит, фильтруем локально
+    if (isFiltered() && isSelectQuery(queryName)) {
+        context.filter = FilterEngine::toQueryFilter(filter, *schema, filterCaseSensitivity());
+    }
+    
+    result.ok = true;
+    return true;
+}
+
+QueryResult TableModelPrivate::runQuery(const QueryContext& context)
+{
     QueryResult result;
     
     try {
         if (queryHandler) {
-            // A?>;L7C5< ?>;L7>20B5;LA:89 >1@01>BG8:
+            // Используем пользовательский обработчик
             result = queryHandler(context);
         } else if (database) {
-            // A?>;L7C5< SQL 107C 40==KE
+            // Используем SQL базу данных
             result = executeSqlQuery(context);
         } else {
             result.ok = false;
             result.log("No query handler or database configured");
         }
-        
-        if (result.ok) {
-            updateModelData(result);
-        }
-        
     } catch (const std::exception& e) {
         result.ok = false;
         result.log(QString("Query execution failed: %1").arg(e.what()));
     }
     
+    return result;
+}
+
+void TableModelPrivate::finishQuery(const QueryContext& context, const QueryResult& result)
+{
     if (!result.ok) {
-        lastError = result.errors_log.join("; ");
+        return;
     }
     
-    return result;
+    filterPushedDown = !context.filter.isEmpty() && result.filterApplied;
+    if (!context.filter.isEmpty()) {
+        FilterPushDownCount& count = filterPushDowns[context.queryName];
+        ++(filterPushedDown ? count.pushedDown : count.local);
+    }
+    // При смене фильтра перезапрашивается только загружающий запрос, не записывающий
+    if (isSelectQuery(context.queryName)) {
+        lastQueryName = context.queryName;
+        lastQueryParams = context.bindings;
+    }
+    updateModelData(result);
+}
+
+bool TableModelPrivate::isSelectQuery(const QString& queryName) const
+{
+    const auto it = schema->queries.constFind(queryName);
+    return it != schema->queries.constEnd() && it->isReadOnly && it->effect == QueryEffect::None
+        && !SqlQueryHandlerFactory::isModifying(it->sql);
+}
+
+LocalEffect TableModelPrivate::applyEffect(const QString& queryName, const QVariantMap& params)
+{
+    LocalEffect effect;
+    effect.type = schema->queries[queryName].effect;
+    
+    // Аргументы, не совпадающие с колонками схемы, к строке не относятся
+    QVariantMap key;
+    QVariantMap values;
+    for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+        if (schema->columnIndex(it.key()) < 0) {
+            continue;
+        }
+        if (schema->primaryKeyColumns.contains(it.key())) {
+            key.insert(it.key(), it.value());
+        }
+        // Непереданное (невалидное) значение в update означает "не менять"
+        if (effect.type != QueryEffect::Update || it.value().isValid()) {
+            values.insert(it.key(), it.value());
+        }
+    }
+    
+    switch (effect.type) {
+        case QueryEffect::Insert:
+            effect.row = store.rowCount();
+            appendRows({values});
+            break;
+        
+        case QueryEffect::Update:
+            effect.row = findSourceRow(key);
+            if (effect.row >= 0) {
+                for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+                    effect.previous.insert(it.key(), store.value(effect.row, schema->columnIndex(it.key())));
+                }
+                updateRow(effect.row, values);
+            }
+            break;
+        
+        case QueryEffect::Remove:
+            effect.row = findSourceRow(key);
+            if (effect.row >= 0) {
+                effect.previous = store.rowMap(effect.row);
+                effect.rowId = journal.isEnabled() ? journal.rowId(effect.row) : 0;
+                removeSourceRows({effect.row});
+            }
+            break;
+        
+        case QueryEffect::None:
+            break;
+    }
+    return effect;
+}
+
+void TableModelPrivate::finishEffect(const LocalEffect& effect, const QueryResult& result)
+{
+    if (effect.row < 0) {
+        return;
+    }
+    
+    if (result.ok) {
+        // Строка, возвращённая источником (RETURNING), дополняет применённую: ключ, значения по умолчанию
+        if (effect.type != QueryEffect::Remove && !result.rows.isEmpty()) {
+            updateRow(effect.row, result.rows.first());
+        }
+        return;
+    }
+    
+    switch (effect.type) {
+        case QueryEffect::Insert:
+            removeSourceRows({effect.row});
+            break;
+        
+        case QueryEffect::Update:
+            updateRow(effect.row, effect.previous);
+            break;
+        
+        case QueryEffect::Remove:
+            // Строка возвращается на прежнее место со своим номером в журнале
+            insertSourceRows({qMin(effect.row, store.rowCount())}, {effect.previous}, {effect.rowId});
+            break;
+        
+        case QueryEffect::None:
+            break;
+    }
+}
+
+void TableModelPrivate::updateRow(int source, const QVariantMap& values)
+{
+    Q_Q(TableModel);
+    
+    // Видимая строка - до записи, пока перестановка согласована со значениями
+    const int row = viewRow(source);
+    QVector<int> changed;
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        const int column = schema->columnIndex(it.key());
+        if (column >= 0 && !schema->columns[column].isCalculated && store.setValue(source, column, it.value())) {
+            changed.append(column);
+            changed += recalculateDependents(source, column);
+        }
+    }
+    if (changed.isEmpty()) {
+        return;
+    }
+    loadLookups(source, 1);
+    
+    if (row >= 0) {
+        const auto [first, last] = std::minmax_element(changed.cbegin(), changed.cend());
+        emit q->dataChanged(q->index(row, *first), q->index(row, *last));
+        rowChanged(row, changed);
+        return;
+    }
+    
+    // Скрытая фильтром строка: место в полном порядке без сигналов, показ - если теперь проходит фильтр
+    if (!isFiltered()) {
+        return;
+    }
+    if (isSorted()) {
+        repositionRow(rowOrder, rowOrder.indexOf(source), false);
+    }
+    if (filterMatcher.matches(store, filter, filterCaseSensitivity(), source)) {
+        filterMask.set(source);
+        insertIntoOrder(visibleRows, {source});
+    }
+}
+
+int TableModelPrivate::findSourceRow(const QVariantMap& key)
+{
+    if (schema->primaryKeyColumns.isEmpty()) {
+        return -1;
+    }
+    
+    // Запись индекса проверяется по самой строке: номера сдвигаются удалениями, ключи - правками
+    const QString wanted = keyString(key);
+    const auto it = keyRows.constFind(wanted);
+    if (it != keyRows.constEnd() && it.value() < store.rowCount() && keyString(primaryKey(it.value())) == wanted) {
+        return it.value();
+    }
+    
+    keyRows.clear();
+    keyRows.reserve(store.rowCount());
+    for (int source = 0; source < store.rowCount(); ++source) {
+        keyRows.insert(keyString(primaryKey(source)), source);
+    }
+    return keyRows.value(wanted, -1);
+}
+
+int TableModelPrivate::viewRow(int source) const
+{
+    if (!isSorted() && !isFiltered()) {
+        return source;
+    }
+    if (isFiltered() && !filterMask.test(source)) {
+        return -1;
+    }
+    
+    // Перестановка упорядочена compareRows: двоичный поиск, затем равные строки подряд
+    const QVector<int>& order = isFiltered() ? visibleRows : rowOrder;
+    const auto first = std::lower_bound(order.cbegin(), order.cend(), source, [this](int lhs, int rhs) {
+        return compareRows(lhs, rhs) < 0;
+    });
+    for (auto it = first; it != order.cend() && compareRows(*it, source) == 0; ++it) {
+        if (*it == source) {
+            return int(it - order.cbegin());
+        }
+    }
+    return -1;
 }
 
 QueryResult TableModelPrivate::executeSqlQuery(const QueryContext& context)
@@ -149,21 +428,16 @@ QueryResult TableModelPrivate::executeSqlQuery(const QueryContext& context)
         return result;
     }
     
-    const QForge::Query& queryDef = schema->queries[context.queryName];
-    QString sql = queryDef.sql;
-    
-    // Подставляем параметры в SQL
-    for (auto it = context.bindings.begin(); it != context.bindings.end(); ++it) {
-        QString placeholder = QString("${%1}").arg(it.key());
-        sql.replace(placeholder, it.value().toString());
+    if (!context.batch.isEmpty()) {
+        return SqlQueryHandlerFactory::executeBatch(database, context);
     }
     
     QSqlQuery query(*database);
-    query.prepare(sql);
-    
-    if (!query.exec()) {
+    bool filterApplied = false;
+    QString error;
+    if (!prepareSqlQuery(context, query, filterApplied, error)) {
         result.ok = false;
-        result.log(query.lastError().text());
+        result.log(error);
         return result;
     }
     
@@ -182,10 +456,203 @@ QueryResult TableModelPrivate::executeSqlQuery(const QueryContext& context)
     }
     
     result.ok = true;
+    result.filterApplied = filterApplied;
     
     return result;
 }
 
+bool TableModelPrivate::prepareSqlQuery(const QueryContext& context, QSqlQuery& query, bool& filterApplied, QString& error)
+{
+    const QForge::Query& queryDef = schema->queries[context.queryName];
+    QString sql = queryDef.sql;
+    
+    // Подставляем параметры в SQL
+    for (auto it = context.bindings.begin(); it != context.bindings.end(); ++it) {
+        QString placeholder = QString("${%1}").arg(it.key());
+        sql.replace(placeholder, it.value().toString());
+    }
+    
+    QVariantMap filterBindings;
+    filterApplied = !context.filter.isEmpty()
+        && SqlQueryHandlerFactory::applyFilter(database, context.filter, sql, filterBindings);
+    
+    query.prepare(sql);
+    for (auto it = filterBindings.constBegin(); it != filterBindings.constEnd(); ++it) {
+        query.bindValue(it.key(), it.value());
+    }
+    
+    if (!query.exec()) {
+        if (filterApplied) {
+            SqlQueryHandlerFactory::clearResultColumns(); // структура таблиц могла измениться
+        }
+        error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// Прогресс и отмена проверяются раз в пакет строк, а не на каждой строке
+static constexpr int kExportBatchRows = 4096;
+
+bool TableModelPrivate::exportRows(QIODevice* device, const QString& formatName)
+{
+    ExportWriter::Format format;
+    if (!startExport(device, formatName, format)) {
+        return false;
+    }
+    
+    QStringList columns;
+    for (const Column& column : schema->columns) {
+        columns.append(column.name);
+    }
+    
+    // Значения берутся из типизированных колонок хранилища в порядке представления
+    ExportWriter writer(device, format, schema->exportSettings, columns);
+    writer.begin();
+    const int count = rowCount();
+    for (int row = 0; row < count; ++row) {
+        writer.writeRow(store, sourceRow(row));
+        if ((row + 1) % kExportBatchRows == 0 && !exportBatch(writer, row + 1)) {
+            return false;
+        }
+    }
+    return finishExport(writer, count);
+}
+
+bool TableModelPrivate::exportQuery(QIODevice* device, const QString& queryName, const QVariantMap& params,
+                                    const QString& formatName)
+{
+    ExportWriter::Format format;
+    if (!startExport(device, formatName, format)) {
+        return false;
+    }
+    
+    QueryContext context;
+    QueryResult result;
+    if (!prepareQuery(queryName, params, context, result)) {
+        lastError = result.errors_log.join("; ");
+        return false;
+    }
+    // Выгружается результат запроса как есть: фильтр модели к нему не относится
+    context.filter = {};
+    
+    QStringList columns;
+    for (const Column& column : schema->columns) {
+        columns.append(column.name);
+    }
+    
+    if (!queryHandler && database) {
+        if (!database->isOpen()) {
+            lastError = "Database not connected";
+            return false;
+        }
+        // Курсор только вперёд: драйвер не кэширует пройденные строки, в памяти одна строка
+        QSqlQuery query(*database);
+        query.setForwardOnly(true);
+        bool filterApplied = false;
+        if (!prepareSqlQuery(context, query, filterApplied, lastError)) {
+            return false;
+        }
+        
+        const QSqlRecord record = query.record();
+        for (int i = columns.size(); i < record.count(); ++i) {
+            columns.append(record.fieldName(i));
+        }
+        columns = columns.mid(0, record.count());
+        
+        ExportWriter writer(device, format, schema->exportSettings, columns);
+        writer.begin();
+        QVariantList values(record.count());
+        qint64 rows = 0;
+        while (query.next()) {
+            for (int i = 0; i < values.size(); ++i) {
+                values[i] = query.value(i);
+            }
+            writer.writeRow(values);
+            if (++rows % kExportBatchRows == 0 && !exportBatch(writer, rows)) {
+                return false;
+            }
+        }
+        if (query.lastError().isValid()) {
+            lastError = query.lastError().text();
+            return false;
+        }
+        return finishExport(writer, rows);
+    }
+    
+    // Обработчик возвращает строки целиком; потоково пишется только вывод
+    result = runQuery(context);
+    if (!result.ok) {
+        lastError = result.errors_log.join("; ");
+        return false;
+    }
+    
+    ExportWriter writer(device, format, schema->exportSettings, columns);
+    writer.begin();
+    QVariantList values(columns.size());
+    qint64 rows = 0;
+    for (const QVariantMap& row : std::as_const(result.rows)) {
+        for (int i = 0; i < values.size(); ++i) {
+            values[i] = row.value(columns[i]);
+        }
+        writer.writeRow(values);
+        if (++rows % kExportBatchRows == 0 && !exportBatch(writer, rows)) {
+            return false;
+        }
+    }
+    return finishExport(writer, rows);
+}
+
+bool TableModelPrivate::startExport(QIODevice* device, const QString& formatName, ExportWriter::Format& format)
+{
+    if (!isInitialized) {
+        lastError = "Model not initialized";
+        return false;
+    }
+    if (!device || !device->isWritable()) {
+        lastError = "Export device is not writable";
+        return false;
+    }
+    
+    const ExportSettings& settings = schema->exportSettings;
+    const QString name = formatName.isEmpty() ? settings.defaultFormat : formatName;
+    if (!settings.supportedFormats.contains(name, Qt::CaseInsensitive) || !ExportWriter::parseFormat(name, format)) {
+        lastError = QString("Export format '%1' is not supported").arg(name);
+        return false;
+    }
+    
+    exportCancelled = false;
+    return true;
+}
+
+bool TableModelPrivate::exportBatch(const ExportWriter& writer, qint64 rows)
+{
+    Q_Q(TableModel);
+    
+    if (writer.hasError()) {
+        lastError = writer.errorString();
+        return false;
+    }
+    emit q->exportProgress(rows, writer.bytesWritten());
+    if (exportCancelled) {
+        lastError = "Export cancelled";
+        return false;
+    }
+    return true;
+}
+
+bool TableModelPrivate::finishExport(ExportWriter& writer, qint64 rows)
+{
+    Q_Q(TableModel);
+    
+    if (!writer.finish()) {
+        lastError = writer.errorString();
+        return false;
+    }
+    emit q->exportProgress(rows, writer.bytesWritten());
+    return true;
+}
+
 QUuid TableModelPrivate::executeQueryAsync(const QString& queryName, const QVariantMap& params)
 {
     QUuid operationId = QUuid::createUuid();
@@ -195,10 +662,19 @@ QUuid TableModelPrivate::executeQueryAsync(const QString& queryName, const QVari
     operation->queryName = queryName;
     operation->params = params;
     
-    // Создаем Future для асинхронного выполнения
-    operation->future = QtConcurrent::run([this, queryName, params]() {
-        return executeQuery(queryName, params);
-    });
+    // Контекст собирается здесь, в потоке модели; в рабочем потоке выполняется только обработчик,
+    // а результат применяется к модели в onAsyncQueryFinished (снова в потоке модели)
+    QueryResult rejected;
+    if (prepareQuery(queryName, params, operation->context, rejected)) {
+        operation->effect = applyEffect(queryName, params);
+        operation->future = QtConcurrent::run([this, context = operation->context]() {
+            return runQuery(context);
+        });
+    } else {
+        operation->future = QtConcurrent::run([rejected]() {
+            return rejected;
+        });
+    }
     
     // Создаем Watcher для отслеживания завершения
     operation->watcher = new QFutureWatcher<QueryResult>();
@@ -232,12 +708,21 @@ void TableModelPrivate::onAsyncQueryFinished()
     
     AsyncOperation* operation = activeOperations.take(operationId);
     QueryResult result = watcher->result();
+    // Справочники новых строк догружаются так же, как выполнялся запрос: не в потоке модели
+    deferLookups = true;
+    if (operation->effect.type == QueryEffect::None) {
+        finishQuery(operation->context, result);
+    } else {
+        finishEffect(operation->effect, result);
+    }
+    deferLookups = false;
     
     if (result.ok) {
         emit q->executionFinished(operationId);
         q->onExecutionFinished(operation->queryName, result);
     } else {
         QString errorMsg = result.errors_log.join("; ");
+        lastError = errorMsg;
         emit q->executionFailed(operationId, errorMsg);
         q->onExecutionError(operation->queryName, errorMsg);
     }
@@ -251,15 +736,29 @@ void TableModelPrivate::updateModelData(const QueryResult& result)
     
     q->beginResetModel();
     
-    modelData.clear();
+    // Строки, изменённые незавершёнными запросами, заменяются новыми данными
+    for (AsyncOperation* operation : std::as_const(activeOperations)) {
+        operation->effect.row = -1;
+    }
+    edits.clear();
+    store.clear();
+    store.appendRows(result.rows);
+    journal.clear();
+    journal.resetRows(store.rowCount());
+    computeCalculatedColumns(0, store.rowCount());
+    loadLookups(0, store.rowCount());
     
-    // Преобразуем QVariantMap обратно в QVariantList для отображения
-    for (const QVariantMap& rowMap : result.rows) {
-        QVariantList row;
-        for (const QForge::Column& column : schema->columns) {
-            row.append(rowMap.value(column.name));
+    // Сохраняем текущий порядок сортировки для новых данных
+    rowOrder = sortKeys.isEmpty() ? QVector<int>() : SortEngine::sort(store, sortKeys);
+    
+    // И текущий фильтр (уже выполненный источником строки не перепроверяются)
+    if (isFiltered()) {
+        if (filterPushedDown) {
+            filterMask = RowBitmap(store.rowCount(), true);
+        } else {
+            FilterEngine::evaluate(store, filter, filterCaseSensitivity(), filterMask);
         }
-        modelData.append(row);
+        rebuildVisibleRows();
     }
     
     q->endResetModel();
@@ -269,21 +768,1513 @@ void TableModelPrivate::clearData()
 {
     Q_Q(TableModel);
     
-    if (!modelData.isEmpty()) {
+    if (store.rowCount() > 0) {
         q->beginResetModel();
-        modelData.clear();
+        store.clear();
+        rowOrder.clear();
+        filterMask = RowBitmap();
+        visibleRows.clear();
         q->endResetModel();
     }
+    for (AsyncOperation* operation : std::as_const(activeOperations)) {
+        operation->effect.row = -1;
+    }
+    edits.clear();
+    journal.clear();
+    journal.resetRows(0);
+    filterPushedDown = false;
 }
 
-QString TableModelPrivate::formatErrorMessage(const QString& error) const
+int TableModelPrivate::compareRows(int lhs, int rhs) const
 {
-    if (!schema) return error;
-    
-    QString message = schema->defaultErrorHandling.message;
-    message.replace("${last_error}", error);
+    if (isSorted()) {
+        return SortEngine::compare(store, sortKeys, lhs, rhs);
+    }
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+void TableModelPrivate::changePersistentRows(const QModelIndexList& indexes, const QVector<int>& sources)
+{
+    Q_Q(TableModel);
     
-    return message;
+    QModelIndexList newIndexes;
+    if (!indexes.isEmpty()) {
+        // Строка хранилища -> новая видимая строка (-1, если строка скрыта)
+        QVector<int> rowOf(store.rowCount(), -1);
+        const int count = rowCount();
+        for (int row = 0; row < count; ++row) {
+            rowOf[sourceRow(row)] = row;
+        }
+        newIndexes.reserve(indexes.size());
+        for (int i = 0; i < indexes.size(); ++i) {
+            const int row = rowOf[sources[i]];
+            newIndexes.append(row < 0 ? QModelIndex() : q->index(row, indexes[i].column()));
+        }
+    }
+    q->changePersistentIndexList(indexes, newIndexes);
+}
+
+bool TableModelPrivate::isSortColumn(int column) const
+{
+    return std::any_of(sortKeys.begin(), sortKeys.end(), [column](const SortKey& key) {
+        return key.column == column;
+    });
+}
+
+void TableModelPrivate::applySort(const QVector<SortRule>& rules, bool force)
+{
+    Q_Q(TableModel);
+    
+    const QVector<SortKey> keys = SortEngine::keysFromRules(*schema, rules);
+    sortRules = rules;
+    
+    // Порядок поддерживается инкрементально, повторная сортировка не нужна
+    if (keys == sortKeys && !force) {
+        return;
+    }
+    
+    emit q->layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    
+    // Запоминаем строки хранилища, на которые указывают persistent-индексы
+    const QModelIndexList oldIndexes = q->persistentIndexList();
+    QVector<int> oldSourceRows;
+    oldSourceRows.reserve(oldIndexes.size());
+    for (const QModelIndex& index : oldIndexes) {
+        oldSourceRows.append(sourceRow(index.row()));
+    }
+    
+    if (!force && SortEngine::isReversal(sortKeys, keys)) {
+        // Та же колонка в обратном направлении - достаточно развернуть перестановку
+        SortEngine::reverseOrder(store, keys, rowOrder);
+    } else if (keys.isEmpty()) {
+        rowOrder.clear();
+    } else {
+        rowOrder = SortEngine::sort(store, keys);
+    }
+    sortKeys = keys;
+    
+    if (isFiltered()) {
+        rebuildVisibleRows();
+    }
+    
+    changePersistentRows(oldIndexes, oldSourceRows);
+    
+    emit q->layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+Qt::CaseSensitivity TableModelPrivate::filterCaseSensitivity() const
+{
+    return schema && schema->caseSensitiveFiltering ? Qt::CaseSensitive : Qt::CaseInsensitive;
+}
+
+bool TableModelPrivate::applyFilter(const Filter& newFilter, bool force)
+{
+    Q_Q(TableModel);
+    
+    if (!schema || !schema->enableFiltering) {
+        lastError = "Filtering is disabled in schema";
+        return false;
+    }
+    
+    if (newFilter == filter && !force) {
+        return true;
+    }
+    
+    // Загруженные строки уже отфильтрованы источником - перезапрашиваем с новым фильтром
+    if (filterPushedDown) {
+        const Filter oldFilter = filter;
+        filter = newFilter;
+        filterColumns = FilterEngine::columns(store, filter);
+        if (!executeQuery(lastQueryName, lastQueryParams).ok) {
+            filter = oldFilter;
+            filterColumns = FilterEngine::columns(store, filter);
+            return false;
+        }
+        return true;
+    }
+    
+    emit q->layoutAboutToBeChanged();
+    
+    const QModelIndexList oldIndexes = q->persistentIndexList();
+    QVector<int> oldSourceRows;
+    oldSourceRows.reserve(oldIndexes.size());
+    for (const QModelIndex& index : oldIndexes) {
+        oldSourceRows.append(sourceRow(index.row()));
+    }
+    
+    filter = newFilter;
+    filterColumns = FilterEngine::columns(store, filter);
+    if (isFiltered()) {
+        FilterEngine::evaluate(store, filter, filterCaseSensitivity(), filterMask);
+        rebuildVisibleRows();
+    } else {
+        filterMask = RowBitmap();
+        visibleRows.clear();
+    }
+    
+    // Persistent-индексы скрытых строк становятся невалидными
+    changePersistentRows(oldIndexes, oldSourceRows);
+    
+    emit q->layoutChanged();
+    return true;
+}
+
+void TableModelPrivate::rebuildVisibleRows()
+{
+    visibleRows.clear();
+    visibleRows.reserve(filterMask.count());
+    
+    if (isSorted()) {
+        for (int source : std::as_const(rowOrder)) {
+            if (filterMask.test(source)) {
+                visibleRows.append(source);
+            }
+        }
+    } else {
+        filterMask.forEach([this](int source) { visibleRows.append(source); });
+    }
+}
+
+void TableModelPrivate::appendRows(const QList<QVariantMap>& rows)
+{
+    Q_Q(TableModel);
+    
+    if (rows.isEmpty()) {
+        return;
+    }
+    
+    if (!isSorted() && !isFiltered()) {
+        const int first = store.rowCount();
+        q->beginInsertRows(QModelIndex(), first, first + rows.size() - 1);
+        store.appendRows(rows);
+        journal.appendRows(rows.size());
+        computeCalculatedColumns(first, rows.size());
+        loadLookups(first, rows.size());
+        q->endInsertRows();
+        return;
+    }
+    
+    // Новые строки не видны, пока не попали в перестановку
+    const int first = store.appendRows(rows);
+    journal.appendRows(rows.size());
+    computeCalculatedColumns(first, rows.size());
+    loadLookups(first, rows.size());
+    QVector<int> added(rows.size());
+    std::iota(added.begin(), added.end(), first);
+    if (isSorted()) {
+        SortEngine::sortRows(store, sortKeys, added);
+    }
+    
+    if (!isFiltered()) {
+        insertIntoOrder(rowOrder, added);
+        return;
+    }
+    
+    // Полный порядок обновляется без сигналов, видимые - только прошедшие фильтр
+    if (isSorted()) {
+        mergeIntoOrder(rowOrder, added);
+    }
+    FilterEngine::evaluate(store, filter, filterCaseSensitivity(), filterMask, first);
+    added.erase(std::remove_if(added.begin(), added.end(), [this](int source) {
+        return !filterMask.test(source);
+    }), added.end());
+    insertIntoOrder(visibleRows, added);
+}
+
+void TableModelPrivate::mergeIntoOrder(QVector<int>& order, const QVector<int>& added) const
+{
+    QVector<int> merged(order.size() + added.size());
+    std::merge(order.begin(), order.end(), added.begin(), added.end(), merged.begin(),
+               [this](int lhs, int rhs) { return compareRows(lhs, rhs) < 0; });
+    order = merged;
+}
+
+void TableModelPrivate::insertIntoOrder(QVector<int>& order, const QVector<int>& added)
+{
+    Q_Q(TableModel);
+    
+    const int count = added.size();
+    if (count == 0) {
+        return;
+    }
+    
+    // Позиции вставки в текущей перестановке (после равных - сохраняем устойчивость).
+    // Новые строки упорядочены, поэтому каждый поиск начинается с предыдущей позиции.
+    QVector<int> positions(count);
+    int low = 0;
+    int groups = 0;
+    for (int i = 0; i < count; ++i) {
+        int high = order.size();
+        while (low < high) {
+            const int mid = low + (high - low) / 2;
+            if (compareRows(added[i], order[mid]) < 0) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        positions[i] = low;
+        if (i == 0 || positions[i] != positions[i - 1]) {
+            ++groups;
+        }
+    }
+    
+    if (groups > kMaxInsertGroups) {
+        q->beginResetModel();
+        mergeIntoOrder(order, added);
+        q->endResetModel();
+        return;
+    }
+    
+    // Вставляем группы подряд идущих строк; позиция сдвигается на уже вставленные
+    for (int i = 0; i < count;) {
+        int last = i;
+        while (last + 1 < count && positions[last + 1] == positions[i]) {
+            ++last;
+        }
+        
+        const int at = positions[i] + i;
+        q->beginInsertRows(QModelIndex(), at, at + last - i);
+        order.insert(at, last - i + 1, 0);
+        std::copy(added.begin() + i, added.begin() + last + 1, order.begin() + at);
+        q->endInsertRows();
+        
+        i = last + 1;
+    }
+}
+
+void TableModelPrivate::repositionRow(QVector<int>& order, int row, bool notify)
+{
+    Q_Q(TableModel);
+    
+    const int source = order[row];
+    const int count = order.size();
+    
+    // Строка по-прежнему упорядочена относительно соседей
+    const bool afterPrevious = row == 0 || compareRows(order[row - 1], source) <= 0;
+    const bool beforeNext = row == count - 1 || compareRows(source, order[row + 1]) <= 0;
+    if (afterPrevious && beforeNext) {
+        return;
+    }
+    
+    // Двоичный поиск среди остальных строк (без самой перемещаемой)
+    auto other = [&order, row](int i) { return order[i < row ? i : i + 1]; };
+    int low = 0;
+    int high = count - 1;
+    while (low < high) {
+        const int mid = low + (high - low) / 2;
+        if (compareRows(source, other(mid)) < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    
+    const int target = low;
+    if (target == row) {
+        return;
+    }
+    
+    // beginMoveRows ожидает позицию назначения в координатах до перемещения
+    const int destination = target > row ? target + 1 : target;
+    if (notify && !q->beginMoveRows(QModelIndex(), row, row, QModelIndex(), destination)) {
+        return;
+    }
+    if (target < row) {
+        std::rotate(order.begin() + target, order.begin() + row, order.begin() + row + 1);
+    } else {
+        std::rotate(order.begin() + row, order.begin() + row + 1, order.begin() + target + 1);
+    }
+    if (notify) {
+        q->endMoveRows();
+    }
+}
+
+void TableModelPrivate::rowChanged(int row, const QVector<int>& columns)
+{
+    Q_Q(TableModel);
+    
+    bool sortAffected = false;
+    bool filterAffected = false;
+    for (int column : columns) {
+        sortAffected = sortAffected || isSortColumn(column);
+        filterAffected = filterAffected || (isFiltered() && filterColumns.contains(column));
+    }
+    if (!sortAffected && !filterAffected) {
+        return;
+    }
+    
+    if (!isFiltered()) {
+        repositionRow(rowOrder, row, true);
+        return;
+    }
+    
+    const int source = visibleRows[row];
+    if (sortAffected) {
+        repositionRow(rowOrder, rowOrder.indexOf(source), false);
+    }
+    
+    // Строка перестала проходить фильтр - скрываем её
+    if (filterAffected && !filterMatcher.matches(store, filter, filterCaseSensitivity(), source)) {
+        q->beginRemoveRows(QModelIndex(), row, row);
+        visibleRows.removeAt(row);
+        filterMask.set(source, false);
+        q->endRemoveRows();
+        return;
+    }
+    
+    if (sortAffected) {
+        repositionRow(visibleRows, row, true);
+    }
+}
+
+void TableModelPrivate::relayoutRows(const QVector<int>& sources)
+{
+    Q_Q(TableModel);
+    
+    emit q->layoutAboutToBeChanged();
+    const QModelIndexList oldIndexes = q->persistentIndexList();
+    QVector<int> oldSourceRows;
+    oldSourceRows.reserve(oldIndexes.size());
+    for (const QModelIndex& index : oldIndexes) {
+        oldSourceRows.append(sourceRow(index.row()));
+    }
+    
+    if (isFiltered()) {
+        for (int source : sources) {
+            filterMask.set(source, filterMatcher.matches(store, filter, filterCaseSensitivity(), source));
+        }
+    }
+    if (isSorted()) {
+        rowOrder = SortEngine::sort(store, sortKeys);
+    }
+    if (isFiltered()) {
+        rebuildVisibleRows();
+    }
+    
+    changePersistentRows(oldIndexes, oldSourceRows);
+    emit q->layoutChanged();
+}
+
+bool TableModelPrivate::setCells(const QVector<CellValue>& cells)
+{
+    Q_Q(TableModel);
+    
+    // Все значения проверяются до первой записи: пакет применяется целиком или не применяется
+    const int rows = rowCount();
+    for (const CellValue& cell : cells) {
+        if (cell.row < 0 || cell.row >= rows || cell.column < 0 || cell.column >= store.columnCount()) {
+            lastError = QString("Cell (%1, %2) is out of range").arg(cell.row).arg(cell.column);
+            return false;
+        }
+        if (!schema || cell.column >= schema->columns.size()) {
+            continue;
+        }
+        const Column& column = schema->columns[cell.column];
+        if (!column.isEditable) {
+            lastError = QString("Column '%1' is not editable").arg(column.name);
+            return false;
+        }
+        const QString validationError = q->validateValue(cell.value, column);
+        if (!validationError.isEmpty()) {
+            lastError = QString("Row %1, column '%2': %3").arg(cell.row).arg(column.name, validationError);
+            return false;
+        }
+    }
+    
+    QVector<CellValue> sourceCells = cells;
+    for (CellValue& cell : sourceCells) {
+        cell.row = sourceRow(cell.row);
+    }
+    writeCells(sourceCells);
+    return submitOnFieldChange();
+}
+
+void TableModelPrivate::writeCells(const QVector<CellValue>& cells)
+{
+    Q_Q(TableModel);
+    
+    // Видимые строки - до записи, пока перестановка согласована со значениями
+    QVector<int> views(cells.size());
+    for (int i = 0; i < cells.size(); ++i) {
+        views[i] = viewRow(cells[i].row);
+    }
+    
+    // Запись за один проход; для сигналов - охватывающий диапазон колонок каждой видимой строки
+    const bool keepBefore = editStrategy != TableModel::EditStrategy::LocalOnly || journal.isEnabled();
+    QVector<bool> changedColumns(store.columnCount(), false);
+    QMap<int, QPair<int, int>> spans;
+    QVector<int> sources;
+    for (int i = 0; i < cells.size(); ++i) {
+        const CellValue& cell = cells[i];
+        const QVariant before = keepBefore ? store.value(cell.row, cell.column) : QVariant();
+        if (!store.setValue(cell.row, cell.column, cell.value)) {
+            continue;
+        }
+        recordEdit(cell.row, cell.column, before);
+        journal.recordCell(cell.row, cell.column, before, store.value(cell.row, cell.column));
+        changedColumns[cell.column] = true;
+        sources.append(cell.row);
+        
+        if (views[i] < 0) {
+            continue;
+        }
+        auto span = spans.find(views[i]);
+        if (span == spans.end()) {
+            spans.insert(views[i], {cell.column, cell.column});
+        } else {
+            span->first = qMin(span->first, cell.column);
+            span->second = qMax(span->second, cell.column);
+        }
+    }
+    if (sources.isEmpty()) {
+        return;
+    }
+    std::sort(sources.begin(), sources.end());
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+    
+    // Зависящие от изменённых колонок вычисляемые - по непрерывным участкам строк хранилища
+    QVector<int> positions;
+    for (int column = 0; column < changedColumns.size(); ++column) {
+        if (changedColumns[column]) {
+            positions += calculation.dependents(column);
+        }
+    }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    int firstDependent = store.columnCount();
+    int lastDependent = -1;
+    for (int position : std::as_const(positions)) {
+        const int column = calculation.columns()[position].column;
+        changedColumns[column] = true;
+        firstDependent = qMin(firstDependent, column);
+        lastDependent = qMax(lastDependent, column);
+    }
+    for (int first = 0; first < sources.size();) {
+        int last = first;
+        while (last + 1 < sources.size() && sources[last + 1] == sources[last] + 1) {
+            ++last;
+        }
+        const int count = sources[last] - sources[first] + 1;
+        for (int position : std::as_const(positions)) {
+            const CalculatedColumn& entry = calculation.columns()[position];
+            expressionVM.run(entry.program, store, sources[first], count, store.column(entry.column));
+        }
+        loadLookups(sources[first], count);
+        first = last + 1;
+    }
+    
+    // Соседние строки с одинаковым диапазоном колонок объединяются в один dataChanged
+    auto notify = [&](int top, int bottom, int left, int right) {
+        emit q->dataChanged(q->index(top, qMin(left, firstDependent)), q->index(bottom, qMax(right, lastDependent)));
+    };
+    if (!spans.isEmpty()) {
+        int top = spans.firstKey();
+        int bottom = top;
+        QPair<int, int> current = spans.first();
+        for (auto it = std::next(spans.constBegin()); it != spans.constEnd(); ++it) {
+            if (it.key() == bottom + 1 && it.value() == current) {
+                bottom = it.key();
+                continue;
+            }
+            notify(top, bottom, current.first, current.second);
+            top = bottom = it.key();
+            current = it.value();
+        }
+        notify(top, bottom, current.first, current.second);
+    }
+    
+    // Порядок и видимость пересчитываются один раз на весь пакет
+    bool layoutAffected = false;
+    for (int column = 0; column < changedColumns.size(); ++column) {
+        layoutAffected = layoutAffected
+            || (changedColumns[column] && (isSortColumn(column) || (isFiltered() && filterColumns.contains(column))));
+    }
+    if (layoutAffected) {
+        relayoutRows(sources);
+    }
+}
+
+QVariantList TableModelPrivate::rowValues(int source) const
+{
+    QVariantList values;
+    values.reserve(store.columnCount());
+    for (int column = 0; column < store.columnCount(); ++column) {
+        values.append(store.value(source, column));
+    }
+    return values;
+}
+
+bool TableModelPrivate::applyJournalStep(bool redo)
+{
+    EditJournal::Step step;
+    if (!(redo ? journal.redo(step) : journal.undo(step))) {
+        return false;
+    }
+    
+    // Шаг однороден: ячейки, добавленные или удалённые строки. Откат идёт с конца шага
+    auto deltaAt = [&](int i) -> const EditJournal::Delta& {
+        return journal.delta(redo ? step.first + i : step.first + step.count - 1 - i);
+    };
+    const EditJournal::Delta& head = journal.delta(step.first);
+    if (head.column >= 0) {
+        QVector<CellValue> cells;
+        cells.reserve(step.count);
+        for (int i = 0; i < step.count; ++i) {
+            const EditJournal::Delta& delta = deltaAt(i);
+            const int source = journal.row(delta.row);
+            if (source >= 0) {
+                cells.append({source, delta.column, journal.value(redo ? delta.after : delta.before)});
+            }
+        }
+        writeCells(cells);
+    } else if ((head.before == EditJournal::kNoValue) != redo) {
+        // Откат добавления или повтор удаления
+        QVector<int> sources;
+        sources.reserve(step.count);
+        for (int i = 0; i < step.count; ++i) {
+            const int source = journal.row(deltaAt(i).row);
+            if (source >= 0) {
+                recordRemoval(source);
+                sources.append(source);
+            }
+        }
+        removeSourceRows(sources);
+    } else {
+        // Откат удаления или повтор добавления: строки возвращаются на прежние места
+        // со своими стабильными номерами (номера возрастают по строкам хранилища)
+        QVector<const EditJournal::Delta*> deltas;
+        deltas.reserve(step.count);
+        for (int i = 0; i < step.count; ++i) {
+            deltas.append(&deltaAt(i));
+        }
+        std::sort(deltas.begin(), deltas.end(), [](const EditJournal::Delta* lhs, const EditJournal::Delta* rhs) {
+            return lhs->row < rhs->row;
+        });
+        
+        QVector<int> positions;
+        QVector<quint32> ids;
+        QList<QVariantMap> rows;
+        positions.reserve(step.count);
+        ids.reserve(step.count);
+        rows.reserve(step.count);
+        for (int i = 0; i < deltas.size(); ++i) {
+            const EditJournal::Delta& delta = *deltas[i];
+            const QVariantList values = journal.values(redo ? delta.after : delta.before, store.columnCount());
+            QVariantMap row;
+            for (int column = 0; column < values.size(); ++column) {
+                row.insert(schema->columns[column].name, values[column]);
+            }
+            positions.append(journal.position(delta.row) + i);
+            ids.append(delta.row);
+            rows.append(row);
+        }
+        insertSourceRows(positions, rows, ids);
+        
+        if (editStrategy != TableModel::EditStrategy::LocalOnly) {
+            for (int source : std::as_const(positions)) {
+                edits.recordRestore(source, keyString(primaryKey(source)), store.rowMap(source));
+            }
+        }
+    }
+    
+    return submitOnFieldChange();
+}
+
+void TableModelPrivate::compileCalculatedColumns()
+{
+    calculation.clear();
+    if (!schema) {
+        return;
+    }
+    
+    // Схемы из файлов проверены при разборе; ошибка возможна только у схемы, собранной в коде
+    QStringList errors;
+    if (!calculation.build(schema->columns, errors)) {
+        qWarning() << "Calculated columns are disabled:" << errors;
+    }
+}
+
+void TableModelPrivate::computeCalculatedColumns(int first, int count)
+{
+    for (const CalculatedColumn& entry : calculation.columns()) {
+        expressionVM.run(entry.program, store, first, count, store.column(entry.column));
+    }
+}
+
+QVector<int> TableModelPrivate::recalculateDependents(int source, int column)
+{
+    QVector<int> columns;
+    const QVector<CalculatedColumn>& entries = calculation.columns();
+    for (int position : calculation.dependents(column)) {
+        const CalculatedColumn& entry = entries[position];
+        expressionVM.run(entry.program, store, source, 1, store.column(entry.column));
+        columns.append(entry.column);
+    }
+    return columns;
+}
+
+void TableModelPrivate::bindLookups()
+{
+    lookups.clear();
+    if (!schema) {
+        return;
+    }
+    
+    for (int i = 0; i < schema->columns.size(); ++i) {
+        const Column& column = schema->columns[i];
+        if (!column.referenceTable.isEmpty() && !column.referenceColumn.isEmpty() && !column.displayColumn.isEmpty()) {
+            lookups.resize(schema->columns.size());
+            lookups[i] = LookupCache::instance().table(column.referenceTable, column.referenceColumn,
+                                                       column.displayColumn);
+        }
+    }
+}
+
+static void runLookupLoads(const QVector<LookupLoad>& loads, const QueryHandler& handler)
+{
+    for (const LookupLoad& load : loads) {
+        QString error;
+        const bool ok = load.all ? load.table->loadAll(handler, &error)
+                                 : load.table->loadKeys(handler, load.keys, &error);
+        // Без справочника колонка показывает сам ключ
+        if (!ok) {
+            qWarning() << "Lookup" << load.table->table << ":" << error;
+        }
+    }
+}
+
+void TableModelPrivate::loadLookups(int first, int count, const QString& table)
+{
+    if (lookups.isEmpty() || count <= 0) {
+        return;
+    }
+    
+    // Ключи читаются из хранилища здесь, в потоке модели; источник опрашивается с копиями
+    QVector<LookupLoad> loads;
+    for (int i = 0; i < lookups.size(); ++i) {
+        const std::shared_ptr<LookupTable>& lookup = lookups[i];
+        if (!lookup || (!table.isEmpty() && lookup->table != table)) {
+            continue;
+        }
+        
+        LookupLoad load{i, lookup, schema->columns[i].referenceLoading == ReferenceLoading::All, {}};
+        if (!load.all) {
+            load.keys.reserve(count);
+            for (int row = first; row < first + count; ++row) {
+                load.keys.append(store.value(row, i));
+            }
+        }
+        loads.append(load);
+    }
+    if (loads.isEmpty()) {
+        return;
+    }
+    
+    const QueryHandler handler = queryHandler ? queryHandler : SqlQueryHandlerFactory::getHandler(database);
+    if (!deferLookups) {
+        runLookupLoads(loads, handler);
+        return;
+    }
+    
+    auto* watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, loads]() {
+        watcher->deleteLater();
+        lookupsLoaded(loads);
+    });
+    watcher->setFuture(QtConcurrent::run([loads, handler]() {
+        runLookupLoads(loads, handler);
+    }));
+}
+
+void TableModelPrivate::lookupsLoaded(const QVector<LookupLoad>& loads)
+{
+    Q_Q(TableModel);
+    
+    if (rowCount() == 0) {
+        return;
+    }
+    for (const LookupLoad& load : loads) {
+        // Колонки могли смениться перезагрузкой схемы
+        if (load.column < lookups.size() && lookups[load.column] == load.table) {
+            emit q->dataChanged(q->index(0, load.column), q->index(rowCount() - 1, load.column), {Qt::DisplayRole});
+        }
+    }
+}
+
+QVariant TableModelPrivate::lookupDisplay(const QVariant& value, int column) const
+{
+    QVariant display;
+    if (column < lookups.size() && lookups[column] && lookups[column]->lookup(value, display)) {
+        return display;
+    }
+    return processColumnValue(value, column);
+}
+
+QVariantMap TableModelPrivate::primaryKey(int source) const
+{
+    QVariantMap key;
+    for (const QString& name : schema->primaryKeyColumns) {
+        key.insert(name, store.value(source, schema->columnIndex(name)));
+    }
+    return key;
+}
+
+QString TableModelPrivate::keyString(const QVariantMap& key) const
+{
+    QStringList parts;
+    parts.reserve(schema->primaryKeyColumns.size());
+    for (const QString& name : schema->primaryKeyColumns) {
+        parts.append(key.value(name).toString());
+    }
+    return parts.join(QChar(0x1F));
+}
+
+void TableModelPrivate::recordEdit(int source, int column, const QVariant& before)
+{
+    if (editStrategy == TableModel::EditStrategy::LocalOnly) {
+        return;
+    }
+    
+    const QString& name = schema->columns[column].name;
+    if (edits.contains(source)) {
+        edits.recordUpdate(source, QString(), QVariantMap(), name, before);
+    } else {
+        // Правка ключевой колонки: строка в источнике ищется по прежнему ключу
+        QVariantMap key = primaryKey(source);
+        if (key.contains(name)) {
+            key.insert(name, before);
+        }
+        edits.recordUpdate(source, keyString(key), key, name, before);
+    }
+    
+    // Значение, вернувшееся к исходному (повторная правка, отмена), в источник не пишется
+    edits.dropUnchanged(source, name, store.value(source, column));
+}
+
+void TableModelPrivate::recordRemoval(int source)
+{
+    if (editStrategy == TableModel::EditStrategy::LocalOnly) {
+        return;
+    }
+    
+    const QVariantMap key = primaryKey(source);
+    edits.recordRemove(source, keyString(key), key, store.rowMap(source),
+                       journal.isEnabled() ? journal.rowId(source) : 0);
+}
+
+void TableModelPrivate::removeSourceRows(QVector<int> sources)
+{
+    Q_Q(TableModel);
+    
+    std::sort(sources.begin(), sources.end());
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+    if (sources.isEmpty()) {
+        return;
+    }
+    
+    // Строка хранилища -> строка после удаления (-1 - удаляется)
+    const int total = store.rowCount();
+    QVector<int> newRows(total);
+    for (int source = 0, removed = 0; source < total; ++source) {
+        if (removed < sources.size() && sources[removed] == source) {
+            newRows[source] = -1;
+            ++removed;
+        } else {
+            newRows[source] = source - removed;
+        }
+    }
+    
+    // Видимые позиции удаляемых строк (скрытые фильтром строки сигналов не требуют)
+    QVector<int> positions;
+    const int count = rowCount();
+    for (int row = 0; row < count; ++row) {
+        if (newRows[sourceRow(row)] < 0) {
+            positions.append(row);
+        }
+    }
+    int groups = 0;
+    for (int i = 0; i < positions.size(); ++i) {
+        if (i == 0 || positions[i] != positions[i - 1] + 1) {
+            ++groups;
+        }
+    }
+    
+    // Группы удаляются с конца, чтобы позиции предыдущих не сдвигались
+    auto forEachGroup = [&positions](const auto& fn) {
+        for (int last = positions.size() - 1; last >= 0;) {
+            int first = last;
+            while (first > 0 && positions[first - 1] == positions[first] - 1) {
+                --first;
+            }
+            fn(first, last);
+            last = first - 1;
+        }
+    };
+    
+    // Строки, на которые ссылаются буфер правок и незавершённые запросы
+    auto remapReferences = [this, &newRows]() {
+        edits.remapRows(newRows);
+        journal.remapRows(newRows);
+        for (AsyncOperation* operation : std::as_const(activeOperations)) {
+            LocalEffect& effect = operation->effect;
+            if (effect.type != QueryEffect::Remove && effect.row >= 0 && effect.row < newRows.size()) {
+                effect.row = newRows[effect.row];
+            } else if (effect.type == QueryEffect::Remove && effect.row >= 0) {
+                // Место возврата удалённой запросом строки - за последней оставшейся строкой перед ним
+                int before = qMin(effect.row, int(newRows.size()));
+                while (before > 0 && newRows[before - 1] < 0) {
+                    --before;
+                }
+                effect.row = before > 0 ? newRows[before - 1] + 1 : 0;
+            }
+        }
+    };
+    
+    const bool reset = groups > kMaxInsertGroups;
+    if (!reset && !isSorted() && !isFiltered()) {
+        // Видимая строка совпадает со строкой хранилища
+        forEachGroup([&](int first, int last) {
+            q->beginRemoveRows(QModelIndex(), positions[first], positions[last]);
+            store.removeRows(QVector<int>(positions.cbegin() + first, positions.cbegin() + last + 1));
+            q->endRemoveRows();
+        });
+        remapReferences();
+        return;
+    }
+    
+    if (reset) {
+        q->beginResetModel();
+    } else {
+        // Сначала из видимой перестановки; хранилище пока не тронуто, номера в ней валидны
+        QVector<int>& visible = isFiltered() ? visibleRows : rowOrder;
+        forEachGroup([&](int first, int last) {
+            q->beginRemoveRows(QModelIndex(), positions[first], positions[last]);
+            visible.remove(positions[first], positions[last] - positions[first] + 1);
+            q->endRemoveRows();
+        });
+    }
+    
+    // Хранилище сжимается за один проход, перестановки переводятся на новые номера
+    store.removeRows(sources);
+    auto remap = [&newRows](QVector<int>& order) {
+        int write = 0;
+        for (int source : std::as_const(order)) {
+            if (newRows[source] >= 0) {
+                order[write++] = newRows[source];
+            }
+        }
+        order.resize(write);
+    };
+    remap(rowOrder);
+    remap(visibleRows);
+    if (isFiltered()) {
+        filterMask = RowBitmap(store.rowCount());
+        for (int source : std::as_const(visibleRows)) {
+            filterMask.set(source);
+        }
+    }
+    remapReferences();
+    
+    if (reset) {
+        q->endResetModel();
+    }
+}
+
+void TableModelPrivate::insertSourceRows(const QVector<int>& positions, const QList<QVariantMap>& rows,
+                                         const QVector<quint32>& ids)
+{
+    Q_Q(TableModel);
+    
+    if (positions.isEmpty()) {
+        return;
+    }
+    
+    // Строка хранилища -> строка после вставки
+    const int total = store.rowCount();
+    QVector<int> newRows(total);
+    for (int source = 0, inserted = 0; source < total; ++source) {
+        while (inserted < positions.size() && positions[inserted] <= source + inserted) {
+            ++inserted;
+        }
+        newRows[source] = source + inserted;
+    }
+    
+    // Группы подряд идущих мест: [first, last] в positions
+    QVector<QPair<int, int>> groups;
+    for (int i = 0; i < positions.size(); ++i) {
+        if (i == 0 || positions[i] != positions[i - 1] + 1) {
+            groups.append({i, i});
+        } else {
+            groups.last().second = i;
+        }
+    }
+    
+    auto prepareGroup = [this, &positions](const QPair<int, int>& group) {
+        const int count = group.second - group.first + 1;
+        computeCalculatedColumns(positions[group.first], count);
+        loadLookups(positions[group.first], count);
+    };
+    
+    auto remapReferences = [this, &newRows, &positions, &ids]() {
+        edits.remapRows(newRows);
+        journal.insertRows(positions, ids);
+        for (AsyncOperation* operation : std::as_const(activeOperations)) {
+            LocalEffect& effect = operation->effect;
+            if (effect.row >= 0 && effect.row < newRows.size()) {
+                effect.row = newRows[effect.row];
+            } else if (effect.type == QueryEffect::Remove && effect.row >= 0) {
+                effect.row += int(positions.size()); // место возврата в конце хранилища
+            }
+        }
+    };
+    
+    if (!isSorted() && !isFiltered() && groups.size() <= kMaxInsertGroups) {
+        // Видимая строка совпадает со строкой хранилища; группы вставляются по возрастанию,
+        // места следующих групп уже учитывают предыдущие
+        for (const QPair<int, int>& group : std::as_const(groups)) {
+            q->beginInsertRows(QModelIndex(), positions[group.first], positions[group.second]);
+            store.insertRows(positions.mid(group.first, group.second - group.first + 1),
+                             rows.mid(group.first, group.second - group.first + 1));
+            prepareGroup(group);
+            q->endInsertRows();
+        }
+        remapReferences();
+        return;
+    }
+    
+    const bool reset = !isSorted() && !isFiltered();
+    if (reset) {
+        q->beginResetModel();
+    }
+    
+    // Вернувшиеся строки не видны, пока не попали в перестановку
+    store.insertRows(positions, rows);
+    for (const QPair<int, int>& group : std::as_const(groups)) {
+        prepareGroup(group);
+    }
+    for (int& source : rowOrder) {
+        source = newRows[source];
+    }
+    for (int& source : visibleRows) {
+        source = newRows[source];
+    }
+    remapReferences();
+    
+    if (reset) {
+        q->endResetModel();
+        return;
+    }
+    
+    QVector<int> added = positions;
+    if (isSorted()) {
+        SortEngine::sortRows(store, sortKeys, added);
+    }
+    
+    if (!isFiltered()) {
+        insertIntoOrder(rowOrder, added);
+        return;
+    }
+    
+    // Полный порядок обновляется без сигналов, видимые - только прошедшие фильтр
+    if (isSorted()) {
+        mergeIntoOrder(rowOrder, added);
+    }
+    filterMask = RowBitmap(store.rowCount());
+    for (int source : std::as_const(visibleRows)) {
+        filterMask.set(source);
+    }
+    FilterEngine::filterRows(store, filter, filterCaseSensitivity(), added);
+    for (int source : std::as_const(added)) {
+        filterMask.set(source);
+    }
+    insertIntoOrder(visibleRows, added);
+}
+
+bool TableModelPrivate::submitEdits()
+{
+    if (edits.isEmpty()) {
+        return true;
+    }
+    if (schema->primaryKeyColumns.isEmpty()) {
+        lastError = "Schema has no primary key: edits cannot be submitted";
+        return false;
+    }
+    
+    // Значения вычисляемых колонок в источник не пишутся
+    auto storedValues = [this](int source) {
+        QVariantMap values = store.rowMap(source);
+        for (const CalculatedColumn& entry : calculation.columns()) {
+            values.remove(schema->columns[entry.column].name);
+        }
+        return values;
+    };
+    
+    QueryBatchStep removes{kRemoveQuery, QString(), {}};
+    QueryBatchStep updates{kUpdateQuery, QString(), {}};
+    QueryBatchStep inserts{kInsertQuery, QString(), {}};
+    QVector<int> insertedRows;
+    const QForge::Query update = schema->queries.value(kUpdateQuery);
+    for (const EditBuffer::RowChange& change : edits.entries()) {
+        switch (change.state) {
+            case EditBuffer::RowState::Removed:
+                removes.bindings.append(change.key);
+                break;
+            
+            case EditBuffer::RowState::Inserted: {
+                const QVariantMap values = storedValues(change.row);
+                // Ключ, которого у строки нет, выдаёт источник: его нужно прочитать обратно
+                for (const QString& column : schema->primaryKeyColumns) {
+                    if (values.value(column).isNull()) {
+                        inserts.returning = schema->primaryKeyColumns;
+                    }
+                }
+                inserts.bindings.append(values);
+                insertedRows.append(change.row);
+                break;
+            }
+            
+            case EditBuffer::RowState::Updated: {
+                QVariantMap values = storedValues(change.row);
+                values.insert(change.key);
+                if (!update.arguments.isEmpty()) {
+                    // Необязательные аргументы передаются только для изменённых колонок
+                    // (SET x = COALESCE(${x}, x)), обязательные - всегда
+                    QVariantMap arguments;
+                    for (const QueryArgument& argument : update.arguments) {
+                        const bool changed = change.original.contains(argument.name) || change.key.contains(argument.name);
+                        arguments.insert(argument.name, changed || !argument.isOptional ? values.value(argument.name) : QVariant());
+                    }
+                    values = arguments;
+                }
+                updates.bindings.append(values);
+                break;
+            }
+        }
+    }
+    
+    // Удаления, изменения, добавления - одним пакетом
+    QueryContext context;
+    context.queryName = kCommitQueryName;
+    QVector<EditBuffer::RowState> stepStates;
+    for (QueryBatchStep* step : {&removes, &updates, &inserts}) {
+        if (step->bindings.isEmpty()) {
+            continue;
+        }
+        if (!schema->queries.contains(step->queryName)) {
+            lastError = QString("Query '%1' not found").arg(step->queryName);
+            return false;
+        }
+        const QForge::Query& query = schema->queries[step->queryName];
+        step->sql = query.sql;
+        if (!query.arguments.isEmpty() && step != &updates) {
+            for (QVariantMap& values : step->bindings) {
+                QVariantMap arguments;
+                for (const QueryArgument& argument : query.arguments) {
+                    arguments.insert(argument.name, values.value(argument.name));
+                }
+                values = arguments;
+            }
+        }
+        context.transactional = context.transactional || query.isTransactional;
+        context.batch.append(*step);
+        stepStates.append(step == &removes ? EditBuffer::RowState::Removed
+                          : step == &updates ? EditBuffer::RowState::Updated
+                                             : EditBuffer::RowState::Inserted);
+    }
+    
+    const QueryResult result = runQuery(context);
+    const int completed = result.ok ? int(context.batch.size())
+                                    : qBound(0, result.completedSteps, int(context.batch.size()));
+    
+    // Сгенерированные ключи добавленных строк: по строке результата на строку пакета.
+    // Запись - как у ответа источника на запрос: сигналы, место строки, вычисляемые колонки
+    if (!inserts.returning.isEmpty() && completed > 0 && stepStates[completed - 1] == EditBuffer::RowState::Inserted) {
+        for (int i = 0; i < insertedRows.size() && i < result.rows.size(); ++i) {
+            updateRow(insertedRows[i], result.rows[i]);
+            keyRows.insert(keyString(primaryKey(insertedRows[i])), insertedRows[i]);
+        }
+    }
+    
+    if (!result.ok) {
+        // Записанные шаги нетранзакционного пакета из буфера уходят, остальные ждут повтора
+        lastError = result.errors_log.join("; ");
+        for (int i = 0; i < completed; ++i) {
+            edits.dropState(stepStates[i]);
+        }
+        return false;
+    }
+    
+    edits.clear();
+    return true;
+}
+
+bool TableModelPrivate::submitOnFieldChange()
+{
+    if (editStrategy != TableModel::EditStrategy::OnFieldChange || submitEdits()) {
+        return true;
+    }
+    // Правка, которую источник не принял, в модели не остаётся
+    revertEdits();
+    return false;
+}
+
+void TableModelPrivate::revertEdits()
+{
+    Q_Q(TableModel);
+    
+    if (edits.isEmpty()) {
+        return;
+    }
+    
+    // Шаги журнала относятся к отброшенным правкам
+    journal.clear();
+    
+    QVector<int> inserted;
+    QVector<EditBuffer::RowChange> removed;
+    QVector<QPair<int, QVector<int>>> restored; // строка хранилища -> изменившиеся колонки
+    for (const EditBuffer::RowChange& change : edits.entries()) {
+        switch (change.state) {
+            case EditBuffer::RowState::Inserted:
+                inserted.append(change.row);
+                break;
+            
+            case EditBuffer::RowState::Removed:
+                removed.append(change);
+                break;
+            
+            case EditBuffer::RowState::Updated: {
+                QVector<int> columns;
+                for (auto it = change.original.constBegin(); it != change.original.constEnd(); ++it) {
+                    const int column = schema->columnIndex(it.key());
+                    if (column >= 0 && store.setValue(change.row, column, it.value())) {
+                        columns.append(column);
+                        columns += recalculateDependents(change.row, column);
+                    }
+                }
+                if (!columns.isEmpty()) {
+                    loadLookups(change.row, 1);
+                    restored.append({change.row, columns});
+                }
+                break;
+            }
+        }
+    }
+    edits.clear();
+    
+    if (!restored.isEmpty() && !isSorted() && !isFiltered()) {
+        for (const auto& [source, columns] : std::as_const(restored)) {
+            const auto [first, last] = std::minmax_element(columns.cbegin(), columns.cend());
+            emit q->dataChanged(q->index(source, *first), q->index(source, *last));
+        }
+    } else if (!restored.isEmpty()) {
+        int firstColumn = store.columnCount();
+        int lastColumn = -1;
+        QVector<int> sources;
+        sources.reserve(restored.size());
+        for (const auto& [source, columns] : std::as_const(restored)) {
+            for (int column : columns) {
+                firstColumn = qMin(firstColumn, column);
+                lastColumn = qMax(lastColumn, column);
+            }
+            sources.append(source);
+        }
+        relayoutRows(sources);
+        if (rowCount() > 0) {
+            emit q->dataChanged(q->index(0, firstColumn), q->index(rowCount() - 1, lastColumn));
+        }
+    }
+    
+    // Удалённые строки возвращаются на места, которые занимали до правок
+    std::sort(removed.begin(), removed.end(), [](const EditBuffer::RowChange& lhs, const EditBuffer::RowChange& rhs) {
+        return lhs.position < rhs.position;
+    });
+    QVector<int> positions;
+    QList<QVariantMap> rows;
+    QVector<quint32> ids;
+    const int remaining = store.rowCount() - int(inserted.size());
+    for (const EditBuffer::RowChange& change : std::as_const(removed)) {
+        const int previous = positions.isEmpty() ? -1 : positions.last();
+        positions.append(qBound(previous + 1, change.position, remaining + int(positions.size())));
+        rows.append(change.values);
+        ids.append(change.rowId);
+    }
+    
+    removeSourceRows(inserted);
+    insertSourceRows(positions, rows, ids);
+}
+
+QString TableModelPrivate::formatErrorMessage(const QString& error) const
+{
+    if (!schema) return error;
+    
+    QString message = schema->defaultErrorHandling.message;
+    message.replace("${last_error}", error);
+    
+    return message;
+}
+
+bool TableModelPrivate::reloadSchema(bool force)
+{
+    if (!modelCore || !isInitialized) {
+        return false;
+    }
+    
+    // Принудительно файл перечитывается в реестре; иначе - только если изменился
+    QStringList errors;
+    if (force && !SchemaRegistry::instance().reload(schemaPath, &errors)) {
+        lastError = errors.join("; ");
+        return false;
+    }
+    if (!modelCore->refresh(&errors)) {
+        lastError = errors.join("; ");
+        return false;
+    }
+    
+    applySchema(modelCore->sharedSchema());
+    return true;
+}
+
+void TableModelPrivate::applySchema(const std::shared_ptr<const ModelSchema>& next)
+{
+    Q_Q(TableModel);
+    
+    if (!next || next == schema) {
+        return;
+    }
+    
+    // Колонки меняются по шагам на рабочей копии схемы: между сигналами
+    // columnCount() и headerData() согласованы с хранилищем
+    auto working = std::make_shared<ModelSchema>(*schema);
+    schema = working;
+    journal.clear(); // строки журнала записаны по прежним колонкам
+    
+    QStringList target;
+    for (const Column& column : next->columns) {
+        target.append(column.name);
+    }
+    QStringList sortColumns;
+    for (const SortKey& key : std::as_const(sortKeys)) {
+        sortColumns.append(working->columns[key.column].name);
+    }
+    QStringList touched; //!< Удалённые колонки и колонки со сменой типа.
+    
+    // Удаление
+    for (int i = working->columns.size() - 1; i >= 0; --i) {
+        if (target.contains(working->columns[i].name)) {
+            continue;
+        }
+        touched.append(working->columns[i].name);
+        q->beginRemoveColumns(QModelIndex(), i, i);
+        working->columns.remove(i);
+        working->rebuildColumnIndex();
+        store.removeColumn(i);
+        q->endRemoveColumns();
+    }
+    
+    // Перемещение: колонки из наибольшей возрастающей подпоследовательности остаются
+    // на местах, каждая из остальных переносится один раз - вслед за предшественницей
+    QStringList current;
+    for (const Column& column : std::as_const(working->columns)) {
+        current.append(column.name);
+    }
+    QStringList order;
+    for (const QString& name : std::as_const(target)) {
+        if (current.contains(name)) {
+            order.append(name);
+        }
+    }
+    QVector<int> positions;
+    for (const QString& name : std::as_const(current)) {
+        positions.append(order.indexOf(name));
+    }
+    const QVector<bool> kept = increasingSubsequence(positions);
+    QSet<QString> staying;
+    for (int i = 0; i < current.size(); ++i) {
+        if (kept[i]) {
+            staying.insert(current[i]);
+        }
+    }
+    for (int t = 0; t < order.size(); ++t) {
+        if (staying.contains(order[t])) {
+            continue;
+        }
+        const int from = current.indexOf(order[t]);
+        int to = (t == 0) ? 0 : current.indexOf(order[t - 1]) + 1;
+        if (to > from) {
+            --to;
+        }
+        if (to == from) {
+            continue;
+        }
+        q->beginMoveColumns(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+        working->columns.move(from, to);
+        working->rebuildColumnIndex();
+        store.moveColumn(from, to);
+        current.move(from, to);
+        q->endMoveColumns();
+    }
+    
+    // Вставка: оставшиеся колонки уже идут в порядке новой схемы
+    for (int t = 0; t < target.size(); ++t) {
+        if (current.value(t) == target[t]) {
+            continue;
+        }
+        q->beginInsertColumns(QModelIndex(), t, t);
+        working->columns.insert(t, next->columns[t]);
+        working->rebuildColumnIndex();
+        store.insertColumn(t, next->columns[t]);
+        current.insert(t, target[t]);
+        q->endInsertColumns();
+    }
+    
+    // Изменения описаний колонок: тип приводится в хранилище, остальное - только отображение
+    int headerFirst = -1;
+    int headerLast = -1;
+    int dataFirst = -1;
+    int dataLast = -1;
+    auto extend = [](int& first, int& last, int column) {
+        first = (first < 0) ? column : qMin(first, column);
+        last = qMax(last, column);
+    };
+    for (int i = 0; i < next->columns.size(); ++i) {
+        const Column& before = working->columns[i];
+        const Column& after = next->columns[i];
+        if (before.type != after.type) {
+            store.retypeColumn(i, after.type);
+            touched.append(after.name);
+        }
+        if (before.displayName != after.displayName) {
+            extend(headerFirst, headerLast, i);
+        }
+        if (before.type != after.type || before.format != after.format
+            || before.nullDisplayText != after.nullDisplayText || before.alignment != after.alignment
+            || before.tooltip != after.tooltip || before.isEditable != after.isEditable
+            || before.referenceTable != after.referenceTable || before.referenceColumn != after.referenceColumn
+            || before.displayColumn != after.displayColumn) {
+            extend(dataFirst, dataLast, i);
+        }
+    }
+    
+    const bool horizontalChanged = !(working->horizontalHeaders == next->horizontalHeaders);
+    const bool verticalChanged = !(working->verticalHeaders == next->verticalHeaders);
+    schema = next;
+    
+    // Выражения ссылаются на индексы колонок: компилируются заново, значения пересчитываются
+    compileCalculatedColumns();
+    computeCalculatedColumns(0, store.rowCount());
+    bindLookups();
+    loadLookups(0, store.rowCount());
+    for (const CalculatedColumn& entry : calculation.columns()) {
+        extend(dataFirst, dataLast, entry.column);
+        touched.append(schema->columns[entry.column].name);
+    }
+    
+    if (horizontalChanged && !schema->columns.isEmpty()) {
+        headerFirst = 0;
+        headerLast = schema->columns.size() - 1;
+    }
+    if (headerFirst >= 0) {
+        emit q->headerDataChanged(Qt::Horizontal, headerFirst, headerLast);
+    }
+    if (verticalChanged && rowCount() > 0) {
+        emit q->headerDataChanged(Qt::Vertical, 0, rowCount() - 1);
+    }
+    if (dataFirst >= 0 && rowCount() > 0) {
+        emit q->dataChanged(q->index(0, dataFirst), q->index(rowCount() - 1, dataLast));
+    }
+    
+    // Ключи сортировки и колонки фильтра пересчитываются по именам; порядок строк
+    // строится заново, только если затронута колонка, по которой он построен
+    bool resort = false;
+    QVector<SortKey> remapped;
+    for (int k = 0; k < sortKeys.size(); ++k) {
+        SortKey key = sortKeys[k];
+        key.column = store.columnIndex(sortColumns[k]);
+        resort = resort || key.column < 0 || touched.contains(sortColumns[k]);
+        remapped.append(key);
+    }
+    if (!resort) {
+        sortKeys = remapped;
+    }
+    applySort(schema->isSortingEnabled ? sortRules : QVector<SortRule>(), resort);
+    
+    filterColumns = FilterEngine::columns(store, filter);
+    bool refilter = false;
+    auto check = [&](const FilterRule& rule) {
+        refilter = refilter || touched.contains(rule.columnName);
+    };
+    std::for_each(filter.rules.cbegin(), filter.rules.cend(), check);
+    for (const FilterGroup& group : std::as_const(filter.groups)) {
+        std::for_each(group.rules.cbegin(), group.rules.cend(), check);
+    }
+    if (refilter && isFiltered() && !filterPushedDown) {
+        applyFilter(filter, true);
+    }
+    
+    emit q->schemaReloaded();
+}
+
+void TableModelPrivate::setSchemaWatching(bool enabled)
+{
+    if (enabled == (schemaWatcher != nullptr)) {
+        return;
+    }
+    
+    if (!enabled) {
+        QObject::disconnect(&SchemaRegistry::instance(), nullptr, this, nullptr);
+        delete schemaWatcher;
+        delete schemaTimer;
+        schemaWatcher = nullptr;
+        schemaTimer = nullptr;
+        return;
+    }
+    
+    // Серия изменений файла (редактор пишет его в несколько приёмов) даёт одну перезагрузку
+    schemaTimer = new QTimer(this);
+    schemaTimer->setSingleShot(true);
+    schemaTimer->setInterval(kSchemaReloadDelayMs);
+    connect(schemaTimer, &QTimer::timeout, this, [this] { reloadSchema(false); });
+    
+    // Каталог отслеживается, чтобы заметить замену файла (запись во временный и переименование)
+    schemaWatcher = new QFileSystemWatcher(this);
+    schemaWatcher->addPath(QFileInfo(schemaPath).absolutePath());
+    schemaWatcher->addPath(schemaPath);
+    connect(schemaWatcher, &QFileSystemWatcher::fileChanged, this, &TableModelPrivate::onSchemaFileChanged);
+    connect(schemaWatcher, &QFileSystemWatcher::directoryChanged, this, &TableModelPrivate::onSchemaFileChanged);
+    
+    // Схему файла могли перезагрузить и другие модели
+    connect(&SchemaRegistry::instance(), &SchemaRegistry::reloaded, this, &TableModelPrivate::onSchemaReloaded);
+}
+
+void TableModelPrivate::onSchemaFileChanged()
+{
+    // Заменённый или удалённый файл пропадает из наблюдения
+    if (QFileInfo::exists(schemaPath) && !schemaWatcher->files().contains(schemaPath)) {
+        schemaWatcher->addPath(schemaPath);
+    }
+    schemaTimer->start();
+}
+
+void TableModelPrivate::onSchemaReloaded(const QString& path)
+{
+    if (path == schemaPath) {
+        reloadSchema(false);
+    }
+}
+
+void TableModelPrivate::onLookupInvalidated(const QString& table)
+{
+    Q_Q(TableModel);
+    
+    // Справочник общий: первая модель загружает его заново, остальные получают готовый;
+    // справочники других таблиц не трогаются
+    loadLookups(0, store.rowCount(), table);
+    for (int i = 0; i < lookups.size(); ++i) {
+        if (lookups[i] && (table.isEmpty() || lookups[i]->table == table) && rowCount() > 0) {
+            emit q->dataChanged(q->index(0, i), q->index(rowCount() - 1, i), {Qt::DisplayRole});
+        }
+    }
 }
 
 QVariant TableModelPrivate::processColumnValue(const QVariant& value, int columnIndex) const
@@ -2,29 +2,76 @@
 
 #include <QObject>
 #include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QUuid>
 #include <QHash>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QFileSystemWatcher>
 #include <QTimer>
 #include <QVariantMap>
 #include <QStringList>
 
+#include <atomic>
+
 #include "ModelCore.h"
 #include "ModelSchema.h"
+#include "ColumnStore.h"
+#include "EditBuffer.h"
+#include "EditJournal.h"
+#include "ExportWriter.h"
+#include "Expression.h"
+#include "LookupCache.h"
+#include "SortEngine.h"
+#include "FilterEngine.h"
 #include "../QueryHandler.hpp"
 #include "../QueryResult.hpp"
 #include "../QueryContext.hpp"
+#include "../TableModel.h"
 
 namespace QForge {
 namespace nsModel {
 
 class TableModel;
 
+/*!
+ * \brief Изменение, применённое к модели до ответа источника (Query::effect).
+ * \details Хранит всё, что нужно для отката: строку хранилища и прежние значения.
+ */
+struct LocalEffect {
+    QueryEffect type = QueryEffect::None;
+    int row = -1;         //!< Строка хранилища (у Remove - место возврата); -1 - строки нет в модели (применять нечего).
+    QVariantMap previous; //!< Update - прежние значения изменённых колонок, Remove - вся строка.
+    quint32 rowId = 0;    //!< Remove - стабильный номер строки в журнале отмены.
+};
+
+//! Сколько раз фильтр модели выполнил источник запроса и сколько - сама модель.
+struct FilterPushDownCount {
+    int pushedDown = 0;
+    int local = 0;
+};
+
+//! Значение ячейки для пакетной записи; row - видимая строка.
+struct CellValue {
+    int row;
+    int column;
+    QVariant value;
+};
+
+//! Загрузка справочника колонки: таблица целиком или ключи строк.
+struct LookupLoad {
+    int column;
+    std::shared_ptr<LookupTable> table;
+    bool all;
+    QVariantList keys;
+};
+
 struct AsyncOperation {
     QUuid id;
     QString queryName;
     QVariantMap params;
+    QueryContext context; //!< Контекст, собранный при запуске (с фильтром модели).
+    LocalEffect effect;   //!< Применённое при запуске изменение записывающего запроса.
     QFuture<QueryResult> future;
     QFutureWatcher<QueryResult>* watcher;
     
@@ -50,7 +97,20 @@ public:
     // K?>;=5=85 70?@>A>2
     QueryResult executeQuery(const QString& queryName, const QVariantMap& params);
     QueryResult executeSqlQuery(const QueryContext& context);
+    bool prepareSqlQuery(const QueryContext& context, QSqlQuery& query, bool& filterApplied, QString& error); //!< Подставляет параметры и фильтр, выполняет запрос.
     QUuid executeQueryAsync(const QString& queryName, const QVariantMap& params);
+    bool prepareQuery(const QString& queryName, const QVariantMap& params,
+                      QueryContext& context, QueryResult& result) const;
+    QueryResult runQuery(const QueryContext& context); //!< Только обработчик/БД; не трогает модель.
+    void finishQuery(const QueryContext& context, const QueryResult& result);
+    bool isSelectQuery(const QString& queryName) const; //!< is_read_only, без effect и не INSERT/UPDATE/DELETE.
+    
+    // Локальное применение записывающих запросов (Query::effect)
+    LocalEffect applyEffect(const QString& queryName, const QVariantMap& params);
+    void finishEffect(const LocalEffect& effect, const QueryResult& result); //!< Подтверждает или откатывает.
+    void updateRow(int source, const QVariantMap& values);
+    int findSourceRow(const QVariantMap& key); //!< Строка хранилища по первичному ключу или -1.
+    int viewRow(int source) const;             //!< Видимая строка по строке хранилища или -1.
     
     // #?@02;5=85 40==K<8
     void updateModelData(const QueryResult& result);
@@ -60,8 +120,83 @@ public:
     QString formatErrorMessage(const QString& error) const;
     QVariant processColumnValue(const QVariant& value, int columnIndex) const;
 
+    // Отображение видимых строк на строки хранилища
+    bool isSorted() const { return !sortKeys.isEmpty(); }
+    bool isFiltered() const { return !filter.isEmpty(); }
+    int rowCount() const {
+        return isFiltered() ? visibleRows.size() : (isSorted() ? rowOrder.size() : store.rowCount());
+    }
+    int sourceRow(int row) const {
+        return isFiltered() ? visibleRows[row] : (isSorted() ? rowOrder[row] : row);
+    }
+    int compareRows(int lhs, int rhs) const;
+    void changePersistentRows(const QModelIndexList& indexes, const QVector<int>& sources);
+
+    // Сортировка
+    bool isSortColumn(int column) const;
+    void applySort(const QVector<SortRule>& rules, bool force = false);
+
+    // Фильтрация
+    Qt::CaseSensitivity filterCaseSensitivity() const;
+    bool applyFilter(const Filter& newFilter, bool force = false);
+    void rebuildVisibleRows();
+    
+    // Инкрементальное поддержание порядка
+    void appendRows(const QList<QVariantMap>& rows);
+    void mergeIntoOrder(QVector<int>& order, const QVector<int>& added) const;
+    void insertIntoOrder(QVector<int>& order, const QVector<int>& added);
+    void repositionRow(QVector<int>& order, int row, bool notify);
+    void rowChanged(int row, const QVector<int>& columns);
+    void relayoutRows(const QVector<int>& sources); //!< Место и видимость строк хранилища одной сменой раскладки.
+    
+    // Пакетная запись ячеек (вставка блока)
+    bool setCells(const QVector<CellValue>& cells);   //!< Видимые строки; проверка и запись.
+    void writeCells(const QVector<CellValue>& cells); //!< Строки хранилища; без проверки.
+    
+    // Отмена и повтор правок
+    QVariantList rowValues(int source) const;
+    bool applyJournalStep(bool redo);
+    
+    // Потоковая выгрузка (export_settings)
+    bool exportRows(QIODevice* device, const QString& formatName);
+    bool exportQuery(QIODevice* device, const QString& queryName, const QVariantMap& params, const QString& formatName);
+    bool startExport(QIODevice* device, const QString& formatName, ExportWriter::Format& format);
+    bool exportBatch(const ExportWriter& writer, qint64 rows); //!< Сигнал прогресса; false - выгрузка отменена.
+    bool finishExport(ExportWriter& writer, qint64 rows);
+    
+    // Вычисляемые колонки
+    void compileCalculatedColumns();
+    void computeCalculatedColumns(int first, int count);
+    QVector<int> recalculateDependents(int source, int column); //!< Пересчитывает зависящие от column колонки строки, возвращает их.
+    
+    // Справочники колонок с внешним ключом
+    void bindLookups();
+    void loadLookups(int first, int count, const QString& table = {}); //!< Справочники (таблицы table, пусто - все) для строк хранилища [first, first + count).
+    void lookupsLoaded(const QVector<LookupLoad>& loads); //!< dataChanged колонок после фоновой загрузки.
+    QVariant lookupDisplay(const QVariant& value, int column) const;
+
+    // Буфер правок и запись их в источник
+    QVariantMap primaryKey(int source) const;
+    QString keyString(const QVariantMap& key) const;
+    void recordEdit(int source, int column, const QVariant& before);
+    void recordRemoval(int source);
+    void removeSourceRows(QVector<int> sources); //!< Удаляет строки хранилища с сигналами по видимым строкам.
+    void insertSourceRows(const QVector<int>& positions, const QList<QVariantMap>& rows,
+                          const QVector<quint32>& ids); //!< Возвращает строки на места positions (по возрастанию) с номерами журнала ids.
+    bool submitEdits();
+    void revertEdits();
+    bool submitOnFieldChange(); //!< OnFieldChange: записывает правку; не принятая источником откатывается.
+    
+    // Горячая перезагрузка схемы без сброса модели
+    bool reloadSchema(bool force);
+    void applySchema(const std::shared_ptr<const ModelSchema>& next);
+    void setSchemaWatching(bool enabled);
+
 private slots:
     void onAsyncQueryFinished();
+    void onSchemaFileChanged();
+    void onSchemaReloaded(const QString& path);
+    void onLookupInvalidated(const QString& table);
 
 public:
     TableModel* const q_ptr;
@@ -69,7 +204,7 @@ public:
     
     // A=>2=K5 :><?>=5=BK
     ModelCore* modelCore;
-    ModelSchema* schema;
+    std::shared_ptr<const ModelSchema> schema;
     
     // AB>G=8:8 40==KE
     QueryHandler queryHandler;
@@ -83,7 +218,42 @@ public:
     QHash<QUuid, AsyncOperation*> activeOperations;
     
     // 0==K5 <>45;8 (107>20O @50;870F8O)
-    QList<QVariantList> modelData;
+    ColumnStore store;
+    QVector<int> rowOrder; //!< Все строки хранилища в порядке сортировки; используется, только если sortKeys не пуст.
+    QVector<SortRule> sortRules;
+    QVector<SortKey> sortKeys;
+    Filter filter;
+    FilterMatcher filterMatcher; //!< Проверка отдельных строк после правок без перекомпиляции фильтра.
+    QVector<int> filterColumns;
+    RowBitmap filterMask;     //!< Строки хранилища, удовлетворяющие фильтру.
+    QVector<int> visibleRows; //!< Видимая строка -> строка хранилища; используется, только если фильтр задан.
+    bool filterPushedDown;    //!< Фильтр выполнен источником последнего запроса.
+    QHash<QString, FilterPushDownCount> filterPushDowns; //!< Запрос -> где выполнялся фильтр модели.
+    QString lastQueryName;    //!< Последний успешный запрос и его параметры (для перезапроса при смене фильтра).
+    QVariantMap lastQueryParams;
+    
+    // Вычисляемые колонки в порядке зависимостей
+    CalculationPlan calculation;
+    ExpressionVM expressionVM;
+    
+    // Справочники (общие с другими моделями) по номеру колонки; nullptr - не внешний ключ
+    QVector<std::shared_ptr<LookupTable>> lookups;
+    bool deferLookups = false; //!< Справочники грузятся в пуле потоков (результат executeAsync).
+    
+    // Первичный ключ -> строка хранилища; перестраивается при промахе
+    QHash<QString, int> keyRows;
+    
+    // Несохранённые правки (при стратегии, отличной от LocalOnly)
+    TableModel::EditStrategy editStrategy = TableModel::EditStrategy::LocalOnly;
+    EditBuffer edits;
+    EditJournal journal; //!< Включается TableModel::setUndoEnabled().
+    
+    std::atomic_bool exportCancelled{false}; //!< TableModel::cancelExport(); проверяется раз в пакет строк.
+    
+    // Слежение за файлом схемы (создаются при включении)
+    QString schemaPath; //!< Абсолютный путь к файлу схемы.
+    QFileSystemWatcher* schemaWatcher;
+    QTimer* schemaTimer;
 };
 
 } // namespace nsModel
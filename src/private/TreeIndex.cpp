@@ -0,0 +1,134 @@
+#include "TreeIndex.h"
+
+namespace QForge::nsModel {
+
+void TreeIndex::clear() {
+    parents.clear();
+    positions.clear();
+    childLists = {QVector<int>()};
+    states.clear();
+    keys.clear();
+    nodes.clear();
+}
+
+int TreeIndex::addNode(int parent, const QString& key) {
+    const int node = parents.size();
+    QVector<int>& siblings = childLists[parent + 1];
+    parents.append(parent);
+    positions.append(siblings.size());
+    siblings.append(node);
+    childLists.append(QVector<int>());
+    states.append(ChildrenState::Unknown);
+    keys.append(key);
+    nodes.insert(key, node);
+    return node;
+}
+
+void TreeIndex::build(const QVector<QString>& nodeKeys, QVector<int> nodeParents) {
+    const int count = nodeKeys.size();
+
+    // Разрыв циклов: подъём к корню с пометкой пути; каждый узел проходится один раз
+    enum Mark : quint8 { Unvisited, OnPath, Rooted };
+    QVector<Mark> marks(count, Unvisited);
+    QVector<int> path;
+    for (int start = 0; start < count; ++start) {
+        int current = start;
+        while (current != kRoot && marks[current] == Unvisited) {
+            marks[current] = OnPath;
+            path.append(current);
+            current = nodeParents[current];
+        }
+        if (current != kRoot && marks[current] == OnPath) {
+            nodeParents[current] = kRoot;
+        }
+        for (int node : std::as_const(path)) {
+            marks[node] = Rooted;
+        }
+        path.clear();
+    }
+
+    parents = std::move(nodeParents);
+    keys = nodeKeys;
+    states.fill(ChildrenState::Unknown, count);
+    positions.resize(count);
+    childLists = QVector<QVector<int>>(count + 1);
+    nodes.clear();
+    nodes.reserve(count);
+    for (int node = 0; node < count; ++node) {
+        QVector<int>& siblings = childLists[parents[node] + 1];
+        positions[node] = siblings.size();
+        siblings.append(node);
+        nodes.insert(keys[node], node);
+    }
+}
+
+void TreeIndex::moveNode(int node, int parent, int position) {
+    detach(node);
+    attach(node, parent, position);
+}
+
+QVector<int> TreeIndex::removeNode(int node) {
+    QVector<int> removed = descendants(node);
+    removed.prepend(node);
+    detach(node);
+    for (int current : std::as_const(removed)) {
+        parents[current] = kRemoved;
+        childLists[current + 1].clear();
+        nodes.remove(keys[current]);
+    }
+    return removed;
+}
+
+QVector<int> TreeIndex::descendants(int node) const {
+    QVector<int> result;
+    QVector<int> stack(children(node).crbegin(), children(node).crend());
+    while (!stack.isEmpty()) {
+        const int current = stack.takeLast();
+        result.append(current);
+        const QVector<int>& next = children(current);
+        for (auto it = next.crbegin(); it != next.crend(); ++it) {
+            stack.append(*it);
+        }
+    }
+    return result;
+}
+
+bool TreeIndex::isAncestor(int ancestor, int node) const {
+    for (int current = node; current >= 0; current = parents[current]) {
+        if (current == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int TreeIndex::depth(int node) const {
+    int depth = 0;
+    for (int current = parents[node]; current != kRoot; current = parents[current]) {
+        ++depth;
+    }
+    return depth;
+}
+
+void TreeIndex::detach(int node) {
+    QVector<int>& siblings = childLists[parents[node] + 1];
+    const int position = positions[node];
+    siblings.removeAt(position);
+    for (int i = position; i < siblings.size(); ++i) {
+        positions[siblings[i]] = i;
+    }
+}
+
+void TreeIndex::attach(int node, int parent, int position) {
+    QVector<int>& siblings = childLists[parent + 1];
+    if (position < 0 || position > siblings.size()) {
+        position = siblings.size();
+    }
+    siblings.insert(position, node);
+    parents[node] = parent;
+    for (int i = position; i < siblings.size(); ++i) {
+        positions[siblings[i]] = i;
+    }
+}
+
+}
@@ -0,0 +1,99 @@
+#ifndef QFORGE_TREEINDEX_H
+#define QFORGE_TREEINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace QForge::nsModel {
+
+/**
+ * @brief Структура дерева в плоских массивах.
+ *
+ * Узел - целый номер, совпадающий со строкой ColumnStore с его значениями;
+ * родитель, позиция среди детей и списки детей хранятся в массивах по номеру узла,
+ * без объекта на узел. Узел находится по строковому представлению первичного ключа
+ * за O(1). Номер узла годится для QModelIndex::internalId(). Удалённые узлы
+ * только отцепляются (номера остальных не меняются) до следующего build()/clear().
+ */
+class TreeIndex
+{
+public:
+    static constexpr int kRoot = -1;    //!< Невидимый корень: его дети - узлы верхнего уровня.
+    static constexpr int kRemoved = -2; //!< Родитель удалённого узла.
+
+    /*!
+     * \brief Состояние загрузки детей узла.
+     */
+    enum class ChildrenState : quint8 {
+        Unknown, //!< Дети не запрашивались.
+        Pending, //!< Запрошены, запрос ещё не выполнен.
+        Loaded
+    };
+
+    TreeIndex() { clear(); }
+
+    void clear();
+    int size() const { return parents.size(); }
+
+    /*!
+     * \brief Добавляет узел последним ребёнком parent.
+     * \return Номер узла; он же - следующая строка хранилища.
+     */
+    int addNode(int parent, const QString& key);
+
+    /*!
+     * \brief Строит дерево целиком за O(n): узел i - ключ keys[i] с родителем parents[i].
+     * \details Дети идут в порядке номеров. Узел, замыкающий цикл родителей, становится
+     * узлом верхнего уровня.
+     */
+    void build(const QVector<QString>& keys, QVector<int> parents);
+
+    /*!
+     * \brief Переносит узел вместе с поддеревом к parent на позицию position (-1 - в конец).
+     * \details position считается среди детей parent без самого узла.
+     */
+    void moveNode(int node, int parent, int position = -1);
+
+    /*!
+     * \brief Удаляет узел вместе с поддеревом.
+     * \return Удалённые узлы (сам узел первым).
+     */
+    QVector<int> removeNode(int node);
+
+    /*!
+     * \brief Потомки узла в прямом порядке обхода, без самого узла.
+     */
+    QVector<int> descendants(int node) const;
+    bool isAncestor(int ancestor, int node) const; //!< ancestor - сам node или его предок.
+    bool isRemoved(int node) const { return parents[node] == kRemoved; }
+
+    /*!
+     * \brief Узел по ключу (-1, если его нет).
+     */
+    int node(const QString& key) const { return nodes.value(key, -1); }
+    const QString& key(int node) const { return keys[node]; }
+
+    int parent(int node) const { return parents[node]; }
+    int position(int node) const { return positions[node]; } //!< Строка узла среди детей родителя.
+    const QVector<int>& children(int parent) const { return childLists[parent + 1]; }
+    int depth(int node) const;
+
+    ChildrenState state(int node) const { return states[node]; }
+    void setState(int node, ChildrenState state) { states[node] = state; }
+
+private:
+    void detach(int node);
+    void attach(int node, int parent, int position);
+
+    QVector<int> parents;
+    QVector<int> positions;
+    QVector<QVector<int>> childLists; //!< По номеру узла + 1; [0] - верхний уровень.
+    QVector<ChildrenState> states;
+    QVector<QString> keys;
+    QHash<QString, int> nodes;
+};
+
+}
+
+#endif // QFORGE_TREEINDEX_H
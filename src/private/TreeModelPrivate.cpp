@@ -0,0 +1,452 @@
+#include "TreeModelPrivate.h"
+#include "Parallel.h"
+#include "../TreeModel.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSet>
+#include <QTimer>
+
+namespace QForge::nsModel {
+
+TreeModelPrivate::TreeModelPrivate(TreeModel* q)
+    : q_ptr(q)
+    , modelCore(nullptr)
+    , isInitialized(false)
+    , fetchScheduled(false)
+{
+}
+
+TreeModelPrivate::~TreeModelPrivate()
+{
+    delete modelCore;
+}
+
+bool TreeModelPrivate::loadSchema(const QString& configPath)
+{
+    modelCore = new ModelCore(configPath, queryHandler);
+    if (!modelCore->isValid()) {
+        lastError = "Failed to load schema from " + configPath + ". Errors: " + modelCore->getErrors().join("; ");
+        return false;
+    }
+
+    schema = modelCore->sharedSchema();
+    if (schema->type != ModelType::Tree) {
+        lastError = QString("Schema '%1' is not a tree").arg(schema->name);
+        return false;
+    }
+    if (schema->primaryKeyColumns.isEmpty()) {
+        lastError = QString("Tree schema '%1' has no primary key").arg(schema->name);
+        return false;
+    }
+
+    store.reset(schema->columns);
+    isInitialized = true;
+    return true;
+}
+
+bool TreeModelPrivate::prepareQuery(const QString& queryName, const QVariantMap& params,
+                                    QueryContext& context, QueryResult& result) const
+{
+    if (!isInitialized) {
+        result.ok = false;
+        result.log("Model not initialized");
+        return false;
+    }
+
+    if (!schema->queries.contains(queryName)) {
+        result.ok = false;
+        result.log(QString("Query '%1' not found").arg(queryName));
+        return false;
+    }
+
+    context.queryName = queryName;
+    context.bindings = params;
+    context.sql = schema->queries[queryName].sql;
+
+    // ${имя} становится именованным параметром :имя, массив - их списком для IN (...);
+    // исходные значения остаются в bindings для обработчиков без SQL
+    for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+        const QString placeholder = QString("${%1}").arg(it.key());
+        if (!context.sql.contains(placeholder)) {
+            continue;
+        }
+        if (it.value().typeId() != QMetaType::QVariantList) {
+            const QString name = ":" + it.key();
+            context.bindings.insert(name, it.value());
+            context.sql.replace(placeholder, name);
+            continue;
+        }
+        const QVariantList values = it.value().toList();
+        QStringList names;
+        names.reserve(values.size());
+        for (int i = 0; i < values.size(); ++i) {
+            const QString name = QString(":%1_%2").arg(it.key()).arg(i);
+            names.append(name);
+            context.bindings.insert(name, values[i]);
+        }
+        context.sql.replace(placeholder, names.join(", "));
+    }
+
+    result.ok = true;
+    return true;
+}
+
+QueryResult TreeModelPrivate::runQuery(const QueryContext& context) const
+{
+    QueryResult result;
+
+    try {
+        if (queryHandler) {
+            result = queryHandler(context);
+        } else {
+            result.ok = false;
+            result.log("No query handler or database configured");
+        }
+    } catch (const std::exception& e) {
+        result.ok = false;
+        result.log(QString("Query execution failed: %1").arg(e.what()));
+    }
+
+    return result;
+}
+
+QueryResult TreeModelPrivate::executeTree(const QString& queryName, const QVariantMap& params)
+{
+    Q_Q(TreeModel);
+
+    QueryContext context;
+    QueryResult result;
+    if (prepareQuery(queryName, params, context, result)) {
+        result = runQuery(context);
+    }
+    if (!result.ok) {
+        lastError = result.errors_log.join("; ");
+        return result;
+    }
+
+    QVector<QString> keys;
+    QVector<int> parents;
+    resolveRows(result.rows, keys, parents);
+
+    q->beginResetModel();
+    store.clear();
+    pending.clear();
+    store.appendRows(result.rows);
+    tree.build(keys, parents);
+    // Без children_query других детей у узлов нет; иначе загруженными считаются узлы,
+    // дети которых пришли в результате
+    const bool lazy = !schema->tree.childrenQuery.isEmpty();
+    for (int node = 0; node < keys.size(); ++node) {
+        if (!lazy || !tree.children(node).isEmpty()) {
+            tree.setState(node, TreeIndex::ChildrenState::Loaded);
+        }
+    }
+    q->endResetModel();
+
+    return result;
+}
+
+void TreeModelPrivate::resolveRows(const QList<QVariantMap>& rows, QVector<QString>& keys, QVector<int>& parents) const
+{
+    const int total = rows.size();
+    keys.resize(total);
+    parents.resize(total);
+    QVector<QString> parentKeys(total);
+
+    // Ключи и ключи родителей считаются параллельно, хеш строится за один проход,
+    // затем родители разрешаются параллельно чтением из хеша
+    const QVariantMap* source = rows.constData();
+    QString* keyData = keys.data();
+    QString* parentKeyData = parentKeys.data();
+    const int tasks = Parallel::taskCount(total);
+    const int rowsPerTask = total > 0 ? (total + tasks - 1) / tasks : 0;
+    Parallel::run(tasks, [&](int t) {
+        const int end = qMin(total, (t + 1) * rowsPerTask);
+        for (int i = t * rowsPerTask; i < end; ++i) {
+            keyData[i] = rowKey(source[i]);
+            parentKeyData[i] = source[i].value(schema->tree.parentColumn).toString();
+        }
+    });
+
+    QHash<QString, int> nodes;
+    nodes.reserve(total);
+    for (int i = 0; i < total; ++i) {
+        nodes.insert(keys[i], i);
+    }
+
+    int* parentData = parents.data();
+    Parallel::run(tasks, [&](int t) {
+        const int end = qMin(total, (t + 1) * rowsPerTask);
+        for (int i = t * rowsPerTask; i < end; ++i) {
+            const int parent = nodes.value(parentKeyData[i], TreeIndex::kRoot);
+            parentData[i] = parent == i ? TreeIndex::kRoot : parent;
+        }
+    });
+}
+
+bool TreeModelPrivate::refreshSubtree(int root, const QString& queryName, const QVariantMap& params)
+{
+    Q_Q(TreeModel);
+
+    QueryContext context;
+    QueryResult result;
+    if (prepareQuery(queryName, params, context, result)) {
+        result = runQuery(context);
+    }
+    if (!result.ok) {
+        lastError = result.errors_log.join("; ");
+        return false;
+    }
+
+    const QString& parentColumn = schema->tree.parentColumn;
+    QSet<QString> present;
+    present.reserve(result.rows.size());
+    QList<QVariantMap> added;
+    QVector<QPair<int, QString>> reparented;
+    QHash<int, QPair<int, int>> changed; // узел -> диапазон изменённых колонок
+
+    // Существующие узлы обновляются на месте, новые откладываются до вставки
+    for (const QVariantMap& row : std::as_const(result.rows)) {
+        const QString key = rowKey(row);
+        present.insert(key);
+        const int node = tree.node(key);
+        if (node < 0) {
+            added.append(row);
+            continue;
+        }
+        for (int column = 0; column < schema->columns.size(); ++column) {
+            const QString& name = schema->columns[column].name;
+            if (row.contains(name) && store.setValue(node, column, row.value(name))) {
+                auto range = changed.find(node);
+                if (range == changed.end()) {
+                    changed.insert(node, {column, column});
+                } else {
+                    range->first = qMin(range->first, column);
+                    range->second = qMax(range->second, column);
+                }
+            }
+        }
+        if (node != root) {
+            reparented.append({node, row.value(parentColumn).toString()});
+        }
+    }
+
+    // Новые узлы - по уровням: на каждом проходе вставляются строки, родитель которых уже
+    // в дереве, одной вставкой на родителя. Строки без родителя попадают под root
+    while (!added.isEmpty()) {
+        QMap<int, QList<QVariantMap>> groups;
+        QList<QVariantMap> deferred;
+        for (const QVariantMap& row : std::as_const(added)) {
+            const QString parentKey = row.value(parentColumn).toString();
+            const int parent = tree.node(parentKey);
+            if (parent >= 0) {
+                groups[parent].append(row);
+            } else {
+                deferred.append(row);
+            }
+        }
+        if (groups.isEmpty()) {
+            // Остались строки, чьи родители не придут: они вставляются под root
+            groups[root] = deferred;
+            deferred.clear();
+        }
+        for (auto it = groups.constBegin(); it != groups.constEnd(); ++it) {
+            const int first = tree.children(it.key()).size();
+            q->beginInsertRows(indexOf(it.key()), first, first + it.value().size() - 1);
+            store.appendRows(it.value());
+            for (const QVariantMap& row : it.value()) {
+                tree.addNode(it.key(), rowKey(row));
+            }
+            q->endInsertRows();
+        }
+        added = deferred;
+    }
+
+    // Переставленные узлы переносятся без сброса; перенос внутрь собственного поддерева пропускается
+    for (const auto& [node, parentKey] : std::as_const(reparented)) {
+        int parent = tree.node(parentKey);
+        if (parent < 0) {
+            parent = root;
+        }
+        if (parent != tree.parent(node) && !tree.isAncestor(node, parent)) {
+            moveNode(node, parent, -1);
+        }
+    }
+
+    // Потомки, которых нет в результате, удаляются вместе с поддеревьями
+    for (int node : tree.descendants(root)) {
+        if (tree.isRemoved(node) || present.contains(tree.key(node))) {
+            continue;
+        }
+        const int position = tree.position(node);
+        q->beginRemoveRows(indexOf(tree.parent(node)), position, position);
+        for (int removed : tree.removeNode(node)) {
+            changed.remove(removed);
+        }
+        q->endRemoveRows();
+    }
+
+    // Результат содержит поддерево целиком
+    tree.setState(root, TreeIndex::ChildrenState::Loaded);
+    for (int node : tree.descendants(root)) {
+        tree.setState(node, TreeIndex::ChildrenState::Loaded);
+    }
+
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        emit q->dataChanged(indexOf(it.key(), it.value().first), indexOf(it.key(), it.value().second));
+    }
+    return true;
+}
+
+bool TreeModelPrivate::moveNode(int node, int parent, int row)
+{
+    Q_Q(TreeModel);
+
+    const int sourceParent = tree.parent(node);
+    const int source = tree.position(node);
+    int siblings = tree.children(parent).size();
+    if (parent == sourceParent) {
+        --siblings;
+    }
+    if (row < 0 || row > siblings) {
+        row = siblings;
+    }
+    if (parent == sourceParent && row == source) {
+        return true;
+    }
+
+    // Для Qt позиция назначения считается до изъятия узла
+    const int destination = parent == sourceParent && row > source ? row + 1 : row;
+    if (!q->beginMoveRows(indexOf(sourceParent), source, source, indexOf(parent), destination)) {
+        return false;
+    }
+    tree.moveNode(node, parent, row);
+    q->endMoveRows();
+
+    const int parentColumn = schema->columnIndex(schema->tree.parentColumn);
+    if (parentColumn >= 0) {
+        const QVariant parentKey = parent == TreeIndex::kRoot
+                                       ? QVariant()
+                                       : store.value(parent, schema->columnIndex(schema->primaryKeyColumns.first()));
+        if (store.setValue(node, parentColumn, parentKey)) {
+            const QModelIndex index = indexOf(node, parentColumn);
+            emit q->dataChanged(index, index);
+        }
+    }
+    return true;
+}
+
+void TreeModelPrivate::requestChildren(int node)
+{
+    Q_Q(TreeModel);
+
+    if (tree.state(node) != TreeIndex::ChildrenState::Unknown) {
+        return;
+    }
+    tree.setState(node, TreeIndex::ChildrenState::Pending);
+    pending.append(node);
+
+    // Представление вызывает fetchMore для каждого раскрытого узла подряд: запросы
+    // собираются до следующего прохода цикла событий
+    if (!fetchScheduled) {
+        fetchScheduled = true;
+        QTimer::singleShot(0, q, [this]() { fetchPending(); });
+    }
+}
+
+void TreeModelPrivate::fetchPending()
+{
+    fetchScheduled = false;
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    // Один запрос на уровень, от верхних к нижним
+    QMap<int, QVector<int>> levels;
+    for (int node : std::as_const(pending)) {
+        levels[tree.depth(node)].append(node);
+    }
+    pending.clear();
+
+    for (auto it = levels.constBegin(); it != levels.constEnd(); ++it) {
+        loadChildren(it.value());
+    }
+}
+
+void TreeModelPrivate::loadChildren(const QVector<int>& parents)
+{
+    Q_Q(TreeModel);
+
+    QVariantList keys;
+    keys.reserve(parents.size());
+    for (int node : parents) {
+        keys.append(store.value(node, schema->columnIndex(schema->primaryKeyColumns.first())));
+    }
+
+    QVariantMap params;
+    params.insert(schema->tree.parentsArgument, keys);
+    QueryContext context;
+    QueryResult result;
+    if (prepareQuery(schema->tree.childrenQuery, params, context, result)) {
+        result = runQuery(context);
+    }
+    if (!result.ok) {
+        // Узлы снова можно запросить
+        lastError = result.errors_log.join("; ");
+        for (int node : parents) {
+            tree.setState(node, TreeIndex::ChildrenState::Unknown);
+        }
+        return;
+    }
+
+    // Строки раскладываются по родителям за один проход
+    QHash<int, QList<QVariantMap>> children;
+    for (const QVariantMap& row : std::as_const(result.rows)) {
+        const int parent = tree.node(row.value(schema->tree.parentColumn).toString());
+        if (parent >= 0 && tree.state(parent) == TreeIndex::ChildrenState::Pending
+            && tree.node(rowKey(row)) < 0) {
+            children[parent].append(row);
+        }
+    }
+
+    for (int parent : parents) {
+        tree.setState(parent, TreeIndex::ChildrenState::Loaded);
+        const QList<QVariantMap> rows = children.value(parent);
+        if (rows.isEmpty()) {
+            continue;
+        }
+        // Под узлом уже могут быть дети, вставленные refreshSubtree или moveNode
+        const int first = tree.children(parent).size();
+        q->beginInsertRows(indexOf(parent), first, first + rows.size() - 1);
+        store.appendRows(rows);
+        for (const QVariantMap& row : rows) {
+            tree.addNode(parent, rowKey(row));
+        }
+        q->endInsertRows();
+    }
+}
+
+QString TreeModelPrivate::rowKey(const QVariantMap& row) const
+{
+    if (schema->primaryKeyColumns.size() == 1) {
+        return row.value(schema->primaryKeyColumns.first()).toString();
+    }
+    QStringList parts;
+    for (const QString& column : schema->primaryKeyColumns) {
+        parts.append(row.value(column).toString());
+    }
+    return parts.join(QChar(0x1F));
+}
+
+QModelIndex TreeModelPrivate::indexOf(int node, int column) const
+{
+    Q_Q(const TreeModel);
+
+    if (node == TreeIndex::kRoot) {
+        return QModelIndex();
+    }
+    return q->createIndex(tree.position(node), column, quintptr(node));
+}
+
+}
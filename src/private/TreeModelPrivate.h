@@ -0,0 +1,76 @@
+#ifndef QFORGE_TREEMODELPRIVATE_H
+#define QFORGE_TREEMODELPRIVATE_H
+
+#include <QModelIndex>
+#include <QVariantMap>
+
+#include <memory>
+
+#include "ColumnStore.h"
+#include "ModelCore.h"
+#include "ModelSchema.h"
+#include "TreeIndex.h"
+#include "../QueryContext.hpp"
+#include "../QueryHandler.hpp"
+#include "../QueryResult.hpp"
+
+namespace QForge::nsModel {
+
+class TreeModel;
+
+/**
+ * @brief Состояние TreeModel: схема, значения узлов в ColumnStore и структура в TreeIndex.
+ *
+ * Узел n - строка n хранилища; QModelIndex::internalId() - номер узла.
+ */
+class TreeModelPrivate
+{
+public:
+    explicit TreeModelPrivate(TreeModel* q);
+    ~TreeModelPrivate();
+
+    bool loadSchema(const QString& configPath);
+
+    // Запросы
+    bool prepareQuery(const QString& queryName, const QVariantMap& params,
+                      QueryContext& context, QueryResult& result) const;
+    QueryResult runQuery(const QueryContext& context) const;
+    QueryResult executeTree(const QString& queryName, const QVariantMap& params);
+
+    // Построение и правка иерархии
+    /*!
+     * \brief Ключи строк и номера строк их родителей (kRoot, если родителя нет в rows).
+     */
+    void resolveRows(const QList<QVariantMap>& rows, QVector<QString>& keys, QVector<int>& parents) const;
+    bool refreshSubtree(int root, const QString& queryName, const QVariantMap& params);
+    bool moveNode(int node, int parent, int row);
+
+    // Ленивая загрузка детей
+    void requestChildren(int node);
+    void fetchPending();
+    void loadChildren(const QVector<int>& parents); //!< Один запрос для узлов одного уровня.
+
+    QString rowKey(const QVariantMap& row) const;
+    QModelIndex indexOf(int node, int column = 0) const;
+    int nodeOf(const QModelIndex& index) const {
+        return index.isValid() ? int(index.internalId()) : TreeIndex::kRoot;
+    }
+
+    TreeModel* const q_ptr;
+    Q_DECLARE_PUBLIC(TreeModel)
+
+    ModelCore* modelCore;
+    std::shared_ptr<const ModelSchema> schema;
+    QueryHandler queryHandler;
+    bool isInitialized;
+    QString lastError;
+
+    ColumnStore store;
+    TreeIndex tree;
+    QVector<int> pending;  //!< Узлы, для которых вызван fetchMore.
+    bool fetchScheduled;
+};
+
+}
+
+#endif // QFORGE_TREEMODELPRIVATE_H
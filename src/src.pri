@@ -2,21 +2,62 @@
 
 HEADERS += \
     $$PWD/HandlerRegistry.h \
+    $$PWD/ModelFactory.h \
     $$PWD/QueryContext.hpp \
     $$PWD/QueryHandler.hpp \
     $$PWD/QueryResult.hpp \
     $$PWD/TableModel.h \
+    $$PWD/TreeModel.h \
+    $$PWD/private/ColumnStore.h \
+    $$PWD/private/CsvFileSource.h \
+    $$PWD/private/CsvReader.h \
+    $$PWD/private/EditBuffer.h \
+    $$PWD/private/EditJournal.h \
+    $$PWD/private/ExportWriter.h \
+    $$PWD/private/Expression.h \
+    $$PWD/private/FieldParser.h \
+    $$PWD/private/FilterEngine.h \
+    $$PWD/private/LookupCache.h \
     $$PWD/private/ModelCore.h \
     $$PWD/private/ModelSchema.h \
+    $$PWD/private/Parallel.h \
+    $$PWD/private/PredicateKernels.h \
+    $$PWD/private/QueryEngine.h \
+    $$PWD/private/RowBitmap.h \
+    $$PWD/private/SchemaCache.h \
+    $$PWD/private/SchemaRegistry.h \
+    $$PWD/private/SortEngine.h \
     $$PWD/private/SqlQueryHandlerFactory.h \
-    $$PWD/private/TableModelPrivate.h
+    $$PWD/private/TableModelPrivate.h \
+    $$PWD/private/TreeIndex.h \
+    $$PWD/private/TreeModelPrivate.h
 
 SOURCES += \
     $$PWD/HandlerRegistry.cpp \
+    $$PWD/ModelFactory.cpp \
     $$PWD/TableModel.cpp \
+    $$PWD/TreeModel.cpp \
+    $$PWD/private/ColumnStore.cpp \
+    $$PWD/private/CsvFileSource.cpp \
+    $$PWD/private/CsvReader.cpp \
+    $$PWD/private/EditBuffer.cpp \
+    $$PWD/private/EditJournal.cpp \
+    $$PWD/private/ExportWriter.cpp \
+    $$PWD/private/Expression.cpp \
+    $$PWD/private/FieldParser.cpp \
+    $$PWD/private/FilterEngine.cpp \
+    $$PWD/private/LookupCache.cpp \
     $$PWD/private/ModelCore.cpp \
     $$PWD/private/ModelSchema.cpp \
+    $$PWD/private/PredicateKernels.cpp \
+    $$PWD/private/QueryEngine.cpp \
+    $$PWD/private/RowBitmap.cpp \
+    $$PWD/private/SchemaCache.cpp \
+    $$PWD/private/SchemaRegistry.cpp \
+    $$PWD/private/SortEngine.cpp \
     $$PWD/private/SqlQueryHandlerFactory.cpp \
-    $$PWD/private/TableModelPrivate.cpp
+    $$PWD/private/TableModelPrivate.cpp \
+    $$PWD/private/TreeIndex.cpp \
+    $$PWD/private/TreeModelPrivate.cpp
 
 INCLUDEPATH += $$PWD/private
@@ -1,7 +1,23 @@
 #include "TableModelTests.h"
 #include <QtTest>
+#include <QBuffer>
 #include <QDir>
 #include <QFile>
+#include <QSortFilterProxyModel>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimeZone>
+
+#include <algorithm>
+#include <limits>
+
+// Начало схемы Items.yml для тестов правок и выгрузки: колонки id (ключ), name, price
+static const QByteArray kItemsSchema = "name: Items\ntype: table\n"
+                                       "columns:\n"
+                                       "  - name: id\n    type: integer\n    is_primary_key: true\n"
+                                       "  - name: name\n    type: string\n"
+                                       "  - name: price\n    type: double\n";
 
 void TableModelTests::initTestCase()
 {
@@ -132,6 +148,2499 @@ void TableModelTests::testModelCoreExecution()
     QVERIFY2(!result.ok, "Несуществующий запрос должен вернуть ошибку");
 }
 
+void TableModelTests::testTableModelSorting()
+{
+    qDebug() << "Тестирование локальной сортировки TableModel";
+    
+    QString yamlPath = getProjectRoot() + "/examples/csv_demo/ProductModel.yml";
+    TableModel model(yamlPath, productQueryHandler);
+    QVERIFY2(model.isValid(), "TableModel должна загрузить ProductModel.yml");
+    QVERIFY2(model.execute("load_all").ok, "Запрос load_all должен выполниться успешно");
+    QCOMPARE(model.rowCount(), 6);
+    
+    // Сортировка из схемы: name asc
+    QCOMPARE(columnValues(model, 1), QStringList({"Cable", "Chair", "Coffee Maker", "Desk", "Laptop", "Phone"}));
+    
+    // Числовая колонка: NULL идёт первым при возрастании
+    model.sort(2, Qt::AscendingOrder);
+    QVERIFY(model.data(model.index(0, 2)).isNull());
+    QCOMPARE(columnValues(model, 1), QStringList({"Cable", "Coffee Maker", "Chair", "Desk", "Phone", "Laptop"}));
+    
+    // Переключение направления разворачивает порядок, persistent-индексы следуют за строками
+    QPersistentModelIndex cheapest = model.index(1, 1);
+    model.sort(2, Qt::DescendingOrder);
+    QCOMPARE(columnValues(model, 1), QStringList({"Laptop", "Phone", "Desk", "Chair", "Coffee Maker", "Cable"}));
+    QCOMPARE(cheapest.row(), 4);
+    QCOMPARE(cheapest.data().toString(), QString("Coffee Maker"));
+    
+    // Многоколоночная сортировка: category asc, quantity desc
+    SortRule byCategory;
+    byCategory.columnName = "category";
+    SortRule byQuantity;
+    byQuantity.columnName = "quantity";
+    byQuantity.order = SortOrder::Descending;
+    byQuantity.priority = 1;
+    model.setSortRules({byCategory, byQuantity});
+    QCOMPARE(columnValues(model, 1), QStringList({"Coffee Maker", "Phone", "Laptop", "Desk", "Chair", "Cable"}));
+    
+    // Равные ключи сохраняют исходный порядок в обоих направлениях, в том числе при развороте
+    auto duplicates = [](const QueryContext&) {
+        QueryResult result;
+        result.ok = true;
+        const QList<QVariantList> items = {{1, "A", 10.0}, {2, "B", 20.0}, {3, "C", 10.0}, {4, "D", 20.0}, {5, "E", 10.0}};
+        for (const QVariantList& item : items) {
+            result.rows.append({{"id", item[0]}, {"name", item[1]}, {"price", item[2]}});
+        }
+        return result;
+    };
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, kItemsSchema + "queries:\n"
+                                                         "  select_all:\n    sql: \"SELECT id, name, price FROM items\"\n");
+    QVERIFY(!path.isEmpty());
+    TableModel items(path, duplicates);
+    QVERIFY(items.execute("select_all").ok);
+    items.sort(2, Qt::DescendingOrder);
+    QCOMPARE(columnValues(items, 1), QStringList({"B", "D", "A", "C", "E"}));
+    items.sort(2, Qt::AscendingOrder);
+    QCOMPARE(columnValues(items, 1), QStringList({"A", "C", "E", "B", "D"}));
+    items.sort(2, Qt::DescendingOrder);
+    QCOMPARE(columnValues(items, 1), QStringList({"B", "D", "A", "C", "E"}));
+}
+
+void TableModelTests::testIncrementalSortMaintenance()
+{
+    qDebug() << "Тестирование инкрементального поддержания сортировки";
+    
+    QString yamlPath = getProjectRoot() + "/examples/csv_demo/ProductModel.yml";
+    TableModel model(yamlPath, productQueryHandler);
+    QVERIFY(model.execute("load_all").ok);
+    model.sort(2, Qt::AscendingOrder);
+    
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy layoutSpy(&model, &QAbstractItemModel::layoutChanged);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    
+    // Coffee Maker (89.99) дорожает и переезжает в конец
+    QVERIFY(model.setData(model.index(1, 2), 1500.0));
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(columnValues(model, 1), QStringList({"Cable", "Chair", "Desk", "Phone", "Laptop", "Coffee Maker"}));
+    
+    // Изменение, не нарушающее порядок, строки не двигает
+    QVERIFY(model.setData(model.index(1, 2), 400.0));
+    QCOMPARE(movedSpy.count(), 1);
+    
+    // Новая строка встаёт между Chair (400) и Desk (599)
+    QVariantMap lamp;
+    lamp["id"] = 7;
+    lamp["name"] = "Lamp";
+    lamp["price"] = 450.0;
+    lamp["quantity"] = 3;
+    lamp["category"] = "Other";
+    model.appendRows({lamp});
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(insertedSpy.first().at(1).toInt(), 2);
+    QCOMPARE(columnValues(model, 1), QStringList({"Cable", "Chair", "Lamp", "Desk", "Phone", "Laptop", "Coffee Maker"}));
+    
+    QCOMPARE(layoutSpy.count(), 0);
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void TableModelTests::testTableModelFiltering()
+{
+    qDebug() << "Тестирование локальной фильтрации TableModel";
+    
+    QString yamlPath = getProjectRoot() + "/examples/csv_demo/ProductModel.yml";
+    TableModel model(yamlPath, productQueryHandler);
+    QVERIFY(model.execute("load_all").ok);
+    QCOMPARE(model.rowCount(), 6);
+    
+    // Равенство без учёта регистра (case_sensitive_filtering: false), порядок сортировки сохраняется
+    QVERIFY(model.setColumnFilter("category", "electronics"));
+    QCOMPARE(columnValues(model, 1), QStringList({"Laptop", "Phone"}));
+    
+    // OR: дешевле 100 или мебель; NULL-цена не проходит сравнение
+    QForge::Filter cheapOrFurniture;
+    cheapOrFurniture.logic = QForge::FilterLogic::Or;
+    cheapOrFurniture.rules.append({"price", QForge::FilterOperator::Less, 100.0, QVariant()});
+    cheapOrFurniture.rules.append({"category", QForge::FilterOperator::Equal, "Furniture", QVariant()});
+    QVERIFY(model.setFilter(cheapOrFurniture));
+    QCOMPARE(columnValues(model, 1), QStringList({"Chair", "Coffee Maker", "Desk"}));
+    
+    // AND правила с OR-группой
+    QForge::Filter inStockFurnitureOrAppliances;
+    inStockFurnitureOrAppliances.rules.append({"in_stock", QForge::FilterOperator::Equal, true, QVariant()});
+    QForge::FilterGroup categories;
+    categories.logic = QForge::FilterLogic::Or;
+    categories.rules.append({"category", QForge::FilterOperator::Equal, "Furniture", QVariant()});
+    categories.rules.append({"category", QForge::FilterOperator::Equal, "Appliances", QVariant()});
+    inStockFurnitureOrAppliances.groups.append(categories);
+    QVERIFY(model.setFilter(inStockFurnitureOrAppliances));
+    QCOMPARE(columnValues(model, 1), QStringList({"Coffee Maker", "Desk"}));
+    
+    QForge::Filter nullPrice;
+    nullPrice.rules.append({"price", QForge::FilterOperator::IsNull, QVariant(), QVariant()});
+    QVERIFY(model.setFilter(nullPrice));
+    QCOMPARE(columnValues(model, 1), QStringList({"Cable"}));
+    
+    // Persistent-индекс видимой строки переживает смену фильтра
+    QVERIFY(model.setColumnFilter("price", QVariant()));
+    QVERIFY(model.setColumnFilter("category", "Electronics"));
+    const QPersistentModelIndex phone = model.index(1, 1);
+    QVERIFY(model.setColumnFilter("quantity", 25));
+    QVERIFY(phone.isValid());
+    QCOMPARE(phone.row(), 0);
+    QCOMPARE(phone.data().toString(), QString("Phone"));
+    QVERIFY(model.setColumnFilter("quantity", QVariant()));
+    
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    
+    // Правка, после которой строка не проходит фильтр, скрывает её
+    QVERIFY(model.setData(model.index(0, 4), "Other"));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(columnValues(model, 1), QStringList({"Phone"}));
+    
+    // Добавленные строки видны, только если проходят фильтр, и встают по сортировке
+    QVariantMap tablet;
+    tablet["id"] = 7;
+    tablet["name"] = "Tablet";
+    tablet["category"] = "Electronics";
+    QVariantMap lamp;
+    lamp["id"] = 8;
+    lamp["name"] = "Lamp";
+    lamp["category"] = "Other";
+    QVariantMap camera;
+    camera["id"] = 9;
+    camera["name"] = "Camera";
+    camera["category"] = "Electronics";
+    model.appendRows({tablet, lamp, camera});
+    QCOMPARE(insertedSpy.count(), 2);
+    QCOMPARE(columnValues(model, 1), QStringList({"Camera", "Phone", "Tablet"}));
+    QCOMPARE(resetSpy.count(), 0);
+    
+    // Снятие фильтра возвращает все строки в порядке сортировки
+    model.clearFilter();
+    QCOMPARE(columnValues(model, 1),
+             QStringList({"Cable", "Camera", "Chair", "Coffee Maker", "Desk", "Lamp", "Laptop", "Phone", "Tablet"}));
+}
+
+void TableModelTests::testFilterPushDown()
+{
+    qDebug() << "Тестирование передачи фильтра источнику данных";
+    
+    QString yamlPath = getProjectRoot() + "/examples/csv_demo/ProductModel.yml";
+    
+    // Обработчик выполняет только равенства, остальное оставляет модели
+    int calls = 0;
+    QueryContext lastContext;
+    auto handler = [&](const QueryContext& context) {
+        ++calls;
+        lastContext = context;
+        QueryResult result = productQueryHandler(context);
+        for (const auto& group : context.filter.groups) {
+            for (const auto& predicate : group.predicates) {
+                if (predicate.op != "=") {
+                    return result;
+                }
+            }
+        }
+        result.rows.erase(std::remove_if(result.rows.begin(), result.rows.end(), [&](const QVariantMap& row) {
+            for (const auto& group : context.filter.groups) {
+                for (const auto& predicate : group.predicates) {
+                    const Qt::CaseSensitivity cs = predicate.caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive;
+                    if (row.value(predicate.column).toString().compare(predicate.value.toString(), cs) != 0) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }), result.rows.end());
+        result.filterApplied = !context.filter.isEmpty();
+        return result;
+    };
+    
+    TableModel model(yamlPath, handler);
+    QVERIFY(model.execute("load_all").ok);
+    QVERIFY(lastContext.filter.isEmpty());
+    QVERIFY(!model.isFilterPushedDown());
+    
+    // Смена фильтра после выполненного источником запроса - перезапрос
+    QVERIFY(model.setColumnFilter("category", "electronics"));
+    QVERIFY(model.execute("load_all").ok);
+    QVERIFY(model.isFilterPushedDown());
+    QCOMPARE(lastContext.filter.groups.size(), 1);
+    QVERIFY(lastContext.filter.groups[0].predicates[0].caseInsensitive);
+    QCOMPARE(columnValues(model, 1), QStringList({"Laptop", "Phone"}));
+    
+    const int callsBefore = calls;
+    QVERIFY(model.setColumnFilter("category", "Furniture"));
+    QCOMPARE(calls, callsBefore + 1);
+    QVERIFY(model.isFilterPushedDown());
+    QCOMPARE(columnValues(model, 1), QStringList({"Chair", "Desk"}));
+    
+    // Неподдерживаемый обработчиком оператор - локальная фильтрация полного набора
+    QForge::Filter cheap;
+    cheap.rules.append({"price", QForge::FilterOperator::Less, 100.0, QVariant()});
+    QVERIFY(model.setFilter(cheap));
+    QVERIFY(!model.isFilterPushedDown());
+    QCOMPARE(columnValues(model, 1), QStringList({"Coffee Maker"}));
+    
+    // Решение о передаче фильтра учитывается по каждому запросу
+    const QVariantMap stats = model.filterPushDownStats().value("load_all").toMap();
+    QCOMPARE(stats.value("pushed_down").toInt(), 2);
+    QCOMPARE(stats.value("local").toInt(), 1);
+    model.resetFilterPushDownStats();
+    QVERIFY(model.filterPushDownStats().isEmpty());
+}
+
+void TableModelTests::testFilterPushDownSqlite()
+{
+    qDebug() << "Тестирование перевода фильтра в WHERE на SQLite";
+    
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("Драйвер QSQLITE недоступен");
+    }
+    
+    // Перевод в параметризованный WHERE на SQLite
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "filter_push_down");
+        db.setDatabaseName(":memory:");
+        QVERIFY(db.open());
+        QSqlQuery setup(db);
+        QVERIFY(setup.exec("CREATE TABLE products (name TEXT, price REAL, category TEXT)"));
+        QVERIFY(setup.exec("INSERT INTO products VALUES ('Laptop', 1299.99, 'Electronics'), "
+                           "('Cable', NULL, 'Other'), ('Desk', 599.0, 'Furniture'), ('50%_off', 10.0, 'Other')"));
+        
+        QForge::nsModel::QueryPredicateGroup group;
+        group.matchAll = false;
+        group.predicates.append({"category", "=", "electronics", QVariant(), true});
+        group.predicates.append({"name", "contains", "%_", QVariant(), false});
+        group.predicates.append({"price", "is_null", QVariant(), QVariant(), false});
+        QForge::nsModel::QueryFilter sqlFilter;
+        sqlFilter.groups.append(group);
+        
+        QueryContext context;
+        context.queryName = "load_all";
+        context.sql = "SELECT name, price, category FROM products ORDER BY name;";
+        context.filter = sqlFilter;
+        const QueryResult result = QForge::nsModel::SqlQueryHandlerFactory::getHandler(&db)(context);
+        QVERIFY2(result.ok, qPrintable(result.errors_log.join("; ")));
+        QVERIFY(result.filterApplied);
+        QStringList names;
+        for (const QVariantMap& row : result.rows) {
+            names.append(row.value("name").toString());
+        }
+        names.sort();
+        QCOMPARE(names, QStringList({"50%_off", "Cable", "Laptop"}));
+        
+        // Неизвестный оператор - запрос выполняется без фильтра
+        context.filter.groups[0].predicates.append({"name", "regex", ".*", QVariant(), false});
+        const QueryResult unfiltered = QForge::nsModel::SqlQueryHandlerFactory::getHandler(&db)(context);
+        QVERIFY(unfiltered.ok);
+        QVERIFY(!unfiltered.filterApplied);
+        QCOMPARE(unfiltered.rows.size(), 4);
+        
+        // Колонки фильтра нет в результате - фильтр остаётся модели
+        context.filter = sqlFilter;
+        context.sql = "SELECT name FROM products ORDER BY name;";
+        const QueryResult narrow = QForge::nsModel::SqlQueryHandlerFactory::getHandler(&db)(context);
+        QVERIFY(narrow.ok);
+        QVERIFY(!narrow.filterApplied);
+        QCOMPARE(narrow.rows.size(), 4);
+        
+        // Записывающий запрос не оборачивается
+        context.sql = "UPDATE products SET price = price WHERE name = 'Desk'";
+        const QueryResult write = QForge::nsModel::SqlQueryHandlerFactory::getHandler(&db)(context);
+        QVERIFY2(write.ok, qPrintable(write.errors_log.join("; ")));
+        QVERIFY(!write.filterApplied);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("filter_push_down");
+}
+
+void TableModelTests::testCsvReader()
+{
+    using QForge::nsModel::ColumnStore;
+    using QForge::nsModel::CsvFormat;
+    using QForge::nsModel::CsvReader;
+    using QForge::nsModel::PredicateKernels;
+    
+    qDebug() << "Тестирование чтения CSV";
+    
+    // Разделитель и кавычка - из import_settings
+    QForge::ImportSettings settings;
+    settings.csvDelimiter = ";";
+    settings.csvQuoteChar = "'";
+    const CsvFormat format = CsvFormat::fromSettings(settings);
+    QVERIFY(format.delimiter == ';');
+    QVERIFY(format.quote == '\'');
+    
+    // Файл в несколько мегабайт, чтобы разбиваться на куски; переводы строк и
+    // разделители внутри кавычек попадают и на границы кусков
+    const int rowCount = 60000;
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("products.csv");
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QByteArray text = "name; id ;note;price;in_stock;ignored\r\n";
+        for (int i = 0; i < rowCount; ++i) {
+            text += "item " + QByteArray::number(i) + ";" + QByteArray::number(i) + ";";
+            if (i % 7 == 0) {
+                text += "'multi;line\nnote ''" + QByteArray::number(i) + "'''";
+            } else {
+                text += "plain";
+            }
+            text += ";" + (i % 11 == 0 ? QByteArray() : QByteArray::number(i * 0.5)) + ";true;x";
+            text += (i % 2 ? "\r\n" : "\n");
+            if (i == rowCount / 2) {
+                text += "\n";
+            }
+        }
+        text += "short;-1";
+        QCOMPARE(file.write(text), qint64(text.size()));
+    }
+    
+    QVector<Column> columns(6);
+    columns[0].name = "id";
+    columns[0].type = ColumnType::Integer;
+    columns[1].name = "name";
+    columns[2].name = "price";
+    columns[2].type = ColumnType::Double;
+    columns[3].name = "in_stock";
+    columns[3].type = ColumnType::Boolean;
+    columns[4].name = "note";
+    columns[5].name = "missing";
+    columns[5].type = ColumnType::Integer;
+    
+    const PredicateKernels::Isa original = PredicateKernels::activeIsa();
+    QList<PredicateKernels::Isa> isas = {PredicateKernels::Isa::Scalar};
+    if (PredicateKernels::supportedIsa() >= PredicateKernels::Isa::Sse2) {
+        isas.append(PredicateKernels::Isa::Sse2);
+    }
+    if (PredicateKernels::supportedIsa() >= PredicateKernels::Isa::Avx2) {
+        isas.append(PredicateKernels::Isa::Avx2);
+    }
+    
+    ColumnStore reference;
+    for (PredicateKernels::Isa isa : std::as_const(isas)) {
+        PredicateKernels::setActiveIsa(isa);
+        
+        CsvReader reader(format);
+        QVERIFY2(reader.open(path), qPrintable(reader.errorString()));
+        QCOMPARE(reader.headers(), QStringList({"name", "id", "note", "price", "in_stock", "ignored"}));
+        
+        ColumnStore store;
+        store.reset(columns);
+        QCOMPARE(reader.read(store), rowCount + 1);
+        QCOMPARE(store.rowCount(), rowCount + 1);
+        
+        QCOMPARE(store.value(0, 1).toString(), QString("item 0"));
+        QCOMPARE(store.value(7, 4).toString(), QString("multi;line\nnote '7'"));
+        QCOMPARE(store.value(8, 4).toString(), QString("plain"));
+        QCOMPARE(store.value(12, 2).toDouble(), 6.0);
+        QVERIFY(store.value(11, 2).isNull());
+        QCOMPARE(store.value(rowCount - 1, 0).toLongLong(), qint64(rowCount - 1));
+        QCOMPARE(store.value(rowCount - 1, 3).toBool(), true);
+        QVERIFY(store.value(0, 5).isNull());
+        
+        // Последняя строка без перевода строки и с недостающими полями
+        QCOMPARE(store.value(rowCount, 1).toString(), QString("short"));
+        QCOMPARE(store.value(rowCount, 0).toLongLong(), qint64(-1));
+        QVERIFY(store.value(rowCount, 4).isNull());
+        
+        if (reference.rowCount() == 0) {
+            reference = store;
+        } else {
+            for (int row = 0; row < store.rowCount(); ++row) {
+                QCOMPARE(store.rowValues(row), reference.rowValues(row));
+            }
+        }
+    }
+    PredicateKernels::setActiveIsa(original);
+    
+    // Неприводимое значение переводит колонку в Variant, остальные значения сохраняются
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("id,price\n1,2.5\n2,n/a\n");
+    }
+    CsvReader reader;
+    QVERIFY(reader.open(path));
+    ColumnStore store;
+    store.reset(columns);
+    QCOMPARE(reader.read(store), 2);
+    QCOMPARE(store.value(0, 2).toDouble(), 2.5);
+    QCOMPARE(store.value(1, 2).toString(), QString("n/a"));
+    
+    // Границы строк
+    const QByteArray text = "a,'b\nc'\nd\n";
+    QCOMPARE(CsvReader::rowEnds(text.constData(), text.size(), '\''), QVector<qint64>({7, 9}));
+}
+
+void TableModelTests::testFieldParser()
+{
+    using QForge::nsModel::FieldParser;
+    using QForge::nsModel::TypedColumn;
+    
+    qDebug() << "Тестирование разбора полей по типу колонки";
+    
+    auto parse = [](const char* text, auto parser, auto& out) {
+        return parser(text, int(qstrlen(text)), out);
+    };
+    
+    qint64 i = 0;
+    QVERIFY(parse(" +42 ", FieldParser::parseInt64, i));
+    QCOMPARE(i, qint64(42));
+    QVERIFY(parse("-9223372036854775808", FieldParser::parseInt64, i));
+    QCOMPARE(i, std::numeric_limits<qint64>::min());
+    QVERIFY(!parse("12a", FieldParser::parseInt64, i));
+    QVERIFY(!parse("99999999999999999999", FieldParser::parseInt64, i));
+    QVERIFY(!parse("", FieldParser::parseInt64, i));
+    
+    double d = 0.0;
+    QVERIFY(parse("1.5e3", FieldParser::parseDouble, d));
+    QCOMPARE(d, 1500.0);
+    QVERIFY(parse("-0.25", FieldParser::parseDouble, d));
+    QCOMPARE(d, -0.25);
+    QVERIFY(!parse("1,5", FieldParser::parseDouble, d));
+    
+    qint64 b = 0;
+    QVERIFY(parse("TRUE", FieldParser::parseBoolean, b));
+    QCOMPARE(b, qint64(1));
+    QVERIFY(parse("no", FieldParser::parseBoolean, b));
+    QCOMPARE(b, qint64(0));
+    QVERIFY(!parse("maybe", FieldParser::parseBoolean, b));
+    
+    qint64 day = 0;
+    QVERIFY(parse("2024-02-29", FieldParser::parseDate, day));
+    QCOMPARE(day, QDate(2024, 2, 29).toJulianDay());
+    QVERIFY(!parse("2023-02-29", FieldParser::parseDate, day));
+    QVERIFY(!parse("2024-2-29", FieldParser::parseDate, day));
+    
+    qint64 ms = 0;
+    QVERIFY(parse("13:45:07.250", FieldParser::parseTime, ms));
+    QCOMPARE(ms, qint64(QTime(13, 45, 7, 250).msecsSinceStartOfDay()));
+    QVERIFY(parse("08:30", FieldParser::parseTime, ms));
+    QCOMPARE(ms, qint64(QTime(8, 30).msecsSinceStartOfDay()));
+    QVERIFY(!parse("24:00", FieldParser::parseTime, ms));
+    
+    // Зона задана явно - пересчёт без QDateTime; без зоны - местное время
+    QVERIFY(parse("2024-03-10T12:00:00Z", FieldParser::parseDateTime, ms));
+    QCOMPARE(ms, QDateTime(QDate(2024, 3, 10), QTime(12, 0), QTimeZone::utc()).toMSecsSinceEpoch());
+    QVERIFY(parse("2024-03-10 15:30+03:30", FieldParser::parseDateTime, ms));
+    QCOMPARE(ms, QDateTime(QDate(2024, 3, 10), QTime(12, 0), QTimeZone::utc()).toMSecsSinceEpoch());
+    QVERIFY(parse("2024-03-10T12:00:00", FieldParser::parseDateTime, ms));
+    QCOMPARE(ms, QDateTime(QDate(2024, 3, 10), QTime(12, 0)).toMSecsSinceEpoch());
+    QVERIFY(!parse("2024-03-10T12:00:00+3", FieldParser::parseDateTime, ms));
+    
+    // Запись в колонку: при неудаче значение не меняется
+    TypedColumn column(ColumnType::DateTime);
+    column.resize(2);
+    const FieldParser parser(column);
+    const QByteArray text = "2024-01-01T00:00:00";
+    QVERIFY(parser.store(text.constData(), text.size(), column, 1));
+    QCOMPARE(column.value(1).toDateTime(), QDateTime(QDate(2024, 1, 1), QTime(0, 0)));
+    QVERIFY(!parser.store("soon", 4, column, 0));
+    QCOMPARE(column.ints[0], qint64(0));
+}
+
+void TableModelTests::testQueryEngine()
+{
+    using QForge::nsModel::ColumnStore;
+    using QForge::nsModel::LocalQuery;
+    using QForge::nsModel::QueryContext;
+    using QForge::nsModel::QueryEngine;
+    using QForge::nsModel::QueryPredicate;
+    using QForge::nsModel::QueryPredicateGroup;
+    using QForge::nsModel::QueryResult;
+    
+    qDebug() << "Тестирование встроенного движка запросов";
+    
+    QVector<Column> columns(5);
+    columns[0].name = "id";
+    columns[0].type = ColumnType::Integer;
+    columns[1].name = "name";
+    columns[2].name = "category";
+    columns[3].name = "price";
+    columns[3].type = ColumnType::Double;
+    columns[4].name = "in_stock";
+    columns[4].type = ColumnType::Boolean;
+    
+    const int rowCount = 5000;
+    ColumnStore store;
+    store.reset(columns);
+    for (int i = 0; i < rowCount; ++i) {
+        store.appendRow({i, QString("item %1").arg(i), QString("cat %1").arg(i % 40),
+                         i % 50 == 0 ? QVariant() : QVariant((i % 100) * 0.5), i % 3 == 0});
+    }
+    
+    QueryEngine engine(store);
+    QVERIFY(engine.createIndex("category"));
+    QVERIFY(!engine.createIndex("missing"));
+    
+    // Параметр подставляется с типом, отбор идёт по индексу
+    QueryContext context;
+    context.sql = "FILTER category = ${category}";
+    context.bindings["category"] = "cat 3";
+    QueryResult result = engine.execute(context);
+    QVERIFY(result.ok);
+    QCOMPARE(result.rows.size(), rowCount / 40);
+    for (const QVariantMap& row : std::as_const(result.rows)) {
+        QCOMPARE(row.value("category").toString(), QString("cat 3"));
+    }
+    LocalQuery query;
+    QVERIFY(QueryEngine::parse(context.sql, context.bindings, query));
+    QCOMPARE(engine.explain(query), QString("index category"));
+    
+    // Индекс без учёта регистра, но сравнение - с учётом
+    context.bindings["category"] = "CAT 3";
+    QCOMPARE(engine.execute(context).rows.size(), 0);
+    
+    // Проекция, AND/OR, порядок и ограничение - сверяем с прямым перебором
+    const QString text = "SELECT id, price WHERE price >= 10 AND in_stock = true OR category IN ('cat 1', \"cat 2\") "
+                         "ORDER BY price DESC, id LIMIT 7 OFFSET 3";
+    QString error;
+    QVERIFY2(QueryEngine::parse(text, {}, query, &error), qPrintable(error));
+    QCOMPARE(query.columns, QStringList({"id", "price"}));
+    QCOMPARE(engine.explain(query), QString("scan"));
+    
+    QVector<int> expected;
+    for (int i = 0; i < rowCount; ++i) {
+        const bool priced = i % 50 != 0 && (i % 100) * 0.5 >= 10;
+        if ((priced && i % 3 == 0) || i % 40 == 1 || i % 40 == 2) {
+            expected.append(i);
+        }
+    }
+    std::stable_sort(expected.begin(), expected.end(), [](int lhs, int rhs) {
+        // NULL при убывании идёт последним
+        const double left = lhs % 50 == 0 ? -1.0 : (lhs % 100) * 0.5;
+        const double right = rhs % 50 == 0 ? -1.0 : (rhs % 100) * 0.5;
+        return left > right;
+    });
+    expected = expected.mid(3, 7);
+    
+    QVector<int> rows;
+    QVERIFY(engine.select(query, rows));
+    QCOMPARE(rows, expected);
+    
+    result = engine.run(query);
+    QVERIFY(result.ok);
+    QCOMPARE(result.rows.size(), expected.size());
+    QCOMPARE(result.rows.first().keys(), QStringList({"id", "price"}));
+    QCOMPARE(result.rows.first().value("id").toInt(), expected.first());
+    
+    // Фильтр модели выполняется вместе с запросом
+    QueryPredicate predicate;
+    predicate.column = "category";
+    predicate.op = "=";
+    predicate.value = "CAT 5";
+    predicate.caseInsensitive = true;
+    QueryPredicateGroup group;
+    group.predicates.append(predicate);
+    context = QueryContext();
+    context.sql = "WHERE in_stock = true";
+    context.filter.groups.append(group);
+    result = engine.execute(context);
+    QVERIFY(result.ok);
+    QVERIFY(result.filterApplied);
+    int inStock = 0;
+    for (int i = 5; i < rowCount; i += 40) {
+        inStock += i % 3 == 0 ? 1 : 0;
+    }
+    QCOMPARE(result.rows.size(), inStock);
+    
+    // После изменения хранилища индекс перестраивается
+    store.appendRow({rowCount, "extra", "cat 3", 1.0, true});
+    engine.rebuildIndexes();
+    context = QueryContext();
+    context.sql = "FILTER category = 'cat 3' AND id > 4990";
+    QCOMPARE(engine.execute(context).rows.size(), 1);
+    
+    // Ошибки разбора и неизвестные колонки
+    QVERIFY(!QueryEngine::parse("FILTER category =", {}, query));
+    QVERIFY(!QueryEngine::parse("FILTER category = ${missing}", {}, query, &error));
+    QVERIFY(error.contains("missing"));
+    QVERIFY(!QueryEngine::parse("FILTER category = 'open", {}, query));
+    QVERIFY(QueryEngine::parse("ORDER BY weight", {}, query));
+    QVERIFY(!engine.run(query).ok);
+}
+
+void TableModelTests::testCsvFileSource()
+{
+    using QForge::nsModel::CsvFileSource;
+    using QForge::nsModel::QueryContext;
+    
+    qDebug() << "Тестирование дочитывания дописываемого CSV-файла";
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("log.csv");
+    auto write = [&path](const QByteArray& text, QIODevice::OpenMode mode) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | mode));
+        QCOMPARE(file.write(text), qint64(text.size()));
+    };
+    write("id,name\n1,a\n2,b\n3,c\n", QIODevice::Truncate);
+    
+    ModelSchema schema;
+    schema.columns.resize(2);
+    schema.columns[0].name = "id";
+    schema.columns[0].type = ColumnType::Integer;
+    schema.columns[1].name = "name";
+    
+    CsvFileSource source(path, schema);
+    QCOMPARE(source.rowCount(), 3);
+    QVERIFY(source.createIndex("name"));
+    QSignalSpy appended(&source, &CsvFileSource::rowsAppended);
+    QSignalSpy reloaded(&source, &CsvFileSource::reloaded);
+    
+    // Дочитываются только завершённые строки; незавершённая ждёт перевода строки
+    write("4,d\n5,e", QIODevice::Append);
+    QVERIFY(source.refresh());
+    QCOMPARE(appended.count(), 1);
+    QCOMPARE(appended.last().at(0).toInt(), 3);
+    QCOMPARE(appended.last().at(1).toInt(), 1);
+    QCOMPARE(source.offset(), qint64(QByteArray("id,name\n1,a\n2,b\n3,c\n4,d\n").size()));
+    
+    write("\n", QIODevice::Append);
+    QVERIFY(source.refresh());
+    QCOMPARE(appended.count(), 2);
+    QCOMPARE(source.rows(4, 1).first().value("name").toString(), QString("e"));
+    
+    // Без изменений - без сигналов
+    QVERIFY(source.refresh());
+    QCOMPARE(appended.count(), 2);
+    QCOMPARE(reloaded.count(), 0);
+    
+    // Индекс дополняется вместе с хранилищем
+    QueryContext context;
+    context.sql = "FILTER name = 'e' OR id <= 1";
+    QCOMPARE(source.execute(context).rows.size(), 2);
+    context.sql = "FILTER name = 'e'";
+    QCOMPARE(source.execute(context).rows.size(), 1);
+    
+    // Укороченный файл и файл, переписанный до запомненного смещения, перечитываются целиком
+    write("id,name\n9,z\n", QIODevice::Truncate);
+    QVERIFY(source.refresh());
+    QCOMPARE(reloaded.count(), 1);
+    QCOMPARE(source.rowCount(), 1);
+    
+    write("id,name\n8,y\n7,x\n", QIODevice::Truncate);
+    QVERIFY(source.refresh());
+    QCOMPARE(reloaded.count(), 2);
+    QCOMPARE(source.rowCount(), 2);
+    QCOMPARE(source.rows(0, 1).first().value("id").toInt(), 8);
+    QCOMPARE(appended.count(), 2);
+    
+    // Изменение файла замечает QFileSystemWatcher
+    source.setWatching(true);
+    QTest::qWait(100);
+    write("6,w\n", QIODevice::Append);
+    QTRY_COMPARE_WITH_TIMEOUT(appended.count(), 3, 5000);
+    QCOMPARE(source.rowCount(), 3);
+    source.setWatching(false);
+    
+    // Последняя строка без перевода строки загружается при полном чтении
+    write("id,name\n1,a\n2,b", QIODevice::Truncate);
+    CsvFileSource tailSource(path, schema);
+    QCOMPARE(tailSource.rowCount(), 2);
+    QCOMPARE(tailSource.rows(1, 1).first().value("name").toString(), QString("b"));
+    QSignalSpy tailAppended(&tailSource, &CsvFileSource::rowsAppended);
+    QSignalSpy tailReloaded(&tailSource, &CsvFileSource::reloaded);
+    
+    // Завершённая дописыванием строка не меняется: сигнал только о новых строках
+    write("\n3,c\n", QIODevice::Append);
+    QVERIFY(tailSource.refresh());
+    QCOMPARE(tailSource.rowCount(), 3);
+    QCOMPARE(tailReloaded.count(), 0);
+    QCOMPARE(tailAppended.count(), 1);
+    QCOMPARE(tailAppended.last().at(0).toInt(), 2);
+    QCOMPARE(tailAppended.last().at(1).toInt(), 1);
+    
+    // Дописанная в ту же строку часть меняет уже отданную строку - данные перечитаны
+    write("id,name\n1,a\n2,b", QIODevice::Truncate);
+    QVERIFY(tailSource.reload());
+    write("x\n", QIODevice::Append);
+    QVERIFY(tailSource.refresh());
+    QCOMPARE(tailSource.rowCount(), 2);
+    QCOMPARE(tailSource.rows(1, 1).first().value("name").toString(), QString("bx"));
+    QCOMPARE(tailReloaded.count(), 2);
+}
+
+void TableModelTests::testSchemaCache()
+{
+    using QForge::nsModel::ModelFactory;
+    using QForge::nsModel::SchemaCache;
+    
+    qDebug() << "Тестирование двоичного кэша схем";
+    
+    // Кэш выключен, пока приложение его не включит
+    QVERIFY(SchemaCache::directory().isEmpty());
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString previousDirectory = SchemaCache::directory();
+    ModelFactory::setSchemaCacheDirectory(dir.filePath("cache"));
+    
+    const QString path = dir.filePath("AlbumModel.yml");
+    QVERIFY(QFile::copy(getProjectRoot() + "/examples/AlbumModel.yml", path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+    
+    // Холодная загрузка разбирает YAML и сохраняет кэш
+    ModelCore cold(path, dummyQueryHandler);
+    QVERIFY(cold.isValid());
+    const QString cacheFile = SchemaCache::cacheFile(path);
+    QVERIFY(QFile::exists(cacheFile));
+    
+    // Тёплая загрузка даёт ту же схему (разбор файла минуя SchemaRegistry)
+    QStringList errors;
+    ModelSchema warm;
+    QVERIFY(ModelCore::parseFile(path, warm, errors));
+    compareSchemas(createExpectedAlbumSchema(), warm);
+    QCOMPARE(SchemaCache::serialize(warm), SchemaCache::serialize(cold.getSchema()));
+    
+    // Схема берётся из кэша, пока не изменился исходный текст
+    QFile source(path);
+    QVERIFY(source.open(QIODevice::ReadOnly));
+    const QByteArray text = source.readAll();
+    source.close();
+    ModelSchema cached = cold.getSchema();
+    cached.description = "из кэша";
+    QVERIFY(SchemaCache::save(path, SchemaCache::sourceHash(text), cached));
+    ModelSchema fromCache;
+    QVERIFY(ModelCore::parseFile(path, fromCache, errors));
+    QCOMPARE(fromCache.description, QString("из кэша"));
+    
+    // Схема из кэша проверяется: не прошедшая проверку разбирается из текста заново
+    ModelSchema invalid = cold.getSchema();
+    invalid.columns.clear();
+    QVERIFY(SchemaCache::save(path, SchemaCache::sourceHash(text), invalid));
+    ModelSchema revalidated;
+    QVERIFY(ModelCore::parseFile(path, revalidated, errors));
+    QCOMPARE(revalidated.columns.size(), cold.getSchema().columns.size());
+    
+    // Изменённый файл разбирается заново, кэш перезаписывается
+    QVERIFY(source.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    source.write(QByteArray(text).replace("name: AlbumModel", "name: AlbumModel2"));
+    source.close();
+    ModelCore changed(path, dummyQueryHandler);
+    QVERIFY(changed.isValid());
+    QCOMPARE(changed.getSchema().name, QString("AlbumModel2"));
+    ModelSchema rewritten;
+    QVERIFY(ModelCore::parseFile(path, rewritten, errors));
+    QCOMPARE(rewritten.name, QString("AlbumModel2"));
+    
+    // Повреждённый кэш пропускается
+    QFile cache(cacheFile);
+    QVERIFY(cache.open(QIODevice::ReadWrite));
+    cache.resize(cache.size() / 2);
+    cache.close();
+    ModelSchema recovered;
+    QVERIFY(ModelCore::parseFile(path, recovered, errors));
+    QCOMPARE(recovered.columns.size(), changed.getSchema().columns.size());
+    QVERIFY(errors.isEmpty());
+    
+    ModelSchema broken;
+    QVERIFY(!SchemaCache::deserialize(text.constData(), text.size(), broken));
+    
+    SchemaCache::setDirectory(previousDirectory);
+}
+
+void TableModelTests::testSchemaRegistry()
+{
+    using QForge::nsModel::SchemaRegistry;
+    
+    qDebug() << "Тестирование общего реестра схем";
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("AlbumModel.yml");
+    QVERIFY(QFile::copy(getProjectRoot() + "/examples/AlbumModel.yml", path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+    SchemaRegistry& registry = SchemaRegistry::instance();
+    
+    // Модели одного файла разделяют один экземпляр схемы
+    ModelCore first(path, dummyQueryHandler);
+    ModelCore second(path, dummyQueryHandler);
+    QVERIFY(first.isValid());
+    QVERIFY(second.isValid());
+    QCOMPARE(first.sharedSchema().get(), second.sharedSchema().get());
+    QCOMPARE(registry.schema(path).get(), first.sharedSchema().get());
+    
+    TableModel model(path, dummyQueryHandler);
+    QVERIFY(model.isValid());
+    QCOMPARE(&model.getSchema(), first.sharedSchema().get());
+    
+    ModelCore own(first.getSchema(), dummyQueryHandler);
+    QVERIFY(own.sharedSchema().get() != first.sharedSchema().get());
+    
+    // Перезагрузка заменяет схему в реестре; выданный ранее экземпляр остаётся целым
+    QFile source(path);
+    QVERIFY(source.open(QIODevice::ReadOnly));
+    const QByteArray text = source.readAll();
+    source.close();
+    QVERIFY(source.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    source.write(QByteArray(text).replace("name: AlbumModel", "name: AlbumModelReloaded"));
+    source.close();
+    
+    // TableModel переходит на новую схему по сигналу; ModelCore - по refresh()
+    QSignalSpy reloaded(&registry, &SchemaRegistry::reloaded);
+    QVERIFY(first.reload());
+    QCOMPARE(reloaded.count(), 1);
+    QCOMPARE(first.getSchema().name, QString("AlbumModelReloaded"));
+    QCOMPARE(model.getSchema().name, QString("AlbumModelReloaded"));
+    QCOMPARE(second.getSchema().name, QString("AlbumModel"));
+    QVERIFY(second.refresh());
+    QCOMPARE(second.sharedSchema().get(), first.sharedSchema().get());
+    QCOMPARE(registry.schema(path).get(), first.sharedSchema().get());
+    
+    ModelCore third(path, dummyQueryHandler);
+    QCOMPARE(third.sharedSchema().get(), first.sharedSchema().get());
+    
+    // Правка того же размера с прежним временем изменения находится по хешу текста
+    const QDateTime modified = QFileInfo(path).lastModified();
+    QVERIFY(source.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    source.write(QByteArray(text).replace("name: AlbumModel", "name: AlbumModelReloadeX"));
+    source.close();
+    QFile touched(path);
+    QVERIFY(touched.open(QIODevice::ReadWrite));
+    QVERIFY(touched.setFileTime(modified, QFileDevice::FileModificationTime));
+    touched.close();
+    ModelCore edited(path, dummyQueryHandler);
+    QCOMPARE(edited.getSchema().name, QString("AlbumModelReloadeX"));
+    QCOMPARE(reloaded.count(), 2);
+    QCOMPARE(model.getSchema().name, QString("AlbumModelReloadeX"));
+    
+    // Ошибка разбора не трогает схему в реестре
+    QVERIFY(source.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    source.write("name: [unterminated\n");
+    source.close();
+    QVERIFY(!second.reload());
+    QVERIFY(!second.getErrors().isEmpty());
+    QCOMPARE(registry.schema(path).get(), edited.sharedSchema().get());
+    QCOMPARE(reloaded.count(), 2);
+    
+    registry.remove(path);
+    QVERIFY(!registry.schema(path));
+    QCOMPARE(first.getSchema().name, QString("AlbumModelReloaded"));
+    
+    // Схема без владельцев не держится реестром
+    const QString otherPath = dir.filePath("ProjectModel.yml");
+    QVERIFY(QFile::copy(getProjectRoot() + "/examples/ProjectModel.yml", otherPath));
+    {
+        ModelCore other(otherPath, dummyQueryHandler);
+        QVERIFY(other.isValid());
+        QVERIFY(registry.schema(otherPath));
+    }
+    QVERIFY(!registry.schema(otherPath));
+}
+
+void TableModelTests::testModelFactory()
+{
+    using QForge::nsModel::ModelFactory;
+    
+    qDebug() << "Тестирование пакетного создания моделей";
+    
+    const QString productPath = getProjectRoot() + "/examples/csv_demo/ProductModel.yml";
+    const QString albumPath = getProjectRoot() + "/examples/AlbumModel.yml";
+    const QString missingPath = getProjectRoot() + "/examples/Missing.yml";
+    
+    ModelFactory factory(productQueryHandler);
+    QSignalSpy finished(&factory, &ModelFactory::finished);
+    QVERIFY(factory.create({productPath, missingPath, productPath, albumPath}));
+    QVERIFY(factory.isRunning());
+    QVERIFY(!factory.create({productPath}));
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(!factory.isRunning());
+    
+    // Модели в порядке путей, загрузочные запросы выполнены
+    const QList<TableModel*> models = factory.models();
+    QCOMPARE(models.size(), 4);
+    QVERIFY(models[0] && models[2] && models[3]);
+    QVERIFY(!models[1]);
+    QCOMPARE(models[0]->rowCount(), 6);
+    QCOMPARE(models[2]->rowCount(), 6);
+    QCOMPARE(&models[0]->getSchema(), &models[2]->getSchema());
+    
+    const QStringList errors = factory.errors();
+    QVERIFY(!errors.isEmpty());
+    for (const QString& error : errors) {
+        QVERIFY2(error.startsWith(missingPath), qPrintable(error));
+    }
+    
+    const ModelFactory::Timings timings = factory.timings();
+    QVERIFY(timings.parseMs >= 0 && timings.constructMs >= 0 && timings.loadMs >= 0);
+    QVERIFY(timings.totalMs >= timings.parseMs + timings.constructMs);
+    qDebug() << "Фазы, мс: разбор" << timings.parseMs << "создание" << timings.constructMs
+             << "загрузка" << timings.loadMs << "всего" << timings.totalMs;
+    
+    // Забранные модели живут отдельно от фабрики
+    const QList<TableModel*> taken = factory.takeModels();
+    QCOMPARE(taken, models);
+    QVERIFY(!factory.models()[0]);
+    QCOMPARE(taken[0]->parent(), static_cast<QObject*>(nullptr));
+    qDeleteAll(taken);
+}
+
+void TableModelTests::testSchemaHotReload()
+{
+    qDebug() << "Тестирование горячей перезагрузки схемы";
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("HotModel.yml");
+    auto writeSchema = [&path](const QByteArray& headers, const QByteArray& columns) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("name: HotModel\ntype: table\nsource: query\nload_query: load_all\n"
+                   "horizontal_headers: " + headers + "\ncolumns:\n" + columns +
+                   "sorting:\n  - column: name\n    order: asc\n"
+                   "queries:\n  load_all:\n    sql: \"LOAD\"\n");
+    };
+    auto column = [](const QByteArray& name, const QByteArray& type) {
+        return "  - name: " + name + "\n    type: " + type + "\n";
+    };
+    
+    writeSchema("[\"ID\", \"Name\", \"Price\", \"Qty\", \"Category\"]",
+                column("id", "integer") + column("name", "string") + column("price", "double")
+                + column("quantity", "integer") + column("category", "string"));
+    TableModel model(path, productQueryHandler);
+    QVERIFY(model.isValid());
+    QVERIFY(model.execute("load_all").ok);
+    QCOMPARE(model.columnCount(), 5);
+    QPersistentModelIndex cable = model.index(0, 1);
+    QCOMPARE(cable.data().toString(), QString("Cable"));
+    
+    // quantity удалена, category переехала ко второй, note добавлена, id стала строкой
+    writeSchema("[\"ID\", \"Category\", \"Title\", \"Note\", \"Price\"]",
+                column("id", "string") + column("category", "string") + column("name", "string")
+                + column("note", "string") + column("price", "double"));
+    
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::columnsRemoved);
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::columnsMoved);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::columnsInserted);
+    QSignalSpy headerSpy(&model, &QAbstractItemModel::headerDataChanged);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy reloadedSpy(&model, &TableModel::schemaReloaded);
+    QVERIFY(model.reloadSchema());
+    
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(insertedSpy.count(), 1);
+    QVERIFY(headerSpy.count() >= 1);
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(reloadedSpy.count(), 1);
+    
+    // Строки не перечитывались: порядок по name сохранён, значения - по именам колонок
+    QCOMPARE(model.columnCount(), 5);
+    QCOMPARE(model.rowCount(), 6);
+    QCOMPARE(model.headerData(2, Qt::Horizontal).toString(), QString("Title"));
+    QCOMPARE(columnValues(model, 2), QStringList({"Cable", "Chair", "Coffee Maker", "Desk", "Laptop", "Phone"}));
+    QCOMPARE(columnValues(model, 1), QStringList({"Other", "Furniture", "Appliances", "Furniture", "Electronics", "Electronics"}));
+    QCOMPARE(model.data(model.index(0, 0)).toString(), QString("6"));
+    QVERIFY(model.data(model.index(0, 3)).isNull());
+    QCOMPARE(model.data(model.index(4, 4)).toDouble(), 1299.99);
+    QCOMPARE(cable.row(), 0);
+    QCOMPARE(cable.column(), 2);
+    
+    // Повторная перезагрузка без изменений ничего не меняет
+    QVERIFY(model.reloadSchema());
+    QCOMPARE(removedSpy.count() + movedSpy.count() + insertedSpy.count(), 3);
+    
+    // Ошибка в файле: модель остаётся со старой схемой
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("columns: [");
+    }
+    QVERIFY(!model.reloadSchema());
+    QVERIFY(!model.getLastError().isEmpty());
+    QCOMPARE(model.columnCount(), 5);
+    
+    // Слежение за файлом: исправленная схема подхватывается сама
+    model.setSchemaWatching(true);
+    QVERIFY(model.isSchemaWatching());
+    writeSchema("[\"ID\", \"Title\", \"Price\"]",
+                column("id", "string") + column("name", "string") + column("price", "double"));
+    QTRY_COMPARE(model.columnCount(), 3);
+    QCOMPARE(columnValues(model, 1), QStringList({"Cable", "Chair", "Coffee Maker", "Desk", "Laptop", "Phone"}));
+    QCOMPARE(resetSpy.count(), 0);
+    
+    model.setSchemaWatching(false);
+    QVERIFY(!model.isSchemaWatching());
+}
+
+void TableModelTests::testGeneratedSchema()
+{
+    using QForge::nsSchema::ProductModel;
+    
+    qDebug() << "Тестирование сгенерированного заголовка схемы";
+    
+    // Индексы и типы колонок известны на этапе компиляции
+    static_assert(ProductModel::Price == 2);
+    static_assert(ProductModel::ColumnCount == 7);
+    static_assert(ProductModel::columnIndex("in_stock") == ProductModel::InStock);
+    static_assert(ProductModel::columnIndex("missing") == -1);
+    static_assert(std::is_same_v<ProductModel::Field<ProductModel::Price>, double>);
+    static_assert(std::is_same_v<ProductModel::Field<ProductModel::LastUpdated>, QDateTime>);
+    
+    QString queryName;
+    QVariantMap bindings;
+    auto handler = [&queryName, &bindings](const QueryContext& context) {
+        queryName = context.queryName;
+        bindings = context.bindings;
+        return productQueryHandler(context);
+    };
+    
+    ProductModel::Model model(getProjectRoot() + "/examples/csv_demo/ProductModel.yml", handler);
+    QVERIFY(model.isValid());
+    QVERIFY(model.matchesSchema());
+    QVERIFY(model.queryLoadAll().ok);
+    QCOMPARE(queryName, QString("load_all"));
+    QCOMPARE(model.rowCount(), 6);
+    
+    // Типизированные значения совпадают с QVariant-доступом; NULL - пустой optional
+    for (int row = 0; row < model.rowCount(); ++row) {
+        QCOMPARE(*model.value<ProductModel::Name>(row), model.data(model.index(row, ProductModel::Name)).toString());
+        QCOMPARE(*model.value<ProductModel::Quantity>(row),
+                 model.data(model.index(row, ProductModel::Quantity)).toLongLong());
+    }
+    QVERIFY(!model.value<ProductModel::Price>(0).has_value());
+    QCOMPARE(*model.value<ProductModel::Price>(4), 1299.99);
+    QCOMPARE(*model.value<ProductModel::InStock>(1), false);
+    QVERIFY(!model.value<ProductModel::Name>(model.rowCount()).has_value());
+    
+    const ProductModel::Row laptop = model.rowAt(4);
+    QCOMPARE(*laptop.id, qint64(1));
+    QCOMPARE(*laptop.category, QString("Electronics"));
+    QCOMPARE(*laptop.last_updated, QDateTime(QDate(2024, 1, 15), QTime(10, 30)));
+    QVERIFY(!model.rowAt(0).last_updated.has_value());
+    
+    const ProductModel::Row copy = ProductModel::Row::fromMap(laptop.toMap());
+    QCOMPARE(*copy.price, 1299.99);
+    QCOMPARE(*copy.in_stock, true);
+    QVERIFY(!ProductModel::Row::fromMap(QVariantMap()).name.has_value());
+    
+    // Аргументы запроса передаются обработчику по именам из схемы
+    QVERIFY(model.queryFilterCategory("Furniture").ok);
+    QCOMPARE(queryName, QString("filter_category"));
+    QVERIFY(bindings.values().contains(QVariant("Furniture")));
+}
+
+void TableModelTests::testColumnIndex()
+{
+    using QForge::ColumnHandle;
+    using QForge::nsModel::ColumnStore;
+    
+    qDebug() << "Тестирование индекса колонок схемы";
+    
+    ModelSchema schema;
+    for (const QString& name : {"id", "name", "price"}) {
+        Column column;
+        column.name = name;
+        schema.addColumn(column);
+    }
+    QCOMPARE(schema.columnIndex("price"), 2);
+    QCOMPARE(schema.columnIndex("missing"), -1);
+    QVERIFY(schema.findColumn("name") == &schema.columns[1]);
+    
+    // Описатель хранит индекс; после удаления колонки он находит её заново по имени
+    const ColumnHandle price = schema.resolveColumn("price");
+    QVERIFY(price.isValid());
+    QCOMPARE(price.index(), 2);
+    QVERIFY(!schema.resolveColumn("missing").isValid());
+    schema.removeColumn("name");
+    QCOMPARE(schema.columnIndex("price"), 1);
+    QVERIFY(price.column(schema) == &schema.columns[1]);
+    QCOMPARE(schema.resolveColumn("price").index(), 1);
+    
+    // После прямого изменения колонок индекс перестраивается; промах возвращает -1
+    schema.columns[0].name = "key";
+    Column added;
+    added.name = "added";
+    schema.columns.prepend(added);
+    schema.rebuildColumnIndex();
+    QCOMPARE(schema.columnIndex("key"), 1);
+    QCOMPARE(schema.columnIndex("id"), -1);
+    QCOMPARE(schema.columnIndex("added"), 0);
+    QCOMPARE(schema.columnIndex("price"), 2);
+    QVERIFY(!schema.findColumn("optional"));
+    QCOMPARE(price.column(schema)->name, QString("price"));
+    
+    // Копия схемы (как в реестре) ищет по своему индексу
+    const ModelSchema copy = schema;
+    QVERIFY(copy.findColumn("key") == &copy.columns[1]);
+    
+    // Хранилище держит свой индекс при вставке, удалении и перемещении колонок
+    ColumnStore store;
+    store.reset(schema.columns);
+    QCOMPARE(store.columnIndex("price"), 2);
+    store.moveColumn(2, 0);
+    QCOMPARE(store.columnIndex("price"), 0);
+    QCOMPARE(store.columnIndex("added"), 1);
+    store.removeColumn(1);
+    QCOMPARE(store.columnIndex("key"), 1);
+    QCOMPARE(store.columnIndex("added"), -1);
+    store.insertColumn(0, added);
+    QCOMPARE(store.columnIndex("added"), 0);
+    QCOMPARE(store.columnIndex("key"), 2);
+}
+
+void TableModelTests::testCalculatedColumns()
+{
+    using QForge::nsModel::ColumnStore;
+    using QForge::nsModel::ExpressionCompiler;
+    using QForge::nsModel::ExpressionProgram;
+    using QForge::nsModel::ExpressionVM;
+    
+    qDebug() << "Тестирование вычисляемых колонок";
+    
+    QVector<Column> columns(5);
+    columns[0].name = "price";
+    columns[0].type = ColumnType::Double;
+    columns[1].name = "quantity";
+    columns[1].type = ColumnType::Integer;
+    columns[2].name = "name";
+    columns[2].type = ColumnType::String;
+    columns[3].name = "result";
+    columns[3].type = ColumnType::Double;
+    columns[3].isCalculated = true;
+    columns[4].name = "later";
+    columns[4].type = ColumnType::Double;
+    columns[4].isCalculated = true;
+    
+    // Ошибки компиляции
+    ExpressionProgram program;
+    QString error;
+    QVERIFY(!ExpressionCompiler::compile("price * missing", columns, 3, program, error));
+    QVERIFY(error.contains("missing"));
+    QVERIFY(!ExpressionCompiler::compile("name + 1", columns, 3, program, error));
+    QVERIFY(!ExpressionCompiler::compile("price * (quantity", columns, 3, program, error));
+    QVERIFY(!ExpressionCompiler::compile("result + 1", columns, 3, program, error));
+    QVERIFY(!ExpressionCompiler::compile("price 2", columns, 3, program, error));
+    QVERIFY(!ExpressionCompiler::compile("pow(price)", columns, 3, program, error));
+    QVERIFY(ExpressionCompiler::compile("result * 2", columns, 4, program, error));
+    
+    // Пачки больше kBatchSize: NULL в операнде, деление на ноль, ?:, функции
+    const int rows = ExpressionVM::kBatchSize * 2 + 7;
+    ColumnStore store;
+    store.reset(columns);
+    for (int row = 0; row < rows; ++row) {
+        store.appendRow({row % 10 == 0 ? QVariant() : QVariant(row * 0.5), row % 4, "x"});
+    }
+    ExpressionVM vm;
+    auto evaluate = [&](const QString& expression, int row) {
+        ExpressionProgram compiled;
+        QString message;
+        if (!ExpressionCompiler::compile(expression, columns, 3, compiled, message)) {
+            return QVariant("error: " + message);
+        }
+        vm.run(compiled, store, 0, rows, store.column(3));
+        return store.value(row, 3);
+    };
+    QCOMPARE(evaluate("price * quantity", 2051), QVariant(2051 * 0.5 * 3));
+    QVERIFY(evaluate("price * quantity", 2050).isNull());
+    QVERIFY(evaluate("price / quantity", 4).isNull());
+    QCOMPARE(evaluate("price % 2", 7), QVariant(1.5));
+    QCOMPARE(evaluate("quantity >= 2 && price < 100 ? -price : max(1, 2, quantity)", 3), QVariant(-1.5));
+    QCOMPARE(evaluate("quantity >= 2 && price < 100 ? -price : max(1, 2, quantity)", 5), QVariant(2.0));
+    QCOMPARE(evaluate("round(sqrt(abs(-16))) + floor(2.7) - ceil(0.2) + 1e1", 1), QVariant(15.0));
+    QVERIFY(evaluate("sqrt(-1)", 1).isNull());
+    QCOMPARE(evaluate("!(quantity == 1) + (quantity != 1)", 1), QVariant(0.0));
+    
+    // Модель: колонки из выражений видны через data(), пересчитываются при setData и сортируются
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("CalculatedModel.yml");
+    auto writeSchema = [&path](const QByteArray& total) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("name: CalculatedModel\ntype: table\nsource: query\nload_query: load_all\ncolumns:\n"
+                   "  - name: id\n    type: integer\n"
+                   "  - name: name\n    type: string\n"
+                   "  - name: price\n    type: double\n"
+                   "  - name: quantity\n    type: integer\n"
+                   "  - name: total\n    type: double\n    expression: \"" + total + "\"\n"
+                   "  - name: bulk\n    type: boolean\n    expression: \"total > 10000\"\n"
+                   "queries:\n  load_all:\n    sql: \"LOAD\"\n");
+    };
+    
+    writeSchema("price * quantity");
+    TableModel model(path, productQueryHandler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QCOMPARE(model.getSchema().columns[4].dependentColumns, QStringList({"price", "quantity"}));
+    QCOMPARE(model.getSchema().columns[5].dependentColumns, QStringList({"total"}));
+    QVERIFY(!(model.flags(model.index(0, 4)) & Qt::ItemIsEditable));
+    QVERIFY(model.execute("load_all").ok);
+    QCOMPARE(model.rowCount(), 6);
+    QCOMPARE(model.data(model.index(0, 4)).toDouble(), 1299.99 * 15);
+    QCOMPARE(model.data(model.index(0, 5)).toBool(), true);
+    QCOMPARE(model.data(model.index(2, 4)).toDouble(), 89.99 * 50);
+    QVERIFY(model.data(model.index(5, 4)).isNull());
+    
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY(model.setData(model.index(2, 3), 200));
+    QCOMPARE(model.data(model.index(2, 4)).toDouble(), 89.99 * 200);
+    QCOMPARE(model.data(model.index(2, 5)).toBool(), true);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy[0][0].value<QModelIndex>(), model.index(2, 3));
+    QCOMPARE(changedSpy[0][1].value<QModelIndex>(), model.index(2, 5));
+    
+    model.sort(4, Qt::DescendingOrder);
+    QCOMPARE(columnValues(model, 1).mid(0, 3), QStringList({"Phone", "Laptop", "Coffee Maker"}));
+    QVERIFY(model.setData(model.index(0, 3), 1));
+    QCOMPARE(columnValues(model, 1).mid(0, 3), QStringList({"Laptop", "Coffee Maker", "Desk"}));
+    
+    // Ошибка в выражении - ошибка разбора схемы
+    writeSchema("price * missing");
+    SchemaRegistry::instance().clear();
+    TableModel broken(path, productQueryHandler);
+    QVERIFY(!broken.isValid());
+    QVERIFY(broken.getLastError().contains("missing"));
+}
+
+void TableModelTests::testCalculationDependencies()
+{
+    using QForge::nsModel::CalculationPlan;
+    
+    qDebug() << "Тестирование графа зависимостей вычисляемых колонок";
+    
+    // Колонки a, b - данные; c = b * 2 ссылается на d, объявленную правее; d = a + 1; e = c + d
+    auto makeColumns = [](const QStringList& expressions) {
+        QVector<Column> columns;
+        const QStringList names = {"a", "b", "c", "d", "e"};
+        for (int i = 0; i < names.size(); ++i) {
+            Column column;
+            column.name = names[i];
+            column.type = ColumnType::Double;
+            if (i >= 2) {
+                column.isCalculated = true;
+                column.calculationExpression = expressions[i - 2];
+            }
+            columns.append(column);
+        }
+        return columns;
+    };
+    
+    CalculationPlan plan;
+    QStringList errors;
+    QVERIFY(plan.build(makeColumns({"b * d", "a + 1", "c + d"}), errors));
+    QVERIFY(errors.isEmpty());
+    QVector<int> order;
+    for (const auto& entry : plan.columns()) {
+        order.append(entry.column);
+    }
+    QCOMPARE(order, QVector<int>({3, 2, 4}));
+    
+    // Зависимые - транзитивно и в порядке пересчёта
+    auto dependents = [&plan](int column) {
+        QVector<int> result;
+        for (int position : plan.dependents(column)) {
+            result.append(plan.columns()[position].column);
+        }
+        return result;
+    };
+    QCOMPARE(dependents(0), QVector<int>({3, 2, 4}));
+    QCOMPARE(dependents(1), QVector<int>({2, 4}));
+    QCOMPARE(dependents(2), QVector<int>({4}));
+    QVERIFY(dependents(4).isEmpty());
+    QVERIFY(dependents(100).isEmpty());
+    
+    // Цикл c -> e -> c
+    QVERIFY(!plan.build(makeColumns({"e * 2", "a + 1", "c + d"}), errors));
+    QVERIFY(plan.isEmpty());
+    QCOMPARE(errors.size(), 1);
+    QVERIFY2(errors[0].contains("c -> e -> c"), qPrintable(errors[0]));
+    
+    // Модель: правка пересчитывает только зависимые колонки, dataChanged один на строку
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("DependencyModel.yml");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("name: DependencyModel\ntype: table\nsource: query\nload_query: load_all\ncolumns:\n"
+               "  - name: id\n    type: integer\n"
+               "  - name: name\n    type: string\n"
+               "  - name: price\n    type: double\n"
+               "  - name: quantity\n    type: integer\n"
+               "  - name: gross\n    type: double\n    expression: \"total * 1.2\"\n"
+               "  - name: total\n    type: double\n    expression: \"price * quantity\"\n"
+               "  - name: heavy\n    type: boolean\n    expression: \"quantity > 20\"\n"
+               "  - name: expensive\n    type: boolean\n    expression: \"price > 500\"\n"
+               "queries:\n  load_all:\n    sql: \"LOAD\"\n");
+    file.close();
+    
+    TableModel model(path, productQueryHandler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("load_all").ok);
+    QCOMPARE(model.data(model.index(0, 4)).toDouble(), 1299.99 * 15 * 1.2);
+    
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY(model.setData(model.index(0, 3), 30));
+    QCOMPARE(model.data(model.index(0, 5)).toDouble(), 1299.99 * 30);
+    QCOMPARE(model.data(model.index(0, 4)).toDouble(), 1299.99 * 30 * 1.2);
+    QCOMPARE(model.data(model.index(0, 6)).toBool(), true);
+    // expensive от quantity не зависит и в диапазон не входит
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy[0][0].value<QModelIndex>(), model.index(0, 3));
+    QCOMPARE(changedSpy[0][1].value<QModelIndex>(), model.index(0, 6));
+    
+    // Колонка без зависимых - только её ячейка
+    changedSpy.clear();
+    QVERIFY(model.setData(model.index(0, 1), "Notebook"));
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy[0][0].value<QModelIndex>(), model.index(0, 1));
+    QCOMPARE(changedSpy[0][1].value<QModelIndex>(), model.index(0, 1));
+    
+    // Цикл в файле схемы - ошибка разбора
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("name: CycleModel\ntype: table\ncolumns:\n"
+               "  - name: a\n    type: double\n    expression: \"b + 1\"\n"
+               "  - name: b\n    type: double\n    expression: \"a + 1\"\n");
+    file.close();
+    SchemaRegistry::instance().clear();
+    TableModel broken(path, productQueryHandler);
+    QVERIFY(!broken.isValid());
+    QVERIFY(broken.getLastError().contains("cycle"));
+}
+
+void TableModelTests::testForeignKeyLookup()
+{
+    using QForge::nsModel::LookupCache;
+    using QForge::nsModel::LookupTable;
+    
+    qDebug() << "Тестирование справочников внешних ключей";
+    
+    LookupCache::instance().clear();
+    
+    // Справочник категорий: ключ - название категории товара, display - код и надпись
+    QHash<QString, QString> titles = {
+        {"Electronics", "Техника"}, {"Appliances", "Бытовая техника"},
+        {"Furniture", "Мебель"}, {"Other", "Прочее"}, {"Garden", "Сад"}
+    };
+    QList<QueryContext> lookups;
+    QThread* lookupThread = nullptr;
+    auto handler = [&](const QueryContext& context) {
+        if (context.queryName != LookupTable::kQueryName) {
+            return productQueryHandler(context);
+        }
+        lookups.append(context);
+        lookupThread = QThread::currentThread();
+        QVariantList keys;
+        if (!context.filter.isEmpty()) {
+            keys = context.filter.groups[0].predicates[0].value.toList();
+        }
+        QueryResult result;
+        result.ok = true;
+        for (auto it = titles.constBegin(); it != titles.constEnd(); ++it) {
+            if (keys.isEmpty() || keys.contains(it.key())) {
+                result.rows.append({{"code", it.key()}, {"title", it.value()}, {"short", it.value().left(3)}});
+            }
+        }
+        result.filterApplied = !keys.isEmpty();
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto writeSchema = [&dir](const QString& name, const QByteArray& display, const QByteArray& load) {
+        const QString path = dir.filePath(name + ".yml");
+        QFile file(path);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write("name: " + name.toUtf8() + "\ntype: table\nsource: query\nload_query: load_all\ncolumns:\n"
+                       "  - name: id\n    type: integer\n"
+                       "  - name: name\n    type: string\n"
+                       "  - name: category\n    type: string\n"
+                       "    reference:\n      table: categories\n      column: code\n"
+                       "      display: " + display + "\n      load: " + load + "\n"
+                       "queries:\n  load_all:\n    sql: \"LOAD\"\n");
+        }
+        return path;
+    };
+    
+    // Загрузка всей таблицы: один запрос на все модели с тем же справочником
+    const QString allPath = writeSchema("LookupAll", "title", "all");
+    TableModel first(allPath, handler);
+    QVERIFY2(first.isValid(), qPrintable(first.getLastError()));
+    QCOMPARE(first.getSchema().columns[2].referenceTable, QString("categories"));
+    QVERIFY(first.execute("load_all").ok);
+    QCOMPARE(lookups.size(), 1);
+    QVERIFY(lookups[0].filter.isEmpty());
+    QCOMPARE(lookups[0].sql, QString("SELECT code, title FROM categories"));
+    QCOMPARE(first.data(first.index(0, 2)).toString(), QString("Техника"));
+    QCOMPARE(first.data(first.index(0, 2), Qt::EditRole).toString(), QString("Electronics"));
+    QCOMPARE(first.data(first.index(5, 2)).toString(), QString("Прочее"));
+    
+    TableModel second(allPath, handler);
+    QVERIFY(second.execute("load_all").ok);
+    QCOMPARE(lookups.size(), 1);
+    QCOMPARE(LookupCache::instance().count(), 1);
+    QCOMPARE(second.data(second.index(2, 2)).toString(), QString("Бытовая техника"));
+    
+    // Загрузка по ключам: только ключи модели, догрузка - только новых
+    lookups.clear();
+    const QString keysPath = writeSchema("LookupKeys", "short", "keys");
+    TableModel byKeys(keysPath, handler);
+    QVERIFY(byKeys.execute("load_all").ok);
+    QCOMPARE(lookups.size(), 1);
+    QCOMPARE(lookups[0].filter.groups[0].predicates[0].op, QString("in"));
+    QCOMPARE(lookups[0].filter.groups[0].predicates[0].value.toList().size(), 4);
+    QCOMPARE(byKeys.data(byKeys.index(3, 2)).toString(), QString("Меб"));
+    
+    QVariantMap hose;
+    hose["id"] = 7;
+    hose["name"] = "Hose";
+    hose["category"] = "Garden";
+    byKeys.appendRows({hose});
+    QCOMPARE(lookups.size(), 2);
+    QCOMPARE(lookups[1].filter.groups[0].predicates[0].value.toList(), QVariantList({"Garden"}));
+    QCOMPARE(byKeys.data(byKeys.index(6, 2)).toString(), QString("Сад"));
+    
+    // Известный ключ и отсутствующий в справочнике: без повторных запросов, показывается ключ
+    QVERIFY(byKeys.setData(byKeys.index(6, 2), "Furniture"));
+    QVERIFY(byKeys.setData(byKeys.index(5, 2), "Unknown"));
+    QVERIFY(byKeys.setData(byKeys.index(4, 2), "Unknown"));
+    QCOMPARE(lookups.size(), 3);
+    QCOMPARE(byKeys.data(byKeys.index(6, 2)).toString(), QString("Меб"));
+    QCOMPARE(byKeys.data(byKeys.index(5, 2)).toString(), QString("Unknown"));
+    
+    // Сброс справочника таблицы перезагружает его во всех моделях
+    titles["Electronics"] = "Электроника";
+    lookups.clear();
+    QSignalSpy firstSpy(&first, &QAbstractItemModel::dataChanged);
+    QSignalSpy secondSpy(&second, &QAbstractItemModel::dataChanged);
+    first.invalidateLookups();
+    QCOMPARE(lookups.size(), 2); // Один раз общий "all" и один раз "keys"
+    QCOMPARE(firstSpy.count(), 1);
+    QCOMPARE(secondSpy.count(), 1);
+    QCOMPARE(firstSpy[0][0].value<QModelIndex>(), first.index(0, 2));
+    QCOMPARE(first.data(first.index(0, 2)).toString(), QString("Электроника"));
+    QCOMPARE(second.data(second.index(0, 2)).toString(), QString("Электроника"));
+    QCOMPARE(byKeys.data(byKeys.index(0, 2)).toString(), QString("Эле"));
+    
+    // Сброс справочников другой таблицы моделей не касается
+    lookups.clear();
+    firstSpy.clear();
+    TableModel::invalidateLookup("suppliers");
+    QCOMPARE(lookups.size(), 0);
+    QCOMPARE(firstSpy.count(), 0);
+    
+    // Отсутствовавший ключ запрашивается снова после интервала повтора
+    const std::shared_ptr<LookupTable> shortTitles = LookupCache::instance().table("categories", "code", "short");
+    shortTitles->setMissingRetryInterval(0);
+    QVERIFY(byKeys.setData(byKeys.index(4, 2), "Missing"));
+    QVERIFY(byKeys.setData(byKeys.index(3, 2), "Missing"));
+    QCOMPARE(lookups.size(), 2);
+    titles["Missing"] = "Найдено";
+    QVERIFY(byKeys.setData(byKeys.index(2, 2), "Missing"));
+    QCOMPARE(lookups.size(), 3);
+    QCOMPARE(byKeys.data(byKeys.index(2, 2)).toString(), QString("Най"));
+    
+    // После executeAsync справочник догружается в пуле потоков, модель сообщает dataChanged
+    shortTitles->invalidate();
+    lookups.clear();
+    lookupThread = nullptr;
+    TableModel asyncModel(keysPath, handler);
+    QSignalSpy asyncChanged(&asyncModel, &QAbstractItemModel::dataChanged);
+    QSignalSpy asyncFinished(&asyncModel, &TableModel::executionFinished);
+    asyncModel.executeAsync("load_all");
+    QTRY_COMPARE(asyncFinished.count(), 1);
+    QTRY_COMPARE(asyncChanged.count(), 1);
+    QCOMPARE(asyncChanged[0][0].value<QModelIndex>(), asyncModel.index(0, 2));
+    QCOMPARE(lookups.size(), 1);
+    QVERIFY(lookupThread && lookupThread != QThread::currentThread());
+    QCOMPARE(asyncModel.data(asyncModel.index(0, 2)).toString(), QString("Эле"));
+    
+    LookupCache::instance().clear();
+}
+
+void TableModelTests::testTreeLazyLoading()
+{
+    qDebug() << "Тестирование дерева с ленивой загрузкой детей";
+    
+    // id, parent_id, name: 1 и 2 - верхний уровень; 3, 4 - дети 1; 5 - ребёнок 2; 6 - ребёнок 3
+    const QList<QVariantList> projects = {
+        {1, QVariant(), "Alpha"}, {2, QVariant(), "Beta"}, {3, 1, "Alpha/Design"},
+        {4, 1, "Alpha/Build"}, {5, 2, "Beta/Research"}, {6, 3, "Alpha/Design/Sketches"}
+    };
+    QList<QueryContext> contexts;
+    auto handler = [&](const QueryContext& context) {
+        contexts.append(context);
+        const QVariantList parents = context.bindings.value("parent_ids").toList();
+        QueryResult result;
+        result.ok = true;
+        for (const QVariantList& project : projects) {
+            const bool root = project[1].isNull();
+            if (context.queryName == "roots" ? root : (!root && parents.contains(project[1]))) {
+                result.rows.append({{"id", project[0]}, {"parent_id", project[1]}, {"name", project[2]}});
+            }
+        }
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("ProjectTree.yml");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("name: ProjectTree\ntype: tree\nload_query: roots\n"
+               "tree:\n  parent_column: parent_id\n  children_query: children\n"
+               "columns:\n"
+               "  - name: id\n    type: integer\n    is_primary_key: true\n"
+               "  - name: name\n    type: string\n"
+               "queries:\n"
+               "  roots:\n    sql: \"SELECT id, parent_id, name FROM projects WHERE parent_id IS NULL\"\n"
+               "  children:\n    sql: \"SELECT id, parent_id, name FROM projects WHERE parent_id IN (${parent_ids})\"\n");
+    file.close();
+    
+    TreeModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("roots").ok);
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(model.columnCount(), 2);
+    
+    const QModelIndex alpha = model.index(0, 0);
+    const QModelIndex beta = model.index(1, 0);
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("Alpha"));
+    QVERIFY(!model.parent(alpha).isValid());
+    QVERIFY(model.hasChildren(alpha));
+    QVERIFY(model.canFetchMore(alpha));
+    QCOMPARE(model.rowCount(alpha), 0);
+    
+    // Раскрытые на одном уровне узлы загружаются одним запросом
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    contexts.clear();
+    model.fetchMore(alpha);
+    model.fetchMore(beta);
+    QVERIFY(!model.canFetchMore(alpha));
+    QVERIFY(contexts.isEmpty());
+    model.fetchPending();
+    QCOMPARE(contexts.size(), 1);
+    QCOMPARE(contexts[0].queryName, QString("children"));
+    QVERIFY2(contexts[0].sql.endsWith("IN (:parent_ids_0, :parent_ids_1)"), qPrintable(contexts[0].sql));
+    QCOMPARE(contexts[0].bindings.value(":parent_ids_1"), QVariant(2));
+    QCOMPARE(insertedSpy.count(), 2);
+    QCOMPARE(model.rowCount(alpha), 2);
+    QCOMPARE(model.rowCount(beta), 1);
+    
+    const QModelIndex design = model.index(0, 0, alpha);
+    const QModelIndex research = model.index(0, 0, beta);
+    QCOMPARE(model.data(model.index(1, 1, alpha)).toString(), QString("Alpha/Build"));
+    QCOMPARE(model.parent(design), alpha);
+    QCOMPARE(model.parent(model.index(0, 1, beta)), beta);
+    QCOMPARE(model.indexOfKey(4), model.index(1, 0, alpha));
+    QVERIFY(!model.indexOfKey(6).isValid());
+    
+    // Следующий уровень: запрос откладывается до цикла событий; лист после загрузки не раскрывается
+    contexts.clear();
+    model.fetchMore(design);
+    model.fetchMore(research);
+    QTRY_COMPARE(contexts.size(), 1);
+    QCOMPARE(contexts[0].bindings.value("parent_ids").toList(), QVariantList({3, 5}));
+    QVERIFY(!model.hasChildren(research));
+    QVERIFY(!model.canFetchMore(research));
+    QCOMPARE(model.data(model.index(0, 1, design)).toString(), QString("Alpha/Design/Sketches"));
+    QCOMPARE(model.parent(model.index(0, 0, design)), design);
+    
+    // Повторный execute заменяет дерево
+    QVERIFY(model.execute("roots").ok);
+    QCOMPARE(model.rowCount(), 2);
+    QVERIFY(model.canFetchMore(model.index(0, 0)));
+    QVERIFY(!model.indexOfKey(3).isValid());
+    
+    // Запрос детей должен существовать
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("name: BrokenTree\ntype: tree\n"
+               "tree:\n  children_query: missing\n"
+               "columns:\n  - name: id\n    type: integer\n    is_primary_key: true\n");
+    file.close();
+    SchemaRegistry::instance().clear();
+    TreeModel broken(path, handler);
+    QVERIFY(!broken.isValid());
+    QVERIFY(broken.getLastError().contains("missing"));
+}
+
+void TableModelTests::testTreeFlatBuild()
+{
+    qDebug() << "Тестирование построения дерева из плоского результата и правки поддеревьев";
+    
+    // 7 - сирота, 8 и 9 ссылаются друг на друга, 10 - сам на себя
+    QList<QVariantList> projects = {
+        {1, QVariant(), "Alpha"}, {2, QVariant(), "Beta"}, {3, 1, "Alpha/Design"}, {4, 1, "Alpha/Build"},
+        {5, 2, "Beta/Research"}, {6, 3, "Alpha/Design/Sketches"}, {7, 99, "Orphan"},
+        {8, 9, "Loop A"}, {9, 8, "Loop B"}, {10, 10, "Self"}
+    };
+    auto handler = [&](const QueryContext& context) {
+        Q_UNUSED(context)
+        QueryResult result;
+        result.ok = true;
+        for (const QVariantList& project : std::as_const(projects)) {
+            result.rows.append({{"id", project[0]}, {"parent_id", project[1]}, {"name", project[2]}});
+        }
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("FlatTree.yml");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("name: FlatTree\ntype: tree\n"
+               "tree:\n  parent_column: parent_id\n"
+               "columns:\n"
+               "  - name: id\n    type: integer\n    is_primary_key: true\n"
+               "  - name: parent_id\n    type: integer\n"
+               "  - name: name\n    type: string\n"
+               "queries:\n"
+               "  all:\n    sql: \"SELECT id, parent_id, name FROM projects\"\n"
+               "  subtree:\n    sql: \"SELECT id, parent_id, name FROM projects WHERE root_id = :id\"\n");
+    file.close();
+    
+    TreeModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("all").ok);
+    
+    // Один проход строит всю иерархию; сироты и узлы циклов - на верхнем уровне
+    QCOMPARE(model.rowCount(), 5);
+    QCOMPARE(model.data(model.index(2, 2)).toString(), QString("Orphan"));
+    QCOMPARE(model.data(model.index(3, 0)).toInt(), 8);
+    QCOMPARE(model.parent(model.indexOfKey(9)), model.indexOfKey(8));
+    QCOMPARE(model.data(model.index(4, 0)).toInt(), 10);
+    QCOMPARE(model.rowCount(model.indexOfKey(1)), 2);
+    QCOMPARE(model.parent(model.indexOfKey(6)), model.indexOfKey(3));
+    QVERIFY(!model.hasChildren(model.indexOfKey(10)));
+    QVERIFY(!model.canFetchMore(model.indexOfKey(6)));
+    
+    // Обновление поддерева: новый узел, перенос, удаление и изменение значений без сброса
+    projects = {
+        {1, QVariant(), "Alpha*"}, {3, 4, "Alpha/Design"}, {4, 1, "Alpha/Build"}, {11, 3, "Alpha/Design/Specs"}
+    };
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY2(model.refreshSubtree(1, "subtree", {{"id", 1}}), qPrintable(model.getLastError()));
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(model.data(model.indexOfKey(1, 2)).toString(), QString("Alpha*"));
+    QCOMPARE(model.rowCount(model.indexOfKey(1)), 1);
+    QCOMPARE(model.parent(model.indexOfKey(3)), model.indexOfKey(4));
+    QCOMPARE(model.parent(model.indexOfKey(11)), model.indexOfKey(3));
+    QCOMPARE(model.data(model.indexOfKey(3, 1)).toInt(), 4);
+    QVERIFY(!model.indexOfKey(6).isValid());
+    QCOMPARE(model.rowCount(), 5);
+    QVERIFY(!model.refreshSubtree(42, "subtree"));
+    
+    // Перенос узла: значение parent_id следует за новым родителем
+    movedSpy.clear();
+    QVERIFY(model.moveNode(5, 1, 0));
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(model.indexOfKey(5), model.index(0, 0, model.indexOfKey(1)));
+    QCOMPARE(model.data(model.indexOfKey(5, 1)).toInt(), 1);
+    QVERIFY(!model.hasChildren(model.indexOfKey(2)));
+    QVERIFY(!model.moveNode(1, 11));
+    QVERIFY(!model.moveNode(5, 42));
+    
+    QVERIFY(model.moveNode(4, QVariant()));
+    QCOMPARE(model.rowCount(), 6);
+    QVERIFY(model.data(model.indexOfKey(4, 1)).isNull());
+    QCOMPARE(model.parent(model.indexOfKey(11)), model.indexOfKey(3));
+    
+    // Перестановка среди соседей: позиция считается без самого узла
+    QVERIFY(model.moveNode(2, QVariant(), 3));
+    QCOMPARE(model.data(model.index(3, 0)).toInt(), 2);
+    QCOMPARE(model.data(model.index(1, 0)).toInt(), 7);
+    QCOMPARE(model.indexOfKey(2).row(), 3);
+    QCOMPARE(model.indexOfKey(10).row(), 4);
+}
+
+void TableModelTests::testTreeSqlite()
+{
+    qDebug() << "Тестирование дерева над SQLite";
+    
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("Драйвер QSQLITE недоступен");
+    }
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("SqliteTree.yml");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("name: SqliteTree\ntype: tree\n"
+               "tree:\n  parent_column: parent_id\n  children_query: children\n"
+               "columns:\n"
+               "  - name: id\n    type: integer\n    is_primary_key: true\n"
+               "  - name: parent_id\n    type: integer\n"
+               "  - name: name\n    type: string\n"
+               "queries:\n"
+               "  roots:\n    sql: \"SELECT id, parent_id, name FROM projects WHERE parent_id IS NULL AND owner = ${owner}\"\n"
+               "  children:\n    sql: \"SELECT id, parent_id, name FROM projects WHERE parent_id IN (${parent_ids})\"\n"
+               "  subtree:\n    sql: \"SELECT id, parent_id, name FROM projects WHERE id = ${id} OR parent_id = ${id}\"\n");
+    file.close();
+    
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "tree_sqlite");
+        db.setDatabaseName(":memory:");
+        QVERIFY(db.open());
+        QSqlQuery setup(db);
+        QVERIFY(setup.exec("CREATE TABLE projects (id INTEGER PRIMARY KEY, parent_id INTEGER, name TEXT, owner TEXT)"));
+        QVERIFY(setup.exec("INSERT INTO projects VALUES (1, NULL, 'Alpha', 'ann'), (2, NULL, 'Beta', 'ann'), "
+                           "(3, 1, 'Alpha/Design', 'ann'), (4, 1, 'Alpha/Build', 'ann'), "
+                           "(5, 2, 'Beta/Research', 'ann'), (6, NULL, 'Gamma', 'bob')"));
+        
+        // Скалярный ${owner} передаётся в БД именованным параметром
+        TreeModel model(path, &db);
+        QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+        const QueryResult roots = model.execute("roots", {{"owner", "ann"}});
+        QVERIFY2(roots.ok, qPrintable(roots.errors_log.join("; ")));
+        QCOMPARE(model.rowCount(), 2);
+        
+        const QModelIndex alpha = model.indexOfKey(1);
+        model.fetchMore(alpha);
+        model.fetchPending();
+        QCOMPARE(model.rowCount(alpha), 2);
+        QCOMPARE(model.data(model.index(1, 2, alpha)).toString(), QString("Alpha/Build"));
+        
+        // Дети догружаются после уже перенесённого под узел: вставка - за ним
+        QVERIFY(model.moveNode(4, 2));
+        QVERIFY(setup.exec("UPDATE projects SET parent_id = 2 WHERE id = 4"));
+        const QModelIndex beta = model.indexOfKey(2);
+        QVERIFY(model.canFetchMore(beta));
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        model.fetchMore(beta);
+        model.fetchPending();
+        QCOMPARE(insertedSpy.count(), 1);
+        QCOMPARE(insertedSpy[0][0].value<QModelIndex>(), beta);
+        QCOMPARE(insertedSpy[0][1].toInt(), 1);
+        QCOMPARE(insertedSpy[0][2].toInt(), 1);
+        QCOMPARE(model.rowCount(beta), 2);
+        QCOMPARE(model.data(model.index(0, 0, beta)).toInt(), 4);
+        QCOMPARE(model.data(model.index(1, 0, beta)).toInt(), 5);
+        
+        // Поддерево перечитывается из БД: изменённый узел и новый ребёнок
+        QVERIFY(setup.exec("UPDATE projects SET name = 'Alpha/Design*' WHERE id = 3"));
+        QVERIFY(setup.exec("INSERT INTO projects VALUES (7, 1, 'Alpha/Test', 'ann')"));
+        setup.finish();
+        insertedSpy.clear();
+        QVERIFY2(model.refreshSubtree(1, "subtree", {{"id", 1}}), qPrintable(model.getLastError()));
+        QCOMPARE(insertedSpy.count(), 1);
+        QCOMPARE(model.rowCount(alpha), 2);
+        QCOMPARE(model.data(model.indexOfKey(3, 2)).toString(), QString("Alpha/Design*"));
+        QCOMPARE(model.parent(model.indexOfKey(7)), alpha);
+        QCOMPARE(model.rowCount(beta), 2);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("tree_sqlite");
+}
+
+void TableModelTests::testEditBuffer()
+{
+    qDebug() << "Тестирование буфера правок с пакетной записью в источник";
+    
+    bool commitOk = true;
+    int completedSteps = 0;
+    QList<QVariantMap> generated;
+    QList<QueryContext> commits;
+    auto handler = [&](const QueryContext& context) {
+        if (context.batch.isEmpty()) {
+            return itemsQueryHandler(context);
+        }
+        commits.append(context);
+        QueryResult result;
+        result.ok = commitOk;
+        result.completedSteps = commitOk ? int(context.batch.size()) : completedSteps;
+        result.rows = generated;
+        if (!commitOk) {
+            result.log("constraint violation");
+        }
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, kItemsSchema + "queries:\n"
+                                                         "  select_all:\n    sql: \"SELECT id, name, price FROM items\"\n"
+                                                         "  update:\n    is_transactional: true\n    arguments:\n"
+                                                         "      - { name: id, type: integer }\n"
+                                                         "      - { name: name, type: string, is_optional: true }\n"
+                                                         "      - { name: price, type: double, is_optional: true }\n"
+                                                         "    sql: \"UPDATE items SET name = COALESCE(${name}, name), price = COALESCE(${price}, price) WHERE id = ${id}\"\n"
+                                                         "  insert:\n    sql: \"INSERT INTO items (id, name, price) VALUES (${id}, ${name}, ${price})\"\n"
+                                                         "  remove:\n    arguments:\n      - { name: id, type: integer }\n"
+                                                         "    sql: \"DELETE FROM items WHERE id = ${id}\"\n");
+    QVERIFY(!path.isEmpty());
+    
+    TableModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("select_all").ok);
+    QCOMPARE(model.editStrategy(), TableModel::EditStrategy::LocalOnly);
+    model.setEditStrategy(TableModel::EditStrategy::OnManualSubmit);
+    
+    // Несколько правок одной строки - одна запись буфера; удаление и добавление - тоже
+    QVERIFY(model.setData(model.index(0, 1), "A2"));
+    QVERIFY(model.setData(model.index(0, 2), 11.0));
+    QVERIFY(model.setData(model.index(0, 1), "A3"));
+    QVERIFY(model.setData(model.index(1, 2), 21.0));
+    QVERIFY(model.removeRows(2, 1));
+    model.appendRows({{{"id", 5}, {"name", "E"}, {"price", 50.0}}});
+    QCOMPARE(columnValues(model, 1), QStringList({"A3", "B", "D", "E"}));
+    QVERIFY(model.isDirty());
+    QVERIFY(model.isDirty(model.index(0, 1)));
+    QVERIFY(!model.isDirty(model.index(0, 0)));
+    QVERIFY(model.isDirty(model.index(3, 0)));
+    
+    // Представление вызывает submit() после каждой правки: при ручной записи это не запись
+    QVERIFY(model.submit());
+    QVERIFY(commits.isEmpty());
+    
+    // Ошибка источника оставляет буфер нетронутым
+    commitOk = false;
+    QVERIFY(!model.submitAll());
+    QVERIFY(model.getLastError().contains("constraint violation"));
+    QVERIFY(model.isDirty());
+    
+    commitOk = true;
+    commits.clear();
+    QVERIFY2(model.submitAll(), qPrintable(model.getLastError()));
+    QVERIFY(!model.isDirty());
+    QCOMPARE(commits.size(), 1);
+    const QueryContext commit = commits.first();
+    QCOMPARE(commit.queryName, QString("qforge_commit"));
+    QVERIFY(commit.transactional);
+    QCOMPARE(commit.batch.size(), 3);
+    QCOMPARE(commit.batch[0].queryName, QString("remove"));
+    QCOMPARE(commit.batch[0].bindings.size(), 1);
+    QCOMPARE(commit.batch[0].bindings[0].value("id").toInt(), 3);
+    QCOMPARE(commit.batch[1].queryName, QString("update"));
+    QCOMPARE(commit.batch[1].bindings.size(), 2);
+    QCOMPARE(commit.batch[1].bindings[0].value("name").toString(), QString("A3"));
+    QCOMPARE(commit.batch[1].bindings[0].value("price").toDouble(), 11.0);
+    QCOMPARE(commit.batch[1].bindings[1].value("id").toInt(), 2);
+    QVERIFY(commit.batch[1].bindings[1].value("name").isNull());
+    QCOMPARE(commit.batch[1].bindings[1].value("price").toDouble(), 21.0);
+    QCOMPARE(commit.batch[2].queryName, QString("insert"));
+    QCOMPARE(commit.batch[2].bindings.size(), 1);
+    QCOMPARE(commit.batch[2].bindings[0].value("name").toString(), QString("E"));
+    
+    // Откат: исходные значения, удалённые строки возвращаются на свои места, добавленная убирается
+    QCOMPARE(columnValues(model, 1), QStringList({"A3", "B", "D", "E"}));
+    QVERIFY(model.setData(model.index(0, 1), "Z"));
+    QVERIFY(model.removeRows(2, 1));
+    model.appendRows({{{"id", 6}, {"name", "F"}, {"price", 60.0}}});
+    QVERIFY(model.removeRows(1, 1));
+    QCOMPARE(columnValues(model, 1), QStringList({"Z", "E", "F"}));
+    model.revertAll();
+    QVERIFY(!model.isDirty());
+    QCOMPARE(columnValues(model, 1), QStringList({"A3", "B", "D", "E"}));
+    QCOMPARE(model.data(model.index(1, 2)).toDouble(), 21.0);
+    
+    // Запись каждой правки сразу
+    model.setEditStrategy(TableModel::EditStrategy::OnFieldChange);
+    commits.clear();
+    QVERIFY(model.setData(model.index(0, 2), 12.0));
+    QCOMPARE(commits.size(), 1);
+    QCOMPARE(commits[0].batch.size(), 1);
+    QCOMPARE(commits[0].batch[0].queryName, QString("update"));
+    QVERIFY(!model.isDirty());
+    
+    // Правка, которую источник не принял, откатывается
+    commitOk = false;
+    QVERIFY(!model.setData(model.index(0, 2), 13.0));
+    QCOMPARE(model.data(model.index(0, 2)).toDouble(), 12.0);
+    QVERIFY(model.getLastError().contains("constraint violation"));
+    QVERIFY(!model.removeRows(3, 1));
+    model.appendRows({{{"id", 7}, {"name", "G"}, {"price", 70.0}}});
+    QCOMPARE(columnValues(model, 1), QStringList({"A3", "D", "E", "B"}));
+    QVERIFY(!model.isDirty());
+    
+    // Пакет без транзакции записан частично: в буфере остаются только незаписанные шаги
+    model.setEditStrategy(TableModel::EditStrategy::OnManualSubmit);
+    QVERIFY(model.removeRows(3, 1));
+    QVERIFY(model.setData(model.index(0, 1), "A4"));
+    completedSteps = 1;
+    QVERIFY(!model.submitAll());
+    QVERIFY(model.isDirty(model.index(0, 1)));
+    commitOk = true;
+    commits.clear();
+    QVERIFY2(model.submitAll(), qPrintable(model.getLastError()));
+    QCOMPARE(commits.size(), 1);
+    QCOMPARE(commits[0].batch.size(), 1);
+    QCOMPARE(commits[0].batch[0].queryName, QString("update"));
+    
+    // Ключ добавленной строки выдаёт источник: он читается обратно в модель
+    model.appendRows({{{"name", "H"}, {"price", 80.0}}});
+    QVERIFY(model.data(model.index(3, 0)).isNull());
+    generated = {{{"id", 8}}};
+    commits.clear();
+    QSignalSpy keySpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY2(model.submitAll(), qPrintable(model.getLastError()));
+    QCOMPARE(commits[0].batch[0].returning, QStringList({"id"}));
+    QCOMPARE(model.data(model.index(3, 0)).toInt(), 8);
+    QCOMPARE(keySpy.count(), 1);
+    QCOMPARE(keySpy[0][0].value<QModelIndex>(), model.index(3, 0));
+    
+    // При сортировке по ключу строка с прочитанным ключом встаёт на своё место
+    model.sort(0, Qt::DescendingOrder);
+    model.appendRows({{{"name", "I"}, {"price", 90.0}}});
+    generated = {{{"id", 9}}};
+    QVERIFY2(model.submitAll(), qPrintable(model.getLastError()));
+    QCOMPARE(model.data(model.index(0, 0)).toInt(), 9);
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("I"));
+    generated.clear();
+}
+
+void TableModelTests::testEditBufferSqlite()
+{
+    qDebug() << "Тестирование пакетной записи правок в SQLite";
+    
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("Драйвер QSQLITE недоступен");
+    }
+    
+    // Пакет в SQLite: execBatch и откат всей транзакции при ошибке одного шага
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "edit_buffer");
+        db.setDatabaseName(":memory:");
+        QVERIFY(db.open());
+        QSqlQuery setup(db);
+        QVERIFY(setup.exec("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT, price REAL)"));
+        QVERIFY(setup.exec("INSERT INTO items VALUES (1, 'A', 10.0), (2, 'B', 20.0)"));
+        
+        QueryContext batch;
+        batch.transactional = true;
+        batch.batch.append({"update", "UPDATE items SET price = ${price} WHERE id = ${id}",
+                            {{{"id", 1}, {"price", 11.0}}, {{"id", 2}, {"price", 21.0}}}});
+        batch.batch.append({"insert", "INSERT INTO items (id, name, price) VALUES (:id, :name, :price)",
+                            {{{"id", 3}, {"name", "C"}, {"price", 30.0}}, {{"id", 1}, {"name", "dup"}, {"price", 0.0}}}});
+        auto handler = QForge::nsModel::SqlQueryHandlerFactory::getHandler(&db);
+        QVERIFY(!handler(batch).ok);
+        QVERIFY(setup.exec("SELECT COUNT(*), SUM(price) FROM items") && setup.next());
+        QCOMPARE(setup.value(0).toInt(), 2);
+        QCOMPARE(setup.value(1).toDouble(), 30.0);
+        setup.finish();
+        
+        batch.batch[1].bindings.removeLast();
+        const QueryResult result = handler(batch);
+        QVERIFY2(result.ok, qPrintable(result.errors_log.join("; ")));
+        QVERIFY(setup.exec("SELECT COUNT(*), SUM(price) FROM items") && setup.next());
+        QCOMPARE(setup.value(0).toInt(), 3);
+        QCOMPARE(setup.value(1).toDouble(), 62.0);
+        setup.finish();
+        
+        // Без транзакции выполненные шаги остаются и сообщаются; ключ - из lastInsertId
+        batch.transactional = false;
+        batch.batch[0].bindings = {{{"id", 1}, {"price", 12.0}}};
+        batch.batch[1].bindings = {{{"id", QVariant()}, {"name", "D"}, {"price", 40.0}},
+                                   {{"id", 1}, {"name", "dup"}, {"price", 0.0}}};
+        batch.batch[1].returning = {"id"};
+        const QueryResult partial = handler(batch);
+        QVERIFY(!partial.ok);
+        QCOMPARE(partial.completedSteps, 1);
+        QCOMPARE(partial.rows.size(), 1);
+        QCOMPARE(partial.rows[0].value("id").toInt(), 4);
+        QVERIFY(setup.exec("SELECT COUNT(*), SUM(price) FROM items") && setup.next());
+        QCOMPARE(setup.value(0).toInt(), 4);
+        QCOMPARE(setup.value(1).toDouble(), 103.0);
+        setup.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("edit_buffer");
+}
+
+void TableModelTests::testQueryEffects()
+{
+    qDebug() << "Тестирование локального применения записывающих запросов";
+    
+    bool writeOk = true;
+    int selects = 0;
+    auto handler = [&](const QueryContext& context) {
+        QueryResult result;
+        result.ok = true;
+        if (context.queryName == "select_all") {
+            ++selects;
+            const QList<QVariantList> items = {{1, "C", 30.0}, {2, "A", 10.0}, {3, "B", 20.0}};
+            for (const QVariantList& item : items) {
+                result.rows.append({{"id", item[0]}, {"name", item[1]}, {"price", item[2]}});
+            }
+            return result;
+        }
+        if (!writeOk) {
+            result.ok = false;
+            result.log("constraint violation");
+        } else if (context.queryName == "insert") {
+            result.rows.append({{"id", 7}}); // RETURNING id
+        }
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, kItemsSchema + "queries:\n"
+                                                         "  select_all:\n    sql: \"SELECT id, name, price FROM items\"\n"
+                                                         "  insert:\n    effect: insert\n"
+                                                         "    sql: \"INSERT INTO items (name, price) VALUES (${name}, ${price}) RETURNING id\"\n"
+                                                         "  update:\n    effect: update\n"
+                                                         "    sql: \"UPDATE items SET name = ${name} WHERE id = ${id}\"\n"
+                                                         "  remove:\n    effect: remove\n"
+                                                         "    sql: \"DELETE FROM items WHERE id = ${id}\"\n");
+    QVERIFY(!path.isEmpty());
+    
+    TableModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QCOMPARE(model.getSchema().queries["insert"].effect, QForge::QueryEffect::Insert);
+    QVERIFY(model.execute("select_all").ok);
+    model.sort(1);
+    QCOMPARE(columnValues(model, 1), QStringList({"A", "B", "C"}));
+    
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    
+    // Добавление: строка на своём месте в сортировке, ключ - из ответа источника
+    QVERIFY(model.execute("insert", {{"name", "AB"}, {"price", 15.0}}).ok);
+    QCOMPARE(columnValues(model, 1), QStringList({"A", "AB", "B", "C"}));
+    QCOMPARE(model.data(model.index(1, 0)).toInt(), 7);
+    QCOMPARE(insertedSpy.size(), 1);
+    
+    // Изменение по ключу: одна строка, перемещение вместо пересортировки
+    QVERIFY(model.execute("update", {{"id", 1}, {"name", "AA"}}).ok);
+    QCOMPARE(columnValues(model, 1), QStringList({"A", "AA", "AB", "B"}));
+    QCOMPARE(changedSpy.size(), 2); // ключ из RETURNING и сама правка
+    QCOMPARE(changedSpy[1][0].value<QModelIndex>().row(), 3); // место строки до перемещения
+    
+    // Удаление по ключу
+    QVERIFY(model.execute("remove", {{"id", 3}}).ok);
+    QCOMPARE(columnValues(model, 1), QStringList({"A", "AA", "AB"}));
+    QCOMPARE(removedSpy.size(), 1);
+    
+    // Ошибка источника откатывает применённое изменение
+    writeOk = false;
+    QVERIFY(!model.execute("insert", {{"name", "Z"}}).ok);
+    QVERIFY(!model.execute("update", {{"id", 2}, {"name", "ZZ"}}).ok);
+    QVERIFY(!model.execute("remove", {{"id", 7}}).ok);
+    QCOMPARE(columnValues(model, 1), QStringList({"A", "AA", "AB"}));
+    QCOMPARE(model.data(model.index(2, 0)).toInt(), 7);
+    
+    // Неизвестный ключ: применять нечего, запрос всё равно уходит в источник
+    writeOk = true;
+    QVERIFY(model.execute("remove", {{"id", 42}}).ok);
+    QCOMPARE(model.rowCount(), 3);
+    
+    // Строка, удалённая незавершённым запросом, возвращается и после удаления других строк
+    writeOk = false;
+    QSignalSpy failedSpy(&model, &TableModel::executionFailed);
+    model.executeAsync("remove", {{"id", 1}});
+    QCOMPARE(columnValues(model, 1), QStringList({"A", "AB"}));
+    QVERIFY(model.removeRows(0, 1));
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(columnValues(model, 1), QStringList({"AA", "AB"}));
+    
+    // Без сортировки видно место в хранилище: строка вернулась туда, откуда удалена
+    model.setSortRules({});
+    QCOMPARE(columnValues(model, 1), QStringList({"AA", "AB"}));
+    model.executeAsync("remove", {{"id", 1}});
+    QCOMPARE(columnValues(model, 1), QStringList({"AB"}));
+    QTRY_COMPARE(failedSpy.size(), 2);
+    QCOMPARE(columnValues(model, 1), QStringList({"AA", "AB"}));
+    QCOMPARE(selects, 1);
+    QCOMPARE(resetSpy.size(), 0);
+}
+
+void TableModelTests::testBulkSetData()
+{
+    qDebug() << "Тестирование пакетной записи ячеек (вставка блока)";
+    
+    auto handler = [](const QueryContext&) {
+        QueryResult result;
+        result.ok = true;
+        for (int i = 0; i < 6; ++i) {
+            result.rows.append({{"id", i + 1}, {"name", QString("n%1").arg(i)}, {"price", 10.0 * i}, {"quantity", 1}});
+        }
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, "name: Items\ntype: table\n"
+                                          "columns:\n"
+                                          "  - name: id\n    type: integer\n    is_primary_key: true\n    is_editable: false\n"
+                                          "  - name: name\n    type: string\n"
+                                          "    validator:\n      type: regexp\n      pattern: '^[a-z0-9]+$'\n"
+                                          "  - name: price\n    type: double\n"
+                                          "  - name: quantity\n    type: integer\n"
+                                          "  - name: total\n    type: double\n    expression: \"price * quantity\"\n"
+                                          "queries:\n  select_all:\n    sql: \"SELECT\"\n");
+    QVERIFY(!path.isEmpty());
+    
+    TableModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("select_all").ok);
+    
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    
+    // Блок 3x2: один dataChanged на прямоугольник вместе с зависимой вычисляемой колонкой
+    QVERIFY(model.setDataBlock(model.index(1, 2), {{1.5, 2}, {2.5, 2}, {3.5, 2}}));
+    QCOMPARE(changedSpy.size(), 1);
+    QCOMPARE(changedSpy[0][0].toModelIndex(), model.index(1, 2));
+    QCOMPARE(changedSpy[0][1].toModelIndex(), model.index(3, 4));
+    QCOMPARE(model.data(model.index(2, 4)).toDouble(), 5.0);
+    
+    // Ошибка проверки любого значения отменяет весь пакет
+    changedSpy.clear();
+    QVERIFY(!model.setDataBlock(model.index(0, 1), {{"ok"}, {"Not Valid"}}));
+    QVERIFY(model.getLastError().contains("name"));
+    QVERIFY(!model.setDataBlock(model.index(0, 0), {{100}}));
+    QVERIFY(!model.setDataBlock(model.index(5, 2), {{1.0}, {2.0}}));
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("n0"));
+    QCOMPARE(changedSpy.size(), 0);
+    
+    // Индексы другой модели (прокси над этой) не принимаются за координаты этой модели
+    QSortFilterProxyModel proxy;
+    proxy.setSourceModel(&model);
+    proxy.sort(0, Qt::DescendingOrder);
+    QVERIFY(!model.setDataBlock(proxy.index(0, 1), {{"x"}}));
+    QVERIFY(!model.setDataCells({{proxy.index(0, 1), "x"}}));
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("n0"));
+    QCOMPARE(changedSpy.size(), 0);
+    
+    // Отдельные ячейки: соседние строки с одинаковыми колонками объединяются, разрыв - новый диапазон
+    QVERIFY(model.setDataCells({{model.index(0, 1), "a"}, {model.index(1, 1), "b"}, {model.index(4, 1), "e"}}));
+    QCOMPARE(changedSpy.size(), 2);
+    QCOMPARE(changedSpy[0][1].toModelIndex(), model.index(1, 1));
+    QCOMPARE(changedSpy[1][0].toModelIndex(), model.index(4, 1));
+    
+    // Колонка сортировки: один пересчёт раскладки на пакет вместо перемещения каждой строки
+    model.sort(1, Qt::DescendingOrder);
+    QSignalSpy layoutSpy(&model, &QAbstractItemModel::layoutChanged);
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+    QVERIFY(model.setDataCells({{model.index(0, 1), "a0"}, {model.index(5, 1), "z"}}));
+    QCOMPARE(layoutSpy.size(), 1);
+    QCOMPARE(movedSpy.size(), 0);
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("z"));
+    QCOMPARE(model.data(model.index(5, 1)).toString(), QString("a0"));
+}
+
+void TableModelTests::testUndoJournal()
+{
+    qDebug() << "Тестирование журнала отмены правок";
+    
+    QList<QueryContext> commits;
+    auto handler = [&](const QueryContext& context) {
+        if (context.batch.isEmpty()) {
+            return itemsQueryHandler(context);
+        }
+        commits.append(context);
+        QueryResult result;
+        result.ok = true;
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, kItemsSchema + "queries:\n"
+                                                         "  select_all:\n    sql: \"SELECT id, name, price FROM items\"\n"
+                                                         "  update:\n    sql: \"UPDATE items SET name = ${name}, price = ${price} WHERE id = ${id}\"\n"
+                                                         "  insert:\n    sql: \"INSERT INTO items (id, name, price) VALUES (${id}, ${name}, ${price})\"\n"
+                                                         "  remove:\n    sql: \"DELETE FROM items WHERE id = ${id}\"\n");
+    QVERIFY(!path.isEmpty());
+    
+    TableModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("select_all").ok);
+    QVERIFY(!model.isUndoEnabled());
+    model.setEditStrategy(TableModel::EditStrategy::OnManualSubmit);
+    model.setUndoEnabled(true);
+    
+    // Повторные правки ячейки - один шаг; отмена возвращает и буфер правок
+    QVERIFY(model.setData(model.index(0, 1), "A2"));
+    QVERIFY(model.setData(model.index(0, 1), "A3"));
+    QVERIFY(model.undo());
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("A"));
+    QVERIFY(!model.isDirty());
+    QVERIFY(!model.canUndo());
+    QVERIFY(model.redo());
+    QCOMPARE(model.data(model.index(0, 1)).toString(), QString("A3"));
+    QVERIFY(model.isDirty(model.index(0, 1)));
+    
+    // Вставка блока отменяется одним шагом и одним dataChanged
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY(model.setDataBlock(model.index(1, 2), {{21.0}, {31.0}}));
+    QVERIFY(model.undo());
+    QCOMPARE(model.data(model.index(1, 2)).toDouble(), 20.0);
+    QCOMPARE(model.data(model.index(2, 2)).toDouble(), 30.0);
+    QCOMPARE(changedSpy.size(), 2);
+    QVERIFY(!model.isDirty(model.index(1, 2)));
+    
+    // Удаление и добавление строк
+    QVERIFY(model.removeRows(3, 1));
+    QVERIFY(!model.canRedo());
+    QVERIFY(model.undo());
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.data(model.index(3, 1)).toString(), QString("D"));
+    QVERIFY(!model.isDirty(model.index(3, 0)));
+    
+    // Строки из середины возвращаются на прежние места в прежнем порядке
+    auto names = [&model]() {
+        QStringList result;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            result.append(model.data(model.index(row, 1)).toString());
+        }
+        return result;
+    };
+    const QStringList original{"A3", "B", "C", "D"};
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QVERIFY(model.removeRows(1, 1));
+    QVERIFY(model.undo());
+    QCOMPARE(names(), original);
+    QCOMPARE(insertedSpy.size(), 1);
+    QCOMPARE(insertedSpy[0][1].toInt(), 1);
+    QVERIFY(!model.isDirty(model.index(1, 0)));
+    
+    QVERIFY(model.removeRows(1, 2));
+    QVERIFY(model.undo());
+    QCOMPARE(names(), original);
+    QVERIFY(model.redo());
+    QCOMPARE(names(), QStringList({"A3", "D"}));
+    QVERIFY(model.undo());
+    QCOMPARE(names(), original);
+    QVERIFY(!model.isDirty(model.index(2, 0)));
+    
+    model.appendRows({{{"id", 5}, {"name", "E"}, {"price", 50.0}}});
+    QVERIFY(model.undo());
+    QCOMPARE(model.rowCount(), 4);
+    QVERIFY(model.redo());
+    QCOMPARE(model.data(model.index(4, 1)).toString(), QString("E"));
+    
+    // Правка, вернувшая исходное значение, не оставляет ни шага, ни записи в буфере
+    QVERIFY(model.setData(model.index(1, 1), "B2"));
+    QVERIFY(model.setData(model.index(1, 1), "B"));
+    QVERIFY(!model.isDirty(model.index(1, 1)));
+    QVERIFY(model.undo());
+    QCOMPARE(model.rowCount(), 4);
+    QVERIFY(model.redo());
+    
+    // В источник уходит только итог: одна правка и одна добавленная строка
+    QVERIFY2(model.submitAll(), qPrintable(model.getLastError()));
+    QCOMPARE(commits.size(), 1);
+    const QueryContext commit = commits.first();
+    QCOMPARE(commit.batch.size(), 2);
+    QCOMPARE(commit.batch[0].queryName, QString("update"));
+    QCOMPARE(commit.batch[0].bindings.size(), 1);
+    QCOMPARE(commit.batch[0].bindings[0].value("id").toInt(), 1);
+    QCOMPARE(commit.batch[0].bindings[0].value("name").toString(), QString("A3"));
+    QCOMPARE(commit.batch[1].queryName, QString("insert"));
+    QCOMPARE(commit.batch[1].bindings.size(), 1);
+    QCOMPARE(commit.batch[1].bindings[0].value("name").toString(), QString("E"));
+    
+    // Ограничение числа шагов и сброс при перезагрузке данных
+    model.setUndoLimit(1);
+    QVERIFY(model.setData(model.index(2, 1), "C2"));
+    QVERIFY(model.setData(model.index(3, 1), "D2"));
+    QVERIFY(model.undo());
+    QVERIFY(!model.canUndo());
+    QCOMPARE(model.data(model.index(2, 1)).toString(), QString("C2"));
+    
+    // Отброшенные шаги сжимаются не сразу: оставшиеся шаги откатываются верно
+    model.setUndoLimit(2);
+    for (int i = 0; i < 6; ++i) {
+        QVERIFY(model.setData(model.index(i % 4, 2), 100.0 + i));
+    }
+    QVERIFY(model.undo());
+    QCOMPARE(model.data(model.index(1, 2)).toDouble(), 101.0);
+    QVERIFY(model.undo());
+    QCOMPARE(model.data(model.index(0, 2)).toDouble(), 100.0);
+    QVERIFY(!model.canUndo());
+    QVERIFY(model.execute("select_all").ok);
+    QVERIFY(!model.canRedo());
+}
+
+void TableModelTests::testExport()
+{
+    qDebug() << "Тестирование потоковой выгрузки";
+    
+    auto handler = [](const QueryContext&) {
+        QueryResult result;
+        result.ok = true;
+        result.rows.append({{"id", 1}, {"name", "A;b"}, {"price", 10.5}});
+        result.rows.append({{"id", 2}, {"name", "Say \"hi\""}, {"price", QVariant()}});
+        result.rows.append({{"id", 3}, {"name", "x<y & z"}, {"price", 30.0}});
+        return result;
+    };
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, kItemsSchema + "queries:\n"
+                                                         "  select_all:\n    sql: \"SELECT id, name, price FROM items ORDER BY id\"\n"
+                                                         "export_settings:\n"
+                                                         "  supported_formats: [csv, json, xml]\n"
+                                                         "  csv_delimiter: \";\"\n"
+                                                         "  json_pretty_print: false\n"
+                                                         "  xml_root_element: items\n"
+                                                         "  xml_row_element: item\n");
+    QVERIFY(!path.isEmpty());
+    
+    TableModel model(path, handler);
+    QVERIFY2(model.isValid(), qPrintable(model.getLastError()));
+    QVERIFY(model.execute("select_all").ok);
+    
+    auto exported = [&](const QString& format) {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        return model.exportRows(&buffer, format) ? buffer.data() : QByteArray("failed: " + model.getLastError().toUtf8());
+    };
+    
+    // CSV: разделитель из схемы, кавычки только где нужны, NULL - пустое поле
+    const QByteArray csv = "id;name;price\r\n1;\"A;b\";10.5\r\n2;\"Say \"\"hi\"\"\";\r\n3;x<y & z;30\r\n";
+    QCOMPARE(exported("csv"), csv);
+    QCOMPARE(exported(QString()), csv); // default_format
+    QCOMPARE(exported("json"), QByteArray("[{\"id\":1,\"name\":\"A;b\",\"price\":10.5},"
+                                          "{\"id\":2,\"name\":\"Say \\\"hi\\\"\",\"price\":null},"
+                                          "{\"id\":3,\"name\":\"x<y & z\",\"price\":30}]\n"));
+    QCOMPARE(exported("xml"), QByteArray("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<items>\n"
+                                         "  <item><id>1</id><name>A;b</name><price>10.5</price></item>\n"
+                                         "  <item><id>2</id><name>Say \"hi\"</name></item>\n"
+                                         "  <item><id>3</id><name>x&lt;y &amp; z</name><price>30</price></item>\n"
+                                         "</items>\n"));
+    QVERIFY(exported("pdf").startsWith("failed"));
+    
+    // Строки пишутся в порядке представления
+    model.sort(0, Qt::DescendingOrder);
+    QVERIFY(exported("csv").startsWith("id;name;price\r\n3;"));
+    
+    // Результат запроса без загрузки в модель
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY2(model.exportQuery(&buffer, "select_all", {}, "csv"), qPrintable(model.getLastError()));
+        QCOMPARE(buffer.data(), csv);
+        QVERIFY(!model.exportQuery(&buffer, "missing"));
+    }
+    
+    // Прогресс по пакетам и отмена на границе пакета
+    QList<QVariantMap> rows;
+    for (int i = 0; i < 10000; ++i) {
+        rows.append({{"id", 100 + i}, {"name", QString("row %1").arg(i)}, {"price", i * 0.5}});
+    }
+    model.appendRows(rows);
+    QSignalSpy progressSpy(&model, &TableModel::exportProgress);
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(model.exportRows(&buffer, "csv"));
+        QCOMPARE(progressSpy.size(), 3);
+        QCOMPARE(progressSpy.last().at(0).toLongLong(), qint64(10003));
+        QCOMPARE(progressSpy.last().at(1).toLongLong(), buffer.size());
+    }
+    progressSpy.clear();
+    connect(&model, &TableModel::exportProgress, &model, [&model]() { model.cancelExport(); });
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(!model.exportRows(&buffer, "json"));
+        QCOMPARE(model.getLastError(), QString("Export cancelled"));
+        QCOMPARE(progressSpy.size(), 1);
+        QCOMPARE(progressSpy.first().at(0).toLongLong(), qint64(4096));
+    }
+}
+
+void TableModelTests::testExportSqlite()
+{
+    qDebug() << "Тестирование выгрузки из SQLite";
+    
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("Драйвер QSQLITE недоступен");
+    }
+    
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = writeSchema(dir, kItemsSchema + "queries:\n"
+                                                         "  select_all:\n    sql: \"SELECT id, name, price FROM items ORDER BY id\"\n"
+                                                         "export_settings:\n  csv_delimiter: \";\"\n");
+    QVERIFY(!path.isEmpty());
+    const QByteArray csv = "id;name;price\r\n1;\"A;b\";10.5\r\n2;\"Say \"\"hi\"\"\";\r\n3;x<y & z;30\r\n";
+    
+    // Выгрузка из базы курсором только вперёд
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "export_cursor");
+        db.setDatabaseName(":memory:");
+        QVERIFY(db.open());
+        QSqlQuery setup(db);
+        QVERIFY(setup.exec("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT, price REAL)"));
+        QVERIFY(setup.exec("INSERT INTO items VALUES (1, 'A;b', 10.5), (2, 'Say \"hi\"', NULL), (3, 'x<y & z', 30.0)"));
+        
+        TableModel sqlModel(path, &db);
+        QVERIFY2(sqlModel.isValid(), qPrintable(sqlModel.getLastError()));
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY2(sqlModel.exportQuery(&buffer, "select_all", {}, "csv"), qPrintable(sqlModel.getLastError()));
+        QCOMPARE(buffer.data(), csv);
+        QCOMPARE(sqlModel.rowCount(), 0);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("export_cursor");
+}
+
+void TableModelTests::testPredicateKernels()
+{
+    using QForge::nsModel::PredicateKernels;
+    using QForge::FilterOperator;
+    
+    qDebug() << "Тестирование ядер предикатов, поддерживается:"
+             << PredicateKernels::isaName(PredicateKernels::supportedIsa());
+    
+    // Длина не кратна 64 - проверяется и хвост; значения на границах 32-битных половин
+    const int count = 1000;
+    const QVector<qint64> pool = {std::numeric_limits<qint64>::min(), -0x100000000LL, -1, 0, 1, 3,
+                                  0xFFFFFFFFLL, 0x100000000LL, std::numeric_limits<qint64>::max()};
+    QVector<qint64> ints(count);
+    QVector<double> doubles(count);
+    for (int i = 0; i < count; ++i) {
+        ints[i] = pool[(i * 7) % pool.size()];
+        doubles[i] = (i % 17 == 0) ? qQNaN() : double((i * 13) % 11 - 5) / 2;
+    }
+    
+    const QList<FilterOperator> operators = {
+        FilterOperator::Equal, FilterOperator::NotEqual, FilterOperator::Less, FilterOperator::LessOrEqual,
+        FilterOperator::Greater, FilterOperator::GreaterOrEqual, FilterOperator::Between
+    };
+    
+    auto collect = [&](PredicateKernels::Isa isa, FilterOperator op, bool useDoubles) {
+        PredicateKernels::setActiveIsa(isa);
+        QVector<quint64> words((count + 63) / 64, ~quint64(0));
+        if (useDoubles) {
+            PredicateKernels::compareDouble(doubles.constData(), count, op, -0.5, 1.5, words.data());
+        } else {
+            PredicateKernels::compareInt64(ints.constData(), count, op, -1, 0xFFFFFFFFLL, words.data());
+        }
+        return words;
+    };
+    
+    for (FilterOperator op : operators) {
+        for (bool useDoubles : {false, true}) {
+            const QVector<quint64> expected = collect(PredicateKernels::Isa::Scalar, op, useDoubles);
+            QCOMPARE(expected.last() >> (count % 64), quint64(0));
+            for (int isa = 1; isa <= int(PredicateKernels::supportedIsa()); ++isa) {
+                QCOMPARE(collect(PredicateKernels::Isa(isa), op, useDoubles), expected);
+            }
+        }
+    }
+    
+    QVERIFY(!PredicateKernels::compareInt64(ints.constData(), count, FilterOperator::Contains, 0, 0, nullptr));
+    PredicateKernels::setActiveIsa(PredicateKernels::supportedIsa());
+}
+
 // ========== ВСПОМОГАТЕЛЬНЫЕ МЕТОДЫ ==========
 
 QString TableModelTests::getProjectRoot()
@@ -266,6 +2775,7 @@ ModelSchema TableModelTests::createExpectedAlbumSchema()
     // Дополнительные настройки
     schema.defaultRowTooltip = "Альбом: ${title} (id: ${id})";
     schema.showNumeration = true;
+    schema.rebuildColumnIndex();
     
     return schema;
 }
@@ -353,3 +2863,63 @@ QueryResult TableModelTests::dummyQueryHandler(const QueryContext& context)
     
     return result;
 }
+
+QueryResult TableModelTests::productQueryHandler(const QueryContext& context)
+{
+    Q_UNUSED(context)
+    
+    const QDateTime updated(QDate(2024, 1, 15), QTime(10, 30));
+    const QList<QVariantList> products = {
+        {1, "Laptop",       1299.99,    15,  "Electronics", true,  updated},
+        {2, "Phone",        999.0,      25,  "Electronics", true,  updated},
+        {3, "Coffee Maker", 89.99,      50,  "Appliances",  true,  updated},
+        {4, "Chair",        399.99,     8,   "Furniture",   false, updated},
+        {5, "Desk",         599.0,      12,  "Furniture",   true,  updated},
+        {6, "Cable",        QVariant(), 100, "Other",       true,  QVariant()}
+    };
+    const QStringList columns = {"id", "name", "price", "quantity", "category", "in_stock", "last_updated"};
+    
+    QueryResult result;
+    result.ok = true;
+    for (const QVariantList& product : products) {
+        QVariantMap row;
+        for (int i = 0; i < columns.size(); ++i) {
+            row[columns[i]] = product[i];
+        }
+        result.rows.append(row);
+    }
+    return result;
+}
+
+QueryResult TableModelTests::itemsQueryHandler(const QueryContext& context)
+{
+    Q_UNUSED(context)
+    
+    const QList<QVariantList> items = {{1, "A", 10.0}, {2, "B", 20.0}, {3, "C", 30.0}, {4, "D", 40.0}};
+    
+    QueryResult result;
+    result.ok = true;
+    for (const QVariantList& item : items) {
+        result.rows.append({{"id", item[0]}, {"name", item[1]}, {"price", item[2]}});
+    }
+    return result;
+}
+
+QString TableModelTests::writeSchema(const QTemporaryDir& dir, const QByteArray& yaml)
+{
+    const QString path = dir.filePath("Items.yml");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(yaml) != yaml.size()) {
+        return QString();
+    }
+    return path;
+}
+
+QStringList TableModelTests::columnValues(const TableModel& model, int column) const
+{
+    QStringList values;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        values.append(model.data(model.index(row, column)).toString());
+    }
+    return values;
+}
\ No newline at end of file
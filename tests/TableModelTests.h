@@ -3,18 +3,35 @@
 #include <QObject>
 #include <QString>
 #include <QDebug>
+#include <QTemporaryDir>
 #include <QtTest>
 
 // Подключаем наши классы для тестирования
 #include "private/ModelCore.h"
 #include "private/ModelSchema.h"
+#include "private/CsvFileSource.h"
+#include "private/CsvReader.h"
+#include "private/Expression.h"
+#include "private/FieldParser.h"
+#include "private/LookupCache.h"
+#include "private/PredicateKernels.h"
+#include "private/QueryEngine.h"
+#include "private/SchemaCache.h"
+#include "private/SchemaRegistry.h"
+#include "private/SqlQueryHandlerFactory.h"
+#include "ModelFactory.h"
+#include "ProductModelSchema.h"
 #include "QueryResult.hpp"
+#include "TableModel.h"
+#include "TreeModel.h"
 
 // Используем полные имена для избежания конфликтов
 using QForge::nsModel::ModelCore;
 using QForge::nsModel::QueryResult;
 using QForge::HeaderType;
 using QForge::nsModel::QueryContext;
+using QForge::nsModel::TableModel;
+using QForge::nsModel::TreeModel;
 using QForge::ModelSchema;
 using QForge::Column;
 using QForge::Query;
@@ -43,6 +60,37 @@ private slots:
     void testAlbumModelJson();     // Тест загрузки AlbumModel.json
     void testModelSchemaValidation(); // Тест валидации схемы
     void testModelCoreExecution();    // Тест выполнения запросов
+    
+    // Тесты для TableModel
+    void testTableModelSorting();     // Локальная сортировка и переключение направления
+    void testIncrementalSortMaintenance(); // Перемещение строк при setData и вставке
+    void testTableModelFiltering();   // Локальная фильтрация: AND/OR, скрытие и вставка строк
+    void testPredicateKernels();      // SIMD-ядра совпадают со скалярными на всех наборах инструкций
+    void testFilterPushDown();        // Фильтр выполняется обработчиком/SQL или локально
+    void testFilterPushDownSqlite();  // Фильтр в WHERE на SQLite: только над колонками результата SELECT
+    void testCsvReader();             // Кавычки, переводы строк в полях, куски и наборы инструкций
+    void testFieldParser();           // Разбор чисел, дат и времени из байтов по типу колонки
+    void testQueryEngine();           // Разбор запроса, индекс, AND/OR, порядок и фильтр модели
+    void testCsvFileSource();         // Дочитывание дописанных строк и перезагрузка переписанного файла
+    void testSchemaCache();           // Двоичный кэш схемы: тёплая загрузка, смена исходника, повреждение
+    void testSchemaRegistry();        // Одна схема на файл, замена при перезагрузке, ошибка перезагрузки
+    void testModelFactory();          // Параллельный разбор схем, одновременная загрузка, один сигнал
+    void testSchemaHotReload();       // Перезагрузка схемы точечными сигналами колонок, без сброса
+    void testGeneratedSchema();       // Заголовок qforge-schemagen: индексы, типизированные строки и запросы
+    void testColumnIndex();           // Поиск колонки по хеш-индексу, описатель колонки, прямые правки схемы
+    void testCalculatedColumns();     // Компиляция выражений, пачки VM, NULL, пересчёт при setData
+    void testCalculationDependencies(); // Граф зависимостей, циклы, пересчёт только зависимых колонок
+    void testForeignKeyLookup();      // Общий кеш справочников, загрузка целиком и по ключам, сброс
+    void testTreeLazyLoading();       // TreeModel: fetchMore, один IN-запрос на уровень, индексы узлов
+    void testTreeFlatBuild();         // TreeModel: дерево из плоского результата, refreshSubtree, moveNode
+    void testTreeSqlite();            // TreeModel над QSQLITE: ${параметры}, догрузка детей, refreshSubtree
+    void testEditBuffer();            // Буфер правок: submitAll/revertAll, пакет update/insert/remove, транзакция
+    void testEditBufferSqlite();      // Пакет правок в SQLite: транзакция, частичная запись, сгенерированный ключ
+    void testQueryEffects();          // effect записывающих запросов: применение без перезагрузки и откат
+    void testBulkSetData();           // setDataBlock/setDataCells: проверка до записи, объединённые dataChanged
+    void testUndoJournal();           // Журнал отмены: шаги, слияние правок ячейки, итоговая запись в источник
+    void testExport();                // Выгрузка csv/json/xml: экранирование, порядок представления, прогресс и отмена
+    void testExportSqlite();          // Выгрузка запроса из SQLite курсором без загрузки в модель
 
 private:
     // Вспомогательные методы
@@ -53,4 +101,12 @@ private:
     
     // Dummy query handler для тестов
     static QueryResult dummyQueryHandler(const QueryContext& context);
+    
+    // Обработчик, возвращающий фиксированный набор продуктов (схема csv_demo/ProductModel.yml)
+    static QueryResult productQueryHandler(const QueryContext& context);
+    
+    // Обработчик с четырьмя строками Items (id, name, price) и запись схемы Items.yml во временный каталог
+    static QueryResult itemsQueryHandler(const QueryContext& context);
+    static QString writeSchema(const QTemporaryDir& dir, const QByteArray& yaml);
+    QStringList columnValues(const TableModel& model, int column) const;
 };
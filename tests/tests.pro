@@ -1,4 +1,4 @@
-QT += core testlib
+QT += core sql testlib
 
 CONFIG += console c++17
 TEMPLATE = app
@@ -6,6 +6,10 @@ TARGET = QMetaModelTests
 
 include(tests.pri)
 
+# Типизированный заголовок схемы для testGeneratedSchema
+QFORGE_SCHEMAS += $$PWD/../examples/csv_demo/ProductModel.yml
+include(../tools/schemagen/schemagen.pri)
+
 # Путь к заголовкам библиотеки
 INCLUDEPATH += $$PWD/../src
 
@@ -0,0 +1,326 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QStringList>
+#include <QTextStream>
+
+#include "ModelCore.h"
+#include "ModelSchema.h"
+
+using namespace QForge;
+using namespace QForge::nsModel;
+
+// ========== HELPER FUNCTIONS ==========
+
+// Имена вложенных типов и членов структуры схемы: колонки с такими именами получают "_"
+static const QSet<QString> kReservedNames = {
+    "Column", "ColumnCount", "Field", "Row", "Model", "kName", "kColumnNames", "columnIndex"
+};
+
+// Члены и локальные имена Row: поля с такими именами получают "_"
+static const QSet<QString> kRowMembers = {"fromMap", "toMap", "map", "row"};
+
+static const QSet<QString> kKeywords = {
+    "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char", "class",
+    "const", "constexpr", "continue", "default", "delete", "do", "double", "else", "enum", "explicit",
+    "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long",
+    "mutable", "namespace", "new", "noexcept", "not", "nullptr", "operator", "or", "private",
+    "protected", "public", "register", "return", "short", "signed", "sizeof", "static", "struct",
+    "switch", "template", "this", "throw", "true", "try", "typedef", "typename", "union", "unsigned",
+    "using", "virtual", "void", "volatile", "while", "xor"
+};
+
+// Допустимый идентификатор C++ из имени схемы
+static QString identifier(const QString& name) {
+    QString result;
+    for (const QChar ch : name) {
+        result.append((ch.isLetterOrNumber() && ch.unicode() < 128) ? ch : QChar('_'));
+    }
+    if (result.isEmpty() || result[0].isDigit()) {
+        result.prepend('_');
+    }
+    if (kKeywords.contains(result)) {
+        result.append('_');
+    }
+    return result;
+}
+
+// snake_case -> PascalCase
+static QString pascalCase(const QString& name) {
+    QString result;
+    bool upper = true;
+    for (const QChar ch : identifier(name)) {
+        if (ch == '_') {
+            upper = true;
+            continue;
+        }
+        result.append(upper ? ch.toUpper() : ch);
+        upper = false;
+    }
+    return result.isEmpty() ? QString("_") : result;
+}
+
+static QString cppType(ColumnType type) {
+    switch (type) {
+        case ColumnType::String:   return "QString";
+        case ColumnType::Integer:  return "qint64";
+        case ColumnType::Double:   return "double";
+        case ColumnType::Boolean:  return "bool";
+        case ColumnType::DateTime: return "QDateTime";
+        case ColumnType::Date:     return "QDate";
+        case ColumnType::Time:     return "QTime";
+        case ColumnType::Uuid:     return "QUuid";
+        case ColumnType::Binary:   return "QByteArray";
+        default:                   return "QVariant";
+    }
+}
+
+// Аргумент запроса по значению для скалярных типов, по ссылке для остальных
+static QString parameterType(ColumnType type) {
+    const QString name = cppType(type);
+    return (name == "qint64" || name == "double" || name == "bool") ? name : QString("const %1&").arg(name);
+}
+
+static QString quoted(const QString& text) {
+    QString result = text;
+    result.replace("\\", "\\\\").replace("\"", "\\\"");
+    return "\"" + result + "\"";
+}
+
+static QString generate(const ModelSchema& schema, const QString& sourceName, const QString& nameSpace) {
+    const QString structName = identifier(schema.name.isEmpty() ? QFileInfo(sourceName).baseName() : schema.name);
+    const int columnCount = schema.columns.size();
+
+    // Имена колонок в перечислении: PascalCase, без совпадений между собой и с членами структуры
+    QStringList enumNames;
+    for (const Column& column : schema.columns) {
+        QString name = pascalCase(column.name);
+        while (kReservedNames.contains(name) || enumNames.contains(name)) {
+            name.append('_');
+        }
+        enumNames.append(name);
+    }
+    QStringList fieldNames;
+    for (const Column& column : schema.columns) {
+        QString name = identifier(column.name);
+        while (kRowMembers.contains(name) || fieldNames.contains(name)) {
+            name.append('_');
+        }
+        fieldNames.append(name);
+    }
+
+    QString text;
+    QTextStream out(&text);
+    out << "// Сгенерировано qforge-schemagen из " << sourceName << ". Не редактировать: файл\n"
+        << "// пересоздаётся при сборке (QFORGE_SCHEMAS в schemagen.pri).\n"
+        << "#pragma once\n\n"
+        << "#include <QByteArray>\n#include <QDate>\n#include <QDateTime>\n#include <QString>\n"
+        << "#include <QTime>\n#include <QUuid>\n#include <QVariantMap>\n\n"
+        << "#include <optional>\n#include <string_view>\n#include <tuple>\n\n"
+        << "#include \"TableModel.h\"\n\n";
+
+    const QStringList namespaces = nameSpace.split("::", Qt::SkipEmptyParts);
+    for (const QString& part : namespaces) {
+        out << "namespace " << part << " {\n";
+    }
+    out << "\n";
+
+    out << "/**\n * @brief Схема " << schema.name << ": индексы колонок, типизированная строка и модель.\n */\n"
+        << "struct " << structName << "\n{\n"
+        << "    static constexpr std::string_view kName = " << quoted(schema.name) << ";\n\n"
+        << "    enum Column : int {\n";
+    for (int i = 0; i < columnCount; ++i) {
+        out << "        " << enumNames[i] << " = " << i << ",\n";
+    }
+    out << "        ColumnCount = " << columnCount << "\n    };\n\n";
+
+    out << "    static constexpr std::string_view kColumnNames[" << qMax(columnCount, 1) << "] = {";
+    for (int i = 0; i < columnCount; ++i) {
+        out << (i ? ", " : "") << quoted(schema.columns[i].name);
+    }
+    out << "};\n\n"
+        << "    /*!\n     * \\brief Индекс колонки по имени на этапе компиляции или -1.\n     */\n"
+        << "    static constexpr int columnIndex(std::string_view name) {\n"
+        << "        for (int i = 0; i < ColumnCount; ++i) {\n"
+        << "            if (kColumnNames[i] == name) {\n"
+        << "                return i;\n"
+        << "            }\n"
+        << "        }\n"
+        << "        return -1;\n"
+        << "    }\n\n";
+
+    out << "    /*!\n     * \\brief Тип значения колонки C.\n     */\n"
+        << "    template <Column C>\n"
+        << "    using Field = std::tuple_element_t<C, std::tuple<";
+    for (int i = 0; i < columnCount; ++i) {
+        out << (i ? ", " : "") << cppType(schema.columns[i].type);
+    }
+    out << ">>;\n\n";
+
+    out << "    struct Row\n    {\n";
+    for (int i = 0; i < columnCount; ++i) {
+        out << "        std::optional<" << cppType(schema.columns[i].type) << "> " << fieldNames[i] << ";\n";
+    }
+    out << "\n        static Row fromMap(const QVariantMap& map) {\n"
+        << "            Row row;\n";
+    for (int i = 0; i < columnCount; ++i) {
+        const QString type = cppType(schema.columns[i].type);
+        const QString key = quoted(schema.columns[i].name);
+        out << "            if (map.value(" << key << ").isValid()) {\n"
+            << "                row." << fieldNames[i] << " = map.value(" << key << ")"
+            << (type == "QVariant" ? QString() : QString(".value<%1>()").arg(type)) << ";\n"
+            << "            }\n";
+    }
+    out << "            return row;\n        }\n\n"
+        << "        QVariantMap toMap() const {\n"
+        << "            QVariantMap map;\n";
+    for (int i = 0; i < columnCount; ++i) {
+        out << "            map.insert(" << quoted(schema.columns[i].name) << ", " << fieldNames[i]
+            << " ? QVariant::fromValue(*" << fieldNames[i] << ") : QVariant());\n";
+    }
+    out << "            return map;\n        }\n    };\n\n";
+
+    out << "    /**\n"
+        << "     * @brief Модель схемы с типизированным доступом к хранилищу.\n"
+        << "     *\n"
+        << "     * Остаётся обычной TableModel: схема по-прежнему читается из файла во время\n"
+        << "     * выполнения, динамический доступ по именам и QVariant работает как раньше.\n"
+        << "     */\n"
+        << "    class Model : public ::QForge::nsModel::TableModel\n    {\n"
+        << "    public:\n"
+        << "        explicit Model(const QString& configPath, const ::QForge::nsModel::QueryHandler& handler = {},\n"
+        << "                       QObject* parent = nullptr)\n"
+        << "            : TableModel(configPath, handler, parent)\n"
+        << "        {}\n\n"
+        << "        /*!\n"
+        << "         * \\brief Колонки загруженной схемы совпадают со сгенерированными.\n"
+        << "         * \\details После перезагрузки схемы с другими колонками индексы Column неверны.\n"
+        << "         */\n"
+        << "        bool matchesSchema() const {\n"
+        << "            if (columnCount() != ColumnCount) {\n"
+        << "                return false;\n"
+        << "            }\n"
+        << "            for (int i = 0; i < ColumnCount; ++i) {\n"
+        << "                if (columnName(i) != QLatin1String(kColumnNames[i].data(), int(kColumnNames[i].size()))) {\n"
+        << "                    return false;\n"
+        << "                }\n"
+        << "            }\n"
+        << "            return true;\n"
+        << "        }\n\n"
+        << "        template <Column C>\n"
+        << "        std::optional<Field<C>> value(int row) const {\n"
+        << "            return typedValue<Field<C>>(row, C);\n"
+        << "        }\n\n"
+        << "        Row rowAt(int row) const {\n"
+        << "            Row result;\n";
+    for (int i = 0; i < columnCount; ++i) {
+        out << "            result." << fieldNames[i] << " = value<" << enumNames[i] << ">(row);\n";
+    }
+    out << "            return result;\n"
+        << "        }\n";
+
+    // Запросы: типизированные аргументы вместо QVariantMap
+    QStringList queryNames = schema.queries.keys();
+    queryNames.sort();
+    for (const QString& queryName : queryNames) {
+        const Query& query = schema.queries[queryName];
+
+        // Необязательные аргументы получают значение по умолчанию, только если за ними нет обязательных
+        int trailingOptional = query.arguments.size();
+        while (trailingOptional > 0 && query.arguments[trailingOptional - 1].isOptional) {
+            --trailingOptional;
+        }
+
+        QStringList parameters;
+        QStringList argumentNames;
+        for (int i = 0; i < query.arguments.size(); ++i) {
+            const QueryArgument& argument = query.arguments[i];
+            QString name = identifier(argument.name);
+            while (argumentNames.contains(name)) {
+                name.append('_');
+            }
+            argumentNames.append(name);
+            if (argument.isOptional) {
+                parameters.append(QString("const std::optional<%1>& %2%3")
+                                      .arg(cppType(argument.type), name, i >= trailingOptional ? " = std::nullopt" : ""));
+            } else {
+                parameters.append(parameterType(argument.type) + " " + name);
+            }
+        }
+
+        out << "\n";
+        if (!query.description.isEmpty()) {
+            out << "        // " << query.description.simplified() << "\n";
+        }
+        out << "        ::QForge::nsModel::QueryResult query" << pascalCase(queryName)
+            << "(" << parameters.join(", ") << ") {\n"
+            << "            QVariantMap params;\n";
+        for (int i = 0; i < query.arguments.size(); ++i) {
+            const QString key = quoted(query.arguments[i].name);
+            if (query.arguments[i].isOptional) {
+                out << "            if (" << argumentNames[i] << ") {\n"
+                    << "                params.insert(" << key << ", QVariant::fromValue(*" << argumentNames[i] << "));\n"
+                    << "            }\n";
+            } else {
+                out << "            params.insert(" << key << ", QVariant::fromValue(" << argumentNames[i] << "));\n";
+            }
+        }
+        out << "            return execute(" << quoted(queryName) << ", params);\n"
+            << "        }\n";
+    }
+    out << "    };\n};\n\n";
+
+    for (int i = namespaces.size() - 1; i >= 0; --i) {
+        out << "}\n";
+    }
+    out.flush();
+    return text;
+}
+
+// ========== ENTRY POINT ==========
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+
+    // qforge-schemagen [--namespace NS] <схема.yml|.json> <заголовок.h>
+    QStringList args = app.arguments().mid(1);
+    QString nameSpace = "QForge::nsSchema";
+    const int nsIndex = args.indexOf("--namespace");
+    if (nsIndex >= 0 && nsIndex + 1 < args.size()) {
+        nameSpace = args[nsIndex + 1];
+        args.remove(nsIndex, 2);
+    }
+    if (args.size() != 2) {
+        err << "Usage: qforge-schemagen [--namespace NS] <schema.yml|schema.json> <output.h>\n";
+        return 2;
+    }
+    const QString sourcePath = args[0];
+    const QString outputPath = args[1];
+
+    ModelSchema schema;
+    QStringList errors;
+    if (!ModelCore::parseFile(sourcePath, schema, errors)) {
+        for (const QString& error : std::as_const(errors)) {
+            err << sourcePath << ": " << error << "\n";
+        }
+        return 1;
+    }
+
+    const QByteArray header = generate(schema, QFileInfo(sourcePath).fileName(), nameSpace).toUtf8();
+
+    // Неизменившийся заголовок не перезаписывается, чтобы не пересобирать зависящие от него файлы
+    QFile output(outputPath);
+    if (output.open(QIODevice::ReadOnly) && output.readAll() == header) {
+        return 0;
+    }
+    output.close();
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << outputPath << ": " << output.errorString() << "\n";
+        return 1;
+    }
+    output.write(header);
+    return 0;
+}
@@ -0,0 +1,34 @@
+# Генерация заголовков схем при сборке.
+#
+#   QFORGE_SCHEMAS += $$PWD/ProductModel.yml
+#   include(<QMetaModel>/tools/schemagen/schemagen.pri)
+#
+# Для каждого файла в каталоге сборки создаётся <имя файла>Schema.h (ProductModelSchema.h)
+# со структурой QForge::nsSchema::<имя схемы>. Заголовок пересоздаётся при изменении схемы;
+# пространство имён задаётся через QFORGE_SCHEMAGEN_NAMESPACE.
+
+isEmpty(QFORGE_SCHEMAGEN) {
+    unix {
+        QFORGE_SCHEMAGEN = $$shadowed($$PWD)/qforge-schemagen
+    } else {
+        contains(CONFIG, debug, debug|release) {
+            QFORGE_SCHEMAGEN = $$shadowed($$PWD)/debug/qforge-schemagen.exe
+        } else {
+            QFORGE_SCHEMAGEN = $$shadowed($$PWD)/release/qforge-schemagen.exe
+        }
+    }
+}
+
+QFORGE_SCHEMAGEN_ARGS =
+!isEmpty(QFORGE_SCHEMAGEN_NAMESPACE): QFORGE_SCHEMAGEN_ARGS = --namespace $$QFORGE_SCHEMAGEN_NAMESPACE
+
+qforge_schemagen.input = QFORGE_SCHEMAS
+qforge_schemagen.output = $$OUT_PWD/${QMAKE_FILE_BASE}Schema.h
+qforge_schemagen.commands = $$shell_path($$QFORGE_SCHEMAGEN) $$QFORGE_SCHEMAGEN_ARGS ${QMAKE_FILE_IN} ${QMAKE_FILE_OUT}
+qforge_schemagen.depends = $$QFORGE_SCHEMAGEN
+qforge_schemagen.variable_out = HEADERS
+qforge_schemagen.CONFIG += target_predeps no_link
+qforge_schemagen.name = qforge-schemagen ${QMAKE_FILE_IN}
+QMAKE_EXTRA_COMPILERS += qforge_schemagen
+
+INCLUDEPATH += $$OUT_PWD
@@ -0,0 +1,35 @@
+QT += core
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = qforge-schemagen
+
+SOURCES += \
+    main.cpp
+
+# Схема разбирается тем же кодом, что и в библиотеке (ModelCore::parseFile)
+INCLUDEPATH += $$PWD/../../src $$PWD/../../src/private
+
+# yaml-cpp integration (копируем из tests.pro)
+DEFINES += YAML_CPP_STATIC_DEFINE
+INCLUDEPATH += $$PWD/../../external/yaml-cpp/include
+
+win32 {
+    LIBS += $$PWD/../../build/external/yaml-cpp-win/libyaml-cpp.a
+    QMAKE_LFLAGS += -Wl,--allow-multiple-definition
+} else {
+    LIBS += $$PWD/../../build/external/yaml-cpp/libyaml-cpp.a
+}
+
+# Путь к собранной библиотеке; генератор запускается при сборке, поэтому путь к ней прописывается в rpath
+unix {
+    LIBS += $$PWD/../../src/libQMetaModel.so
+    QMAKE_RPATHDIR += $$PWD/../../src
+} else {
+    contains(CONFIG, debug, debug|release) {
+        LIBS += -L$$OUT_PWD/../../src/debug -lQMetaModel
+    } else {
+        LIBS += -L$$OUT_PWD/../../src/release -lQMetaModel
+    }
+}